@@ -0,0 +1,84 @@
+#include "asrc.hpp"
+#include <cstring>
+
+void Asrc::reset()
+{
+    // One zero sample of history for the x[-1] tap
+    m_in[0] = 0;
+    m_inCount = 1;
+    m_pos = 1;
+    m_frac = 0;
+    setDriftPpb(0);
+}
+
+void Asrc::setDriftPpb(int32_t ppb)
+{
+    if (ppb > kMaxDriftPpb) {
+        ppb = kMaxDriftPpb;
+    } else if (ppb < -kMaxDriftPpb) {
+        ppb = -kMaxDriftPpb;
+    }
+
+    m_driftPpb = ppb;
+    m_step = static_cast<int64_t>(kOne) + (static_cast<int64_t>(ppb) << 32) / 1000000000;
+}
+
+int16_t* Asrc::inputSpan(size_t n)
+{
+    // Keep the unconsumed input plus one sample of history at the front
+    size_t keep = m_inCount - (m_pos - 1);
+    if (m_pos > 1) {
+        memmove(m_in, m_in + m_pos - 1, keep * sizeof(int16_t));
+        m_inCount = keep;
+        m_pos = 1;
+    }
+
+    if (m_inCount + n > kInputCapacity) {
+        return nullptr;
+    }
+    return m_in + m_inCount;
+}
+
+int16_t Asrc::interpolate() const
+{
+    const int16_t* x = m_in + m_pos;
+    int64_t xm1 = x[-1];
+    int64_t x0 = x[0];
+    int64_t x1 = x[1];
+    int64_t x2 = x[2];
+    int64_t t = m_frac >> 17;  // Q15
+
+    // Catmull-Rom: y = x0 + ((a*t + b)*t + c)*t / 2
+    int64_t a = -xm1 + 3 * x0 - 3 * x1 + x2;
+    int64_t b = 2 * xm1 - 5 * x0 + 4 * x1 - x2;
+    int64_t c = x1 - xm1;
+    int64_t acc = ((a * t) >> 15) + b;
+    acc = ((acc * t) >> 15) + c;
+    acc = (acc * t) >> 15;
+
+    int64_t y = x0 + (acc >> 1);
+    if (y > INT16_MAX) {
+        y = INT16_MAX;
+    } else if (y < INT16_MIN) {
+        y = INT16_MIN;
+    }
+    return static_cast<int16_t>(y);
+}
+
+size_t Asrc::process(int16_t* out, size_t n)
+{
+    size_t produced = 0;
+
+    while (produced < n && m_pos + 2 < m_inCount) {
+        if (out) {
+            out[produced] = interpolate();
+        }
+        produced++;
+
+        uint64_t acc = m_frac + static_cast<uint64_t>(m_step);
+        m_pos += static_cast<size_t>(acc >> 32);
+        m_frac = static_cast<uint32_t>(acc);
+    }
+
+    return produced;
+}
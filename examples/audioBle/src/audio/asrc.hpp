@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "../net/packet_pool.hpp"
+
+/**
+ * @brief Small fixed-point asynchronous sample-rate converter
+ *
+ * Sits between the jitter buffer and the PCM ring and absorbs the clock
+ * difference between the sender and us (a ratio within ±500 ppm of 1).
+ * Each output sample advances the read position by 1 + drift; the sample is
+ * interpolated with a 4-tap cubic Hermite (Catmull-Rom) kernel, which keeps
+ * the fractional-delay error well below the L16 noise floor at 16 kHz.
+ *
+ * The input side is a linear buffer filled one decoded frame at a time
+ * through inputSpan()/commitInput(). The caller feeds one frame per sender
+ * frame period and drains everything process() can produce, which is
+ * slightly fewer or more samples than the frame holds: the output then
+ * follows our clock while the input follows the sender's.
+ *
+ * Not thread-safe: feed and drain from the same thread.
+ */
+class Asrc {
+public:
+    static constexpr int32_t kMaxDriftPpb = 500000;  // ±500 ppm
+
+    // Room for one leftover frame plus one new frame and the kernel taps
+    static constexpr size_t kMaxFrameSamples = CONFIG_RTP_PACKET_BUF_SIZE / sizeof(int16_t);
+    static constexpr size_t kInputCapacity = 2 * kMaxFrameSamples + 8;
+
+    Asrc() { reset(); }
+
+    /**
+     * @brief Drop buffered input and restart at ratio 1
+     */
+    void reset();
+
+    /**
+     * @brief Set the sender clock drift (positive = sender fast)
+     * @param ppb Parts per billion, clamped to ±kMaxDriftPpb
+     */
+    void setDriftPpb(int32_t ppb);
+
+    int32_t driftPpb() const { return m_driftPpb; }
+
+    /**
+     * @brief Get space for n input samples, compacting consumed input first
+     * @return Pointer to n writable samples, or nullptr if they do not fit
+     */
+    int16_t* inputSpan(size_t n);
+
+    /**
+     * @brief Publish n samples written through inputSpan()
+     */
+    void commitInput(size_t n) { m_inCount += n; }
+
+    /**
+     * @brief Produce up to n output samples
+     * @param out Output buffer, or nullptr to advance without output (discard)
+     * @param n Maximum number of samples
+     * @return Number of samples produced (less than n if input ran out)
+     */
+    size_t process(int16_t* out, size_t n);
+
+    /**
+     * @brief Input samples buffered and not yet consumed
+     */
+    size_t buffered() const { return m_inCount - m_pos; }
+
+private:
+    static constexpr uint64_t kOne = 1ull << 32;
+
+    int16_t interpolate() const;
+
+    int16_t m_in[kInputCapacity];
+    size_t m_inCount = 0;
+    size_t m_pos = 0;       // Input index of x0; x[-1] and x[1..2] are the other taps
+    uint32_t m_frac = 0;    // Fractional read position, Q32
+    int64_t m_step = kOne;  // Read position advance per output sample, Q32
+    int32_t m_driftPpb = 0;
+};
@@ -0,0 +1,107 @@
+#include "clock_recovery.hpp"
+
+ClockRecovery::ClockRecovery(uint32_t clockRate, uint32_t cyclesPerSec)
+    : m_clockRate(clockRate), m_cyclesPerSec(cyclesPerSec)
+{
+    reset();
+}
+
+void ClockRecovery::reset()
+{
+    m_started = false;
+    m_windowHasSample = false;
+    m_locked = false;
+    restartHistory();
+}
+
+void ClockRecovery::restartHistory()
+{
+    m_historyCount = 0;
+    m_historyHead = 0;
+}
+
+uint64_t ClockRecovery::localTicksQ16() const
+{
+    // Split into whole seconds and remainder so neither product overflows
+    uint64_t seconds = m_localCycles / m_cyclesPerSec;
+    uint64_t rem = m_localCycles % m_cyclesPerSec;
+    return ((seconds * m_clockRate) << 16) + ((rem * m_clockRate) << 16) / m_cyclesPerSec;
+}
+
+void ClockRecovery::onPacket(uint32_t timestamp, uint32_t arrivalCycles)
+{
+    if (!m_started) {
+        m_started = true;
+        m_localCycles = 0;
+        m_rtpTicks = 0;
+        m_windowEndQ16 = (static_cast<uint64_t>(m_clockRate) * kWindowMs / 1000) << 16;
+        m_windowHasSample = false;
+    } else {
+        // Deltas keep both clocks extended across 32-bit wraps; RTP deltas
+        // are signed so reordered packets step back correctly
+        m_localCycles += arrivalCycles - m_lastCycles;
+        m_rtpTicks += static_cast<int32_t>(timestamp - m_lastTs);
+    }
+    m_lastTs = timestamp;
+    m_lastCycles = arrivalCycles;
+
+    uint64_t localQ16 = localTicksQ16();
+    int64_t offsetQ16 = static_cast<int64_t>(localQ16) - (m_rtpTicks << 16);
+
+    // Queuing only delays packets, so the window minimum is the cleanest sample
+    if (!m_windowHasSample || offsetQ16 < m_windowMin.offsetQ16) {
+        m_windowMin.localQ16 = localQ16;
+        m_windowMin.offsetQ16 = offsetQ16;
+        m_windowHasSample = true;
+    }
+
+    if (localQ16 >= m_windowEndQ16) {
+        closeWindow();
+        m_windowEndQ16 = localQ16 + ((static_cast<uint64_t>(m_clockRate) * kWindowMs / 1000) << 16);
+    }
+}
+
+void ClockRecovery::closeWindow()
+{
+    m_windowHasSample = false;
+
+    const Sample& newest = m_windowMin;
+    if (m_historyCount > 0) {
+        const Sample& oldest =
+            m_history[(m_historyHead + kHistory - m_historyCount) % kHistory];
+        int64_t dLocal = static_cast<int64_t>(newest.localQ16 - oldest.localQ16);
+        int64_t dOffset = newest.offsetQ16 - oldest.offsetQ16;
+
+        // Offset moving faster than kMaxPlausiblePpb: the sender clock
+        // stepped, start over from this window
+        int64_t absOffset = dOffset < 0 ? -dOffset : dOffset;
+        if (dLocal <= 0 || absOffset > dLocal / (1000000000 / kMaxPlausiblePpb)) {
+            m_steps++;
+            restartHistory();
+        }
+    }
+
+    m_history[m_historyHead] = newest;
+    m_historyHead = (m_historyHead + 1) % kHistory;
+    if (m_historyCount < kHistory) {
+        m_historyCount++;
+    }
+
+    if (m_historyCount < kLockWindows) {
+        return;
+    }
+
+    // Slope of the minimum offset over the whole baseline. The offset shrinks
+    // when the sender is fast, hence the sign flip.
+    const Sample& oldest = m_history[(m_historyHead + kHistory - m_historyCount) % kHistory];
+    int64_t dLocal = static_cast<int64_t>(newest.localQ16 - oldest.localQ16);
+    int64_t dOffset = newest.offsetQ16 - oldest.offsetQ16;
+    int32_t estimate = static_cast<int32_t>(-(dOffset * 1000000000) / dLocal);
+
+    if (!m_locked) {
+        m_driftPpb = estimate;
+        m_locked = true;
+    } else {
+        m_driftPpb += (estimate - m_driftPpb) / 4;
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Sender media clock recovery from RTP timestamps
+ *
+ * Compares each packet's RTP timestamp with its local arrival time (in
+ * hardware cycles). The transit offset (local time - RTP time) drifts with
+ * the clock rate difference; queuing delay only ever adds to it, so the
+ * minimum offset per window is a low-noise sample of the clock relation.
+ * The drift estimate is the slope of these minima over a long baseline,
+ * lightly smoothed.
+ *
+ * Everything is integer. Local time is kept as an extended cycle count and
+ * converted to RTP ticks exactly (no rounded rate factor, which would show
+ * up as a constant ppm bias); offsets are Q16 ticks.
+ *
+ * Not thread-safe: call from the receive thread only.
+ */
+class ClockRecovery {
+public:
+    // Windows are 2 s of local time, the baseline spans up to 8 of them
+    static constexpr uint32_t kWindowMs = 2000;
+    static constexpr size_t kHistory = 8;
+    // Estimate is published once this many windows are in the history
+    static constexpr size_t kLockWindows = 4;
+    // Slopes beyond this are a clock step (sender restart), not drift
+    static constexpr int32_t kMaxPlausiblePpb = 2000000;
+
+    /**
+     * @param clockRate RTP media clock rate in Hz
+     * @param cyclesPerSec Rate of the arrival time counter (k_cycle_get_32)
+     */
+    ClockRecovery(uint32_t clockRate, uint32_t cyclesPerSec);
+
+    /**
+     * @brief Forget all history (stream restart); the last estimate is kept
+     *        as a starting point since the clocks themselves did not change
+     */
+    void reset();
+
+    /**
+     * @brief Account one received packet
+     * @param timestamp RTP timestamp
+     * @param arrivalCycles Arrival time from k_cycle_get_32(); the counter
+     *                      may wrap, but packets must arrive more often
+     */
+    void onPacket(uint32_t timestamp, uint32_t arrivalCycles);
+
+    /**
+     * @brief Sender clock rate relative to ours, parts per billion
+     *
+     * Positive means the sender runs fast, i.e. it produces more samples
+     * per local second than the nominal clock rate.
+     */
+    int32_t driftPpb() const { return m_driftPpb; }
+
+    /**
+     * @brief True once enough history backs the estimate
+     */
+    bool isLocked() const { return m_locked; }
+
+    /**
+     * @brief Number of discontinuities (clock steps) that restarted the history
+     */
+    uint32_t steps() const { return m_steps; }
+
+private:
+    struct Sample {
+        uint64_t localQ16;  // Local time of the minimum, RTP ticks Q16
+        int64_t offsetQ16;  // Minimum transit offset in the window
+    };
+
+    uint64_t localTicksQ16() const;
+    void closeWindow();
+    void restartHistory();
+
+    const uint32_t m_clockRate;
+    const uint32_t m_cyclesPerSec;
+
+    bool m_started = false;
+    uint32_t m_lastTs = 0;
+    uint32_t m_lastCycles = 0;
+    uint64_t m_localCycles = 0;  // Local time since the first packet (extended)
+    int64_t m_rtpTicks = 0;      // RTP time since the first packet (extended)
+
+    // Current window
+    uint64_t m_windowEndQ16 = 0;
+    Sample m_windowMin = {};
+    bool m_windowHasSample = false;
+
+    Sample m_history[kHistory] = {};
+    size_t m_historyCount = 0;
+    size_t m_historyHead = 0;  // Next slot to write
+
+    int32_t m_driftPpb = 0;
+    bool m_locked = false;
+    uint32_t m_steps = 0;
+};
@@ -0,0 +1,123 @@
+#include "dsp.hpp"
+
+using namespace dsp_simd;
+
+namespace dsp {
+
+namespace scalar {
+
+void l16beToHost(const uint8_t* in, int16_t* out, size_t samples)
+{
+    for (size_t i = 0; i < samples; i++) {
+        out[i] = static_cast<int16_t>((in[2 * i] << 8) | in[2 * i + 1]);
+    }
+}
+
+void applyGainQ16(int16_t* buf, size_t samples, int32_t gainQ16)
+{
+    for (size_t i = 0; i < samples; i++) {
+        int32_t y = static_cast<int32_t>((static_cast<int64_t>(buf[i]) * gainQ16) >> 16);
+        buf[i] = static_cast<int16_t>(y > INT16_MAX ? INT16_MAX : (y < INT16_MIN ? INT16_MIN : y));
+    }
+}
+
+void mixSaturate(int16_t* dst, const int16_t* src, size_t samples)
+{
+    for (size_t i = 0; i < samples; i++) {
+        int32_t y = dst[i] + src[i];
+        dst[i] = static_cast<int16_t>(y > INT16_MAX ? INT16_MAX : (y < INT16_MIN ? INT16_MIN : y));
+    }
+}
+
+void stereoToMono(const int16_t* in, int16_t* out, size_t frames)
+{
+    for (size_t i = 0; i < frames; i++) {
+        out[i] = static_cast<int16_t>((in[2 * i] + in[2 * i + 1]) >> 1);
+    }
+}
+
+int64_t dot(const int16_t* a, const int16_t* b, size_t samples)
+{
+    int64_t acc = 0;
+    for (size_t i = 0; i < samples; i++) {
+        acc += static_cast<int32_t>(a[i]) * b[i];
+    }
+    return acc;
+}
+
+}  // namespace scalar
+
+// Main loops take four samples (two words) per iteration, which keeps the
+// M33 pipeline busy between loads; tails fall back to the scalar code
+
+namespace simd {
+
+void l16beToHost(const uint8_t* in, int16_t* out, size_t samples)
+{
+    size_t i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        uint32_t w0 = load32(in + 2 * i);
+        uint32_t w1 = load32(in + 2 * i + 4);
+        store32(out + i, rev16(w0));
+        store32(out + i + 2, rev16(w1));
+    }
+    scalar::l16beToHost(in + 2 * i, out + i, samples - i);
+}
+
+void applyGainQ16(int16_t* buf, size_t samples, int32_t gainQ16)
+{
+    size_t i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        uint32_t w0 = load32(buf + i);
+        uint32_t w1 = load32(buf + i + 2);
+        uint32_t y0 = pkhbt(ssat16(smulwb(gainQ16, w0)), ssat16(smulwt(gainQ16, w0)));
+        uint32_t y1 = pkhbt(ssat16(smulwb(gainQ16, w1)), ssat16(smulwt(gainQ16, w1)));
+        store32(buf + i, y0);
+        store32(buf + i + 2, y1);
+    }
+    scalar::applyGainQ16(buf + i, samples - i, gainQ16);
+}
+
+void mixSaturate(int16_t* dst, const int16_t* src, size_t samples)
+{
+    size_t i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        uint32_t d0 = load32(dst + i);
+        uint32_t d1 = load32(dst + i + 2);
+        uint32_t s0 = load32(src + i);
+        uint32_t s1 = load32(src + i + 2);
+        store32(dst + i, qadd16(d0, s0));
+        store32(dst + i + 2, qadd16(d1, s1));
+    }
+    scalar::mixSaturate(dst + i, src + i, samples - i);
+}
+
+void stereoToMono(const int16_t* in, int16_t* out, size_t frames)
+{
+    // L + R of one frame in a single dual multiply-add against (1, 1)
+    constexpr uint32_t kOnes = 0x00010001;
+    size_t i = 0;
+    for (; i + 2 <= frames; i += 2) {
+        uint32_t f0 = load32(in + 2 * i);
+        uint32_t f1 = load32(in + 2 * i + 2);
+        store32(out + i, pkhbt(smuad(f0, kOnes) >> 1, smuad(f1, kOnes) >> 1));
+    }
+    scalar::stereoToMono(in + 2 * i, out + i, frames - i);
+}
+
+int64_t dot(const int16_t* a, const int16_t* b, size_t samples)
+{
+    // Two accumulators so consecutive SMLALDs do not wait on each other
+    int64_t acc0 = 0;
+    int64_t acc1 = 0;
+    size_t i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        acc0 = smlald(load32(a + i), load32(b + i), acc0);
+        acc1 = smlald(load32(a + i + 2), load32(b + i + 2), acc1);
+    }
+    return acc0 + acc1 + scalar::dot(a + i, b + i, samples - i);
+}
+
+}  // namespace simd
+
+}  // namespace dsp
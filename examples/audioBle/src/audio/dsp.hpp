@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "dsp_simd.hpp"
+
+/**
+ * @brief Per-sample PCM kernels for the receive path
+ *
+ * Every kernel has a scalar reference (dsp::scalar) and a packed 16-bit
+ * version (dsp::simd) built on dsp_simd.hpp; both produce identical
+ * output. The unqualified dsp:: functions pick the SIMD version when the
+ * core has the DSP extension and the scalar one otherwise. Buffers need
+ * no particular alignment.
+ */
+namespace dsp {
+
+// Unity gain for applyGainQ16()
+constexpr int32_t kGainUnityQ16 = 1 << 16;
+
+namespace scalar {
+
+/**
+ * @brief Convert big-endian L16 bytes to host-order samples
+ */
+void l16beToHost(const uint8_t* in, int16_t* out, size_t samples);
+
+/**
+ * @brief buf[i] = sat16((buf[i] * gain) >> 16), in place
+ * @param gainQ16 Linear gain in Q16 (kGainUnityQ16 = 0 dB), may exceed unity
+ */
+void applyGainQ16(int16_t* buf, size_t samples, int32_t gainQ16);
+
+/**
+ * @brief dst[i] = sat16(dst[i] + src[i])
+ */
+void mixSaturate(int16_t* dst, const int16_t* src, size_t samples);
+
+/**
+ * @brief out[i] = (in[2i] + in[2i + 1]) >> 1; out may alias in
+ * @param frames Number of interleaved frames (output samples)
+ */
+void stereoToMono(const int16_t* in, int16_t* out, size_t frames);
+
+/**
+ * @brief Sum of a[i] * b[i] (exact, no overflow for any realistic length)
+ */
+int64_t dot(const int16_t* a, const int16_t* b, size_t samples);
+
+}  // namespace scalar
+
+// Same contracts as dsp::scalar, two samples per instruction
+namespace simd {
+
+void l16beToHost(const uint8_t* in, int16_t* out, size_t samples);
+void applyGainQ16(int16_t* buf, size_t samples, int32_t gainQ16);
+void mixSaturate(int16_t* dst, const int16_t* src, size_t samples);
+void stereoToMono(const int16_t* in, int16_t* out, size_t frames);
+int64_t dot(const int16_t* a, const int16_t* b, size_t samples);
+
+}  // namespace simd
+
+#if DSP_HAS_SIMD
+namespace impl = simd;
+#else
+namespace impl = scalar;
+#endif
+
+inline void l16beToHost(const uint8_t* in, int16_t* out, size_t samples)
+{
+    impl::l16beToHost(in, out, samples);
+}
+
+inline void applyGainQ16(int16_t* buf, size_t samples, int32_t gainQ16)
+{
+    impl::applyGainQ16(buf, samples, gainQ16);
+}
+
+inline void mixSaturate(int16_t* dst, const int16_t* src, size_t samples)
+{
+    impl::mixSaturate(dst, src, samples);
+}
+
+inline void stereoToMono(const int16_t* in, int16_t* out, size_t frames)
+{
+    impl::stereoToMono(in, out, frames);
+}
+
+inline int64_t dot(const int16_t* a, const int16_t* b, size_t samples)
+{
+    return impl::dot(a, b, samples);
+}
+
+}  // namespace dsp
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief Packed 16-bit SIMD primitives (Armv8-M DSP extension)
+ *
+ * On a core with the DSP extension (Cortex-M33, __ARM_FEATURE_DSP) each
+ * helper is one CMSIS intrinsic, i.e. one instruction. Elsewhere (host
+ * builds, cores without DSP) they are bit-exact C emulations, so the
+ * SIMD kernels in dsp.cpp can be checked against the scalar reference on
+ * the host. A word holds two samples: element 0 in bits 15:0, element 1
+ * in bits 31:16 (little-endian load order).
+ */
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#include <cmsis_core.h>
+#define DSP_HAS_SIMD 1
+#else
+#define DSP_HAS_SIMD 0
+#endif
+
+namespace dsp_simd {
+
+// Unaligned word access; compiles to a single LDR/STR on the M33
+static inline uint32_t load32(const void* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void store32(void* p, uint32_t v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+#if DSP_HAS_SIMD
+
+static inline uint32_t rev16(uint32_t x) { return __REV16(x); }
+static inline uint32_t qadd16(uint32_t a, uint32_t b) { return __QADD16(a, b); }
+static inline int32_t smuad(uint32_t a, uint32_t b) { return static_cast<int32_t>(__SMUAD(a, b)); }
+static inline int64_t smlald(uint32_t a, uint32_t b, int64_t acc)
+{
+    return static_cast<int64_t>(__SMLALD(a, b, static_cast<uint64_t>(acc)));
+}
+static inline uint32_t pkhbt(uint32_t lo, uint32_t hi) { return __PKHBT(lo, hi, 16); }
+static inline int32_t ssat16(int32_t x) { return __SSAT(x, 16); }
+
+// (a * b[15:0]) >> 16 and (a * b[31:16]) >> 16; CMSIS has no wrapper for these
+static inline int32_t smulwb(int32_t a, uint32_t b)
+{
+    int32_t r;
+    __asm__("smulwb %0, %1, %2" : "=r"(r) : "r"(a), "r"(b));
+    return r;
+}
+
+static inline int32_t smulwt(int32_t a, uint32_t b)
+{
+    int32_t r;
+    __asm__("smulwt %0, %1, %2" : "=r"(r) : "r"(a), "r"(b));
+    return r;
+}
+
+#else
+
+static inline int32_t lo16(uint32_t x) { return static_cast<int16_t>(x & 0xFFFF); }
+static inline int32_t hi16(uint32_t x) { return static_cast<int16_t>(x >> 16); }
+
+static inline int32_t ssat16(int32_t x)
+{
+    return x > INT16_MAX ? INT16_MAX : (x < INT16_MIN ? INT16_MIN : x);
+}
+
+static inline uint32_t pack16(int32_t lo, int32_t hi)
+{
+    return (static_cast<uint32_t>(lo) & 0xFFFF) | (static_cast<uint32_t>(hi) << 16);
+}
+
+static inline uint32_t rev16(uint32_t x)
+{
+    return ((x & 0x00FF00FFu) << 8) | ((x >> 8) & 0x00FF00FFu);
+}
+
+static inline uint32_t qadd16(uint32_t a, uint32_t b)
+{
+    return pack16(ssat16(lo16(a) + lo16(b)), ssat16(hi16(a) + hi16(b)));
+}
+
+static inline int32_t smuad(uint32_t a, uint32_t b)
+{
+    // The hardware wraps on the one overflowing case (-32768^2 * 2)
+    return static_cast<int32_t>(static_cast<uint32_t>(lo16(a) * lo16(b)) +
+                                static_cast<uint32_t>(hi16(a) * hi16(b)));
+}
+
+static inline int64_t smlald(uint32_t a, uint32_t b, int64_t acc)
+{
+    return acc + static_cast<int64_t>(lo16(a) * lo16(b)) + static_cast<int64_t>(hi16(a) * hi16(b));
+}
+
+static inline uint32_t pkhbt(uint32_t lo, uint32_t hi) { return pack16(lo16(lo), lo16(hi)); }
+
+static inline int32_t smulwb(int32_t a, uint32_t b)
+{
+    return static_cast<int32_t>((static_cast<int64_t>(a) * lo16(b)) >> 16);
+}
+
+static inline int32_t smulwt(int32_t a, uint32_t b)
+{
+    return static_cast<int32_t>((static_cast<int64_t>(a) * hi16(b)) >> 16);
+}
+
+#endif
+
+}  // namespace dsp_simd
@@ -0,0 +1,254 @@
+#include "jitter_buffer.hpp"
+
+// Initial frame duration guess until the first in-order packet pair arrives
+#define JB_DEFAULT_FRAME_MS 20
+
+// Transit variations above this are treated as a clock jump, not jitter
+#define JB_MAX_TRANSIT_DELTA_US 1000000
+
+JitterBuffer::JitterBuffer(uint32_t clockRate, PacketPool& pool)
+    : m_clockRate(clockRate), m_pool(pool)
+{
+    reset();
+}
+
+void JitterBuffer::reset()
+{
+    for (auto& slot : m_slots) {
+        m_pool.free(slot.buf);
+        slot.buf = nullptr;
+    }
+
+    m_started = false;
+    m_playing = false;
+    m_havePlayed = false;
+    m_playSeq = 0;
+    m_newestSeq = 0;
+    m_count = 0;
+    m_targetDepth = kMinDepth;
+    m_windowMin = SIZE_MAX;
+    m_windowPops = 0;
+    m_nextTs = 0;
+
+    m_haveLast = false;
+    m_jitterUs16 = 0;
+    m_peakUs = 0;
+    m_frameTs = m_clockRate * JB_DEFAULT_FRAME_MS / 1000;
+    m_frameUs = JB_DEFAULT_FRAME_MS * 1000;
+
+    m_underruns = 0;
+    m_drops = 0;
+}
+
+uint32_t JitterBuffer::jitterTs() const
+{
+    return static_cast<uint32_t>((static_cast<uint64_t>(jitterUs()) * m_clockRate) / 1000000);
+}
+
+size_t JitterBuffer::depth() const
+{
+    if (!m_started) {
+        return 0;
+    }
+
+    int32_t span = static_cast<int16_t>(m_newestSeq - m_playSeq) + 1;
+    return span > 0 ? static_cast<size_t>(span) : 0;
+}
+
+void JitterBuffer::updateJitter(uint16_t sequence, uint32_t timestamp, uint32_t arrivalUs)
+{
+    if (m_haveLast) {
+        int32_t seqDelta = static_cast<int16_t>(sequence - m_lastSeq);
+        int32_t tsDelta = static_cast<int32_t>(timestamp - m_lastTs);
+        int32_t arrivalDelta = static_cast<int32_t>(arrivalUs - m_lastArrivalUs);
+        int64_t tsDeltaUs = (static_cast<int64_t>(tsDelta) * 1000000) / m_clockRate;
+
+        // D(i-1,i) from RFC 3550 section 6.4.1, in microseconds
+        int64_t d = arrivalDelta - tsDeltaUs;
+        uint32_t absD = static_cast<uint32_t>(d < 0 ? -d : d);
+
+        if (absD <= JB_MAX_TRANSIT_DELTA_US) {
+            // J += (|D| - J) / 16, J kept scaled by 16 (RFC 3550 A.8)
+            m_jitterUs16 += absD - ((m_jitterUs16 + 8) >> 4);
+
+            // Bursts: take the new peak at once, forget it over a few seconds
+            if (absD > m_peakUs) {
+                m_peakUs = absD;
+            } else {
+                m_peakUs -= m_peakUs >> 9;
+            }
+        }
+
+        if (seqDelta == 1 && tsDelta > 0 && tsDeltaUs < JB_MAX_TRANSIT_DELTA_US) {
+            m_frameTs = static_cast<uint32_t>(tsDelta);
+            m_frameUs = static_cast<uint32_t>(tsDeltaUs);
+        }
+    }
+
+    m_haveLast = true;
+    m_lastSeq = sequence;
+    m_lastTs = timestamp;
+    m_lastArrivalUs = arrivalUs;
+}
+
+void JitterBuffer::updateTarget()
+{
+    uint32_t spreadUs = 3 * jitterUs();
+    if (m_peakUs > spreadUs) {
+        spreadUs = m_peakUs;
+    }
+
+    // One frame in flight plus enough frames to cover the spread
+    size_t target = (spreadUs + m_frameUs - 1) / m_frameUs + 1;
+    if (target < kMinDepth) {
+        target = kMinDepth;
+    } else if (target > kMaxDepth) {
+        target = kMaxDepth;
+    }
+
+    m_targetDepth = target;
+}
+
+void JitterBuffer::release(uint16_t sequence)
+{
+    Slot& slot = slotFor(sequence);
+    if (slot.buf && slot.sequence == sequence) {
+        m_pool.free(slot.buf);
+        slot.buf = nullptr;
+        m_count--;
+    }
+}
+
+JitterBuffer::PushResult JitterBuffer::push(uint16_t sequence, uint32_t timestamp,
+                                            PacketBuf* buf, const uint8_t* payload,
+                                            size_t length, uint32_t arrivalUs)
+{
+    updateJitter(sequence, timestamp, arrivalUs);
+    updateTarget();
+
+    PushResult result = PushResult::Queued;
+
+    if (!m_started) {
+        m_started = true;
+        m_playSeq = sequence;
+        m_newestSeq = sequence;
+    }
+
+    int32_t ahead = static_cast<int16_t>(sequence - m_playSeq);
+
+    if (ahead < 0) {
+        // Before the first playout a reordered start can still move back
+        uint16_t behindNewest = static_cast<uint16_t>(m_newestSeq - sequence);
+        if (m_havePlayed || behindNewest > kMaxDepth) {
+            m_pool.free(buf);
+            return PushResult::Late;
+        }
+        m_playSeq = sequence;
+        ahead = 0;
+    } else if (static_cast<size_t>(ahead) >= kSlots) {
+        // Sender restarted or we stalled for longer than the window
+        for (auto& slot : m_slots) {
+            m_pool.free(slot.buf);
+            slot.buf = nullptr;
+        }
+        m_count = 0;
+        m_playing = false;
+        m_havePlayed = false;
+        m_playSeq = sequence;
+        m_newestSeq = sequence;
+        result = PushResult::Resync;
+    }
+
+    Slot& slot = slotFor(sequence);
+    if (slot.buf) {
+        // Slots older than the playout point are released before reuse
+        m_pool.free(buf);
+        return PushResult::Duplicate;
+    }
+
+    slot.buf = buf;
+    slot.sequence = sequence;
+    slot.timestamp = timestamp;
+    slot.payload = payload;
+    slot.length = length;
+    m_count++;
+
+    if (static_cast<int16_t>(sequence - m_newestSeq) > 0) {
+        m_newestSeq = sequence;
+    }
+
+    // Hard latency cap, independent of the slow adaptation in pop()
+    while (depth() > kMaxDepth) {
+        release(m_playSeq);
+        m_playSeq++;
+        m_drops++;
+    }
+
+    return result;
+}
+
+JitterBuffer::PopResult JitterBuffer::pop(Frame* frame)
+{
+    size_t d = depth();
+
+    if (!m_playing) {
+        if (d == 0 || d < m_targetDepth) {
+            return PopResult::Empty;
+        }
+        m_playing = true;
+        m_windowMin = SIZE_MAX;
+        m_windowPops = 0;
+    }
+
+    if (d == 0) {
+        // Underrun: re-buffer up to the (possibly larger) target
+        m_playing = false;
+        m_underruns++;
+        return PopResult::Empty;
+    }
+
+    if (d < m_windowMin) {
+        m_windowMin = d;
+    }
+
+    // Shrink by one frame when the buffer never ran below target all window
+    if (++m_windowPops >= kAdaptWindow) {
+        if (m_windowMin > m_targetDepth && d > 1) {
+            Slot& dropped = slotFor(m_playSeq);
+            if (dropped.buf && dropped.sequence == m_playSeq) {
+                m_nextTs = dropped.timestamp + m_frameTs;
+            } else {
+                m_nextTs += m_frameTs;
+            }
+            release(m_playSeq);
+            m_playSeq++;
+            m_drops++;
+        }
+        m_windowPops = 0;
+        m_windowMin = SIZE_MAX;
+    }
+
+    Slot& slot = slotFor(m_playSeq);
+    frame->sequence = m_playSeq;
+    m_playSeq++;
+    m_havePlayed = true;
+
+    if (slot.buf && slot.sequence == frame->sequence) {
+        // Ownership of the block moves to the caller
+        frame->timestamp = slot.timestamp;
+        frame->buf = slot.buf;
+        frame->payload = slot.payload;
+        frame->length = slot.length;
+        slot.buf = nullptr;
+        m_count--;
+        m_nextTs = slot.timestamp + m_frameTs;
+        return PopResult::Frame;
+    }
+
+    frame->timestamp = m_nextTs;
+    frame->buf = nullptr;
+    frame->payload = nullptr;
+    frame->length = 0;
+    m_nextTs += m_frameTs;
+    return PopResult::Lost;
+}
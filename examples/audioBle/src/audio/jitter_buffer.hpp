@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "../net/packet_pool.hpp"
+
+// Defaults for builds without Kconfig (host tools); see audioBle/Kconfig
+#ifndef CONFIG_RTP_JITTER_BUFFER_SLOTS
+#define CONFIG_RTP_JITTER_BUFFER_SLOTS 16
+#endif
+#ifndef CONFIG_RTP_JITTER_BUFFER_MIN_DEPTH
+#define CONFIG_RTP_JITTER_BUFFER_MIN_DEPTH 2
+#endif
+#ifndef CONFIG_RTP_JITTER_BUFFER_MAX_DEPTH
+#define CONFIG_RTP_JITTER_BUFFER_MAX_DEPTH 12
+#endif
+
+/**
+ * @brief Fixed-capacity, sequence-ordered adaptive jitter buffer
+ *
+ * Packets are stored by sequence number in a power-of-two slot array, so
+ * insertion is O(1) regardless of reordering. Slots hold PacketPool blocks,
+ * not copies: push() takes ownership of the block, pop() hands it on. The
+ * playout side is pulled once per frame period and always advances by
+ * exactly one sequence number.
+ *
+ * The target depth adapts to the measured network behaviour:
+ * - RFC 3550 interarrival jitter (smoothed with gain 1/16)
+ * - A fast-attack, slow-decay peak of the transit-time variation, which
+ *   tracks WiFi power-save bursts that the RFC estimator averages away
+ *
+ * The buffer grows by re-buffering to the target after an underrun and
+ * shrinks by dropping at most one frame per adaptation window while the
+ * minimum observed depth stays above the target.
+ *
+ * Not thread-safe: push() and pop() must run on the same thread.
+ */
+class JitterBuffer {
+public:
+    static constexpr size_t kSlots = CONFIG_RTP_JITTER_BUFFER_SLOTS;
+    static constexpr size_t kMinDepth = CONFIG_RTP_JITTER_BUFFER_MIN_DEPTH;
+    static constexpr size_t kMaxDepth = CONFIG_RTP_JITTER_BUFFER_MAX_DEPTH;
+
+    static_assert((kSlots & (kSlots - 1)) == 0, "slot count must be a power of two");
+    static_assert(kMinDepth >= 1 && kMinDepth <= kMaxDepth, "invalid depth limits");
+    static_assert(kMaxDepth < kSlots, "max depth must leave room for reordering");
+
+    enum class PushResult {
+        Queued,     // Stored for playout
+        Duplicate,  // Same sequence number already buffered
+        Late,       // Playout already passed this sequence number
+        Resync,     // Sequence jumped out of the window, buffer restarted
+    };
+
+    enum class PopResult {
+        Frame,      // Frame is valid
+        Lost,       // Sequence number missing at playout time - conceal
+        Empty,      // Buffering (start-up or after underrun) - nothing to play
+    };
+
+    struct Frame {
+        uint16_t sequence;
+        uint32_t timestamp;
+        PacketBuf* buf;          // Owned by the caller now, nullptr for Lost
+        const uint8_t* payload;  // Points into buf
+        size_t length;
+    };
+
+    /**
+     * @param clockRate RTP media clock rate in Hz (e.g. 16000 for L16 mono)
+     * @param pool Pool that rejected and dropped blocks are returned to
+     */
+    JitterBuffer(uint32_t clockRate, PacketPool& pool);
+
+    /**
+     * @brief Release all buffered packets and forget the jitter history
+     */
+    void reset();
+
+    /**
+     * @brief Insert a parsed RTP packet
+     * @param sequence RTP sequence number
+     * @param timestamp RTP timestamp
+     * @param buf Pool block holding the datagram, always consumed
+     * @param payload Payload data inside buf
+     * @param length Payload length in bytes
+     * @param arrivalUs Arrival time in microseconds (free-running, may wrap)
+     */
+    PushResult push(uint16_t sequence, uint32_t timestamp, PacketBuf* buf,
+                    const uint8_t* payload, size_t length, uint32_t arrivalUs);
+
+    /**
+     * @brief Take the next frame for playout, call once per frame period
+     * @param frame Output frame (sequence/timestamp also set for Lost);
+     *              the caller must free frame->buf back to the pool
+     */
+    PopResult pop(Frame* frame);
+
+    /**
+     * @brief Frames between the playout point and the newest packet
+     */
+    size_t depth() const;
+
+    size_t targetDepth() const { return m_targetDepth; }
+    bool isPlaying() const { return m_playing; }
+
+    /**
+     * @brief RFC 3550 interarrival jitter in microseconds
+     */
+    uint32_t jitterUs() const { return m_jitterUs16 >> 4; }
+
+    /**
+     * @brief RFC 3550 interarrival jitter in RTP timestamp units
+     */
+    uint32_t jitterTs() const;
+
+    /**
+     * @brief Frame duration learned from the timestamp increments
+     */
+    uint32_t frameDurationUs() const { return m_frameUs; }
+
+    uint32_t underruns() const { return m_underruns; }
+    uint32_t drops() const { return m_drops; }
+
+private:
+    struct Slot {
+        PacketBuf* buf;  // nullptr when empty
+        uint16_t sequence;
+        uint32_t timestamp;
+        const uint8_t* payload;
+        size_t length;
+    };
+
+    // Pops per adaptation window (about 1 s at 20 ms frames)
+    static constexpr uint32_t kAdaptWindow = 50;
+
+    Slot& slotFor(uint16_t sequence) { return m_slots[sequence & (kSlots - 1)]; }
+    void updateJitter(uint16_t sequence, uint32_t timestamp, uint32_t arrivalUs);
+    void updateTarget();
+    void release(uint16_t sequence);
+
+    Slot m_slots[kSlots] = {};
+    const uint32_t m_clockRate;
+    PacketPool& m_pool;
+
+    // Playout state
+    bool m_started = false;
+    bool m_playing = false;
+    bool m_havePlayed = false;
+    uint16_t m_playSeq = 0;
+    uint16_t m_newestSeq = 0;
+    size_t m_count = 0;
+    size_t m_targetDepth = kMinDepth;
+    size_t m_windowMin = SIZE_MAX;
+    uint32_t m_windowPops = 0;
+    uint32_t m_nextTs = 0;
+
+    // Jitter estimation (arrival order)
+    bool m_haveLast = false;
+    uint16_t m_lastSeq = 0;
+    uint32_t m_lastTs = 0;
+    uint32_t m_lastArrivalUs = 0;
+    uint32_t m_jitterUs16 = 0;  // RFC 3550 J, scaled by 16
+    uint32_t m_peakUs = 0;      // Peak transit variation, slow decay
+    uint32_t m_frameTs = 0;
+    uint32_t m_frameUs = 0;
+
+    uint32_t m_underruns = 0;
+    uint32_t m_drops = 0;
+};
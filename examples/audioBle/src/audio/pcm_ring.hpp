@@ -0,0 +1,239 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <atomic>
+
+// Defaults for builds without Kconfig (host tools); see audioBle/Kconfig
+#ifndef CONFIG_AUDIO_PCM_RING_SAMPLES
+#define CONFIG_AUDIO_PCM_RING_SAMPLES 4096
+#endif
+
+/**
+ * @brief Lock-free single-producer/single-consumer ring of PCM samples
+ *
+ * The producer (RTP receive thread) only writes m_head, the consumer
+ * (I2S/LE Audio thread or ISR) only writes m_tail; both are free-running
+ * counters, so full/empty need no extra flag. No k_mutex, no blocking -
+ * safe to drain from an ISR.
+ *
+ * Writes that do not fit are truncated and counted as overruns, reads that
+ * find too few samples are short and counted as underruns. Fill-level
+ * watermarks show how much of the ring is actually used in the field.
+ *
+ * @tparam Capacity Ring size in samples, must be a power of two
+ */
+template <size_t Capacity>
+class PcmRing {
+public:
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "PCM ring capacity must be a power of two");
+
+    static constexpr size_t capacity() { return Capacity; }
+
+    // --- Producer side ---
+
+    /**
+     * @brief Copy samples into the ring
+     * @return Number of samples written (less than count on overrun)
+     */
+    size_t write(const int16_t* samples, size_t count)
+    {
+        int16_t* span;
+        size_t done = 0;
+
+        // At most two spans: up to the end of the storage, then from the start
+        while (done < count) {
+            size_t n = writeSpan(&span);
+            if (n == 0) {
+                break;
+            }
+            if (n > count - done) {
+                n = count - done;
+            }
+            memcpy(span, samples + done, n * sizeof(int16_t));
+            commitWrite(n);
+            done += n;
+        }
+
+        if (done < count) {
+            noteOverrun(count - done);
+        }
+        return done;
+    }
+
+    /**
+     * @brief Get contiguous free space for in-place decoding
+     * @param span Output pointer to the first free sample
+     * @return Number of contiguous free samples (0 when full)
+     */
+    size_t writeSpan(int16_t** span)
+    {
+        uint32_t head = m_head.load(std::memory_order_relaxed);
+        uint32_t tail = m_tail.load(std::memory_order_acquire);
+        size_t idx = head & (Capacity - 1);
+        size_t space = Capacity - (head - tail);
+        size_t contiguous = Capacity - idx;
+
+        *span = &m_data[idx];
+        return space < contiguous ? space : contiguous;
+    }
+
+    /**
+     * @brief Publish samples written through writeSpan()
+     */
+    void commitWrite(size_t count)
+    {
+        uint32_t head = m_head.load(std::memory_order_relaxed) + count;
+        m_head.store(head, std::memory_order_release);
+
+        uint32_t fill = head - m_tail.load(std::memory_order_relaxed);
+        if (fill > m_high_water.load(std::memory_order_relaxed)) {
+            m_high_water.store(fill, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Record samples the producer had to drop
+     */
+    void noteOverrun(size_t dropped)
+    {
+        m_overruns.store(m_overruns.load(std::memory_order_relaxed) + 1,
+                         std::memory_order_relaxed);
+        m_dropped.store(m_dropped.load(std::memory_order_relaxed) + dropped,
+                        std::memory_order_relaxed);
+    }
+
+    // --- Consumer side ---
+
+    /**
+     * @brief Copy samples out of the ring
+     * @return Number of samples read (less than count on underrun)
+     */
+    size_t read(int16_t* samples, size_t count)
+    {
+        const int16_t* span;
+        size_t done = 0;
+
+        while (done < count) {
+            size_t n = readSpan(&span);
+            if (n == 0) {
+                break;
+            }
+            if (n > count - done) {
+                n = count - done;
+            }
+            memcpy(samples + done, span, n * sizeof(int16_t));
+            commitRead(n);
+            done += n;
+        }
+
+        if (done < count) {
+            noteUnderrun(count - done);
+        }
+        return done;
+    }
+
+    /**
+     * @brief Get contiguous readable samples for in-place consumption
+     * @param span Output pointer to the oldest sample
+     * @return Number of contiguous readable samples (0 when empty)
+     */
+    size_t readSpan(const int16_t** span)
+    {
+        uint32_t tail = m_tail.load(std::memory_order_relaxed);
+        uint32_t head = m_head.load(std::memory_order_acquire);
+        size_t idx = tail & (Capacity - 1);
+        size_t avail = head - tail;
+        size_t contiguous = Capacity - idx;
+
+        *span = &m_data[idx];
+        return avail < contiguous ? avail : contiguous;
+    }
+
+    /**
+     * @brief Release samples consumed through readSpan()
+     */
+    void commitRead(size_t count)
+    {
+        uint32_t tail = m_tail.load(std::memory_order_relaxed) + count;
+        m_tail.store(tail, std::memory_order_release);
+
+        uint32_t fill = m_head.load(std::memory_order_relaxed) - tail;
+        if (fill < m_low_water.load(std::memory_order_relaxed)) {
+            m_low_water.store(fill, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Record samples the consumer had to make up (silence/PLC)
+     */
+    void noteUnderrun(size_t missing)
+    {
+        m_underruns.store(m_underruns.load(std::memory_order_relaxed) + 1,
+                          std::memory_order_relaxed);
+        m_missing.store(m_missing.load(std::memory_order_relaxed) + missing,
+                        std::memory_order_relaxed);
+    }
+
+    // --- Either side ---
+
+    /**
+     * @brief Samples currently buffered (a snapshot when called concurrently)
+     */
+    size_t fillLevel() const
+    {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+
+    uint32_t overruns() const { return m_overruns.load(std::memory_order_relaxed); }
+    uint32_t droppedSamples() const { return m_dropped.load(std::memory_order_relaxed); }
+    uint32_t underruns() const { return m_underruns.load(std::memory_order_relaxed); }
+    uint32_t missingSamples() const { return m_missing.load(std::memory_order_relaxed); }
+    uint32_t highWater() const { return m_high_water.load(std::memory_order_relaxed); }
+    uint32_t lowWater() const { return m_low_water.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Clear counters and watermarks (samples are kept)
+     *
+     * Counters are owned by their side; call while the ring is idle or
+     * accept that an update racing with the reset may be lost.
+     */
+    void resetStats()
+    {
+        m_overruns.store(0, std::memory_order_relaxed);
+        m_dropped.store(0, std::memory_order_relaxed);
+        m_underruns.store(0, std::memory_order_relaxed);
+        m_missing.store(0, std::memory_order_relaxed);
+        m_high_water.store(fillLevel(), std::memory_order_relaxed);
+        m_low_water.store(Capacity, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Discard all samples; only call while neither side is active
+     */
+    void clear()
+    {
+        m_tail.store(m_head.load(std::memory_order_relaxed), std::memory_order_release);
+        resetStats();
+    }
+
+private:
+    alignas(4) int16_t m_data[Capacity] = {};
+
+    // Producer-owned
+    std::atomic<uint32_t> m_head{0};
+    std::atomic<uint32_t> m_overruns{0};
+    std::atomic<uint32_t> m_dropped{0};
+    std::atomic<uint32_t> m_high_water{0};
+
+    // Consumer-owned
+    std::atomic<uint32_t> m_tail{0};
+    std::atomic<uint32_t> m_underruns{0};
+    std::atomic<uint32_t> m_missing{0};
+    std::atomic<uint32_t> m_low_water{Capacity};
+};
+
+// Ring between the RTP receiver and the audio consumer
+using AudioPcmRing = PcmRing<CONFIG_AUDIO_PCM_RING_SAMPLES>;
@@ -0,0 +1,157 @@
+#include "plc.hpp"
+#include "dsp.hpp"
+#include <cstring>
+
+void Plc::reset()
+{
+    memset(m_history, 0, sizeof(m_history));
+    m_concealing = false;
+    m_pitch = kMaxPitch;
+    m_phase = 0;
+    m_concealed = 0;
+}
+
+void Plc::appendHistory(const int16_t* pcm, size_t n)
+{
+    if (n >= kHistory) {
+        memcpy(m_history, pcm + n - kHistory, sizeof(m_history));
+        return;
+    }
+
+    memmove(m_history, m_history + n, (kHistory - n) * sizeof(int16_t));
+    memcpy(m_history + kHistory - n, pcm, n * sizeof(int16_t));
+}
+
+size_t Plc::findPitch() const
+{
+#ifdef CONFIG_AUDIO_PLC_PITCH_SEARCH
+    // Coarse search on a 2:1 decimated copy: a quarter of the multiplies
+    constexpr size_t kDecLen = kHistory / 2;
+    constexpr size_t kDecWindow = kCorrLen / 2;
+    int16_t dec[kDecLen];
+    dsp::stereoToMono(m_history, dec, kDecLen);  // Pairwise average
+
+    // Maximise corr^2 / energy with positive correlation (normalised match
+    // of the newest 10 ms against the same window one lag earlier)
+    const int16_t* ref = dec + kDecLen - kDecWindow;
+    size_t bestLag = 0;
+    float bestScore = 0.0f;
+    for (size_t lag = kMinPitch / 2; lag <= kMaxPitch / 2; lag++) {
+        const int16_t* cand = ref - lag;
+        int64_t corr = dsp::dot(ref, cand, kDecWindow);
+        int64_t energy = dsp::dot(cand, cand, kDecWindow);
+        if (corr <= 0 || energy == 0) {
+            continue;
+        }
+
+        float score = static_cast<float>(corr) * static_cast<float>(corr) /
+                      static_cast<float>(energy);
+        if (score > bestScore) {
+            bestScore = score;
+            bestLag = lag;
+        }
+    }
+
+    if (bestLag == 0) {
+        // Silence or noise without any periodicity
+        return kMaxPitch;
+    }
+
+    // Refine +-1 sample around the coarse result at full rate
+    const int16_t* fullRef = m_history + kHistory - kCorrLen;
+    size_t pitch = 2 * bestLag;
+    bestScore = 0.0f;
+    for (size_t lag = 2 * bestLag - 1; lag <= 2 * bestLag + 1; lag++) {
+        if (lag < kMinPitch || lag > kMaxPitch) {
+            continue;
+        }
+        const int16_t* cand = fullRef - lag;
+        int64_t corr = dsp::dot(fullRef, cand, kCorrLen);
+        int64_t energy = dsp::dot(cand, cand, kCorrLen);
+        if (corr <= 0 || energy == 0) {
+            continue;
+        }
+
+        float score = static_cast<float>(corr) * static_cast<float>(corr) /
+                      static_cast<float>(energy);
+        if (score > bestScore) {
+            bestScore = score;
+            pitch = lag;
+        }
+    }
+    return pitch;
+#else
+    return kMaxPitch;
+#endif
+}
+
+void Plc::preparePeriod()
+{
+    const size_t p = m_pitch;
+    const size_t ola = p / 4;
+
+    memcpy(m_period, m_history + kHistory - p, p * sizeof(int16_t));
+
+    // Blend the end of the period towards the samples that precede its
+    // start, so wrapping from m_period[p - 1] to m_period[0] is continuous
+    const int16_t* pre = m_history + kHistory - p - ola;
+    for (size_t j = 0; j < ola; j++) {
+        int32_t wPre = static_cast<int32_t>(j + 1);
+        int32_t wEnd = static_cast<int32_t>(ola - j);
+        m_period[p - ola + j] = static_cast<int16_t>(
+            (m_period[p - ola + j] * wEnd + pre[j] * wPre) / static_cast<int32_t>(ola + 1));
+    }
+}
+
+int16_t Plc::nextSample()
+{
+    int32_t s = m_period[m_phase];
+    if (++m_phase >= m_pitch) {
+        m_phase = 0;
+    }
+
+    // Full level, then a linear fade, then silence
+    uint32_t n = m_concealed++;
+    if (n < kFullLevel) {
+        return static_cast<int16_t>(s);
+    }
+    if (n >= kFullLevel + kFadeLen) {
+        return 0;
+    }
+    int32_t gain = static_cast<int32_t>(((kFullLevel + kFadeLen - n) << 15) / kFadeLen);
+    return static_cast<int16_t>((s * gain) >> 15);
+}
+
+void Plc::conceal(int16_t* out, size_t n)
+{
+    if (!m_concealing) {
+        // First loss of a burst: the only place the pitch search runs
+        m_pitch = findPitch();
+        preparePeriod();
+        m_phase = 0;
+        m_concealed = 0;
+        m_concealing = true;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        out[i] = nextSample();
+    }
+
+    appendHistory(out, n);
+}
+
+void Plc::onGoodFrame(int16_t* pcm, size_t n)
+{
+    if (m_concealing) {
+        // Fade from the concealment into the real signal
+        size_t ola = n < kRecoveryOla ? n : kRecoveryOla;
+        for (size_t i = 0; i < ola; i++) {
+            int32_t c = nextSample();
+            int32_t w = static_cast<int32_t>(((i + 1) << 15) / (ola + 1));
+            pcm[i] = static_cast<int16_t>((c * ((1 << 15) - w) + pcm[i] * w) >> 15);
+        }
+        m_concealing = false;
+    }
+
+    appendHistory(pcm, n);
+}
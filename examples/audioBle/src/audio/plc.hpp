@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// Defaults for builds without Kconfig (host tools); see audioBle/Kconfig
+#ifndef CONFIG_RTP_CLOCK_RATE
+#define CONFIG_RTP_CLOCK_RATE 16000
+#endif
+
+/**
+ * @brief Packet loss concealment for mono 16-bit PCM (waveform repeat)
+ *
+ * On the first lost frame of a burst the pitch period of the recent
+ * history is estimated with a normalised autocorrelation (coarse search on
+ * a 2:1 decimated signal, refined at full rate). The last period is then
+ * repeated, with its loop point crossfaded so the repetition has no
+ * discontinuity. Concealment plays at full level for 10 ms, fades out
+ * linearly over the next 50 ms and stays silent after that. When real audio
+ * returns, its first 4 ms are crossfaded from the concealed signal.
+ *
+ * The cost is bounded: one pitch search per loss burst (fixed lag range and
+ * window), and O(n) work per frame otherwise. Without
+ * CONFIG_AUDIO_PLC_PITCH_SEARCH the period is fixed at the maximum pitch
+ * (20 ms) and the search is skipped.
+ *
+ * Not thread-safe: call from the playout thread only.
+ */
+class Plc {
+public:
+    static constexpr uint32_t kSampleRate = CONFIG_RTP_CLOCK_RATE;
+    static constexpr size_t kMinPitch = kSampleRate / 400;     // 2.5 ms (400 Hz)
+    static constexpr size_t kMaxPitch = kSampleRate / 50;      // 20 ms (50 Hz)
+    static constexpr size_t kCorrLen = kSampleRate / 100;      // 10 ms match window
+    static constexpr size_t kHistory = kMaxPitch + kCorrLen;
+    static constexpr size_t kRecoveryOla = kSampleRate / 250;  // 4 ms
+    static constexpr size_t kFullLevel = kSampleRate / 100;    // 10 ms before fading
+    static constexpr size_t kFadeLen = kSampleRate / 20;       // 50 ms fade to silence
+
+    Plc() { reset(); }
+
+    /**
+     * @brief Forget the history (stream restart)
+     */
+    void reset();
+
+    /**
+     * @brief Account a correctly received frame
+     *
+     * If the previous frame was concealed, the start of pcm is crossfaded
+     * in place from the concealment so the transition is smooth.
+     * @param pcm Decoded samples, modified in place on recovery
+     * @param n Number of samples
+     */
+    void onGoodFrame(int16_t* pcm, size_t n);
+
+    /**
+     * @brief Synthesize a frame in place of a lost one
+     * @param out Output samples
+     * @param n Number of samples
+     */
+    void conceal(int16_t* out, size_t n);
+
+    /**
+     * @brief Pitch period used for the current/last concealment, in samples
+     */
+    size_t pitch() const { return m_pitch; }
+
+private:
+    size_t findPitch() const;
+    void preparePeriod();
+    int16_t nextSample();
+    void appendHistory(const int16_t* pcm, size_t n);
+
+    int16_t m_history[kHistory];
+    int16_t m_period[kMaxPitch];  // Last pitch period with a smoothed loop point
+
+    bool m_concealing = false;
+    size_t m_pitch = kMaxPitch;
+    size_t m_phase = 0;           // Read position in m_period
+    uint32_t m_concealed = 0;     // Samples synthesized in the current burst
+};
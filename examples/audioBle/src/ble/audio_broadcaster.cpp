@@ -0,0 +1,229 @@
+#include "audio_broadcaster.hpp"
+#include <zephyr/logging/log.h>
+#include "../trace/cycle_counter.hpp"
+#include "../util/log_throttle.hpp"
+#include <cerrno>
+#include <cstring>
+
+LOG_MODULE_REGISTER(audio_broadcaster, LOG_LEVEL_INF);
+
+#define BROADCAST_THREAD_STACK_SIZE 4096
+
+// Samples buffered before the first real frame is encoded
+#define BROADCAST_PREFILL_SAMPLES (Lc3Encoder::kSampleRate / 1000 * CONFIG_AUDIO_BROADCAST_PREFILL_MS)
+
+static_assert(CONFIG_RTP_CLOCK_RATE == Lc3Encoder::kSampleRate,
+              "The broadcast encodes the PCM ring as-is; RTP_CLOCK_RATE must match the LC3 preset");
+static_assert(BROADCAST_PREFILL_SAMPLES + Lc3Encoder::kFrameSamples <= CONFIG_AUDIO_PCM_RING_SAMPLES,
+              "AUDIO_BROADCAST_PREFILL_MS does not fit in the PCM ring");
+static_assert(CONFIG_AUDIO_BROADCAST_THREAD_PRIORITY < CONFIG_RTP_RX_THREAD_PRIORITY,
+              "The LC3 encoder must preempt the RTP receive thread");
+
+static K_THREAD_STACK_DEFINE(broadcast_thread_stack, BROADCAST_THREAD_STACK_SIZE);
+static struct k_thread broadcast_thread_data;
+
+AudioBroadcaster::AudioBroadcaster(AudioPcmRing& ring)
+    : m_ring(ring)
+{
+    k_sem_init(&m_credits, 0, BroadcastSource::kSdusInFlight);
+    m_source.setSentCallback(onSduSent, this);
+    cycle_counter_init();
+}
+
+void AudioBroadcaster::onSduSent(void* ctx)
+{
+    AudioBroadcaster* self = static_cast<AudioBroadcaster*>(ctx);
+    k_sem_give(&self->m_credits);
+}
+
+int AudioBroadcaster::start()
+{
+    if (isRunning()) {
+        return 0;
+    }
+
+    k_sem_reset(&m_credits);
+    m_prefilled = false;
+
+    int ret = m_source.start();
+    if (ret < 0) {
+        return ret;
+    }
+
+    if (!m_thread_id) {
+        // Above the RTP receive thread: encoding is short and has a hard
+        // 10 ms deadline, receiving has the jitter buffer as slack
+        m_thread_id = k_thread_create(&broadcast_thread_data, broadcast_thread_stack,
+                                      K_THREAD_STACK_SIZEOF(broadcast_thread_stack),
+                                      encoderThread,
+                                      this, NULL, NULL,
+                                      CONFIG_AUDIO_BROADCAST_THREAD_PRIORITY, 0, K_NO_WAIT);
+        k_thread_name_set(m_thread_id, "lc3_encoder");
+    }
+
+    m_running.store(true, std::memory_order_release);
+    LOG_INF("Audio broadcast started (broadcast ID 0x%06x)", m_source.broadcastId());
+    return 0;
+}
+
+void AudioBroadcaster::stop()
+{
+    if (!isRunning()) {
+        return;
+    }
+
+    m_running.store(false, std::memory_order_release);
+    m_source.stop();
+
+    // Wake the thread if it waits for a credit; it goes back to waiting
+    k_sem_give(&m_credits);
+    LOG_INF("Audio broadcast stopped");
+}
+
+void AudioBroadcaster::encoderThread(void* arg1, void* arg2, void* arg3)
+{
+    static_cast<AudioBroadcaster*>(arg1)->run();
+}
+
+void AudioBroadcaster::run()
+{
+    while (true) {
+        k_sem_take(&m_credits, K_FOREVER);
+
+        applyPendingReset();
+        if (!isRunning() || !m_source.isStreaming()) {
+            m_sdu_pending = false;
+            continue;
+        }
+
+        // A frame the source refused is sent again before the ring is read
+        if (!m_sdu_pending) {
+            encodeFrame();
+        }
+        sendSdu();
+    }
+}
+
+void AudioBroadcaster::encodeFrame()
+{
+    size_t fill = m_ring.fillLevel();
+    bool silent = false;
+
+    if (!m_prefilled) {
+        if (fill < BROADCAST_PREFILL_SAMPLES) {
+            silent = true;
+        } else {
+            m_prefilled = true;
+        }
+    }
+
+    if (silent) {
+        memset(m_pcm, 0, sizeof(m_pcm));
+        set(m_silent_frames, m_silent_frames.load(std::memory_order_relaxed) + 1);
+    } else {
+        // The oldest sample has waited for the whole fill level
+        uint32_t ring_us = fill * 1000000u / Lc3Encoder::kSampleRate;
+        uint32_t reads = m_frames.load(std::memory_order_relaxed) -
+                         m_silent_frames.load(std::memory_order_relaxed) + 1;
+        m_ring_sum_us += ring_us;
+        set(m_ring_avg_us, static_cast<uint32_t>(m_ring_sum_us / reads));
+        if (ring_us > m_ring_max_us.load(std::memory_order_relaxed)) {
+            set(m_ring_max_us, ring_us);
+        }
+
+        // A short read is counted as a ring underrun; pad it with silence
+        size_t got = m_ring.read(m_pcm, Lc3Encoder::kFrameSamples);
+        if (got < Lc3Encoder::kFrameSamples) {
+            memset(&m_pcm[got], 0, (Lc3Encoder::kFrameSamples - got) * sizeof(int16_t));
+        }
+    }
+
+    uint32_t start_cyc = cycle_counter_get();
+    int ret = m_encoder.encode(m_pcm, m_sdu);
+    uint32_t ns = cycle_counter_to_ns(cycle_counter_get() - start_cyc);
+
+    uint32_t frames = m_frames.load(std::memory_order_relaxed) + 1;
+    m_encode_sum_ns += ns;
+    set(m_encode_avg_ns, static_cast<uint32_t>(m_encode_sum_ns / frames));
+    if (ns < m_encode_min_ns.load(std::memory_order_relaxed)) {
+        set(m_encode_min_ns, ns);
+    }
+    if (ns > m_encode_max_ns.load(std::memory_order_relaxed)) {
+        set(m_encode_max_ns, ns);
+    }
+
+    if (ret < 0) {
+        // No SDU for this credit; give it back so pacing continues
+        set(m_send_errors, m_send_errors.load(std::memory_order_relaxed) + 1);
+        LOG_DBG_THROTTLED("LC3 encode failed: %d", ret);
+        k_sem_give(&m_credits);
+        k_sleep(K_MSEC(1));
+    } else {
+        m_sdu_pending = true;
+    }
+
+    set(m_frames, frames);
+}
+
+void AudioBroadcaster::sendSdu()
+{
+    if (!m_sdu_pending) {
+        return;
+    }
+
+    int ret = m_source.send(m_sdu, sizeof(m_sdu));
+    if (ret == 0 || ret == -ENOTCONN) {
+        // Sent, or the stream is gone and the frame with it
+        m_sdu_pending = false;
+    }
+    if (ret < 0) {
+        set(m_send_errors, m_send_errors.load(std::memory_order_relaxed) + 1);
+        LOG_DBG_THROTTLED("SDU send failed: %d", ret);
+        if (ret != -ENOTCONN) {
+            // Kept for the next pass; give the credit back so it comes soon
+            k_sem_give(&m_credits);
+            k_sleep(K_MSEC(1));
+        }
+    }
+}
+
+void AudioBroadcaster::resetStats()
+{
+    m_source.resetStats();
+    m_reset_requested.store(true, std::memory_order_release);
+}
+
+void AudioBroadcaster::applyPendingReset()
+{
+    if (!m_reset_requested.load(std::memory_order_acquire)) {
+        return;
+    }
+    m_reset_requested.store(false, std::memory_order_relaxed);
+
+    m_encode_sum_ns = 0;
+    m_ring_sum_us = 0;
+    set(m_frames, 0);
+    set(m_silent_frames, 0);
+    set(m_send_errors, 0);
+    set(m_encode_min_ns, UINT32_MAX);
+    set(m_encode_avg_ns, 0);
+    set(m_encode_max_ns, 0);
+    set(m_ring_avg_us, 0);
+    set(m_ring_max_us, 0);
+}
+
+void AudioBroadcaster::snapshot(Snapshot* out) const
+{
+    uint32_t encode_min = m_encode_min_ns.load(std::memory_order_relaxed);
+
+    out->frames = m_frames.load(std::memory_order_relaxed);
+    out->silent_frames = m_silent_frames.load(std::memory_order_relaxed);
+    out->send_errors = m_send_errors.load(std::memory_order_relaxed);
+    out->encode_min_ns = encode_min == UINT32_MAX ? 0 : encode_min;
+    out->encode_avg_ns = m_encode_avg_ns.load(std::memory_order_relaxed);
+    out->encode_max_ns = m_encode_max_ns.load(std::memory_order_relaxed);
+    out->ring_avg_us = m_ring_avg_us.load(std::memory_order_relaxed);
+    out->ring_max_us = m_ring_max_us.load(std::memory_order_relaxed);
+    out->iso_avg_us = m_source.sendLatencyAvgUs();
+    out->iso_max_us = m_source.sendLatencyMaxUs();
+}
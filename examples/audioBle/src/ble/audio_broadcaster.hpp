@@ -0,0 +1,110 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include "broadcast_source.hpp"
+#include "lc3_encoder.hpp"
+#include "../audio/pcm_ring.hpp"
+
+// Defaults for builds without Kconfig (host tools); see audioBle/Kconfig
+#ifndef CONFIG_AUDIO_BROADCAST_PREFILL_MS
+#define CONFIG_AUDIO_BROADCAST_PREFILL_MS 20
+#endif
+
+/**
+ * @brief PCM ring -> LC3 -> BIS pipeline
+ *
+ * A dedicated thread takes one 10 ms frame from the PCM ring, encodes it
+ * and queues the SDU on the broadcast source. It runs on a credit from the
+ * controller (one per sent SDU), so the encoder is paced by the ISO clock
+ * instead of a local timer and never has more than
+ * CONFIG_AUDIO_BROADCAST_SDUS_IN_FLIGHT SDUs queued.
+ *
+ * The thread is the only consumer of the ring. Before the first frame it
+ * waits for CONFIG_AUDIO_BROADCAST_PREFILL_MS of audio (sending silence
+ * meanwhile); after that a short read is padded with silence and shows up
+ * as a ring underrun.
+ */
+class AudioBroadcaster {
+public:
+    struct Snapshot {
+        uint32_t frames;          // Frames encoded (one SDU each)
+        uint32_t silent_frames;   // Frames sent as silence (prefill, ring empty)
+        uint32_t send_errors;     // SDUs the host refused
+        uint32_t encode_min_ns;   // LC3 encode time per frame
+        uint32_t encode_avg_ns;
+        uint32_t encode_max_ns;
+        uint32_t ring_avg_us;     // Audio waiting in the PCM ring at each read
+        uint32_t ring_max_us;
+        uint32_t iso_avg_us;      // send() to controller sent event
+        uint32_t iso_max_us;
+    };
+
+    explicit AudioBroadcaster(AudioPcmRing& ring);
+
+    /**
+     * @brief Bring up the broadcast and the encoder thread
+     * @return 0 on success, negative error code on failure
+     */
+    int start();
+
+    /**
+     * @brief Stop the broadcast; the thread idles until the next start()
+     */
+    void stop();
+
+    bool isRunning() const { return m_running.load(std::memory_order_acquire); }
+
+    const BroadcastSource& getSource() const { return m_source; }
+
+    /**
+     * @brief Copy the pipeline statistics (safe from any thread)
+     */
+    void snapshot(Snapshot* out) const;
+
+    /**
+     * @brief Clear the statistics (applied by the encoder thread)
+     */
+    void resetStats();
+
+private:
+    static void encoderThread(void* arg1, void* arg2, void* arg3);
+    static void onSduSent(void* ctx);
+
+    void run();
+    void encodeFrame();
+    void sendSdu();
+    void applyPendingReset();
+
+    static void set(std::atomic<uint32_t>& value, uint32_t v)
+    {
+        value.store(v, std::memory_order_relaxed);
+    }
+
+    AudioPcmRing& m_ring;
+    BroadcastSource m_source;
+    Lc3Encoder m_encoder;
+    struct k_sem m_credits;
+    k_tid_t m_thread_id = nullptr;
+    std::atomic<bool> m_running{false};
+
+    // Encoder thread state
+    bool m_prefilled = false;
+    int16_t m_pcm[Lc3Encoder::kFrameSamples];
+    uint8_t m_sdu[Lc3Encoder::kFrameOctets];
+    bool m_sdu_pending = false;  // Encoded, not yet accepted by the source
+    uint64_t m_encode_sum_ns = 0;
+    uint64_t m_ring_sum_us = 0;
+
+    std::atomic<bool> m_reset_requested{false};
+    std::atomic<uint32_t> m_frames{0};
+    std::atomic<uint32_t> m_silent_frames{0};
+    std::atomic<uint32_t> m_send_errors{0};
+    std::atomic<uint32_t> m_encode_min_ns{UINT32_MAX};
+    std::atomic<uint32_t> m_encode_avg_ns{0};
+    std::atomic<uint32_t> m_encode_max_ns{0};
+    std::atomic<uint32_t> m_ring_avg_us{0};
+    std::atomic<uint32_t> m_ring_max_us{0};
+};
@@ -0,0 +1,296 @@
+#include "broadcast_source.hpp"
+#include <zephyr/logging/log.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/iso.h>
+#include <zephyr/bluetooth/uuid.h>
+#include <zephyr/bluetooth/audio/audio.h>
+#include <zephyr/random/random.h>
+#include <zephyr/sys/util.h>
+#include <cerrno>
+#include <cstring>
+
+LOG_MODULE_REGISTER(broadcast_source, LOG_LEVEL_INF);
+
+// One TX buffer per SDU in flight; the controller reports each one sent
+NET_BUF_POOL_FIXED_DEFINE(bis_tx_pool, CONFIG_AUDIO_BROADCAST_SDUS_IN_FLIGHT,
+                          BT_ISO_SDU_BUF_SIZE(CONFIG_BT_ISO_TX_MTU),
+                          CONFIG_BT_CONN_TX_USER_DATA_SIZE, NULL);
+
+BroadcastSource* BroadcastSource::s_instance = nullptr;
+
+static struct bt_bap_stream_ops stream_ops;
+
+BroadcastSource::BroadcastSource()
+    : m_preset(BT_BAP_LC3_BROADCAST_PRESET_16_2_1(BT_AUDIO_LOCATION_MONO_AUDIO,
+                                                   BT_AUDIO_CONTEXT_TYPE_MEDIA))
+{
+    s_instance = this;
+}
+
+uint32_t BroadcastSource::presentationDelayUs() const
+{
+    return m_preset.qos.pd;
+}
+
+uint16_t BroadcastSource::transportLatencyMs() const
+{
+    return m_preset.qos.latency;
+}
+
+int BroadcastSource::init()
+{
+    if (m_initialized) {
+        return 0;
+    }
+
+    int ret = bt_enable(NULL);
+    if (ret < 0 && ret != -EALREADY) {
+        LOG_ERR("Bluetooth init failed: %d", ret);
+        return ret;
+    }
+
+    stream_ops.started = onStarted;
+    stream_ops.stopped = onStopped;
+    stream_ops.sent = onSent;
+    bt_bap_stream_cb_register(&m_stream, &stream_ops);
+
+    struct bt_bap_broadcast_source_stream_param stream_param = {};
+    stream_param.stream = &m_stream;
+
+    struct bt_bap_broadcast_source_subgroup_param subgroup_param = {};
+    subgroup_param.params_count = 1;
+    subgroup_param.params = &stream_param;
+    subgroup_param.codec_cfg = &m_preset.codec_cfg;
+
+    struct bt_bap_broadcast_source_param create_param = {};
+    create_param.params_count = 1;
+    create_param.params = &subgroup_param;
+    create_param.qos = &m_preset.qos;
+    create_param.packing = BT_ISO_PACKING_SEQUENTIAL;
+    create_param.encryption = false;
+
+    ret = bt_bap_broadcast_source_create(&create_param, &m_source);
+    if (ret < 0) {
+        LOG_ERR("Broadcast source create failed: %d", ret);
+        return ret;
+    }
+
+    ret = setupAdvertising();
+    if (ret < 0) {
+        bt_bap_broadcast_source_delete(m_source);
+        m_source = nullptr;
+        return ret;
+    }
+
+    m_initialized = true;
+    LOG_INF("Broadcast source ready, broadcast ID 0x%06x", m_broadcast_id);
+    return 0;
+}
+
+int BroadcastSource::setupAdvertising()
+{
+    int ret = bt_le_ext_adv_create(BT_LE_EXT_ADV_NCONN, NULL, &m_adv);
+    if (ret < 0) {
+        LOG_ERR("Extended advertising create failed: %d", ret);
+        return ret;
+    }
+
+    ret = bt_le_per_adv_set_param(m_adv, BT_LE_PER_ADV_DEFAULT);
+    if (ret < 0) {
+        LOG_ERR("Periodic advertising params failed: %d", ret);
+        goto err_adv;
+    }
+
+    m_broadcast_id = sys_rand32_get() & 0xFFFFFF;
+
+    {
+        // Broadcast Audio Announcement (UUID + broadcast ID) and device name
+        NET_BUF_SIMPLE_DEFINE(ad_buf, BT_UUID_SIZE_16 + BT_AUDIO_BROADCAST_ID_SIZE);
+        net_buf_simple_add_le16(&ad_buf, BT_UUID_BROADCAST_AUDIO_VAL);
+        net_buf_simple_add_le24(&ad_buf, m_broadcast_id);
+
+        struct bt_data ext_ad[2];
+        ext_ad[0].type = BT_DATA_SVC_DATA16;
+        ext_ad[0].data_len = ad_buf.len;
+        ext_ad[0].data = ad_buf.data;
+        ext_ad[1].type = BT_DATA_NAME_COMPLETE;
+        ext_ad[1].data_len = sizeof(CONFIG_BT_DEVICE_NAME) - 1;
+        ext_ad[1].data = reinterpret_cast<const uint8_t*>(CONFIG_BT_DEVICE_NAME);
+
+        ret = bt_le_ext_adv_set_data(m_adv, ext_ad, ARRAY_SIZE(ext_ad), NULL, 0);
+        if (ret < 0) {
+            LOG_ERR("Extended advertising data failed: %d", ret);
+            goto err_adv;
+        }
+
+        // BASE in the periodic advertising
+        NET_BUF_SIMPLE_DEFINE(base_buf, 128);
+        ret = bt_bap_broadcast_source_get_base(m_source, &base_buf);
+        if (ret < 0) {
+            LOG_ERR("BASE encode failed: %d", ret);
+            goto err_adv;
+        }
+
+        struct bt_data per_ad;
+        per_ad.type = BT_DATA_SVC_DATA16;
+        per_ad.data_len = base_buf.len;
+        per_ad.data = base_buf.data;
+
+        ret = bt_le_per_adv_set_data(m_adv, &per_ad, 1);
+        if (ret < 0) {
+            LOG_ERR("Periodic advertising data failed: %d", ret);
+            goto err_adv;
+        }
+    }
+
+    return 0;
+
+err_adv:
+    bt_le_ext_adv_delete(m_adv);
+    m_adv = nullptr;
+    return ret;
+}
+
+int BroadcastSource::start()
+{
+    int ret = init();
+    if (ret < 0) {
+        return ret;
+    }
+
+    ret = bt_le_ext_adv_start(m_adv, BT_LE_EXT_ADV_START_DEFAULT);
+    if (ret < 0 && ret != -EALREADY) {
+        LOG_ERR("Extended advertising start failed: %d", ret);
+        return ret;
+    }
+
+    ret = bt_le_per_adv_start(m_adv);
+    if (ret < 0 && ret != -EALREADY) {
+        LOG_ERR("Periodic advertising start failed: %d", ret);
+        bt_le_ext_adv_stop(m_adv);
+        return ret;
+    }
+
+    ret = bt_bap_broadcast_source_start(m_source, m_adv);
+    if (ret < 0) {
+        LOG_ERR("Broadcast source start failed: %d", ret);
+        bt_le_per_adv_stop(m_adv);
+        bt_le_ext_adv_stop(m_adv);
+        return ret;
+    }
+
+    LOG_INF("Broadcast starting");
+    return 0;
+}
+
+int BroadcastSource::stop()
+{
+    if (!m_initialized) {
+        return 0;
+    }
+
+    int ret = bt_bap_broadcast_source_stop(m_source);
+    if (ret < 0 && ret != -EALREADY) {
+        LOG_WRN("Broadcast source stop failed: %d", ret);
+    }
+
+    bt_le_per_adv_stop(m_adv);
+    bt_le_ext_adv_stop(m_adv);
+    return ret;
+}
+
+int BroadcastSource::send(const uint8_t* sdu, size_t len)
+{
+    if (!isStreaming()) {
+        return -ENOTCONN;
+    }
+
+    struct net_buf* buf = net_buf_alloc(&bis_tx_pool, K_NO_WAIT);
+    if (!buf) {
+        return -ENOBUFS;
+    }
+
+    net_buf_reserve(buf, BT_ISO_CHAN_SEND_RESERVE);
+    net_buf_add_mem(buf, sdu, len);
+
+    // Record the send time before the controller can complete it
+    k_spinlock_key_t key = k_spin_lock(&m_lock);
+    m_send_cyc[(m_send_head + m_send_count) % kSdusInFlight] = k_cycle_get_32();
+    m_send_count++;
+    k_spin_unlock(&m_lock, key);
+
+    int ret = bt_bap_stream_send(&m_stream, buf, m_seq_num, BT_ISO_TIMESTAMP_NONE);
+    if (ret < 0) {
+        net_buf_unref(buf);
+        key = k_spin_lock(&m_lock);
+        m_send_count--;
+        k_spin_unlock(&m_lock, key);
+        return ret;
+    }
+
+    m_seq_num++;
+    return 0;
+}
+
+void BroadcastSource::onStarted(struct bt_bap_stream* stream)
+{
+    BroadcastSource* self = s_instance;
+
+    k_spinlock_key_t key = k_spin_lock(&self->m_lock);
+    self->m_send_head = 0;
+    self->m_send_count = 0;
+    k_spin_unlock(&self->m_lock, key);
+
+    self->m_seq_num = 0;
+    self->m_streaming.store(true, std::memory_order_release);
+    LOG_INF("BIS streaming");
+
+    // Hand out the initial credits
+    if (self->m_sent_cb) {
+        for (size_t i = 0; i < kSdusInFlight; i++) {
+            self->m_sent_cb(self->m_sent_ctx);
+        }
+    }
+}
+
+void BroadcastSource::onStopped(struct bt_bap_stream* stream, uint8_t reason)
+{
+    s_instance->m_streaming.store(false, std::memory_order_release);
+    LOG_INF("BIS stopped (reason 0x%02x)", reason);
+}
+
+void BroadcastSource::onSent(struct bt_bap_stream* stream)
+{
+    BroadcastSource* self = s_instance;
+    uint32_t now = k_cycle_get_32();
+    uint32_t sent_cyc = now;
+
+    k_spinlock_key_t key = k_spin_lock(&self->m_lock);
+    if (self->m_send_count > 0) {
+        sent_cyc = self->m_send_cyc[self->m_send_head];
+        self->m_send_head = (self->m_send_head + 1) % kSdusInFlight;
+        self->m_send_count--;
+    }
+    k_spin_unlock(&self->m_lock, key);
+
+    if (self->m_reset_requested.load(std::memory_order_acquire)) {
+        self->m_reset_requested.store(false, std::memory_order_relaxed);
+        self->m_latency_sum_us = 0;
+        self->m_latency_count = 0;
+        self->m_latency_max_us.store(0, std::memory_order_relaxed);
+    }
+
+    uint32_t us = k_cyc_to_us_floor32(now - sent_cyc);
+    self->m_latency_count++;
+    self->m_latency_sum_us += us;
+    self->m_latency_us.store(us, std::memory_order_relaxed);
+    self->m_latency_avg_us.store(static_cast<uint32_t>(self->m_latency_sum_us / self->m_latency_count),
+                                 std::memory_order_relaxed);
+    if (us > self->m_latency_max_us.load(std::memory_order_relaxed)) {
+        self->m_latency_max_us.store(us, std::memory_order_relaxed);
+    }
+
+    if (self->m_sent_cb) {
+        self->m_sent_cb(self->m_sent_ctx);
+    }
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/audio/bap.h>
+#include <zephyr/bluetooth/audio/bap_lc3_preset.h>
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+// Defaults for builds without Kconfig (host tools); see audioBle/Kconfig
+#ifndef CONFIG_AUDIO_BROADCAST_SDUS_IN_FLIGHT
+#define CONFIG_AUDIO_BROADCAST_SDUS_IN_FLIGHT 2
+#endif
+
+/**
+ * @brief LE Audio (BAP) broadcast source with one mono BIS
+ *
+ * Sets up a BAP 16_2_1 broadcast (16 kHz LC3, 10 ms frames, 40-octet SDUs,
+ * 2 retransmissions, 10 ms transport latency, 40 ms presentation delay),
+ * the extended advertising set carrying the Broadcast Audio Announcement
+ * and the periodic advertising carrying the BASE. The controller is the
+ * hci_ipc image on the network core built with
+ * nrf5340_cpunet_bis-bt_ll_sw_split.conf.
+ *
+ * SDUs are paced by the controller: every completed SDU fires the sent
+ * callback, which the caller uses as a credit for the next one. The time
+ * from send() to that callback is the controller-side latency of the BIS.
+ *
+ * Only one instance may exist (Zephyr stream callbacks carry no context).
+ */
+class BroadcastSource {
+public:
+    using SentCallback = void (*)(void* ctx);
+
+    static constexpr size_t kSdusInFlight = CONFIG_AUDIO_BROADCAST_SDUS_IN_FLIGHT;
+
+    BroadcastSource();
+
+    /**
+     * @brief Enable Bluetooth and create the broadcast source and its
+     *        advertising sets (once; later calls return 0)
+     * @return 0 on success, negative error code on failure
+     */
+    int init();
+
+    /**
+     * @brief Start advertising and create the BIG
+     * @return 0 on success (streaming begins asynchronously), negative error code on failure
+     */
+    int start();
+
+    /**
+     * @brief Terminate the BIG and stop advertising
+     */
+    int stop();
+
+    /**
+     * @brief True while the BIS is established and accepts SDUs
+     */
+    bool isStreaming() const { return m_streaming.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Queue one SDU on the BIS
+     * @return 0 on success, -ENOTCONN if not streaming, -ENOBUFS if no TX
+     *         buffer is free, other negative error code from the host
+     */
+    int send(const uint8_t* sdu, size_t len);
+
+    /**
+     * @brief Called for every SDU the controller has sent, and once per
+     *        free TX slot when streaming starts; runs in the BT RX thread
+     */
+    void setSentCallback(SentCallback cb, void* ctx)
+    {
+        m_sent_cb = cb;
+        m_sent_ctx = ctx;
+    }
+
+    uint32_t broadcastId() const { return m_broadcast_id; }
+
+    /**
+     * @brief Presentation delay advertised in the BASE, microseconds
+     */
+    uint32_t presentationDelayUs() const;
+
+    /**
+     * @brief Maximum transport latency requested for the BIG, milliseconds
+     */
+    uint16_t transportLatencyMs() const;
+
+    /**
+     * @brief Last send()-to-sent latency, and its average/maximum (microseconds)
+     */
+    uint32_t sendLatencyUs() const { return m_latency_us.load(std::memory_order_relaxed); }
+    uint32_t sendLatencyAvgUs() const { return m_latency_avg_us.load(std::memory_order_relaxed); }
+    uint32_t sendLatencyMaxUs() const { return m_latency_max_us.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Clear the latency statistics (applied at the next sent SDU)
+     */
+    void resetStats() { m_reset_requested.store(true, std::memory_order_release); }
+
+private:
+    static void onStarted(struct bt_bap_stream* stream);
+    static void onStopped(struct bt_bap_stream* stream, uint8_t reason);
+    static void onSent(struct bt_bap_stream* stream);
+
+    int setupAdvertising();
+
+    static BroadcastSource* s_instance;
+
+    struct bt_bap_lc3_preset m_preset;
+    struct bt_bap_stream m_stream = {};
+    struct bt_bap_broadcast_source* m_source = nullptr;
+    struct bt_le_ext_adv* m_adv = nullptr;
+    uint32_t m_broadcast_id = 0;
+    bool m_initialized = false;
+
+    std::atomic<bool> m_streaming{false};
+    uint16_t m_seq_num = 0;
+
+    SentCallback m_sent_cb = nullptr;
+    void* m_sent_ctx = nullptr;
+
+    // Send times of SDUs not yet reported sent, completed in FIFO order
+    uint32_t m_send_cyc[kSdusInFlight] = {};
+    size_t m_send_head = 0;   // Written by send()
+    size_t m_send_count = 0;  // Guarded by m_lock, shared with onSent()
+    struct k_spinlock m_lock = {};
+
+    // Latency statistics, written by onSent() only
+    std::atomic<bool> m_reset_requested{false};
+    std::atomic<uint32_t> m_latency_us{0};
+    std::atomic<uint32_t> m_latency_avg_us{0};
+    std::atomic<uint32_t> m_latency_max_us{0};
+    uint64_t m_latency_sum_us = 0;
+    uint32_t m_latency_count = 0;
+};
@@ -0,0 +1,13 @@
+#include "lc3_encoder.hpp"
+#include <cerrno>
+
+Lc3Encoder::Lc3Encoder()
+{
+    m_encoder = lc3_setup_encoder(kFrameUs, kSampleRate, 0, &m_mem);
+}
+
+int Lc3Encoder::encode(const int16_t* pcm, uint8_t* out)
+{
+    int ret = lc3_encode(m_encoder, LC3_PCM_FORMAT_S16, pcm, 1, kFrameOctets, out);
+    return ret == 0 ? 0 : -EIO;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <lc3.h>
+
+/**
+ * @brief LC3 encoder for one mono channel (liblc3), fixed memory
+ *
+ * Frame duration and sample rate are compile-time so the encoder state is
+ * a plain member, no heap. Matches the BAP 16_2 preset: 16 kHz, 10 ms,
+ * 40 octets per frame (32 kbps).
+ */
+class Lc3Encoder {
+public:
+    static constexpr int kFrameUs = 10000;
+    static constexpr int kSampleRate = 16000;
+    static constexpr size_t kFrameSamples = kSampleRate / 1000 * kFrameUs / 1000;
+    static constexpr size_t kFrameOctets = 40;
+
+    Lc3Encoder();
+
+    /**
+     * @brief Encode one frame
+     * @param pcm kFrameSamples host-order samples
+     * @param out kFrameOctets output bytes
+     * @return 0 on success, -EIO if the encoder rejected the frame
+     */
+    int encode(const int16_t* pcm, uint8_t* out);
+
+    /**
+     * @brief Algorithmic delay added by the codec, in microseconds
+     */
+    static uint32_t delayUs() { return lc3_delay_samples(kFrameUs, kSampleRate) * 1000000u / kSampleRate; }
+
+private:
+    lc3_encoder_t m_encoder;
+    lc3_encoder_mem_16k_t m_mem;
+};
@@ -1,9 +1,22 @@
 #include "shell_commands.hpp"
 #include "../net/wifi_mgr.h"
+#ifdef CONFIG_AUDIO_AUTO_RTP_START
+#include "../net/rtp_autostart.hpp"
+#endif
+#ifdef CONFIG_WIFI_PS_POLICY
+#include "../net/wifi_ps_policy.h"
+#endif
+#include "../audio/dsp.hpp"
+#include "../trace/boot_metrics.hpp"
+#include "../trace/cycle_counter.hpp"
+#ifdef CONFIG_AUDIO_LATENCY_TRACE
+#include "../trace/latency_trace.hpp"
+#endif
 #include <zephyr/shell/shell.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/sys/printk.h>
 #include <zephyr/net/net_if.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -11,6 +24,9 @@ LOG_MODULE_REGISTER(shell_cmds, LOG_LEVEL_INF);
 
 // Global references to managers (set during init)
 static RtpReceiver* g_rtp = nullptr;
+#ifdef CONFIG_AUDIO_BROADCAST
+static AudioBroadcaster* g_bis = nullptr;
+#endif
 
 // Connection status command (workaround for broken wifi status)
 static int cmd_status(const struct shell *sh, size_t argc, char **argv)
@@ -112,6 +128,11 @@ static int cmd_rtp_start(const struct shell *sh, size_t argc, char **argv)
     
     shell_print(sh, "RTP receiver started!");
     shell_print(sh, "Connected to: %s:%u", server_ip, port);
+
+#ifdef CONFIG_AUDIO_AUTO_RTP_START
+    // Started again at the next boot
+    rtp_autostart::save(server_ip, port);
+#endif
     
     return 0;
 }
@@ -154,6 +175,893 @@ static int cmd_rtp_status(const struct shell *sh, size_t argc, char **argv)
     return 0;
 }
 
+// Stream gain as a percentage (Q16 1.0 = 100 %)
+static uint32_t gain_to_percent(int32_t gainQ16)
+{
+    return (static_cast<uint32_t>(gainQ16) * 100 + dsp::kGainUnityQ16 / 2) / dsp::kGainUnityQ16;
+}
+
+// One-way delay histogram, power-of-two millisecond buckets, empty ones skipped
+static void print_delay_histogram(const struct shell *sh, const DelayHistogram::Snapshot& d)
+{
+    uint32_t peak = 1;
+    for (size_t b = 0; b < DelayHistogram::kBuckets; b++) {
+        peak = MAX(peak, d.buckets[b]);
+    }
+
+    for (size_t b = 0; b < DelayHistogram::kBuckets; b++) {
+        if (d.buckets[b] == 0) {
+            continue;
+        }
+        char bar[33];
+        size_t len = (d.buckets[b] * (sizeof(bar) - 1) + peak - 1) / peak;
+        memset(bar, '#', len);
+        bar[len] = '\0';
+        if (b == 0) {
+            shell_print(sh, "        < 1 ms %5u %s", d.buckets[b], bar);
+        } else if (b == DelayHistogram::kBuckets - 1) {
+            shell_print(sh, "    >= %5u ms %5u %s", DelayHistogram::bucketLowMs(b), d.buckets[b], bar);
+        } else {
+            shell_print(sh, "   %5u-%-5u %5u %s", DelayHistogram::bucketLowMs(b),
+                        DelayHistogram::bucketLowMs(b + 1) - 1, d.buckets[b], bar);
+        }
+    }
+}
+
+// Statistics block of one stream
+static void print_stream_stats(const struct shell *sh, size_t index)
+{
+    const RtpStream& stream = g_rtp->getStream(index);
+    RtpStats::Snapshot st;
+    stream.getStats().snapshot(&st);
+
+    if (stream.isBound()) {
+        shell_print(sh, "--- Stream %u%s: SSRC 0x%08x ---", index,
+                    index == g_rtp->getLeadStream() ? " (lead)" : "", stream.boundSsrc());
+    } else {
+        shell_print(sh, "--- Stream %u%s: no source ---", index,
+                    index == g_rtp->getLeadStream() ? " (lead)" : "");
+    }
+
+    shell_print(sh, "Packets:    received %u | lost %u | reordered %u | duplicate %u | late %u",
+                st.received, st.lost, st.reordered, st.duplicates, st.late);
+    shell_print(sh, "Jitter:     %u us (RFC 3550)", st.jitter_us);
+    shell_print(sh, "Processing: min %u | avg %u | max %u ns (parse + enqueue)",
+                st.proc_min_ns, st.proc_avg_ns, st.proc_max_ns);
+    shell_print(sh, "Concealed:  %u frames | avg %u | max %u ns per frame",
+                st.plc_frames, st.plc_avg_ns, st.plc_max_ns);
+    shell_print(sh, "Jitter buf: depth %u | target %u | max %u | underruns %u | drops %u",
+                st.jb_depth, st.jb_target, st.jb_max_depth, st.jb_underruns, st.jb_drops);
+    shell_print(sh, "JB delay:   avg %u | max %u us (arrival to playout)",
+                st.jb_delay_avg_us, st.jb_delay_max_us);
+
+    const DelayHistogram::Snapshot& net = st.network_delay;
+    if (net.count) {
+        shell_print(sh, "Net delay:  min %d | p50 ~%d | p99 ~%d | max %d us (%u packets, send to recvfrom)",
+                    net.min_us, net.p50_us, net.p99_us, net.max_us, net.count);
+        shell_print(sh, "Latency:    network %d + buffer %u + processing %u.%u us (averages)",
+                    net.avg_us, st.jb_delay_avg_us, st.proc_avg_ns / 1000, (st.proc_avg_ns % 1000) / 100);
+        print_delay_histogram(sh, net);
+    } else {
+        int64_t offset;
+        shell_print(sh, "Net delay:  no send timestamps%s",
+                    wifi_mgr_get_clock_offset(&offset) == 0 ? "" : " (wall clock not synced)");
+    }
+
+    uint32_t drift = abs(st.clock_drift_ppb);
+    shell_print(sh, "Clock:      sender drift %s%u.%03u ppm | resampler %s",
+                st.clock_drift_ppb < 0 ? "-" : "", drift / 1000, drift % 1000,
+                st.clock_locked ? "locked" : "acquiring");
+
+    const RtcpReporter& rtcp = stream.getRtcp();
+    shell_print(sh, "RTCP:       SRs received %u | last RR fraction lost %u/256",
+                rtcp.senderReports(), rtcp.lastFractionLost());
+
+    if (index != g_rtp->getLeadStream()) {
+        const RtpStream::OutputRing& ring = stream.getOutputRing();
+        shell_print(sh, "Mix ring:   fill %u/%u | gain %u%% | overruns %u | underruns %u",
+                    ring.fillLevel(), ring.capacity(),
+                    gain_to_percent(stream.gainQ16()), ring.overruns(), ring.underruns());
+    }
+}
+
+// RTP stats command
+static int cmd_rtp_stats(const struct shell *sh, size_t argc, char **argv)
+{
+    if (!g_rtp) {
+        shell_error(sh, "RTP receiver not initialized");
+        return -ENODEV;
+    }
+
+    if (argc > 1) {
+        if (strcmp(argv[1], "reset") != 0) {
+            shell_error(sh, "Usage: rtp stats [reset]");
+            return -EINVAL;
+        }
+        g_rtp->resetStats();
+        shell_print(sh, "RTP statistics reset");
+        return 0;
+    }
+
+    shell_print(sh, "=== RTP Statistics (%s) ===", g_rtp->isRunning() ? "running" : "stopped");
+    for (size_t i = 0; i < RtpReceiver::kMaxStreams; i++) {
+        if (g_rtp->getStream(i).isEnabled()) {
+            print_stream_stats(sh, i);
+        }
+    }
+
+    const PacketPool& pool = g_rtp->getPacketPool();
+    shell_print(sh, "Pkt pool:   free %u/%u | high water %u | alloc failures %u",
+                pool.freeCount(), pool.capacity(), pool.highWater(), pool.allocFailures());
+
+    AudioPcmRing& pcm = g_rtp->getPcmRing();
+    shell_print(sh, "PCM ring:   fill %u/%u | high %u | low %u | overruns %u | underruns %u",
+                pcm.fillLevel(), pcm.capacity(), pcm.highWater(), pcm.lowWater(),
+                pcm.overruns(), pcm.underruns());
+
+    return 0;
+}
+
+// RTP clock command: SNTP state behind the network delay
+static int cmd_rtp_clock(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+#ifdef CONFIG_WIFI_SNTP
+    struct wifi_mgr_clock_info info;
+    wifi_mgr_get_clock_info(&info);
+
+    shell_print(sh, "=== Wall Clock (SNTP %s) ===", CONFIG_WIFI_SNTP_SERVER);
+    if (!info.synced) {
+        shell_print(sh, "Not synced | %u failed attempts", info.failures);
+        return 0;
+    }
+    shell_print(sh, "Synced %u s ago | round trip %u us (error up to %u us)", info.age_s,
+                info.rtt_us, info.rtt_us / 2);
+    shell_print(sh, "Last resync stepped %d us | syncs %u | failures %u",
+                info.last_step_us, info.syncs, info.failures);
+#else
+    shell_print(sh, "No wall clock (CONFIG_WIFI_SNTP disabled)");
+#endif
+    return 0;
+}
+
+// Parse and check a stream index argument
+static int parse_stream_index(const struct shell *sh, const char *arg, size_t *index)
+{
+    char *end;
+    unsigned long value = strtoul(arg, &end, 10);
+    if (*end != '\0' || value >= RtpReceiver::kMaxStreams) {
+        shell_error(sh, "Invalid stream index: %s (0-%u)", arg, RtpReceiver::kMaxStreams - 1);
+        return -EINVAL;
+    }
+    *index = value;
+    return 0;
+}
+
+// RTP stream list command
+static int cmd_rtp_stream_list(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    if (!g_rtp) {
+        shell_error(sh, "RTP receiver not initialized");
+        return -ENODEV;
+    }
+
+    shell_print(sh, "=== RTP Streams ===");
+    for (size_t i = 0; i < RtpReceiver::kMaxStreams; i++) {
+        const RtpStream& stream = g_rtp->getStream(i);
+        if (!stream.isEnabled()) {
+            shell_print(sh, "%u: off", i);
+            continue;
+        }
+
+        char port[8];
+        if (stream.port()) {
+            snprintf(port, sizeof(port), "%u", stream.port());
+        } else {
+            strcpy(port, "primary");
+        }
+        char ssrc[12];
+        if (stream.ssrcFilter()) {
+            snprintf(ssrc, sizeof(ssrc), "0x%08x", stream.ssrcFilter());
+        } else {
+            strcpy(ssrc, "any");
+        }
+
+        uint32_t gain = gain_to_percent(stream.gainQ16());
+        if (stream.isBound()) {
+            shell_print(sh, "%u: port %s | ssrc %s | gain %u%%%s | bound to 0x%08x", i, port,
+                        ssrc, gain, i == g_rtp->getLeadStream() ? " | lead" : "",
+                        stream.boundSsrc());
+        } else {
+            shell_print(sh, "%u: port %s | ssrc %s | gain %u%%%s", i, port, ssrc, gain,
+                        i == g_rtp->getLeadStream() ? " | lead" : "");
+        }
+    }
+
+    return 0;
+}
+
+// RTP stream set command
+static int cmd_rtp_stream_set(const struct shell *sh, size_t argc, char **argv)
+{
+    if (!g_rtp) {
+        shell_error(sh, "RTP receiver not initialized");
+        return -ENODEV;
+    }
+
+    size_t index;
+    if (parse_stream_index(sh, argv[1], &index) < 0) {
+        return -EINVAL;
+    }
+
+    char *end;
+    unsigned long port = strtoul(argv[2], &end, 10);
+    if (*end != '\0' || port > 65534) {
+        shell_error(sh, "Invalid port: %s (0 = primary port)", argv[2]);
+        return -EINVAL;
+    }
+
+    unsigned long ssrc = 0;
+    if (argc > 3) {
+        ssrc = strtoul(argv[3], &end, 0);
+        if (*end != '\0') {
+            shell_error(sh, "Invalid SSRC: %s", argv[3]);
+            return -EINVAL;
+        }
+    }
+
+    int ret = g_rtp->configureStream(index, port, ssrc);
+    if (ret == -EBUSY) {
+        shell_error(sh, "Stop the receiver first (rtp stop)");
+        return ret;
+    }
+    if (ret < 0) {
+        shell_error(sh, "Failed to configure stream %u: %d", index, ret);
+        return ret;
+    }
+
+    shell_print(sh, "Stream %u configured, applies at the next rtp start", index);
+    return 0;
+}
+
+// RTP stream off command
+static int cmd_rtp_stream_off(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+
+    if (!g_rtp) {
+        shell_error(sh, "RTP receiver not initialized");
+        return -ENODEV;
+    }
+
+    size_t index;
+    if (parse_stream_index(sh, argv[1], &index) < 0) {
+        return -EINVAL;
+    }
+
+    int ret = g_rtp->disableStream(index);
+    if (ret == -EBUSY) {
+        shell_error(sh, "Stop the receiver first (rtp stop)");
+        return ret;
+    }
+    if (ret < 0) {
+        shell_error(sh, "Stream 0 cannot be disabled");
+        return ret;
+    }
+
+    shell_print(sh, "Stream %u disabled", index);
+    return 0;
+}
+
+// RTP stream select command
+static int cmd_rtp_stream_select(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+
+    if (!g_rtp) {
+        shell_error(sh, "RTP receiver not initialized");
+        return -ENODEV;
+    }
+
+    size_t index;
+    if (parse_stream_index(sh, argv[1], &index) < 0) {
+        return -EINVAL;
+    }
+
+    if (g_rtp->selectStream(index) < 0) {
+        shell_error(sh, "Stream %u is not configured", index);
+        return -EINVAL;
+    }
+
+    shell_print(sh, "Stream %u drives the PCM ring", index);
+    return 0;
+}
+
+// RTP stream gain command
+static int cmd_rtp_stream_gain(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+
+    if (!g_rtp) {
+        shell_error(sh, "RTP receiver not initialized");
+        return -ENODEV;
+    }
+
+    size_t index;
+    if (parse_stream_index(sh, argv[1], &index) < 0) {
+        return -EINVAL;
+    }
+
+    char *end;
+    unsigned long percent = strtoul(argv[2], &end, 10);
+    if (*end != '\0' || percent > 400) {
+        shell_error(sh, "Invalid gain: %s (0-400 %%)", argv[2]);
+        return -EINVAL;
+    }
+
+    int32_t gain = static_cast<int32_t>(percent * dsp::kGainUnityQ16 / 100);
+    g_rtp->setStreamGain(index, gain);
+    shell_print(sh, "Stream %u gain %u%%%s", index, percent,
+                index != g_rtp->getLeadStream() && gain ? " (mixed)" : "");
+    return 0;
+}
+
+#ifdef CONFIG_AUDIO_BROADCAST
+// Print microseconds as milliseconds with one decimal
+#define US_MS_FMT "%u.%u ms"
+#define US_MS_ARG(us) (us) / 1000, ((us) % 1000) / 100
+
+// BIS start command
+static int cmd_bis_start(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    if (!g_bis) {
+        shell_error(sh, "Audio broadcaster not initialized");
+        return -ENODEV;
+    }
+
+    int ret = g_bis->start();
+    if (ret < 0) {
+        shell_error(sh, "Failed to start broadcast: %d", ret);
+        return ret;
+    }
+
+    shell_print(sh, "Broadcasting, broadcast ID 0x%06x", g_bis->getSource().broadcastId());
+    return 0;
+}
+
+// BIS stop command
+static int cmd_bis_stop(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    if (!g_bis) {
+        shell_error(sh, "Audio broadcaster not initialized");
+        return -ENODEV;
+    }
+
+    g_bis->stop();
+    shell_print(sh, "Broadcast stopped");
+    return 0;
+}
+
+// BIS stats command: per-stage latency from RTP arrival to presentation
+static int cmd_bis_stats(const struct shell *sh, size_t argc, char **argv)
+{
+    if (!g_bis || !g_rtp) {
+        shell_error(sh, "Audio broadcaster not initialized");
+        return -ENODEV;
+    }
+
+    if (argc > 1) {
+        if (strcmp(argv[1], "reset") != 0) {
+            shell_error(sh, "Usage: bis stats [reset]");
+            return -EINVAL;
+        }
+        g_bis->resetStats();
+        shell_print(sh, "Broadcast statistics reset");
+        return 0;
+    }
+
+    AudioBroadcaster::Snapshot st;
+    g_bis->snapshot(&st);
+    RtpStats::Snapshot rtp;
+    g_rtp->getStats().snapshot(&rtp);
+    const BroadcastSource& src = g_bis->getSource();
+
+    shell_print(sh, "=== LE Audio Broadcast (%s) ===",
+                src.isStreaming() ? "streaming" : (g_bis->isRunning() ? "starting" : "stopped"));
+    shell_print(sh, "Frames:     encoded %u | silent %u | send errors %u",
+                st.frames, st.silent_frames, st.send_errors);
+    shell_print(sh, "LC3 encode: min %u | avg %u | max %u ns per 10 ms frame",
+                st.encode_min_ns, st.encode_avg_ns, st.encode_max_ns);
+
+    // Measured stages first, then the fixed ones from the codec and QoS
+    uint32_t frame_us = Lc3Encoder::kFrameUs;
+    uint32_t codec_us = Lc3Encoder::delayUs();
+    uint32_t transport_us = src.transportLatencyMs() * 1000u;
+    uint32_t pd_us = src.presentationDelayUs();
+    uint32_t total_us = rtp.jb_delay_avg_us + st.ring_avg_us + frame_us + codec_us +
+                        transport_us + pd_us;
+
+    shell_print(sh, "Latency:");
+    shell_print(sh, "  Jitter buffer   avg " US_MS_FMT " | max " US_MS_FMT,
+                US_MS_ARG(rtp.jb_delay_avg_us), US_MS_ARG(rtp.jb_delay_max_us));
+    shell_print(sh, "  PCM ring        avg " US_MS_FMT " | max " US_MS_FMT,
+                US_MS_ARG(st.ring_avg_us), US_MS_ARG(st.ring_max_us));
+    shell_print(sh, "  LC3 framing     " US_MS_FMT " + " US_MS_FMT " codec delay",
+                US_MS_ARG(frame_us), US_MS_ARG(codec_us));
+    shell_print(sh, "  ISO send->sent  avg " US_MS_FMT " | max " US_MS_FMT " (host + controller queue)",
+                US_MS_ARG(st.iso_avg_us), US_MS_ARG(st.iso_max_us));
+    shell_print(sh, "  ISO transport   <= " US_MS_FMT " | presentation delay " US_MS_FMT,
+                US_MS_ARG(transport_us), US_MS_ARG(pd_us));
+    shell_print(sh, "  Total (avg)     ~" US_MS_FMT " RTP arrival to presentation",
+                US_MS_ARG(total_us));
+
+    return 0;
+}
+
+// Define BIS subcommands
+SHELL_STATIC_SUBCMD_SET_CREATE(bis_cmds,
+    SHELL_CMD_ARG(start, NULL,
+                  "Start the LE Audio broadcast of the received stream",
+                  cmd_bis_start, 1, 0),
+    SHELL_CMD_ARG(stop, NULL,
+                  "Stop the LE Audio broadcast",
+                  cmd_bis_stop, 1, 0),
+    SHELL_CMD_ARG(stats, NULL,
+                  "Show broadcast statistics and per-stage latency\n"
+                  "Usage: bis stats [reset]\n"
+                  "  reset - Clear all counters",
+                  cmd_bis_stats, 1, 1),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(bis, &bis_cmds, "LE Audio broadcast commands", NULL);
+#endif
+
+#define DSP_BENCH_SAMPLES 320  // One 20 ms frame of 16 kHz mono
+#define DSP_BENCH_RUNS 16
+
+// Best-of-N cycles for one call, interrupts locked so the count is clean
+template <typename Fn>
+static uint32_t bench_best(Fn fn)
+{
+    uint32_t best = UINT32_MAX;
+    for (int run = 0; run < DSP_BENCH_RUNS; run++) {
+        unsigned int key = irq_lock();
+        uint32_t start = cycle_counter_get();
+        fn();
+        uint32_t cycles = cycle_counter_get() - start;
+        irq_unlock(key);
+        if (cycles < best) {
+            best = cycles;
+        }
+    }
+    return best;
+}
+
+static void bench_print(const struct shell *sh, const char *name, uint32_t scalar, uint32_t simd)
+{
+    // Cycles per sample with two decimals, and the speed-up
+    uint32_t scalar_x100 = scalar * 100 / DSP_BENCH_SAMPLES;
+    uint32_t simd_x100 = simd * 100 / DSP_BENCH_SAMPLES;
+    uint32_t gain_x10 = simd ? scalar * 10 / simd : 0;
+    shell_print(sh, "%-14s %6u (%u.%02u/smp) %6u (%u.%02u/smp)  x%u.%u",
+                name, scalar, scalar_x100 / 100, scalar_x100 % 100,
+                simd, simd_x100 / 100, simd_x100 % 100, gain_x10 / 10, gain_x10 % 10);
+}
+
+// DSP benchmark command: scalar vs SIMD kernels in CPU cycles
+static int cmd_dsp_bench(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    static uint8_t be[DSP_BENCH_SAMPLES * 2];
+    static int16_t a[DSP_BENCH_SAMPLES * 2];
+    static int16_t b[DSP_BENCH_SAMPLES];
+    static int16_t out[DSP_BENCH_SAMPLES];
+    static volatile int64_t sink;
+
+    for (size_t i = 0; i < ARRAY_SIZE(a); i++) {
+        a[i] = static_cast<int16_t>(i * 2654435761u >> 16);
+    }
+    memcpy(be, a, sizeof(be));
+    memcpy(b, a + DSP_BENCH_SAMPLES, sizeof(b));
+
+    cycle_counter_init();
+    shell_print(sh, "=== DSP kernels, %u samples, cycles per call (best of %u) ===",
+                DSP_BENCH_SAMPLES, DSP_BENCH_RUNS);
+    if (!cycle_counter_is_dwt()) {
+        shell_warn(sh, "No DWT cycle counter: using k_cycle_get_32(), results are coarse");
+    }
+#if !DSP_HAS_SIMD
+    shell_warn(sh, "No DSP extension: the simd column runs C emulations");
+#endif
+    shell_print(sh, "%-14s %22s %22s  speed-up", "kernel", "scalar", "simd");
+
+    bench_print(sh, "l16beToHost",
+                bench_best([&] { dsp::scalar::l16beToHost(be, out, DSP_BENCH_SAMPLES); }),
+                bench_best([&] { dsp::simd::l16beToHost(be, out, DSP_BENCH_SAMPLES); }));
+    bench_print(sh, "applyGainQ16",
+                bench_best([&] { dsp::scalar::applyGainQ16(out, DSP_BENCH_SAMPLES, 0xB505); }),
+                bench_best([&] { dsp::simd::applyGainQ16(out, DSP_BENCH_SAMPLES, 0xB505); }));
+    bench_print(sh, "mixSaturate",
+                bench_best([&] { dsp::scalar::mixSaturate(out, b, DSP_BENCH_SAMPLES); }),
+                bench_best([&] { dsp::simd::mixSaturate(out, b, DSP_BENCH_SAMPLES); }));
+    bench_print(sh, "stereoToMono",
+                bench_best([&] { dsp::scalar::stereoToMono(a, out, DSP_BENCH_SAMPLES); }),
+                bench_best([&] { dsp::simd::stereoToMono(a, out, DSP_BENCH_SAMPLES); }));
+    bench_print(sh, "dot",
+                bench_best([&] { sink = dsp::scalar::dot(a + 1, b, DSP_BENCH_SAMPLES); }),
+                bench_best([&] { sink = dsp::simd::dot(a + 1, b, DSP_BENCH_SAMPLES); }));
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(dsp_cmds,
+    SHELL_CMD_ARG(bench, NULL,
+                  "Benchmark the PCM kernels, scalar vs SIMD (interrupts are\n"
+                  "locked for each ~1k-cycle run)",
+                  cmd_dsp_bench, 1, 0),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(dsp, &dsp_cmds, "Audio DSP kernel commands", NULL);
+
+#ifdef CONFIG_AUDIO_LATENCY_TRACE
+// Print nanoseconds as microseconds with one decimal
+#define NS_US_FMT "%u.%u"
+#define NS_US_ARG(ns) (ns) / 1000, ((ns) % 1000) / 100
+
+// Trace on/off commands
+static int cmd_trace_on(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    latency_trace::setEnabled(true);
+    shell_print(sh, "Latency tracing enabled");
+    return 0;
+}
+
+static int cmd_trace_off(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    latency_trace::setEnabled(false);
+    shell_print(sh, "Latency tracing paused");
+    return 0;
+}
+
+// Trace clear command
+static int cmd_trace_clear(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    latency_trace::clear();
+    shell_print(sh, "Trace ring cleared");
+    return 0;
+}
+
+// Trace stats command: per-stage latency histograms from the trace ring
+static int cmd_trace_stats(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    static latency_trace::Report report;
+    latency_trace::analyze(&report);
+
+    shell_print(sh, "=== Packet latency (%u records, %u packets, %u incomplete) ===",
+                report.records, report.packets, report.partial);
+    if (!cycle_counter_is_dwt()) {
+        shell_warn(sh, "No DWT cycle counter: stamps have kernel cycle resolution");
+    }
+    shell_print(sh, "%-11s %12s %12s %12s", "stage", "p50 us", "p99 us", "max us");
+    for (size_t i = 0; i < latency_trace::kStageCount; i++) {
+        const latency_trace::StageStats& st = report.stages[i];
+        shell_print(sh, "%-11s %10u.%u %10u.%u %10u.%u",
+                    latency_trace::stageName(static_cast<latency_trace::Stage>(i)),
+                    NS_US_ARG(st.p50_ns), NS_US_ARG(st.p99_ns), NS_US_ARG(st.max_ns));
+    }
+
+    // One histogram per stage, log2 microsecond buckets, empty ones skipped
+    for (size_t i = 0; i < latency_trace::kStageCount; i++) {
+        const latency_trace::StageStats& st = report.stages[i];
+        if (st.count == 0) {
+            continue;
+        }
+
+        uint32_t peak = 1;
+        for (size_t b = 0; b < latency_trace::kBuckets; b++) {
+            peak = MAX(peak, st.buckets[b]);
+        }
+
+        shell_print(sh, "--- %s ---",
+                    latency_trace::stageName(static_cast<latency_trace::Stage>(i)));
+        for (size_t b = 0; b < latency_trace::kBuckets; b++) {
+            if (st.buckets[b] == 0) {
+                continue;
+            }
+            char bar[33];
+            size_t len = (st.buckets[b] * (sizeof(bar) - 1) + peak - 1) / peak;
+            memset(bar, '#', len);
+            bar[len] = '\0';
+            if (b == 0) {
+                shell_print(sh, "        < 1 us %5u %s", st.buckets[b], bar);
+            } else if (b == latency_trace::kBuckets - 1) {
+                shell_print(sh, "  >= %7u us %5u %s", 1u << (b - 1), st.buckets[b], bar);
+            } else {
+                shell_print(sh, "%7u-%-7u %5u %s", 1u << (b - 1), (1u << b) - 1,
+                            st.buckets[b], bar);
+            }
+        }
+    }
+
+    return 0;
+}
+
+static void trace_dump_record(unsigned cpu, const latency_trace::Record& rec, void* ctx)
+{
+    const struct shell *sh = static_cast<const struct shell *>(ctx);
+    shell_print(sh, "T %u %u %s %u %u", cpu, rec.stream,
+                latency_trace::pointName(static_cast<latency_trace::Point>(rec.point)),
+                rec.sequence, rec.cycles);
+}
+
+// Trace dump command: raw records for tools/trace_timeline.py
+static int cmd_trace_dump(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    shell_print(sh, "# latency trace: cycles_per_sec=%u", latency_trace::cyclesPerSec());
+    shell_print(sh, "# T <cpu> <stream> <point> <seq> <cycles>");
+    latency_trace::forEach(trace_dump_record, const_cast<struct shell *>(sh));
+    shell_print(sh, "# end");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(trace_cmds,
+    SHELL_CMD_ARG(on, NULL,
+                  "Resume latency tracing",
+                  cmd_trace_on, 1, 0),
+    SHELL_CMD_ARG(off, NULL,
+                  "Pause latency tracing (the ring is kept)",
+                  cmd_trace_off, 1, 0),
+    SHELL_CMD_ARG(clear, NULL,
+                  "Drop all trace records",
+                  cmd_trace_clear, 1, 0),
+    SHELL_CMD_ARG(stats, NULL,
+                  "Per-stage packet latency: p50/p99/max and histograms",
+                  cmd_trace_stats, 1, 0),
+    SHELL_CMD_ARG(dump, NULL,
+                  "Print the raw records (feed to tools/trace_timeline.py)",
+                  cmd_trace_dump, 1, 0),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(trace, &trace_cmds, "Audio pipeline latency tracing", NULL);
+#endif
+
+// WiFi reconnect commands
+static int cmd_reconnect_status(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    struct wifi_mgr_reconnect_info info;
+    wifi_mgr_get_reconnect_info(&info);
+
+    shell_print(sh, "=== WiFi Reconnect ===");
+    shell_print(sh, "Auto reconnect: %s%s", info.auto_reconnect ? "on" : "off",
+                info.recovering ? " (recovering)" : "");
+    if (info.have_network) {
+        shell_print(sh, "Network: %s, BSSID %02x:%02x:%02x:%02x:%02x:%02x, channel %u",
+                    info.ssid, info.bssid[0], info.bssid[1], info.bssid[2],
+                    info.bssid[3], info.bssid[4], info.bssid[5], info.channel);
+    } else {
+        shell_print(sh, "Network: none cached");
+    }
+    shell_print(sh, "Drops: %u | directed ok: %u | directed failed: %u | scan ok: %u",
+                info.drops, info.fast_ok, info.fast_fail, info.full_ok);
+    if (info.last_recovery_ms) {
+        shell_print(sh, "Last recovery: %u ms (drop to IPv4)", info.last_recovery_ms);
+    }
+
+    return 0;
+}
+
+static int cmd_reconnect_connect(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+
+    shell_print(sh, "Connecting to %s...", argv[1]);
+    int ret = wifi_mgr_connect(argv[1], argv[2]);
+    if (ret < 0) {
+        shell_error(sh, "Connect failed: %d", ret);
+        return ret;
+    }
+
+    char ip[16];
+    if (wifi_mgr_get_ip(ip, sizeof(ip)) == 0) {
+        shell_print(sh, "Connected, IP %s", ip);
+    }
+    return 0;
+}
+
+static int cmd_reconnect_on(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    wifi_mgr_set_auto_reconnect(true);
+    shell_print(sh, "Auto reconnect on");
+    return 0;
+}
+
+static int cmd_reconnect_off(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    wifi_mgr_set_auto_reconnect(false);
+    shell_print(sh, "Auto reconnect off");
+    return 0;
+}
+
+static int cmd_reconnect_now(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    int ret = wifi_mgr_reconnect();
+    if (ret == -ENOENT) {
+        shell_error(sh, "No network cached, connect once first");
+        return ret;
+    }
+    if (ret == -EALREADY) {
+        shell_warn(sh, "WiFi is already connected");
+        return 0;
+    }
+
+    shell_print(sh, "Reconnecting ('reconnect status' shows the result)");
+    return ret;
+}
+
+static int cmd_reconnect_forget(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    wifi_mgr_forget();
+    shell_print(sh, "Cached network cleared");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(reconnect_cmds,
+    SHELL_CMD_ARG(status, NULL,
+                  "Show the cached network and recovery counters",
+                  cmd_reconnect_status, 1, 0),
+    SHELL_CMD_ARG(connect, NULL,
+                  "Connect and keep the PSK for reconnecting (RAM only)\n"
+                  "Usage: reconnect connect <ssid> <psk>",
+                  cmd_reconnect_connect, 3, 0),
+    SHELL_CMD_ARG(on, NULL,
+                  "Reconnect automatically after a drop",
+                  cmd_reconnect_on, 1, 0),
+    SHELL_CMD_ARG(off, NULL,
+                  "Stay disconnected after a drop (use before 'wifi disconnect')",
+                  cmd_reconnect_off, 1, 0),
+    SHELL_CMD_ARG(now, NULL,
+                  "Reconnect to the cached network now",
+                  cmd_reconnect_now, 1, 0),
+    SHELL_CMD_ARG(forget, NULL,
+                  "Clear the cached network",
+                  cmd_reconnect_forget, 1, 0),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(reconnect, &reconnect_cmds, "WiFi fast reconnect", NULL);
+
+#ifdef CONFIG_WIFI_PS_POLICY
+// WiFi power-save policy commands
+static int cmd_powersave_status(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    struct wifi_ps_policy_info info;
+    wifi_ps_policy_get_info(&info);
+
+    shell_print(sh, "=== WiFi Power Save ===");
+    shell_print(sh, "Mode:    %s (%s)", wifi_ps_policy_mode_name(info.mode),
+                info.forced ? "pinned" : info.streaming ? "auto, streaming" : "auto, idle");
+    shell_print(sh, "Traffic: %u packets/s | packet period %u us",
+                info.packets_per_sec, info.packet_period_us);
+    if (info.twt_active) {
+        shell_print(sh, "TWT:     flow active, wake interval %u us", info.twt_interval_us);
+    } else {
+        shell_print(sh, "TWT:     %s", info.twt_rejected ? "refused by the AP" : "no flow");
+    }
+    shell_print(sh, "Switches: %u | driver errors: %u", info.switches, info.errors);
+
+    return 0;
+}
+
+static int cmd_powersave_auto(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    wifi_ps_policy_auto();
+    shell_print(sh, "Power save follows the stream");
+    return 0;
+}
+
+static int cmd_powersave_pin(const struct shell *sh, enum wifi_ps_policy_mode mode)
+{
+    wifi_ps_policy_force(mode);
+    shell_print(sh, "Power save pinned to %s ('powersave auto' to release)",
+                wifi_ps_policy_mode_name(mode));
+    return 0;
+}
+
+static int cmd_powersave_save(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+    return cmd_powersave_pin(sh, WIFI_PS_POLICY_SAVE);
+}
+
+static int cmd_powersave_low_latency(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+    return cmd_powersave_pin(sh, WIFI_PS_POLICY_LOW_LATENCY);
+}
+
+static int cmd_powersave_twt(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+    return cmd_powersave_pin(sh, WIFI_PS_POLICY_TWT);
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(powersave_cmds,
+    SHELL_CMD_ARG(status, NULL,
+                  "Show the applied mode, traffic and TWT flow",
+                  cmd_powersave_status, 1, 0),
+    SHELL_CMD_ARG(auto, NULL,
+                  "Choose the mode from the stream state (default)",
+                  cmd_powersave_auto, 1, 0),
+    SHELL_CMD_ARG(save, NULL,
+                  "Pin aggressive power save (listen-interval wakeup)",
+                  cmd_powersave_save, 1, 0),
+    SHELL_CMD_ARG(low_latency, NULL,
+                  "Pin low-latency power save (DTIM wakeup)",
+                  cmd_powersave_low_latency, 1, 0),
+    SHELL_CMD_ARG(twt, NULL,
+                  "Pin TWT with the packet period as wake interval",
+                  cmd_powersave_twt, 1, 0),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(powersave, &powersave_cmds, "WiFi power-save policy", NULL);
+#endif
+
 // Debug/test command
 static int cmd_test_print(const struct shell *sh, size_t argc, char **argv)
 {
@@ -184,6 +1092,56 @@ static int cmd_test_print(const struct shell *sh, size_t argc, char **argv)
     return 0;
 }
 
+SHELL_STATIC_SUBCMD_SET_CREATE(rtp_stream_cmds,
+    SHELL_CMD_ARG(list, NULL,
+                  "Show stream configuration and bindings",
+                  cmd_rtp_stream_list, 1, 0),
+    SHELL_CMD_ARG(set, NULL,
+                  "Receive a source into a stream (receiver stopped)\n"
+                  "Usage: rtp stream set <idx> <port> [ssrc]\n"
+                  "  port - UDP port, 0 for the rtp start port\n"
+                  "  ssrc - Source to accept (e.g. 0x1234abcd), default any",
+                  cmd_rtp_stream_set, 3, 1),
+    SHELL_CMD_ARG(off, NULL,
+                  "Disable a stream (receiver stopped, not stream 0)\n"
+                  "Usage: rtp stream off <idx>",
+                  cmd_rtp_stream_off, 2, 0),
+    SHELL_CMD_ARG(select, NULL,
+                  "Make a stream drive the PCM ring\n"
+                  "Usage: rtp stream select <idx>",
+                  cmd_rtp_stream_select, 2, 0),
+    SHELL_CMD_ARG(gain, NULL,
+                  "Set a stream's gain; other streams than the lead are\n"
+                  "mixed in when their gain is above 0\n"
+                  "Usage: rtp stream gain <idx> <percent>",
+                  cmd_rtp_stream_gain, 3, 0),
+    SHELL_SUBCMD_SET_END
+);
+
+#ifdef CONFIG_AUDIO_AUTO_RTP_START
+static int cmd_rtp_autostart(const struct shell *sh, size_t argc, char **argv)
+{
+    if (argc > 1) {
+        if (strcmp(argv[1], "off") != 0) {
+            shell_error(sh, "Usage: rtp autostart [off]");
+            return -EINVAL;
+        }
+        rtp_autostart::clear();
+        shell_print(sh, "RTP autostart off until the next 'rtp start'");
+        return 0;
+    }
+
+    char server_ip[16];
+    uint16_t port;
+    if (rtp_autostart::get(server_ip, sizeof(server_ip), &port)) {
+        shell_print(sh, "At boot: rtp start %s %u", server_ip, port);
+    } else {
+        shell_print(sh, "No session saved, 'rtp start' saves one");
+    }
+    return 0;
+}
+#endif
+
 // Define RTP subcommands
 SHELL_STATIC_SUBCMD_SET_CREATE(rtp_cmds,
     SHELL_CMD_ARG(start, NULL, 
@@ -198,16 +1156,70 @@ SHELL_STATIC_SUBCMD_SET_CREATE(rtp_cmds,
     SHELL_CMD_ARG(status, NULL, 
                   "Show RTP receiver status", 
                   cmd_rtp_status, 1, 0),
+    SHELL_CMD_ARG(stats, NULL, 
+                  "Show RTP receive statistics\n"
+                  "Usage: rtp stats [reset]\n"
+                  "  reset - Clear all counters", 
+                  cmd_rtp_stats, 1, 1),
+    SHELL_CMD_ARG(clock, NULL,
+                  "Show the SNTP wall clock used for the network delay",
+                  cmd_rtp_clock, 1, 0),
+    SHELL_CMD(stream, &rtp_stream_cmds,
+              "Configure, select and mix RTP streams",
+              NULL),
+#ifdef CONFIG_AUDIO_AUTO_RTP_START
+    SHELL_CMD_ARG(autostart, NULL,
+                  "Show or forget the session started at boot\n"
+                  "Usage: rtp autostart [off]",
+                  cmd_rtp_autostart, 1, 1),
+#endif
     SHELL_SUBCMD_SET_END
 );
 
+// Boot milestones: a table, then one "boot_us" line of key=value pairs
+// for scripts (0 = not reached yet)
+static int cmd_boot(const struct shell *sh, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    char line[160];
+    size_t len = snprintf(line, sizeof(line), "boot_us");
+
+    shell_print(sh, "=== Boot Timing (since kernel start) ===");
+    for (size_t i = 0; i < boot_metrics::kStageCount; i++) {
+        auto stage = static_cast<boot_metrics::Stage>(i);
+        uint32_t us = boot_metrics::get(stage);
+
+        if (us) {
+            shell_print(sh, "%-14s %6u.%03u ms", boot_metrics::name(stage), us / 1000U, us % 1000U);
+        } else {
+            shell_print(sh, "%-14s        -", boot_metrics::name(stage));
+        }
+        if (len < sizeof(line)) {
+            len += snprintf(line + len, sizeof(line) - len, " %s=%u", boot_metrics::name(stage), us);
+        }
+    }
+    shell_print(sh, "%s", line);
+
+    return 0;
+}
+
 // Register root commands - only RTP and test (WiFi is provided by CONFIG_NET_L2_WIFI_SHELL)
 SHELL_CMD_REGISTER(rtp, &rtp_cmds, "RTP receiver commands", NULL);
 SHELL_CMD_REGISTER(status, NULL, "Show connection status", cmd_status);
 SHELL_CMD_REGISTER(test, NULL, "Test print output", cmd_test_print);
+SHELL_CMD_REGISTER(boot, NULL, "Show boot timing, up to the first RTP packet", cmd_boot);
 
 void shell_init(RtpReceiver& rtp)
 {
     g_rtp = &rtp;
     LOG_INF("Shell commands initialized");
 }
+
+#ifdef CONFIG_AUDIO_BROADCAST
+void shell_init_broadcast(AudioBroadcaster& bis)
+{
+    g_bis = &bis;
+}
+#endif
@@ -1,9 +1,20 @@
 #pragma once
 
 #include "../net/rtp_receiver.hpp"
+#ifdef CONFIG_AUDIO_BROADCAST
+#include "../ble/audio_broadcaster.hpp"
+#endif
 
 /**
  * @brief Initialize shell commands for WiFi and RTP control
  * @param rtp Reference to RtpReceiver instance
  */
 void shell_init(RtpReceiver& rtp);
+
+#ifdef CONFIG_AUDIO_BROADCAST
+/**
+ * @brief Register the audio broadcaster for the 'bis' commands
+ * @param bis Reference to AudioBroadcaster instance
+ */
+void shell_init_broadcast(AudioBroadcaster& bis);
+#endif
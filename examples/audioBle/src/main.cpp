@@ -1,130 +1,219 @@
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
-#include <zephyr/sys/printk.h>
 #include <zephyr/device.h>
 #include <zephyr/net/net_config.h>
 #include <zephyr/net/net_if.h>
+#include <zephyr/net/net_mgmt.h>
+#include <zephyr/net/net_event.h>
+#include <atomic>
+#include <new>
 #include "net/wifi_mgr.h"
 #include "net/rtp_receiver.hpp"
 #include "cli/shell_commands.hpp"
+#include "trace/boot_metrics.hpp"
+#ifdef CONFIG_AUDIO_AUTO_RTP_START
+#include "net/rtp_autostart.hpp"
+#endif
+#ifdef CONFIG_AUDIO_BROADCAST
+#include "ble/audio_broadcaster.hpp"
+#endif
+#ifdef CONFIG_AUDIO_LATENCY_TRACE
+#include "trace/latency_trace.hpp"
+#endif
+#ifdef CONFIG_WIFI_PS_POLICY
+#include "net/wifi_ps_policy.h"
+#endif
 
 LOG_MODULE_REGISTER(main, LOG_LEVEL_INF);
 
-int main(void)
-{
-    // Wait a bit for console to be ready
-    k_sleep(K_MSEC(100));
-    
-    // Use printk to bypass logging system for debugging
-    printk("\n\n");
-    printk("========================================\n");
-    printk("=== MAIN() STARTED - BUILD %s %s ===\n", __DATE__, __TIME__);
-    printk("========================================\n");
-    printk("If you see this, printk is working!\n");
-    printk("========================================\n");
-    
-    LOG_INF("========================================");
-    LOG_INF("=== WiFi RTP Receiver - BUILD %s %s ===", __DATE__, __TIME__);
-    LOG_INF("========================================");
-    LOG_INF("Board: nRF7002-DK");
-    LOG_INF("Firmware compiled: %s at %s", __DATE__, __TIME__);
-    
-    // Check WiFi driver configuration at compile time
-#ifdef CONFIG_WIFI_NRF70
-    printk("CONFIG_WIFI_NRF70: ENABLED\n");
-    LOG_INF("CONFIG_WIFI_NRF70: ENABLED");
-#else
-    printk("CONFIG_WIFI_NRF70: DISABLED!!!\n");
-    LOG_ERR("CONFIG_WIFI_NRF70: DISABLED!!!");
-    LOG_ERR("WiFi driver is NOT compiled in!");
+// Long-lived and large: constructed in place at boot instead of on the heap
+alignas(RtpReceiver) static uint8_t rtp_storage[sizeof(RtpReceiver)];
+#ifdef CONFIG_AUDIO_BROADCAST
+alignas(AudioBroadcaster) static uint8_t broadcaster_storage[sizeof(AudioBroadcaster)];
 #endif
 
-#ifdef CONFIG_WIFI
-    printk("CONFIG_WIFI: ENABLED\n");
-    LOG_INF("CONFIG_WIFI: ENABLED");
-#else
-    printk("CONFIG_WIFI: DISABLED!!!\n");
-    LOG_ERR("CONFIG_WIFI: DISABLED!!!");
+#ifdef CONFIG_AUDIO_AUTO_RTP_START
+// A saved session waits for the first network ready after boot
+static std::atomic<bool> autostart_pending{false};
 #endif
 
-#ifdef CONFIG_NETWORKING
-    printk("CONFIG_NETWORKING: ENABLED\n");
-    LOG_INF("CONFIG_NETWORKING: ENABLED");
-#else
-    printk("CONFIG_NETWORKING: DISABLED!!!\n");
-    LOG_ERR("CONFIG_NETWORKING: DISABLED!!!");
-#endif
-    
-    printk("\n");
-    LOG_INF("Use shell commands to control:");
-    LOG_INF("  wifi connect -s <ssid> -p <password>  - Connect to WiFi");
-    LOG_INF("  wifi scan                             - Scan for networks");
-    LOG_INF("  wifi disconnect                       - Disconnect");
-    LOG_INF("  rtp start [port]                      - Start RTP receiver");
-    LOG_INF("  rtp status                            - Show RTP status");
-    LOG_INF("");
-
-    // Initialize network stack - CRITICAL for WiFi to work!
-    printk("Initializing network configuration...\n");
-#ifdef CONFIG_NET_CONFIG_SETTINGS
-    const struct device *dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_wifi));
-    if (device_is_ready(dev)) {
-        struct net_if *wifi_iface = net_if_lookup_by_dev(dev);
-        if (wifi_iface) {
-            // Set WiFi as default interface
-            net_if_set_default(wifi_iface);
-            LOG_INF("WiFi interface set as default");
-            
-            // Initialize network config (starts DHCP, etc.)
-            net_config_init_app(dev, "Initializing network");
-            LOG_INF("Network configuration initialized");
-            
-            // Explicitly bring up the WiFi interface
-            if (!net_if_is_up(wifi_iface)) {
-                LOG_INF("Bringing up WiFi interface...");
-                net_if_up(wifi_iface);
-                k_sleep(K_SECONDS(1));
-                
-                if (net_if_is_up(wifi_iface)) {
-                    LOG_INF("WiFi interface is now UP");
-                } else {
-                    LOG_ERR("Failed to bring up WiFi interface!");
-                }
-            } else {
-                LOG_INF("WiFi interface already UP");
-            }
+// The interface has an address again (after a drop, or another lease):
+// a running RTP session gets new sockets and sends its hello right away
+static void on_network_ready(void* user_data)
+{
+    RtpReceiver* rtp = static_cast<RtpReceiver*>(user_data);
+
+    boot_metrics::mark(boot_metrics::Stage::NetworkReady);
+
+    if (rtp->isRunning()) {
+        rtp->resume();
+        return;
+    }
+
+#ifdef CONFIG_AUDIO_AUTO_RTP_START
+    char server_ip[16];
+    uint16_t port;
+    if (autostart_pending.exchange(false) && rtp_autostart::get(server_ip, sizeof(server_ip), &port)) {
+        int ret = rtp->start(server_ip, port);
+        if (ret < 0) {
+            LOG_ERR("RTP autostart with %s:%u failed: %d", server_ip, port, ret);
         } else {
-            LOG_ERR("Failed to get WiFi network interface!");
+            LOG_INF("RTP autostart with %s:%u", server_ip, port);
         }
-    } else {
+    }
+#endif
+}
+
+#ifdef CONFIG_NET_CONFIG_SETTINGS
+static struct net_mgmt_event_callback iface_cb;
+static struct net_if* wifi_iface;
+
+static void on_iface_up()
+{
+    if (!boot_metrics::mark(boot_metrics::Stage::IfaceUp)) {
+        return;
+    }
+    LOG_INF("WiFi interface is up");
+
+#ifdef CONFIG_AUDIO_AUTO_CONNECT
+    // Directed connect to the cached BSSID and channel, as after a drop
+    int ret = wifi_mgr_reconnect();
+    if (ret == -ENOENT) {
+        LOG_INF("No cached network, connect with 'reconnect connect' once");
+    } else if (ret < 0 && ret != -EALREADY) {
+        LOG_ERR("WiFi auto-connect failed: %d", ret);
+    }
+#endif
+}
+
+static void handle_iface_event(struct net_mgmt_event_callback* cb, uint32_t mgmt_event,
+                               struct net_if* iface)
+{
+    ARG_UNUSED(cb);
+
+    if (mgmt_event == NET_EVENT_IF_ADMIN_UP && iface == wifi_iface) {
+        on_iface_up();
+    }
+}
+
+// Bring the interface up without waiting for it: NET_EVENT_IF_ADMIN_UP
+// reports when it is, and the rest of the boot goes on. (Operationally
+// the WiFi interface stays dormant until it associates.)
+static void start_network()
+{
+    const struct device* dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_wifi));
+    if (!device_is_ready(dev)) {
         LOG_ERR("WiFi device not ready!");
+        return;
     }
-#else
-    LOG_WRN("CONFIG_NET_CONFIG_SETTINGS not enabled - network may not work properly");
+    wifi_iface = net_if_lookup_by_dev(dev);
+    if (!wifi_iface) {
+        LOG_ERR("Failed to get WiFi network interface!");
+        return;
+    }
+
+    net_if_set_default(wifi_iface);
+    net_mgmt_init_event_callback(&iface_cb, handle_iface_event, NET_EVENT_IF_ADMIN_UP);
+    net_mgmt_add_event_callback(&iface_cb);
+
+    // Starts DHCP once the interface is up
+    net_config_init_app(dev, "Initializing network");
+
+    if (!net_if_is_admin_up(wifi_iface)) {
+        int ret = net_if_up(wifi_iface);
+        if (ret < 0 && ret != -EALREADY) {
+            LOG_ERR("Failed to bring up WiFi interface: %d", ret);
+            return;
+        }
+    }
+    // Already up, or up synchronously: the event may have come and gone
+    if (net_if_is_admin_up(wifi_iface)) {
+        on_iface_up();
+    }
+}
+#endif
+
+int main(void)
+{
+    boot_metrics::mark(boot_metrics::Stage::Main);
+
+    LOG_INF("WiFi RTP Receiver on nRF7002-DK, build %s %s", __DATE__, __TIME__);
+#ifdef CONFIG_LOG_MODE_IMMEDIATE
+    LOG_WRN("Immediate logging (bring-up profile): log output can stall RTP reception, "
+            "build with production.conf for deferred logging");
+#endif
+
+    // Check WiFi driver configuration at compile time
+#ifndef CONFIG_WIFI_NRF70
+    LOG_ERR("CONFIG_WIFI_NRF70: DISABLED, the WiFi driver is NOT compiled in!");
+#endif
+#ifndef CONFIG_WIFI
+    LOG_ERR("CONFIG_WIFI: DISABLED!");
 #endif
+#ifndef CONFIG_NETWORKING
+    LOG_ERR("CONFIG_NETWORKING: DISABLED!");
+#endif
+
+#ifdef CONFIG_AUDIO_LATENCY_TRACE
+    // Trace from the first packet on; 'trace stats' reads the ring
+    latency_trace::init();
+    LOG_INF("Latency tracing enabled");
+#endif
+
+    // Nothing below waits for the network: the shell is usable while the
+    // interface comes up and associates
+    RtpReceiver* rtpReceiver = new (rtp_storage) RtpReceiver();
+
+    // Recover WiFi drops (also of 'wifi connect' sessions) and resume RTP.
+    // Also initializes settings and loads the cached network.
+    int wifi_ret = wifi_mgr_init();
+    if (wifi_ret < 0) {
+        LOG_ERR("WiFi reconnect engine failed to start: %d", wifi_ret);
+    }
+
+#ifdef CONFIG_AUDIO_AUTO_RTP_START
+    char server_ip[16];
+    uint16_t port;
+    rtp_autostart::load();
+    if (rtp_autostart::get(server_ip, sizeof(server_ip), &port)) {
+        LOG_INF("RTP autostart with %s:%u once the network is ready", server_ip, port);
+        autostart_pending = true;
+    }
+#endif
+    wifi_mgr_set_ip_callback(on_network_ready, rtpReceiver);
 
-    printk("About to create RtpReceiver instance...\n");
-    static RtpReceiver* rtpReceiver = nullptr;
-    rtpReceiver = new RtpReceiver();
-    printk("RtpReceiver created successfully at %p\n", rtpReceiver);
-    
-    LOG_INF("RtpReceiver created successfully");
+#ifdef CONFIG_WIFI_PS_POLICY
+    // Before the first connect: the idle listen interval is set at association
+    int ps_ret = wifi_ps_policy_init();
+    if (ps_ret < 0) {
+        LOG_ERR("WiFi power-save policy failed to start: %d", ps_ret);
+    }
+#endif
 
-    // Initialize shell commands
-    printk("Initializing shell commands...\n");
     shell_init(*rtpReceiver);
-    printk("Shell commands initialized\n");
-    LOG_INF("Shell commands initialized");
 
-    printk("Ready! Type 'help' for available commands\n\n");
-    LOG_INF("Ready! Type 'help' for available commands");
-    LOG_INF("");
+#ifdef CONFIG_AUDIO_BROADCAST
+    // Broadcast whatever the receiver puts in the PCM ring (silence until
+    // an RTP stream is running)
+    AudioBroadcaster* broadcaster =
+        new (broadcaster_storage) AudioBroadcaster(rtpReceiver->getPcmRing());
+    shell_init_broadcast(*broadcaster);
 
-    printk("Entering main loop...\n");
-    // Main loop - shell handles commands
-    while (1) {
-        k_sleep(K_SECONDS(1));
+    int bis_ret = broadcaster->start();
+    if (bis_ret < 0) {
+        LOG_ERR("LE Audio broadcast failed to start: %d (retry with 'bis start')", bis_ret);
     }
+#endif
+
+    boot_metrics::mark(boot_metrics::Stage::ShellReady);
+    LOG_INF("Ready! Type 'help' for available commands, 'boot' for boot timing");
+
+#ifdef CONFIG_NET_CONFIG_SETTINGS
+    start_network();
+#else
+    LOG_WRN("CONFIG_NET_CONFIG_SETTINGS not enabled - network may not work properly");
+#endif
 
+    // Everything else runs in its own threads and work queues
     return 0;
 }
@@ -0,0 +1,39 @@
+#include "packet_pool.hpp"
+#include <zephyr/kernel.h>
+
+PacketBuf* PacketPool::alloc()
+{
+    void* block = nullptr;
+
+    if (k_mem_slab_alloc(m_slab, &block, K_NO_WAIT) != 0) {
+        m_alloc_failures++;
+        return nullptr;
+    }
+
+    uint32_t used = k_mem_slab_num_used_get(m_slab);
+    if (used > m_high_water) {
+        m_high_water = used;
+    }
+
+    PacketBuf* buf = static_cast<PacketBuf*>(block);
+    buf->length = 0;
+    buf->arrival_us = 0;
+    return buf;
+}
+
+void PacketPool::free(PacketBuf* buf)
+{
+    if (buf) {
+        k_mem_slab_free(m_slab, buf);
+    }
+}
+
+uint32_t PacketPool::freeCount() const
+{
+    return k_mem_slab_num_free_get(m_slab);
+}
+
+uint32_t PacketPool::capacity() const
+{
+    return m_slab->info.num_blocks;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// Defaults for builds without Kconfig (host tools); see audioBle/Kconfig
+#ifndef CONFIG_RTP_PACKET_BUF_SIZE
+#define CONFIG_RTP_PACKET_BUF_SIZE 1536
+#endif
+
+struct k_mem_slab;
+
+/**
+ * @brief One received datagram, a fixed-size block owned by a PacketPool
+ *
+ * recvfrom() writes straight into data[]; the parsed payload is referenced
+ * in place, so the block travels parse -> jitter buffer -> decoder without
+ * a copy. Whoever holds the pointer owns the block and must free it.
+ */
+struct PacketBuf {
+    size_t length;        // Datagram length in data[]
+    uint32_t arrival_us;  // Receive time, free-running microseconds
+    uint32_t arrival_cyc; // Receive time in hardware cycles (clock recovery)
+#ifdef CONFIG_AUDIO_LATENCY_TRACE
+    uint32_t trace_cyc;   // recvfrom() return, latency_trace::now()
+#endif
+    uint8_t data[CONFIG_RTP_PACKET_BUF_SIZE];
+};
+
+/**
+ * @brief Preallocated pool of PacketBuf blocks backed by a k_mem_slab
+ *
+ * alloc() never blocks, so it is safe on the receive hot path; free() may
+ * be called from any thread or ISR.
+ */
+class PacketPool {
+public:
+    explicit PacketPool(struct k_mem_slab* slab) : m_slab(slab) {}
+
+    /**
+     * @brief Take a block from the pool
+     * @return Block, or nullptr if the pool is exhausted
+     */
+    PacketBuf* alloc();
+
+    /**
+     * @brief Return a block to the pool (nullptr is ignored)
+     */
+    void free(PacketBuf* buf);
+
+    /**
+     * @brief Number of blocks currently free
+     */
+    uint32_t freeCount() const;
+
+    /**
+     * @brief Total number of blocks in the pool
+     */
+    uint32_t capacity() const;
+
+    /**
+     * @brief Largest number of blocks in use at the same time
+     */
+    uint32_t highWater() const { return m_high_water; }
+
+    /**
+     * @brief Number of alloc() calls that found the pool empty
+     */
+    uint32_t allocFailures() const { return m_alloc_failures; }
+
+private:
+    struct k_mem_slab* m_slab;
+    uint32_t m_high_water = 0;
+    uint32_t m_alloc_failures = 0;
+};
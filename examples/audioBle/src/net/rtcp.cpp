@@ -0,0 +1,150 @@
+#include "rtcp.hpp"
+#include <cerrno>
+#include <cstring>
+
+static void put_be16(uint8_t* p, uint16_t v)
+{
+    p[0] = v >> 8;
+    p[1] = v & 0xFF;
+}
+
+static void put_be32(uint8_t* p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = (v >> 16) & 0xFF;
+    p[2] = (v >> 8) & 0xFF;
+    p[3] = v & 0xFF;
+}
+
+static uint32_t get_be32(const uint8_t* p)
+{
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+RtcpReporter::RtcpReporter(const char* cname)
+{
+    m_cname_len = strlen(cname);
+    if (m_cname_len > sizeof(m_cname) - 1) {
+        m_cname_len = sizeof(m_cname) - 1;
+    }
+    memcpy(m_cname, cname, m_cname_len);
+}
+
+void RtcpReporter::reset(uint32_t ssrc)
+{
+    m_ssrc = ssrc;
+    m_have_prior = false;
+    m_expected_prior = 0;
+    m_received_prior = 0;
+    m_last_fraction = 0;
+    m_lsr = 0;
+    m_lsr_arrival_us = 0;
+    m_sr_ssrc = 0;
+    m_sr_count = 0;
+}
+
+int RtcpReporter::onPacket(const uint8_t* packet, size_t length, uint32_t arrivalUs)
+{
+    int reports = 0;
+    size_t offset = 0;
+
+    // Walk the compound packet: each part has a 4-byte header with its length
+    while (offset + 4 <= length) {
+        const uint8_t* part = packet + offset;
+        if ((part[0] >> 6) != 2) {
+            return -EINVAL;
+        }
+
+        size_t part_len = (((part[2] << 8) | part[3]) + 1) * 4;
+        if (offset + part_len > length) {
+            return -EINVAL;
+        }
+
+        // SR: header, SSRC, NTP msw, NTP lsw, RTP ts, packet count, octet count
+        if (part[1] == kTypeSR && part_len >= 28 &&
+            (m_source_ssrc == 0 || get_be32(part + 4) == m_source_ssrc)) {
+            uint32_t ntp_msw = get_be32(part + 8);
+            uint32_t ntp_lsw = get_be32(part + 12);
+            m_sr_ssrc = get_be32(part + 4);
+            m_lsr = (ntp_msw << 16) | (ntp_lsw >> 16);
+            m_lsr_arrival_us = arrivalUs;
+            m_sr_count++;
+            reports++;
+        }
+
+        offset += part_len;
+    }
+
+    return reports;
+}
+
+size_t RtcpReporter::buildReceiverReport(uint8_t* buf, size_t size,
+                                         const RtcpSourceState& source, uint32_t nowUs)
+{
+    if (size < kMaxReportSize) {
+        return 0;
+    }
+
+    // Fraction lost over the interval since the last report (RFC 3550 A.3)
+    // A stats reset moves the totals backwards: start a fresh interval
+    if (source.expected < m_expected_prior || source.received < m_received_prior) {
+        m_have_prior = false;
+    }
+
+    uint32_t expected_interval = source.expected - m_expected_prior;
+    uint32_t received_interval = source.received - m_received_prior;
+    uint8_t fraction = 0;
+    if (m_have_prior && expected_interval > 0 && expected_interval > received_interval) {
+        uint32_t lost_interval = expected_interval - received_interval;
+        fraction = static_cast<uint8_t>((lost_interval << 8) / expected_interval);
+    }
+    m_have_prior = true;
+    m_expected_prior = source.expected;
+    m_received_prior = source.received;
+    m_last_fraction = fraction;
+
+    // Cumulative lost is a signed 24-bit value, clamped
+    int32_t cumulative = static_cast<int32_t>(source.expected - source.received);
+    if (cumulative > 0x7FFFFF) {
+        cumulative = 0x7FFFFF;
+    }
+
+    // DLSR in units of 1/65536 s, 0 if no SR has been received yet
+    uint32_t dlsr = 0;
+    if (m_sr_count > 0) {
+        uint64_t delay_us = nowUs - m_lsr_arrival_us;
+        dlsr = static_cast<uint32_t>((delay_us << 16) / 1000000);
+    }
+
+    uint8_t* p = buf;
+
+    // RR: V=2, RC=1, length 7 words
+    p[0] = 0x81;
+    p[1] = kTypeRR;
+    put_be16(p + 2, 7);
+    put_be32(p + 4, m_ssrc);
+    put_be32(p + 8, source.ssrc);
+    put_be32(p + 12, (static_cast<uint32_t>(fraction) << 24) |
+                     (static_cast<uint32_t>(cumulative) & 0xFFFFFF));
+    put_be32(p + 16, source.extended_max_seq);
+    put_be32(p + 20, source.jitter_ts);
+    put_be32(p + 24, m_sr_count > 0 ? m_lsr : 0);
+    put_be32(p + 28, dlsr);
+    p += 32;
+
+    // SDES: one chunk with CNAME, null-terminated item list padded to 32 bits
+    size_t chunk_len = 4 + 2 + m_cname_len + 1;
+    size_t padded = (chunk_len + 3) & ~static_cast<size_t>(3);
+    p[0] = 0x81;
+    p[1] = kTypeSDES;
+    put_be16(p + 2, static_cast<uint16_t>(padded / 4));
+    put_be32(p + 4, m_ssrc);
+    p[8] = 1;  // CNAME
+    p[9] = static_cast<uint8_t>(m_cname_len);
+    memcpy(p + 10, m_cname, m_cname_len);
+    memset(p + 10 + m_cname_len, 0, padded - (chunk_len - 1));
+    p += 4 + padded;
+
+    return p - buf;
+}
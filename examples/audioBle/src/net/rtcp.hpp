@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// Receive-side state of one RTP source, as needed for a report block
+struct RtcpSourceState {
+    uint32_t ssrc;            // Source being reported on
+    uint32_t extended_max_seq;
+    uint32_t expected;        // Packets expected so far (cumulative)
+    uint32_t received;        // Unique packets received so far (cumulative)
+    uint32_t jitter_ts;       // Interarrival jitter in RTP timestamp units
+};
+
+/**
+ * @brief RTCP receiver report generation and sender report tracking (RFC 3550)
+ *
+ * buildReceiverReport() produces a compound RR + SDES(CNAME) packet with one
+ * report block; fraction lost is computed over the interval since the
+ * previous report. onPacket() picks up sender reports so the RR can carry
+ * LSR/DLSR, which lets the sender measure the round-trip time.
+ *
+ * Pure byte-level code, no sockets, so it can be built on the host.
+ */
+class RtcpReporter {
+public:
+    static constexpr uint8_t kTypeSR = 200;
+    static constexpr uint8_t kTypeRR = 201;
+    static constexpr uint8_t kTypeSDES = 202;
+
+    // RR with one block (32) + SDES with a short CNAME
+    static constexpr size_t kMaxReportSize = 32 + 8 + 2 + 32 + 2;
+
+    /**
+     * @param cname SDES CNAME, truncated to 32 characters
+     */
+    explicit RtcpReporter(const char* cname);
+
+    /**
+     * @brief Start a new session: forget interval and sender report state
+     * @param ssrc Our own SSRC (packet sender of the RR), should be random
+     */
+    void reset(uint32_t ssrc);
+
+    /**
+     * @brief Only track sender reports from this source (0 accepts any)
+     *
+     * Needed when several sources share one RTCP port.
+     */
+    void setSourceSsrc(uint32_t ssrc) { m_source_ssrc = ssrc; }
+
+    /**
+     * @brief Process a received RTCP (compound) packet
+     * @param packet RTCP datagram
+     * @param length Datagram length
+     * @param arrivalUs Arrival time in microseconds (free-running)
+     * @return Number of sender reports accepted, negative if malformed
+     */
+    int onPacket(const uint8_t* packet, size_t length, uint32_t arrivalUs);
+
+    /**
+     * @brief Build a compound RR + SDES packet
+     * @param buf Output buffer, at least kMaxReportSize bytes
+     * @param size Output buffer size
+     * @param source Current receive state of the reported source
+     * @param nowUs Current time in microseconds (same clock as onPacket)
+     * @return Packet length, or 0 if buf is too small
+     */
+    size_t buildReceiverReport(uint8_t* buf, size_t size, const RtcpSourceState& source,
+                               uint32_t nowUs);
+
+    /**
+     * @brief Fraction lost (0..255 = 0..100%) sent in the last report
+     */
+    uint8_t lastFractionLost() const { return m_last_fraction; }
+
+    /**
+     * @brief Number of sender reports received
+     */
+    uint32_t senderReports() const { return m_sr_count; }
+
+private:
+    uint32_t m_ssrc = 0;
+    uint32_t m_source_ssrc = 0;  // Sender reports accepted from, 0 = any
+    char m_cname[33] = {0};
+    size_t m_cname_len = 0;
+
+    // Interval state for fraction lost
+    bool m_have_prior = false;
+    uint32_t m_expected_prior = 0;
+    uint32_t m_received_prior = 0;
+    uint8_t m_last_fraction = 0;
+
+    // Last sender report, for LSR/DLSR
+    uint32_t m_lsr = 0;          // Middle 32 bits of the SR NTP timestamp
+    uint32_t m_lsr_arrival_us = 0;
+    uint32_t m_sr_ssrc = 0;
+    uint32_t m_sr_count = 0;
+};
@@ -0,0 +1,102 @@
+#include "rtp_autostart.hpp"
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/settings/settings.h>
+#include <cstring>
+
+LOG_MODULE_REGISTER(rtp_autostart, LOG_LEVEL_INF);
+
+namespace rtp_autostart {
+
+namespace {
+
+constexpr uint8_t kVersion = 1;
+
+// Settings value "rtp/server"; port 0: nothing saved
+struct Session {
+    uint8_t version;
+    char server_ip[16];
+    uint16_t port;
+};
+
+K_MUTEX_DEFINE(s_lock);
+Session s_session;
+
+int settingsSet(const char* name, size_t len, settings_read_cb read_cb, void* cb_arg)
+{
+    Session loaded;
+
+    if (!settings_name_steq(name, "server", nullptr)) {
+        return -ENOENT;
+    }
+    if (len != sizeof(loaded)) {
+        // Other layout: forget it, the next 'rtp start' writes a new one
+        return 0;
+    }
+
+    ssize_t rc = read_cb(cb_arg, &loaded, sizeof(loaded));
+    if (rc < 0) {
+        return static_cast<int>(rc);
+    }
+    loaded.server_ip[sizeof(loaded.server_ip) - 1] = '\0';
+    if (loaded.version == kVersion && loaded.port != 0) {
+        k_mutex_lock(&s_lock, K_FOREVER);
+        s_session = loaded;
+        k_mutex_unlock(&s_lock);
+    }
+    return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(rtp_autostart, "rtp", nullptr, settingsSet, nullptr, nullptr);
+
+}  // namespace
+
+int load()
+{
+    return settings_load_subtree("rtp");
+}
+
+bool get(char* server_ip, size_t len, uint16_t* port)
+{
+    k_mutex_lock(&s_lock, K_FOREVER);
+    bool saved = s_session.port != 0;
+    if (saved) {
+        strncpy(server_ip, s_session.server_ip, len - 1);
+        server_ip[len - 1] = '\0';
+        *port = s_session.port;
+    }
+    k_mutex_unlock(&s_lock);
+    return saved;
+}
+
+int save(const char* server_ip, uint16_t port)
+{
+    Session session;
+    memset(&session, 0, sizeof(session));
+    session.version = kVersion;
+    strncpy(session.server_ip, server_ip, sizeof(session.server_ip) - 1);
+    session.port = port;
+
+    k_mutex_lock(&s_lock, K_FOREVER);
+    int ret = 0;
+    if (session.port != s_session.port || strcmp(session.server_ip, s_session.server_ip) != 0) {
+        ret = settings_save_one("rtp/server", &session, sizeof(session));
+        if (ret == 0) {
+            s_session = session;
+        } else {
+            LOG_WRN("Failed to save RTP session: %d", ret);
+        }
+    }
+    k_mutex_unlock(&s_lock);
+    return ret;
+}
+
+void clear()
+{
+    k_mutex_lock(&s_lock, K_FOREVER);
+    memset(&s_session, 0, sizeof(s_session));
+    settings_delete("rtp/server");
+    k_mutex_unlock(&s_lock);
+}
+
+}  // namespace rtp_autostart
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Last RTP session, kept in settings for 'rtp start' at boot
+ *
+ * A successful 'rtp start' saves the server address and port as the
+ * settings value "rtp/server". At boot (CONFIG_AUDIO_AUTO_RTP_START) the
+ * receiver starts with them as soon as the network is first ready.
+ */
+namespace rtp_autostart {
+
+/**
+ * @brief Load the saved session (call after settings_subsys_init())
+ * @return 0 on success, negative error code on failure
+ */
+int load();
+
+/**
+ * @brief Get the saved session
+ * @param server_ip Output buffer for the IPv4 address string
+ * @param len Buffer length, at least 16
+ * @param port Output port
+ * @return true if a session is saved
+ */
+bool get(char* server_ip, size_t len, uint16_t* port);
+
+/**
+ * @brief Save a session (written only if it changed)
+ * @return 0 on success, negative error code on failure
+ */
+int save(const char* server_ip, uint16_t port);
+
+/**
+ * @brief Forget the saved session (RAM and settings)
+ */
+void clear();
+
+}  // namespace rtp_autostart
@@ -0,0 +1,117 @@
+#include "rtp_parser.hpp"
+
+void RtpParser::setPayloadTypeFilter(int payloadType)
+{
+    if (payloadType < 0) {
+        m_payloadType = 0;
+        m_payloadTypeMask = 0;
+    } else {
+        m_payloadType = static_cast<uint8_t>(payloadType & 0x7F);
+        m_payloadTypeMask = 0xFF;
+    }
+}
+
+void RtpParser::setSsrcFilter(uint32_t ssrc)
+{
+    m_ssrc = ssrc;
+    m_ssrcMask = 0xFFFFFFFF;
+}
+
+void RtpParser::clearSsrcFilter()
+{
+    m_ssrc = 0;
+    m_ssrcMask = 0;
+}
+
+uint64_t RtpParser::findSendTime(const uint8_t* ext, size_t length) const
+{
+    // One-byte elements: ID (4 bits), length - 1 (4 bits), data.
+    // ID 0 is a padding byte, ID 15 ends the list
+    size_t pos = 0;
+    while (pos < length) {
+        uint8_t id = ext[pos] >> 4;
+        size_t len = (ext[pos] & 0x0F) + 1;
+
+        if (id == 0) {
+            pos++;
+            continue;
+        }
+        if (id == 15 || pos + 1 + len > length) {
+            break;
+        }
+        if (id == m_sendTimeExtId && len == 8) {
+            return (static_cast<uint64_t>(loadBe32(ext + pos + 1)) << 32) |
+                   loadBe32(ext + pos + 5);
+        }
+        pos += 1 + len;
+    }
+    return 0;
+}
+
+__attribute__((noinline, cold))
+int RtpParser::parseSlow(const uint8_t* packet, size_t length, RtpPacket* out) const
+{
+    if (length < kHeaderSize) {
+        return -EINVAL;
+    }
+
+    // Extract version (top 2 bits)
+    uint8_t vpxcc = packet[0];
+    if ((vpxcc >> 6) != 2) {
+        return -EINVAL;
+    }
+
+    bool padding = (vpxcc & 0x20) != 0;
+    bool extension = (vpxcc & 0x10) != 0;
+    size_t csrcCount = vpxcc & 0x0F;
+
+    // Fixed header, then CSRC list
+    size_t headerSize = kHeaderSize + csrcCount * 4;
+
+    // Extension header: 16-bit profile, 16-bit length in 32-bit words
+    size_t extStart = 0;
+    size_t extBytes = 0;
+    uint16_t extProfile = 0;
+    if (extension) {
+        if (length < headerSize + 4) {
+            return -EINVAL;
+        }
+        extProfile = static_cast<uint16_t>((packet[headerSize] << 8) | packet[headerSize + 1]);
+        extBytes = ((packet[headerSize + 2] << 8) | packet[headerSize + 3]) * 4;
+        extStart = headerSize + 4;
+        headerSize = extStart + extBytes;
+    }
+
+    if (headerSize > length) {
+        return -EINVAL;
+    }
+
+    out->sendTimeNtp = 0;
+    if (extProfile == kOneByteExtProfile && m_sendTimeExtId != 0) {
+        out->sendTimeNtp = findSendTime(packet + extStart, extBytes);
+    }
+
+    size_t payloadLen = length - headerSize;
+
+    // Last payload byte counts the padding bytes, including itself
+    if (padding) {
+        if (payloadLen == 0) {
+            return -EINVAL;
+        }
+        size_t paddingLen = packet[length - 1];
+        if (paddingLen == 0 || paddingLen > payloadLen) {
+            return -EINVAL;
+        }
+        payloadLen -= paddingLen;
+    }
+
+    out->payloadType = packet[1] & 0x7F;
+    out->marker = (packet[1] & 0x80) != 0;
+    out->sequence = static_cast<uint16_t>((packet[2] << 8) | packet[3]);
+    out->timestamp = loadBe32(packet + 4);
+    out->ssrc = loadBe32(packet + 8);
+    out->payload = packet + headerSize;
+    out->payloadLen = payloadLen;
+
+    return filter(out);
+}
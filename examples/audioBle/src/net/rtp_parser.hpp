@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cerrno>
+
+// RTP Header structure (RFC 3550)
+struct RtpHeader {
+    uint8_t vpxcc;      // Version, Padding, Extension, CSRC count
+    uint8_t mpt;        // Marker, Payload type
+    uint16_t sequence;  // Sequence number
+    uint32_t timestamp; // Timestamp
+    uint32_t ssrc;      // Synchronization source identifier
+};
+
+// Parsed RTP packet (fields in host byte order)
+struct RtpPacket {
+    uint16_t sequence;
+    uint32_t timestamp;
+    uint32_t ssrc;
+    uint8_t payloadType;
+    bool marker;
+    const uint8_t* payload;  // Points into the received datagram (no copy)
+    size_t payloadLen;
+    uint64_t sendTimeNtp;    // Send-time header extension (NTP format), 0 if absent
+};
+
+/**
+ * @brief RTP header parser with a fast path for the common case
+ *
+ * Almost every packet we receive is V=2 with no padding, extension or
+ * CSRCs, i.e. a first byte of exactly 0x80. parse() checks that with one
+ * compare and decodes the fixed 12-byte header with byte loads (no
+ * unaligned word access). Everything else goes to an out-of-line slow path.
+ *
+ * No logging: errors are reported through the return value only, so the
+ * caller decides what to count or print.
+ */
+class RtpParser {
+public:
+    static constexpr size_t kHeaderSize = 12;
+    static constexpr uint16_t kOneByteExtProfile = 0xBEDE;  // RFC 8285
+
+    /**
+     * @brief Only accept packets with this payload type
+     * @param payloadType 0..127, or negative to accept any
+     */
+    void setPayloadTypeFilter(int payloadType);
+
+    /**
+     * @brief Only accept packets from this SSRC
+     */
+    void setSsrcFilter(uint32_t ssrc);
+
+    /**
+     * @brief Accept packets from any SSRC
+     */
+    void clearSsrcFilter();
+
+    /**
+     * @brief Decode the send-time header extension with this ID
+     *
+     * An RFC 8285 one-byte element of 8 bytes: the sender's wall clock as
+     * a 64-bit NTP timestamp (tools/stream_audio.py --bench sends ID 1).
+     * @param id Element ID 1..14, 0 to ignore header extensions
+     */
+    void setSendTimeExtensionId(uint8_t id) { m_sendTimeExtId = id < 15 ? id : 0; }
+
+    /**
+     * @brief Parse an RTP packet
+     * @param packet Raw datagram (any alignment)
+     * @param length Datagram length
+     * @param out Output parsed packet; payload points into packet
+     * @return 0 on success, -EINVAL if malformed, -ENOMSG if filtered out
+     */
+    int parse(const uint8_t* packet, size_t length, RtpPacket* out) const
+    {
+        if (__builtin_expect(length >= kHeaderSize && packet[0] == 0x80, 1)) {
+            out->payloadType = packet[1] & 0x7F;
+            out->marker = (packet[1] & 0x80) != 0;
+            out->sequence = static_cast<uint16_t>((packet[2] << 8) | packet[3]);
+            out->timestamp = loadBe32(packet + 4);
+            out->ssrc = loadBe32(packet + 8);
+            out->payload = packet + kHeaderSize;
+            out->payloadLen = length - kHeaderSize;
+            out->sendTimeNtp = 0;
+            return filter(out);
+        }
+        return parseSlow(packet, length, out);
+    }
+
+private:
+    static uint32_t loadBe32(const uint8_t* p)
+    {
+        return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+               (static_cast<uint32_t>(p[2]) << 8) | p[3];
+    }
+
+    int filter(const RtpPacket* pkt) const
+    {
+        uint32_t mismatch = ((pkt->payloadType ^ m_payloadType) & m_payloadTypeMask) |
+                            ((pkt->ssrc ^ m_ssrc) & m_ssrcMask);
+        return mismatch ? -ENOMSG : 0;
+    }
+
+    int parseSlow(const uint8_t* packet, size_t length, RtpPacket* out) const;
+    uint64_t findSendTime(const uint8_t* ext, size_t length) const;
+
+    // Filters are compared unconditionally and masked, no extra branches
+    uint8_t m_payloadType = 0;
+    uint8_t m_payloadTypeMask = 0;  // 0xFF when the payload type filter is on
+    uint32_t m_ssrc = 0;
+    uint32_t m_ssrcMask = 0;        // 0xFFFFFFFF when the SSRC filter is on
+    uint8_t m_sendTimeExtId = 0;
+};
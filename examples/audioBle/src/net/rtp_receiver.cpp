@@ -1,190 +1,553 @@
 #include "rtp_receiver.hpp"
+#include "../audio/dsp.hpp"
+#include "../trace/boot_metrics.hpp"
+#include "../trace/cycle_counter.hpp"
+#include "../trace/latency_trace.hpp"
+#include "../util/log_throttle.hpp"
+#include "wifi_mgr.h"
+#ifdef CONFIG_WIFI_PS_POLICY
+#include "wifi_ps_policy.h"
+#endif
 #include <zephyr/logging/log.h>
 #include <zephyr/net/socket.h>
 #include <zephyr/posix/arpa/inet.h>
 #include <zephyr/posix/unistd.h>
 #include <zephyr/posix/fcntl.h>
+#include <zephyr/posix/poll.h>
+#include <zephyr/posix/sys/eventfd.h>
+#include <zephyr/random/random.h>
+#include <climits>
+
+LOG_MODULE_REGISTER(rtp_receiver, CONFIG_RTP_RX_LOG_LEVEL);
+
+// Defaults for builds without Kconfig (host tools); see audioBle/Kconfig
+#ifndef CONFIG_RTP_RX_THREAD_STACK_SIZE
+#define CONFIG_RTP_RX_THREAD_STACK_SIZE 4096
+#endif
+#ifndef CONFIG_RTP_RX_THREAD_PRIORITY
+#define CONFIG_RTP_RX_THREAD_PRIORITY 5
+#endif
+#ifndef CONFIG_RTP_SOCKET_RCVBUF
+#define CONFIG_RTP_SOCKET_RCVBUF 0
+#endif
+#ifndef CONFIG_RTP_SEND_TIME_EXT_ID
+#define CONFIG_RTP_SEND_TIME_EXT_ID 1
+#endif
+
+#define RTP_HELLO_INTERVAL_MS 2000
+#define RTP_STATS_INTERVAL_MS 5000
+#define RTP_PS_REPORT_INTERVAL_MS 500  // Traffic reports to the WiFi power-save policy
+#define RTP_STREAM_REBIND_MS 1000  // Silence after which a stream takes a new SSRC
+#define RTCP_RX_BUF_SIZE 256
+
+static K_THREAD_STACK_DEFINE(rtp_thread_stack, CONFIG_RTP_RX_THREAD_STACK_SIZE);
+static struct k_thread rtp_thread_data;
+static bool rtp_instance_created;
+
+// Datagrams are received straight into these blocks (see packet_pool.hpp).
+// All jitter buffers draw from it: a burst on every stream at once must
+// not run it dry while each stream is still within its own depth
+static_assert(CONFIG_RTP_PACKET_POOL_SIZE >=
+              CONFIG_RTP_MAX_STREAMS * CONFIG_RTP_JITTER_BUFFER_MAX_DEPTH + CONFIG_RTP_RX_BATCH_SIZE + 1,
+              "RTP_PACKET_POOL_SIZE must cover RTP_MAX_STREAMS full jitter buffers plus one batch");
+K_MEM_SLAB_DEFINE_STATIC(rtp_packet_slab, sizeof(PacketBuf), CONFIG_RTP_PACKET_POOL_SIZE, 4);
+
+// Free-running microsecond clock for arrival and playout times (wraps after ~71 min)
+static inline uint32_t rtp_now_us()
+{
+    return static_cast<uint32_t>(k_ticks_to_us_floor64(k_uptime_ticks()));
+}
 
-LOG_MODULE_REGISTER(rtp_receiver, LOG_LEVEL_DBG);
+// Seconds between 1900-01-01 (NTP epoch) and 1970-01-01 (Unix epoch)
+#define NTP_UNIX_EPOCH_OFFSET 2208988800LL
 
-#define RTP_BUFFER_SIZE 2048
-#define RTP_THREAD_STACK_SIZE 4096
-#define RTP_THREAD_PRIORITY 5  // Higher priority (lower number) for network receiving
+// 64-bit NTP timestamp to Unix microseconds
+static inline int64_t ntp_to_unix_us(uint64_t ntp)
+{
+    int64_t seconds = static_cast<int64_t>(ntp >> 32) - NTP_UNIX_EPOCH_OFFSET;
+    return seconds * 1000000 + static_cast<int64_t>(((ntp & 0xFFFFFFFF) * 1000000) >> 32);
+}
 
-static K_THREAD_STACK_DEFINE(rtp_thread_stack, RTP_THREAD_STACK_SIZE);
-static struct k_thread rtp_thread_data;
+template <typename Ring>
+void RtpReceiver::drainInto(RtpStream& stream, Ring& ring)
+{
+    int16_t* span;
+
+    // Resample straight into the ring until the input is used up
+    while (true) {
+        size_t n = ring.writeSpan(&span);
+        if (n == 0) {
+            // Consumer stalled: still consume the input to keep the timeline
+            ring.noteOverrun(stream.drain(nullptr, SIZE_MAX));
+            return;
+        }
 
-int RtpReceiver::parseRtpPacket(const uint8_t* packet, size_t length,
-                                 const uint8_t** payload, size_t* payloadLen)
+        size_t produced = stream.drain(span, n);
+        ring.commitWrite(produced);
+        if (produced < n) {
+            return;
+        }
+    }
+}
+
+bool RtpReceiver::hasMixedStreams(size_t lead) const
 {
-    static uint32_t packet_count = 0;
-    
-    if (length < sizeof(RtpHeader)) {
-        LOG_WRN("Packet too small for RTP header");
-        return -EINVAL;
+    for (size_t i = 0; i < kMaxStreams; i++) {
+        if (i != lead && m_streams[i].isEnabled() && m_streams[i].gainQ16() != 0) {
+            return true;
+        }
     }
+    return false;
+}
 
-    const RtpHeader* header = reinterpret_cast<const RtpHeader*>(packet);
-    
-    // Extract version (top 2 bits)
-    uint8_t version = (header->vpxcc >> 6) & 0x03;
-    if (version != 2) {
-        LOG_WRN("Invalid RTP version: %u", version);
-        return -EINVAL;
+void RtpReceiver::routeOutput(size_t index)
+{
+    RtpStream& stream = m_streams[index];
+    size_t lead = getLeadStream();
+
+    if (index != lead) {
+        if (stream.gainQ16() == 0) {
+            // Not heard: still resample so the stream is ready when selected
+            stream.drain(nullptr, SIZE_MAX);
+        } else {
+            // Parked until the lead's next tick mixes it in
+            drainInto(stream, stream.outputRing());
+        }
+        return;
     }
 
-    // Extract fields
-    uint8_t padding = (header->vpxcc >> 5) & 0x01;
-    uint8_t extension = (header->vpxcc >> 4) & 0x01;
-    uint8_t csrcCount = header->vpxcc & 0x0F;
-    uint8_t marker = (header->mpt >> 7) & 0x01;
-    uint8_t payloadType = header->mpt & 0x7F;
-    uint16_t sequence = ntohs(header->sequence);
-    uint32_t timestamp = ntohl(header->timestamp);
-    uint32_t ssrc = ntohl(header->ssrc);
+    int32_t gain = stream.gainQ16();
+    if (gain == dsp::kGainUnityQ16 && !hasMixedStreams(lead)) {
+        // Single stream: no copy, resample straight into the PCM ring
+        drainInto(stream, m_pcm);
+        return;
+    }
 
-    // Calculate header size
-    size_t headerSize = sizeof(RtpHeader) + (csrcCount * 4);
-    
-    // Handle extension if present
-    if (extension) {
-        if (length < headerSize + 4) {
-            return -EINVAL;
+    while (true) {
+        size_t n = stream.drain(m_mix, ARRAY_SIZE(m_mix));
+        if (n == 0) {
+            return;
+        }
+        if (gain != dsp::kGainUnityQ16) {
+            dsp::applyGainQ16(m_mix, n, gain);
+        }
+
+        for (size_t i = 0; i < kMaxStreams; i++) {
+            RtpStream& other = m_streams[i];
+            int32_t other_gain = other.gainQ16();
+            if (i == lead || !other.isEnabled() || other_gain == 0 || !other.mixReady(n)) {
+                continue;
+            }
+
+            size_t got = other.outputRing().read(m_mix_in, n);
+            if (other_gain != dsp::kGainUnityQ16) {
+                dsp::applyGainQ16(m_mix_in, got, other_gain);
+            }
+            dsp::mixSaturate(m_mix, m_mix_in, got);
+        }
+
+        m_pcm.write(m_mix, n);
+        if (n < ARRAY_SIZE(m_mix)) {
+            return;
         }
-        uint16_t extLen = ntohs(*reinterpret_cast<const uint16_t*>(packet + headerSize + 2));
-        headerSize += 4 + (extLen * 4);
     }
+}
 
-    if (headerSize > length) {
-        LOG_WRN("Invalid RTP header size");
-        return -EINVAL;
+void RtpReceiver::sendHello(const Port& port)
+{
+    const char* hello = "RTP_CLIENT_READY";
+    sendto(port.socket, hello, strlen(hello), 0,
+           (struct sockaddr*)&port.server_addr, sizeof(port.server_addr));
+}
+
+void RtpReceiver::sendReceiverReports()
+{
+    uint8_t buf[RtcpReporter::kMaxReportSize];
+    uint32_t now_us = rtp_now_us();
+
+    for (RtpStream& stream : m_streams) {
+        if (!stream.isEnabled()) {
+            continue;
+        }
+
+        size_t len = stream.buildReceiverReport(buf, sizeof(buf), now_us);
+        if (len == 0) {
+            continue;
+        }
+
+        const Port& port = m_ports[stream.portIndex()];
+        if (sendto(port.rtcp_socket, buf, len, 0,
+                   (struct sockaddr*)&port.rtcp_addr, sizeof(port.rtcp_addr)) < 0) {
+            LOG_DBG_THROTTLED("RTCP send failed: %d", errno);
+        }
     }
+}
+
+void RtpReceiver::receiveRtcp(size_t port_index)
+{
+    uint8_t buf[RTCP_RX_BUF_SIZE];
 
-    // Extract payload
-    *payload = packet + headerSize;
-    *payloadLen = length - headerSize;
+    while (true) {
+        ssize_t len = recvfrom(m_ports[port_index].rtcp_socket, buf, sizeof(buf),
+                               MSG_DONTWAIT, NULL, NULL);
+        if (len <= 0) {
+            break;
+        }
 
-    // Handle padding
-    if (padding && *payloadLen > 0) {
-        uint8_t paddingLen = (*payload)[*payloadLen - 1];
-        if (paddingLen <= *payloadLen) {
-            *payloadLen -= paddingLen;
+        // Each stream only takes the sender reports of its own SSRC
+        uint32_t now_us = rtp_now_us();
+        for (RtpStream& stream : m_streams) {
+            if (stream.isEnabled() && stream.isBound() && stream.portIndex() == port_index) {
+                stream.onRtcp(buf, len, now_us);
+            }
         }
     }
+}
 
-    // Log detailed info for first few packets
-    packet_count++;
-    if (packet_count <= 3) {
-        LOG_INF("RTP #%u: seq=%u, ts=%u, pt=%u, ssrc=0x%08x, marker=%u, payload=%u bytes", 
-                packet_count, sequence, timestamp, payloadType, ssrc, marker, *payloadLen);
-    } else {
-        LOG_DBG("RTP: seq=%u, ts=%u, pt=%u, payload=%u bytes", 
-                sequence, timestamp, payloadType, *payloadLen);
+int RtpReceiver::serviceTimers()
+{
+    uint32_t now = k_uptime_get_32();
+    int timeout = INT_MAX;
+
+    // Send periodic hello packets until a port gets its first RTP packet
+    for (size_t i = 0; i < m_port_count; i++) {
+        Port& port = m_ports[i];
+        if (port.got_first_packet) {
+            continue;
+        }
+
+        uint32_t since_hello = now - port.last_hello_time;
+        if (since_hello >= RTP_HELLO_INTERVAL_MS) {
+            sendHello(port);
+            LOG_DBG("Sent periodic hello packet to port %u", port.number);
+            port.last_hello_time = now;
+            since_hello = 0;
+        }
+        timeout = MIN(timeout, static_cast<int>(RTP_HELLO_INTERVAL_MS - since_hello));
     }
 
-    return 0;
+    // Receiver reports let the server back off before we underrun
+    uint32_t since_rr = now - m_last_rr_time;
+    if (since_rr >= CONFIG_RTCP_RR_INTERVAL_MS) {
+        sendReceiverReports();
+        m_last_rr_time = now;
+        since_rr = 0;
+    }
+    timeout = MIN(timeout, static_cast<int>(CONFIG_RTCP_RR_INTERVAL_MS - since_rr));
+
+#ifdef CONFIG_WIFI_PS_POLICY
+    // Packet rate and period decide between power-save modes
+    uint32_t since_ps = now - m_last_ps_time;
+    if (since_ps >= RTP_PS_REPORT_INTERVAL_MS) {
+        wifi_ps_policy_traffic(m_packet_count - m_ps_packet_count, since_ps,
+                               m_streams[getLeadStream()].getJitterBuffer().frameDurationUs());
+        m_ps_packet_count = m_packet_count;
+        m_last_ps_time = now;
+        since_ps = 0;
+    }
+    timeout = MIN(timeout, static_cast<int>(RTP_PS_REPORT_INTERVAL_MS - since_ps));
+#endif
+
+    // Every stream runs its own playout clock in step with its sender;
+    // the lead's ticks collect the others' output for the mix
+    uint32_t now_us = rtp_now_us();
+    for (size_t i = 0; i < kMaxStreams; i++) {
+        RtpStream& stream = m_streams[i];
+        if (!stream.isEnabled() || !stream.isPlaying()) {
+            continue;
+        }
+
+        while (stream.playoutDue(now_us)) {
+            stream.playoutTick();
+            routeOutput(i);
+            stream.traceHandoff();
+        }
+
+        // Round up so we never wake just before the deadline
+        int playout_timeout = (stream.nextPlayoutUs() - now_us + 999) / 1000;
+        timeout = MIN(timeout, playout_timeout);
+    }
+
+    return timeout;
 }
 
-void RtpReceiver::receiverThread(void* arg1, void* arg2, void* arg3)
+size_t RtpReceiver::receiveBatch(size_t port_index, PacketBuf** batch, size_t max_count)
 {
-    RtpReceiver* receiver = static_cast<RtpReceiver*>(arg1);
-    uint8_t buffer[RTP_BUFFER_SIZE];
-    uint32_t packet_count = 0;
-    uint32_t bytes_received = 0;
-    uint32_t last_report_time = k_uptime_get_32();
-    
-    // Server address for sending hello packets
-    struct sockaddr_in server_addr;
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(receiver->m_server_port);
-    inet_pton(AF_INET, receiver->m_server_ip, &server_addr.sin_addr);
-    
-    LOG_INF("RTP receiver thread started, will send hello to %s:%u", 
-            receiver->m_server_ip, receiver->m_server_port);
-    
-    LOG_INF("Waiting for RTP packets...");
-    
-    uint32_t last_alive_log = k_uptime_get_32();
-    uint32_t last_hello_time = k_uptime_get_32();
-    bool got_first_packet = false;
-
-    while (receiver->m_running) {
-        // Send periodic hello packets until we get our first RTP packet
-        if (!got_first_packet) {
-            uint32_t now = k_uptime_get_32();
-            if (now - last_hello_time >= 2000) {  // Every 2 seconds
-                const char* hello = "RTP_CLIENT_READY";
-                sendto(receiver->m_socket, hello, strlen(hello), 0,
-                       (struct sockaddr*)&server_addr, sizeof(server_addr));
-                LOG_DBG("Sent periodic hello packet");
-                last_hello_time = now;
+    Port& port = m_ports[port_index];
+    size_t count = 0;
+
+    // recvmmsg() emulation: drain queued datagrams until the socket would block
+    while (count < max_count) {
+        // Receive straight into a pool block, ownership follows the packet
+        PacketBuf* buf = m_pool.alloc();
+        if (!buf) {
+            // Only possible if a consumer leaks blocks; playout frees them
+            LOG_ERR_THROTTLED("Packet pool exhausted");
+            if (count == 0) {
+                k_sleep(K_MSEC(10));
             }
+            break;
         }
-        
-        // Set short timeout on blocking socket to check for hello packets
-        struct timeval tv;
-        tv.tv_sec = 0;
-        tv.tv_usec = got_first_packet ? 100000 : 10000; // 100ms after first packet, 10ms before
-        setsockopt(receiver->m_socket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-        
+
         struct sockaddr_in from_addr;
         socklen_t from_len = sizeof(from_addr);
-        ssize_t len = recvfrom(receiver->m_socket, buffer, sizeof(buffer), 0,
+        ssize_t len = recvfrom(port.socket, buf->data, sizeof(buf->data), MSG_DONTWAIT,
                                (struct sockaddr*)&from_addr, &from_len);
 
-        if (len < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                // Timeout - check if we need to send hello
+        if (len <= 0) {
+            m_pool.free(buf);
+            if (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG_ERR_THROTTLED("recvfrom error: %d", errno);
+                if (count == 0) {
+                    k_sleep(K_MSEC(100));
+                }
+            }
+            break;
+        }
+
+        buf->length = len;
+        buf->arrival_us = rtp_now_us();
+        buf->arrival_cyc = k_cycle_get_32();
+        LAT_TRACE_STAMP(buf->trace_cyc);
+
+        if (!port.got_first_packet) {
+            char from_ip[INET_ADDRSTRLEN];
+            inet_ntop(AF_INET, &from_addr.sin_addr, from_ip, sizeof(from_ip));
+            LOG_INF("!!! First packet on port %u from %s:%u (%d bytes) !!!",
+                    port.number, from_ip, ntohs(from_addr.sin_port), len);
+            port.got_first_packet = true;  // Stop sending hello packets
+            if (boot_metrics::mark(boot_metrics::Stage::FirstPacket)) {
+                LOG_INF("Boot to first RTP packet: %u ms",
+                        boot_metrics::get(boot_metrics::Stage::FirstPacket) / 1000U);
+            }
+        }
+
+        batch[count++] = buf;
+    }
+
+    return count;
+}
+
+RtpStream* RtpReceiver::findStream(size_t port_index, uint32_t ssrc)
+{
+    RtpStream* unbound = nullptr;
+    RtpStream* idle = nullptr;
+    uint32_t now = k_uptime_get_32();
+
+    for (RtpStream& stream : m_streams) {
+        if (!stream.isEnabled() || stream.portIndex() != port_index) {
+            continue;
+        }
+
+        if (stream.ssrcFilter() != 0) {
+            if (stream.ssrcFilter() == ssrc) {
+                if (!stream.isBound()) {
+                    stream.bind(ssrc);
+                }
+                return &stream;
+            }
+        } else if (stream.isBound()) {
+            if (stream.boundSsrc() == ssrc) {
+                return &stream;
+            }
+            if (!idle && stream.idleMs(now) >= RTP_STREAM_REBIND_MS) {
+                idle = &stream;
+            }
+        } else if (!unbound) {
+            unbound = &stream;
+        }
+    }
+
+    // A new source takes a free stream, or one whose source went silent
+    // (e.g. the sender restarted with a new SSRC)
+    RtpStream* stream = unbound ? unbound : idle;
+    if (stream) {
+        LOG_INF("SSRC 0x%08x on port %u -> stream %u", ssrc, m_ports[port_index].number,
+                static_cast<unsigned>(stream - m_streams.data()));
+        stream->bind(ssrc);
+    }
+    return stream;
+}
+
+void RtpReceiver::processBatch(size_t port_index, PacketBuf* const* batch, size_t count)
+{
+    // Wall clock for send timestamps, read once per batch
+    int64_t wall_offset_us = 0;
+    bool have_wall_clock = wifi_mgr_get_clock_offset(&wall_offset_us) == 0;
+    int64_t uptime_us = k_ticks_to_us_floor64(k_uptime_ticks());
+
+    for (size_t i = 0; i < count; i++) {
+        PacketBuf* buf = batch[i];
+        RtpPacket pkt;
+        // Start of the parse + enqueue time in 'rtp stats'
+        uint32_t start_cyc = cycle_counter_get();
+
+        // Hot path: no logging per packet, failures are only counted
+        int ret = parseRtpPacket(buf->data, buf->length, &pkt);
+        if (ret != 0) {
+            if (ret == -ENOMSG) {
+                m_filtered++;
+            } else {
+                m_parse_errors++;
+            }
+            m_pool.free(buf);
+            continue;
+        }
+
+        RtpStream* stream = findStream(port_index, pkt.ssrc);
+        if (!stream) {
+            // No stream takes this SSRC
+            m_filtered++;
+            m_pool.free(buf);
+            continue;
+        }
+
+        LAT_TRACE_AT(RxDone, stream->index(), pkt.sequence, buf->trace_cyc);
+        LAT_TRACE(ParseDone, stream->index(), pkt.sequence);
+
+        m_packet_count++;
+        m_bytes_received += pkt.payloadLen;
+
+        // Log first few packets with details (bring-up builds)
+        if (m_packet_count <= 3) {
+            LOG_DBG("RTP #%u: seq=%u, ts=%u, pt=%u, ssrc=0x%08x, marker=%u, payload=%u bytes",
+                    m_packet_count, pkt.sequence, pkt.timestamp, pkt.payloadType,
+                    pkt.ssrc, pkt.marker, pkt.payloadLen);
+        }
+
+        // Before onPacket(): the jitter buffer owns the block after it
+        int64_t network_delay_us = 0;
+        bool have_delay = pkt.sendTimeNtp != 0 && have_wall_clock;
+        if (have_delay) {
+            uint32_t age_us = static_cast<uint32_t>(uptime_us) - buf->arrival_us;
+            network_delay_us = uptime_us - age_us + wall_offset_us - ntp_to_unix_us(pkt.sendTimeNtp);
+        }
+
+        stream->onPacket(pkt, buf, start_cyc);
+        if (have_delay) {
+            stream->onNetworkDelay(static_cast<int32_t>(
+                network_delay_us < INT32_MIN ? INT32_MIN :
+                network_delay_us > INT32_MAX ? INT32_MAX : network_delay_us));
+        }
+    }
+
+    for (RtpStream& stream : m_streams) {
+        if (stream.isEnabled() && stream.portIndex() == port_index) {
+            stream.onBatchDone();
+        }
+    }
+
+    // Report statistics every 5 seconds
+    uint32_t now = k_uptime_get_32();
+    if (now - m_last_report_time >= RTP_STATS_INTERVAL_MS) {
+        uint32_t elapsed_sec = (now - m_last_report_time) / 1000;
+        uint32_t kbps = (m_bytes_received * 8) / (elapsed_sec * 1000);
+        LOG_INF("=== RTP Stats: %u packets | %u KB received | %u kbps | %u bad | %u filtered ===",
+                m_packet_count, m_bytes_received / 1024, kbps, m_parse_errors, m_filtered);
+        for (size_t i = 0; i < kMaxStreams; i++) {
+            const RtpStream& stream = m_streams[i];
+            if (!stream.isBound()) {
                 continue;
             }
-            LOG_ERR("recvfrom error: %d", errno);
+            const JitterBuffer& jitter = stream.getJitterBuffer();
+            LOG_INF("=== Stream %u (0x%08x): depth %u/%u | jitter %u us | underruns %u | drops %u ===",
+                    i, stream.boundSsrc(), jitter.depth(), jitter.targetDepth(),
+                    jitter.jitterUs(), jitter.underruns(), jitter.drops());
+        }
+        m_last_report_time = now;
+        m_bytes_received = 0;  // Reset for next interval
+    }
+}
+
+void RtpReceiver::receiverThread(void* arg1, void* arg2, void* arg3)
+{
+    RtpReceiver* receiver = static_cast<RtpReceiver*>(arg1);
+
+    LOG_INF("RTP receiver thread started, will send hello to %s:%u",
+            receiver->m_server_ip, receiver->m_server_port);
+
+    LOG_INF("Waiting for RTP packets on %u port(s)...", receiver->m_port_count);
+
+    receiver->m_packet_count = 0;
+    receiver->m_parse_errors = 0;
+    receiver->m_filtered = 0;
+    receiver->m_bytes_received = 0;
+    receiver->m_last_report_time = k_uptime_get_32();
+    receiver->m_last_rr_time = k_uptime_get_32();
+    receiver->m_last_ps_time = k_uptime_get_32();
+    receiver->m_ps_packet_count = 0;
+    for (size_t i = 0; i < receiver->m_port_count; i++) {
+        receiver->m_ports[i].last_hello_time = k_uptime_get_32();
+        receiver->m_ports[i].got_first_packet = false;
+    }
+
+    // Sleep until a datagram arrives, a timer deadline passes or stop() wakes us.
+    // fds[0] is the wakeup channel, then RTP and RTCP of each port
+    struct pollfd fds[1 + 2 * kMaxStreams];
+    size_t nfds = 1 + 2 * receiver->m_port_count;
+    fds[0].fd = receiver->m_wake_fd;
+    fds[0].events = POLLIN;
+    for (size_t i = 0; i < receiver->m_port_count; i++) {
+        fds[1 + 2 * i].fd = receiver->m_ports[i].socket;
+        fds[1 + 2 * i].events = POLLIN;
+        fds[2 + 2 * i].fd = receiver->m_ports[i].rtcp_socket;
+        fds[2 + 2 * i].events = POLLIN;
+    }
+
+    while (receiver->m_running) {
+        int timeout_ms = receiver->serviceTimers();
+
+        int ret = poll(fds, nfds, timeout_ms);
+        if (ret < 0) {
+            LOG_ERR_THROTTLED("poll error: %d", errno);
             k_sleep(K_MSEC(100));
             continue;
         }
 
-        if (len > 0) {
-            if (!got_first_packet) {
-                char from_ip[INET_ADDRSTRLEN];
-                inet_ntop(AF_INET, &from_addr.sin_addr, from_ip, sizeof(from_ip));
-                LOG_INF("!!! First packet from %s:%u (%d bytes) !!!", 
-                        from_ip, ntohs(from_addr.sin_port), len);
-                got_first_packet = true;  // Stop sending hello packets
+        if (fds[0].revents & POLLIN) {
+            eventfd_t value;
+            eventfd_read(receiver->m_wake_fd, &value);
+        }
+
+        for (size_t i = 0; i < receiver->m_port_count; i++) {
+            const struct pollfd& rtp_fd = fds[1 + 2 * i];
+            const struct pollfd& rtcp_fd = fds[2 + 2 * i];
+
+            if (rtcp_fd.revents & POLLIN) {
+                receiver->receiveRtcp(i);
             }
-            
-            const uint8_t* payload;
-            size_t payloadLen;
-            
-            if (receiver->parseRtpPacket(buffer, len, &payload, &payloadLen) == 0) {
-                packet_count++;
-                bytes_received += payloadLen;
-                
-                // Log first few packets with details
-                if (packet_count <= 5) {
-                    LOG_INF("*** Packet #%u received! Total len: %d, Payload: %u bytes", 
-                            packet_count, len, payloadLen);
-                }
-                
-                // Report statistics every 5 seconds
-                uint32_t now = k_uptime_get_32();
-                if (now - last_report_time >= 5000) {
-                    uint32_t elapsed_sec = (now - last_report_time) / 1000;
-                    uint32_t kbps = (bytes_received * 8) / (elapsed_sec * 1000);
-                    LOG_INF("=== RTP Stats: %u packets | %u KB received | %u kbps ===", 
-                            packet_count, bytes_received / 1024, kbps);
-                    last_report_time = now;
-                    bytes_received = 0;  // Reset for next interval
+
+            if (rtp_fd.revents & POLLIN) {
+                PacketBuf* batch[CONFIG_RTP_RX_BATCH_SIZE];
+                size_t count = receiver->receiveBatch(i, batch, ARRAY_SIZE(batch));
+                if (count > 0) {
+                    receiver->processBatch(i, batch, count);
                 }
-                
-                // Here you would forward the payload to audio processing
-                // For now, just count and log statistics
-            } else {
-                LOG_WRN("Failed to parse RTP packet (%d bytes)", len);
+            } else if (rtp_fd.revents & (POLLERR | POLLNVAL)) {
+                LOG_ERR_THROTTLED("Socket error on port %u (revents 0x%x)",
+                        receiver->m_ports[i].number, rtp_fd.revents);
+                k_sleep(K_MSEC(100));
             }
         }
     }
 
-    LOG_INF("RTP receiver thread stopped - Total packets: %u", packet_count);
+    LOG_INF("RTP receiver thread stopped - Total packets: %u", receiver->m_packet_count);
+}
+
+RtpReceiver::RtpReceiver()
+    : m_pool(&rtp_packet_slab),
+      m_streams(makeStreams(m_pool, sys_clock_hw_cycles_per_sec(),
+                            std::make_index_sequence<kMaxStreams>()))
+{
+    __ASSERT(!rtp_instance_created, "Only one RtpReceiver (static thread stack)");
+    rtp_instance_created = true;
+
+    k_mutex_init(&m_control);
+    cycle_counter_init();
+
+    m_parser.setPayloadTypeFilter(CONFIG_RTP_PAYLOAD_TYPE_FILTER);
+    m_parser.setSendTimeExtensionId(CONFIG_RTP_SEND_TIME_EXT_ID);
+    m_streams[0].configure(0, CONFIG_RTP_SSRC_FILTER);
 }
 
 RtpReceiver::~RtpReceiver()
@@ -192,34 +555,79 @@ RtpReceiver::~RtpReceiver()
     stop();
 }
 
-int RtpReceiver::start(const char* server_ip, uint16_t server_port)
+int RtpReceiver::configureStream(size_t index, uint16_t port, uint32_t ssrc)
 {
+    if (index >= kMaxStreams) {
+        return -EINVAL;
+    }
     if (m_running) {
-        LOG_WRN("RTP receiver already running");
-        return -EALREADY;
+        return -EBUSY;
     }
 
-    if (!server_ip || server_port == 0) {
-        LOG_ERR("Invalid server address or port");
+    m_streams[index].configure(port, ssrc);
+    return 0;
+}
+
+int RtpReceiver::disableStream(size_t index)
+{
+    if (index == 0 || index >= kMaxStreams) {
         return -EINVAL;
     }
+    if (m_running) {
+        return -EBUSY;
+    }
 
-    // Store server info
-    strncpy(m_server_ip, server_ip, sizeof(m_server_ip) - 1);
-    m_server_port = server_port;
+    m_streams[index].disable();
+    if (getLeadStream() == index) {
+        m_lead.store(0, std::memory_order_relaxed);
+    }
+    return 0;
+}
+
+int RtpReceiver::selectStream(size_t index)
+{
+    if (index >= kMaxStreams || !m_streams[index].isEnabled()) {
+        return -EINVAL;
+    }
+
+    m_lead.store(index, std::memory_order_relaxed);
+    return 0;
+}
+
+int RtpReceiver::setStreamGain(size_t index, int32_t gainQ16)
+{
+    if (index >= kMaxStreams || gainQ16 < 0) {
+        return -EINVAL;
+    }
+
+    m_streams[index].setGainQ16(gainQ16);
+    return 0;
+}
+
+void RtpReceiver::resetStats()
+{
+    for (RtpStream& stream : m_streams) {
+        stream.resetStats();
+    }
+}
+
+int RtpReceiver::openPort(Port& port, uint16_t number)
+{
+    port.number = number;
 
     // Create UDP socket
-    m_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-    if (m_socket < 0) {
+    port.socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (port.socket < 0) {
         LOG_ERR("Failed to create socket: %d", errno);
         return -errno;
     }
-    
-    LOG_INF("Created UDP socket: fd=%d", m_socket);
 
-    // Keep socket BLOCKING for reliable receive (non-blocking was causing drops)
-    // int flags = fcntl(m_socket, F_GETFL, 0);
-    // fcntl(m_socket, F_SETFL, flags | O_NONBLOCK);
+    LOG_INF("Created UDP socket: fd=%d", port.socket);
+
+    // Non-blocking: the thread only reads after poll() reports data,
+    // so a spurious wakeup can never stall the playout clock
+    int flags = fcntl(port.socket, F_GETFL, 0);
+    fcntl(port.socket, F_SETFL, flags | O_NONBLOCK);
 
     // DON'T connect - just bind to the specified port
     // This is the port the server will send RTP packets to
@@ -227,55 +635,221 @@ int RtpReceiver::start(const char* server_ip, uint16_t server_port)
     memset(&local_addr, 0, sizeof(local_addr));
     local_addr.sin_family = AF_INET;
     local_addr.sin_addr.s_addr = INADDR_ANY;
-    local_addr.sin_port = htons(server_port);  // Bind to the SERVER port - that's where we'll receive!
+    local_addr.sin_port = htons(number);  // Bind to the SERVER port - that's where we'll receive!
 
-    if (bind(m_socket, (struct sockaddr*)&local_addr, sizeof(local_addr)) < 0) {
-        LOG_ERR("Failed to bind socket to port %u: %d", server_port, errno);
-        close(m_socket);
-        m_socket = -1;
-        return -errno;
+    if (bind(port.socket, (struct sockaddr*)&local_addr, sizeof(local_addr)) < 0) {
+        int ret = -errno;
+        LOG_ERR("Failed to bind socket to port %u: %d", number, errno);
+        closePort(port);
+        return ret;
+    }
+
+    LOG_INF("Socket bound to port %u (waiting for RTP packets on this port)", number);
+
+    // Queued datagrams are bounded by the net_pkt/net_buf pools, not by
+    // this; the option only exists with CONFIG_NET_CONTEXT_RCVBUF
+    if (CONFIG_RTP_SOCKET_RCVBUF > 0) {
+        int rcvbuf = CONFIG_RTP_SOCKET_RCVBUF;
+        if (setsockopt(port.socket, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)) == 0) {
+            LOG_INF("Set SO_RCVBUF to %d bytes", rcvbuf);
+        } else {
+            LOG_DBG("SO_RCVBUF not supported: %d", errno);
+        }
     }
 
-    LOG_INF("Socket bound to port %u (waiting for RTP packets on this port)", server_port);
-    
-    // Enable socket receive buffer increase
-    int rcvbuf = 32768;
-    if (setsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)) == 0) {
-        LOG_INF("Set SO_RCVBUF to %d bytes", rcvbuf);
+    port.rtcp_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (port.rtcp_socket < 0) {
+        int ret = -errno;
+        LOG_ERR("Failed to create RTCP socket: %d", errno);
+        closePort(port);
+        return ret;
     }
 
-    // Store server address for sending hello packets
-    struct sockaddr_in server_addr;
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(server_port);
-    inet_pton(AF_INET, server_ip, &server_addr.sin_addr);
+    flags = fcntl(port.rtcp_socket, F_GETFL, 0);
+    fcntl(port.rtcp_socket, F_SETFL, flags | O_NONBLOCK);
+
+    // Same symmetric layout as RTP: receive on the port we send to
+    local_addr.sin_port = htons(number + 1);
+    if (bind(port.rtcp_socket, (struct sockaddr*)&local_addr, sizeof(local_addr)) < 0) {
+        int ret = -errno;
+        LOG_ERR("Failed to bind RTCP socket to port %u: %d", number + 1, errno);
+        closePort(port);
+        return ret;
+    }
+
+    LOG_INF("RTCP socket bound to port %u", number + 1);
+
+    // Store server address for sending hello packets and reports
+    memset(&port.server_addr, 0, sizeof(port.server_addr));
+    port.server_addr.sin_family = AF_INET;
+    port.server_addr.sin_port = htons(number);
+    inet_pton(AF_INET, m_server_ip, &port.server_addr.sin_addr);
+    port.rtcp_addr = port.server_addr;
+    port.rtcp_addr.sin_port = htons(number + 1);
 
     // Send initial hello packet using sendto (not send, since we're not connected)
     const char* hello = "RTP_CLIENT_READY";
-    ssize_t sent = sendto(m_socket, hello, strlen(hello), 0,
-                          (struct sockaddr*)&server_addr, sizeof(server_addr));
+    ssize_t sent = sendto(port.socket, hello, strlen(hello), 0,
+                          (struct sockaddr*)&port.server_addr, sizeof(port.server_addr));
     if (sent < 0) {
-        LOG_WRN("Failed to send initial hello to %s:%u: %d", server_ip, server_port, errno);
+        LOG_WRN("Failed to send initial hello to %s:%u: %d", m_server_ip, number, errno);
     } else {
-        LOG_INF("Sent initial hello to %s:%u (%d bytes)", server_ip, server_port, sent);
+        LOG_INF("Sent initial hello to %s:%u (%d bytes)", m_server_ip, number, sent);
+    }
+
+    return 0;
+}
+
+void RtpReceiver::closePort(Port& port)
+{
+    if (port.socket >= 0) {
+        close(port.socket);
+        port.socket = -1;
+    }
+
+    if (port.rtcp_socket >= 0) {
+        close(port.rtcp_socket);
+        port.rtcp_socket = -1;
+    }
+}
+
+int RtpReceiver::start(const char* server_ip, uint16_t server_port)
+{
+    k_mutex_lock(&m_control, K_FOREVER);
+    int ret = startSession(server_ip, server_port);
+    k_mutex_unlock(&m_control);
+    if (ret == 0) {
+        boot_metrics::mark(boot_metrics::Stage::RtpStarted);
+    }
+    return ret;
+}
+
+void RtpReceiver::stop()
+{
+    k_mutex_lock(&m_control, K_FOREVER);
+    stopSession();
+    k_mutex_unlock(&m_control);
+}
+
+int RtpReceiver::resume()
+{
+    k_mutex_lock(&m_control, K_FOREVER);
+    if (!m_running) {
+        k_mutex_unlock(&m_control);
+        return -ENOTCONN;
+    }
+
+    // startSession() copies the address into m_server_ip, so pass it a copy
+    char server_ip[sizeof(m_server_ip)];
+    strncpy(server_ip, m_server_ip, sizeof(server_ip));
+    uint16_t server_port = m_server_port;
+
+    stopSession();
+    int ret = startSession(server_ip, server_port);
+    k_mutex_unlock(&m_control);
+
+    if (ret < 0) {
+        LOG_ERR("Failed to resume RTP session with %s:%u: %d", server_ip, server_port, ret);
+    } else {
+        LOG_INF("RTP session with %s:%u resumed", server_ip, server_port);
+    }
+    return ret;
+}
+
+int RtpReceiver::startSession(const char* server_ip, uint16_t server_port)
+{
+    if (m_running) {
+        LOG_WRN("RTP receiver already running");
+        return -EALREADY;
+    }
+
+    if (!server_ip || server_port == 0) {
+        LOG_ERR("Invalid server address or port");
+        return -EINVAL;
+    }
+
+    // Store server info
+    strncpy(m_server_ip, server_ip, sizeof(m_server_ip) - 1);
+    m_server_port = server_port;
+
+    // One socket pair per distinct port, shared by the streams on it
+    uint8_t port_of[kMaxStreams] = {};
+    uint16_t numbers[kMaxStreams];
+    m_port_count = 0;
+    for (size_t i = 0; i < kMaxStreams; i++) {
+        if (!m_streams[i].isEnabled()) {
+            continue;
+        }
+
+        uint16_t number = m_streams[i].port() ? m_streams[i].port() : server_port;
+        size_t p = 0;
+        while (p < m_port_count && numbers[p] != number) {
+            // RTCP lives on port + 1, so adjacent ports would collide
+            if (numbers[p] + 1 == number || number + 1 == numbers[p]) {
+                LOG_ERR("Stream %u: port %u collides with RTCP of port %u", i, number,
+                        numbers[p]);
+                return -EINVAL;
+            }
+            p++;
+        }
+        if (p == m_port_count) {
+            numbers[m_port_count++] = number;
+        }
+        port_of[i] = p;
+    }
+
+    int ret = 0;
+    for (size_t p = 0; p < m_port_count; p++) {
+        ret = openPort(m_ports[p], numbers[p]);
+        if (ret < 0) {
+            for (size_t q = 0; q < p; q++) {
+                closePort(m_ports[q]);
+            }
+            return ret;
+        }
+    }
+
+    // Wakeup channel so stop() does not wait for a poll timeout
+    m_wake_fd = eventfd(0, EFD_NONBLOCK);
+    if (m_wake_fd < 0) {
+        ret = -errno;
+        LOG_ERR("Failed to create eventfd: %d", errno);
+        for (size_t p = 0; p < m_port_count; p++) {
+            closePort(m_ports[p]);
+        }
+        return ret;
+    }
+
+    // Start receiver thread with empty jitter buffers and fresh stats
+    uint32_t rtcp_ssrc = sys_rand32_get();
+    for (size_t i = 0; i < kMaxStreams; i++) {
+        if (m_streams[i].isEnabled()) {
+            m_streams[i].start(port_of[i], rtcp_ssrc);
+        }
+    }
+    if (!m_streams[getLeadStream()].isEnabled()) {
+        m_lead.store(0, std::memory_order_relaxed);
     }
 
-    // Start receiver thread
     m_running = true;
     m_thread_id = k_thread_create(&rtp_thread_data, rtp_thread_stack,
                                    K_THREAD_STACK_SIZEOF(rtp_thread_stack),
                                    receiverThread,
                                    this, NULL, NULL,
-                                   RTP_THREAD_PRIORITY, 0, K_NO_WAIT);
+                                   CONFIG_RTP_RX_THREAD_PRIORITY, 0, K_NO_WAIT);
 
     k_thread_name_set(m_thread_id, "rtp_receiver");
 
-    LOG_INF("RTP receiver started");
+#ifdef CONFIG_WIFI_PS_POLICY
+    wifi_ps_policy_stream_state(true);
+#endif
+
+    LOG_INF("RTP receiver started (priority %d, batch %d)", CONFIG_RTP_RX_THREAD_PRIORITY,
+            CONFIG_RTP_RX_BATCH_SIZE);
     return 0;
 }
 
-void RtpReceiver::stop()
+void RtpReceiver::stopSession()
 {
     if (!m_running) {
         return;
@@ -283,16 +857,32 @@ void RtpReceiver::stop()
 
     m_running = false;
 
+    // Wake the thread out of poll() so it exits right away
+    eventfd_write(m_wake_fd, 1);
+
     // Wait for thread to finish
     if (m_thread_id) {
         k_thread_join(m_thread_id, K_FOREVER);
         m_thread_id = nullptr;
     }
 
-    if (m_socket >= 0) {
-        close(m_socket);
-        m_socket = -1;
+    for (size_t p = 0; p < m_port_count; p++) {
+        closePort(m_ports[p]);
+    }
+
+    if (m_wake_fd >= 0) {
+        close(m_wake_fd);
+        m_wake_fd = -1;
+    }
+
+    // Return buffered packets to the pool
+    for (RtpStream& stream : m_streams) {
+        stream.restart();
     }
 
+#ifdef CONFIG_WIFI_PS_POLICY
+    wifi_ps_policy_stream_state(false);
+#endif
+
     LOG_INF("RTP receiver stopped");
 }
@@ -1,28 +1,48 @@
 #pragma once
 
 #include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
 #include <cstdint>
 #include <cstddef>
 #include <array>
+#include <atomic>
+#include <utility>
+#include "packet_pool.hpp"
+#include "rtp_parser.hpp"
+#include "rtp_stream.hpp"
+#include "../audio/pcm_ring.hpp"
 
-// RTP Header structure (RFC 3550)
-struct RtpHeader {
-    uint8_t vpxcc;      // Version, Padding, Extension, CSRC count
-    uint8_t mpt;        // Marker, Payload type
-    uint16_t sequence;  // Sequence number
-    uint32_t timestamp; // Timestamp
-    uint32_t ssrc;      // Synchronization source identifier
-};
+// Defaults for builds without Kconfig (host tools); see audioBle/Kconfig
+#ifndef CONFIG_RTP_MAX_STREAMS
+#define CONFIG_RTP_MAX_STREAMS 2
+#endif
 
+/**
+ * @brief RTP receiver: sockets, demultiplexing and output routing
+ *
+ * One receive thread serves up to CONFIG_RTP_MAX_STREAMS streams
+ * (RtpStream, one per SSRC) on one or more UDP ports; all of them share
+ * the packet pool. Stream 0 is configured on the start() port and
+ * accepts any SSRC, which is the single-stream setup; more streams are
+ * added with configureStream().
+ *
+ * The lead stream (selectStream()) drives the PCM ring. Other streams
+ * with a non-zero gain are mixed into it, so switching between sources
+ * is a selectStream() call and mixing them a setStreamGain() call.
+ *
+ * Only one instance may exist: the thread stack is file-static.
+ */
 class RtpReceiver {
 public:
-    RtpReceiver() = default;
+    static constexpr size_t kMaxStreams = CONFIG_RTP_MAX_STREAMS;
+
+    RtpReceiver();
     ~RtpReceiver();
 
     /**
      * @brief Connect to RTP server and start receiving packets
      * @param server_ip Server IP address (e.g., "192.168.1.100")
-     * @param server_port Server UDP port
+     * @param server_port Server UDP port, also the port of streams configured with port 0
      * @return 0 on success, negative error code on failure
      */
     int start(const char* server_ip, uint16_t server_port);
@@ -32,6 +52,17 @@ public:
      */
     void stop();
 
+    /**
+     * @brief Restart a running session with the same server and streams
+     *
+     * For when the network comes back after a drop: reopens the sockets,
+     * empties the jitter buffers and sends the hello right away instead of
+     * at the next hello interval. Safe from any thread but the receive thread.
+     * @return 0 on success, -ENOTCONN if the receiver is not running,
+     *         otherwise start()'s error (the receiver is then stopped)
+     */
+    int resume();
+
     /**
      * @brief Check if receiver is running
      */
@@ -43,26 +74,230 @@ public:
     const char* getServerIp() const { return m_server_ip; }
     uint16_t getServerPort() const { return m_server_port; }
 
+    /**
+     * @brief Only accept this RTP payload type (negative accepts any)
+     */
+    void setPayloadTypeFilter(int payloadType) { m_parser.setPayloadTypeFilter(payloadType); }
+
+    /**
+     * @brief Only accept packets from this SSRC on stream 0 (next start())
+     */
+    void setSsrcFilter(uint32_t ssrc) { configureStream(0, m_streams[0].port(), ssrc); }
+
+    /**
+     * @brief Accept packets from any SSRC on stream 0 (next start())
+     */
+    void clearSsrcFilter() { setSsrcFilter(0); }
+
+    /**
+     * @brief Receive a source into a stream (only while stopped)
+     * @param index Stream index, 0..kMaxStreams-1
+     * @param port UDP port, 0 for the start() port; streams may share a port
+     * @param ssrc Source to accept, 0 for the first unclaimed one on the port
+     * @return 0 on success, -EINVAL for a bad index, -EBUSY while running
+     */
+    int configureStream(size_t index, uint16_t port, uint32_t ssrc);
+
+    /**
+     * @brief Take a stream out of use (only while stopped, not stream 0)
+     * @return 0 on success, -EINVAL for a bad index, -EBUSY while running
+     */
+    int disableStream(size_t index);
+
+    /**
+     * @brief Make a stream the one that drives the PCM ring (any time)
+     * @return 0 on success, -EINVAL if the stream is not configured
+     */
+    int selectStream(size_t index);
+
+    /**
+     * @brief Set a stream's output gain (any time)
+     * @param gainQ16 Linear gain in Q16 (dsp::kGainUnityQ16 = 0 dB). For a
+     *                non-lead stream any non-zero gain mixes it in
+     * @return 0 on success, -EINVAL for a bad index
+     */
+    int setStreamGain(size_t index, int32_t gainQ16);
+
+    size_t getLeadStream() const { return m_lead.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get a stream for status reporting
+     */
+    const RtpStream& getStream(size_t index) const { return m_streams[index]; }
+
+    /**
+     * @brief Get the lead stream's statistics (lock-free, safe from any thread)
+     */
+    const RtpStats& getStats() const { return m_streams[getLeadStream()].getStats(); }
+
+    /**
+     * @brief Clear the statistics of all streams (applied by the receive thread)
+     */
+    void resetStats();
+
+    /**
+     * @brief Get the lead stream's jitter buffer (read-only, for status reporting)
+     */
+    const JitterBuffer& getJitterBuffer() const { return m_streams[getLeadStream()].getJitterBuffer(); }
+
+    /**
+     * @brief Get the lead stream's RTCP reporter (read-only, for status reporting)
+     */
+    const RtcpReporter& getRtcp() const { return m_streams[getLeadStream()].getRtcp(); }
+
+    /**
+     * @brief Get the packet pool (read-only, for status reporting)
+     */
+    const PacketPool& getPacketPool() const { return m_pool; }
+
+    /**
+     * @brief Get the decoded PCM ring (host-order int16 samples)
+     *
+     * The receiver is the only producer; exactly one audio consumer
+     * (thread or ISR) may drain it.
+     */
+    AudioPcmRing& getPcmRing() { return m_pcm; }
+
 private:
+    // One UDP port: RTP socket, RTCP on port + 1
+    struct Port {
+        uint16_t number = 0;
+        int socket = -1;
+        int rtcp_socket = -1;
+        struct sockaddr_in server_addr = {};
+        struct sockaddr_in rtcp_addr = {};
+        bool got_first_packet = false;
+        uint32_t last_hello_time = 0;
+    };
+
+    template <size_t... I>
+    static std::array<RtpStream, sizeof...(I)> makeStreams(PacketPool& pool, uint32_t cyclesPerSec,
+                                                           std::index_sequence<I...>)
+    {
+        return {{RtpStream(pool, cyclesPerSec, I)...}};
+    }
+
     /**
-     * @brief Parse RTP packet and extract payload
-     * @param packet Raw packet data (const reference for input)
+     * @brief Parse RTP packet and extract header fields and payload
+     * @param packet Raw packet data
      * @param length Packet length
-     * @param payload Output pointer to payload data (pointer OK for output param)
-     * @param payloadLen Output payload length (pointer OK for output param)
+     * @param out Output parsed packet (pointer OK for output param)
+     * @return 0 on success, -EINVAL if malformed, -ENOMSG if filtered out
+     */
+    int parseRtpPacket(const uint8_t* packet, size_t length, RtpPacket* out) const
+    {
+        return m_parser.parse(packet, length, out);
+    }
+
+    /**
+     * @brief start() and stop() without taking m_control
+     */
+    int startSession(const char* server_ip, uint16_t server_port);
+    void stopSession();
+
+    /**
+     * @brief Open the RTP and RTCP sockets of a port
      * @return 0 on success, negative error code on failure
      */
-    int parseRtpPacket(const uint8_t* packet, size_t length,
-                       const uint8_t** payload, size_t* payloadLen);
+    int openPort(Port& port, uint16_t number);
+
+    /**
+     * @brief Close a port's sockets (safe on a closed port)
+     */
+    void closePort(Port& port);
+
+    /**
+     * @brief Find the stream for a packet, binding a free one if needed
+     * @return Stream, or nullptr if no stream takes this source
+     */
+    RtpStream* findStream(size_t port_index, uint32_t ssrc);
+
+    /**
+     * @brief Route a stream's output after one of its playout ticks:
+     *        the lead mixes others in and writes the PCM ring, the rest
+     *        park theirs for mixing or discard it
+     */
+    void routeOutput(size_t index);
+
+    /**
+     * @brief Resample everything a stream can produce straight into a ring
+     */
+    template <typename Ring>
+    void drainInto(RtpStream& stream, Ring& ring);
+
+    /**
+     * @brief True if any stream besides the lead is mixed in
+     */
+    bool hasMixedStreams(size_t lead) const;
+
+    /**
+     * @brief Send the RTP_CLIENT_READY hello to the server
+     */
+    void sendHello(const Port& port);
+
+    /**
+     * @brief Send an RTCP receiver report for every bound stream
+     */
+    void sendReceiverReports();
+
+    /**
+     * @brief Drain a port's RTCP socket and hand sender reports to its streams
+     */
+    void receiveRtcp(size_t port_index);
+
+    /**
+     * @brief Run due hello/RTCP/playout work
+     * @return Milliseconds until the next deadline (poll timeout)
+     */
+    int serviceTimers();
+
+    /**
+     * @brief Receive up to max_count queued datagrams into pool blocks
+     * @param port_index Port to read
+     * @param batch Output array of received blocks (ownership passes to caller)
+     * @param max_count Array size
+     * @return Number of datagrams received
+     */
+    size_t receiveBatch(size_t port_index, PacketBuf** batch, size_t max_count);
+
+    /**
+     * @brief Parse a batch of datagrams and hand them to their streams
+     * @param port_index Port the batch was received on
+     * @param batch Blocks from receiveBatch(), always consumed
+     * @param count Number of blocks
+     */
+    void processBatch(size_t port_index, PacketBuf* const* batch, size_t count);
 
     /**
      * @brief Background thread function for receiving packets
      */
     static void receiverThread(void* arg1, void* arg2, void* arg3);
 
-    int m_socket = -1;
+    std::array<Port, kMaxStreams> m_ports;
+    size_t m_port_count = 0;
+    int m_wake_fd = -1;         // eventfd, written by stop() to wake poll()
+    struct k_mutex m_control;   // Serializes start(), stop() and resume()
     bool m_running = false;
     char m_server_ip[16] = {0};  // IPv4 address string
     uint16_t m_server_port = 0;
     k_tid_t m_thread_id = nullptr;
+    RtpParser m_parser;
+    PacketPool m_pool;
+    std::array<RtpStream, kMaxStreams> m_streams;
+    std::atomic<size_t> m_lead{0};
+    AudioPcmRing m_pcm;
+
+    // Mix scratch: the lead's output and one other stream's at a time
+    int16_t m_mix[Asrc::kMaxFrameSamples];
+    int16_t m_mix_in[Asrc::kMaxFrameSamples];
+
+    // Receive thread state
+    uint32_t m_packet_count = 0;
+    uint32_t m_parse_errors = 0;
+    uint32_t m_filtered = 0;
+    uint32_t m_bytes_received = 0;
+    uint32_t m_last_report_time = 0;
+    uint32_t m_last_rr_time = 0;
+    uint32_t m_last_ps_time = 0;     // Last power-save policy traffic report
+    uint32_t m_ps_packet_count = 0;  // m_packet_count at that report
 };
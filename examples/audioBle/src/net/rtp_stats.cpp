@@ -0,0 +1,272 @@
+#include "rtp_stats.hpp"
+
+void DelayHistogram::record(int32_t us)
+{
+    size_t bucket = 0;
+    if (us >= 1000) {
+        uint32_t ms = static_cast<uint32_t>(us) / 1000;
+        bucket = 32 - __builtin_clz(ms);  // [2^(i-1), 2^i) ms -> i
+        if (bucket >= kBuckets) {
+            bucket = kBuckets - 1;
+        }
+    }
+
+    uint32_t count = m_count.load(std::memory_order_relaxed) + 1;
+    m_sum_us += us;
+    m_buckets[bucket].store(m_buckets[bucket].load(std::memory_order_relaxed) + 1,
+                            std::memory_order_relaxed);
+    m_count.store(count, std::memory_order_relaxed);
+    m_avg_us.store(static_cast<int32_t>(m_sum_us / count), std::memory_order_relaxed);
+    if (us < m_min_us.load(std::memory_order_relaxed)) {
+        m_min_us.store(us, std::memory_order_relaxed);
+    }
+    if (us > m_max_us.load(std::memory_order_relaxed)) {
+        m_max_us.store(us, std::memory_order_relaxed);
+    }
+}
+
+void DelayHistogram::clear()
+{
+    m_sum_us = 0;
+    m_count.store(0, std::memory_order_relaxed);
+    m_min_us.store(INT32_MAX, std::memory_order_relaxed);
+    m_avg_us.store(0, std::memory_order_relaxed);
+    m_max_us.store(INT32_MIN, std::memory_order_relaxed);
+    for (auto& bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+int32_t DelayHistogram::percentile(const Snapshot& s, uint32_t permille)
+{
+    // Bucket counts may run ahead of count while the writer is mid-update
+    uint32_t total = 0;
+    for (uint32_t n : s.buckets) {
+        total += n;
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    uint32_t rank = (static_cast<uint64_t>(total) * permille + 999) / 1000;
+    uint32_t below = 0;
+    for (size_t i = 0; i < kBuckets; i++) {
+        if (below + s.buckets[i] < rank) {
+            below += s.buckets[i];
+            continue;
+        }
+        int64_t lo = i == 0 ? (s.min_us < 0 ? s.min_us : 0) : bucketLowMs(i) * 1000;
+        int64_t hi = i + 1 < kBuckets ? bucketLowMs(i + 1) * 1000 : s.max_us;
+        int64_t v = lo + (hi - lo) * (rank - below) / s.buckets[i];
+        return static_cast<int32_t>(v < s.min_us ? s.min_us : (v > s.max_us ? s.max_us : v));
+    }
+    return s.max_us;
+}
+
+void DelayHistogram::snapshot(Snapshot* out) const
+{
+    out->count = m_count.load(std::memory_order_relaxed);
+    out->min_us = out->count ? m_min_us.load(std::memory_order_relaxed) : 0;
+    out->avg_us = m_avg_us.load(std::memory_order_relaxed);
+    out->max_us = out->count ? m_max_us.load(std::memory_order_relaxed) : 0;
+    for (size_t i = 0; i < kBuckets; i++) {
+        out->buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+    }
+    out->p50_us = percentile(*out, 500);
+    out->p99_us = percentile(*out, 990);
+}
+
+void RtpStats::clear()
+{
+    m_have_seq = false;
+    m_max_seq = 0;
+    m_cycles = 0;
+    m_base_seq = 0;
+    m_lost_carry = 0;
+    m_unique_base = 0;
+    m_proc_sum_ns = 0;
+    m_plc_sum_ns = 0;
+    m_jb_delay_sum_us = 0;
+    m_jb_delay_count = 0;
+
+    set(m_received, 0);
+    set(m_lost, 0);
+    set(m_reordered, 0);
+    set(m_duplicates, 0);
+    set(m_late, 0);
+    set(m_proc_count, 0);
+    set(m_proc_min_ns, UINT32_MAX);
+    set(m_proc_avg_ns, 0);
+    set(m_proc_max_ns, 0);
+    set(m_plc_frames, 0);
+    set(m_plc_avg_ns, 0);
+    set(m_plc_max_ns, 0);
+    set(m_jb_delay_avg_us, 0);
+    set(m_jb_delay_max_us, 0);
+    set(m_jb_max_depth, 0);
+    set(m_jb_underruns, 0);
+    set(m_jb_drops, 0);
+    m_network_delay.clear();
+
+    m_jb_underruns_base = m_jb_underruns_raw;
+    m_jb_drops_base = m_jb_drops_raw;
+}
+
+void RtpStats::applyPendingReset()
+{
+    if (m_reset_requested.load(std::memory_order_acquire)) {
+        m_reset_requested.store(false, std::memory_order_relaxed);
+        clear();
+    }
+}
+
+void RtpStats::onPacket(uint16_t sequence, JitterBuffer::PushResult result)
+{
+    inc(m_received);
+
+    if (result == JitterBuffer::PushResult::Duplicate) {
+        inc(m_duplicates);
+    } else if (result == JitterBuffer::PushResult::Late) {
+        inc(m_late);
+    }
+
+    uint32_t unique = m_received.load(std::memory_order_relaxed) -
+                      m_duplicates.load(std::memory_order_relaxed);
+
+    if (!m_have_seq || result == JitterBuffer::PushResult::Resync) {
+        // (Re)start sequence tracking; keep the loss seen so far
+        m_lost_carry = m_lost.load(std::memory_order_relaxed);
+        m_unique_base = unique - 1;
+        m_have_seq = true;
+        m_max_seq = sequence;
+        m_cycles = 0;
+        m_base_seq = sequence;
+        return;
+    }
+
+    int32_t delta = static_cast<int16_t>(sequence - m_max_seq);
+    if (delta > 0) {
+        if (sequence < m_max_seq) {
+            m_cycles += 1u << 16;
+        }
+        m_max_seq = sequence;
+    } else if (delta < 0 && result != JitterBuffer::PushResult::Duplicate) {
+        inc(m_reordered);
+    }
+
+    // RFC 3550 A.3: lost = expected - received
+    uint32_t expected = (m_cycles + m_max_seq) - m_base_seq + 1;
+    uint32_t received = unique - m_unique_base;
+    set(m_lost, m_lost_carry + (expected > received ? expected - received : 0));
+}
+
+void RtpStats::onProcessTime(uint32_t ns)
+{
+    uint32_t count = m_proc_count.load(std::memory_order_relaxed) + 1;
+    m_proc_sum_ns += ns;
+
+    set(m_proc_count, count);
+    set(m_proc_avg_ns, static_cast<uint32_t>(m_proc_sum_ns / count));
+    if (ns < m_proc_min_ns.load(std::memory_order_relaxed)) {
+        set(m_proc_min_ns, ns);
+    }
+    if (ns > m_proc_max_ns.load(std::memory_order_relaxed)) {
+        set(m_proc_max_ns, ns);
+    }
+}
+
+void RtpStats::onConcealment(uint32_t ns)
+{
+    uint32_t count = m_plc_frames.load(std::memory_order_relaxed) + 1;
+    m_plc_sum_ns += ns;
+
+    set(m_plc_frames, count);
+    set(m_plc_avg_ns, static_cast<uint32_t>(m_plc_sum_ns / count));
+    if (ns > m_plc_max_ns.load(std::memory_order_relaxed)) {
+        set(m_plc_max_ns, ns);
+    }
+}
+
+void RtpStats::onPlayoutDelay(uint32_t us)
+{
+    m_jb_delay_count++;
+    m_jb_delay_sum_us += us;
+
+    set(m_jb_delay_avg_us, static_cast<uint32_t>(m_jb_delay_sum_us / m_jb_delay_count));
+    if (us > m_jb_delay_max_us.load(std::memory_order_relaxed)) {
+        set(m_jb_delay_max_us, us);
+    }
+}
+
+void RtpStats::onJitterBuffer(const JitterBuffer& jb)
+{
+    uint32_t depth = jb.depth();
+
+    // The jitter buffer restarts its counters on RtpReceiver::start()
+    if (jb.underruns() < m_jb_underruns_base) {
+        m_jb_underruns_base = 0;
+    }
+    if (jb.drops() < m_jb_drops_base) {
+        m_jb_drops_base = 0;
+    }
+    m_jb_underruns_raw = jb.underruns();
+    m_jb_drops_raw = jb.drops();
+
+    set(m_jitter_us, jb.jitterUs());
+    set(m_jb_depth, depth);
+    set(m_jb_target, jb.targetDepth());
+    set(m_jb_underruns, m_jb_underruns_raw - m_jb_underruns_base);
+    set(m_jb_drops, m_jb_drops_raw - m_jb_drops_base);
+    if (depth > m_jb_max_depth.load(std::memory_order_relaxed)) {
+        set(m_jb_max_depth, depth);
+    }
+}
+
+void RtpStats::onClock(int32_t driftPpb, bool locked)
+{
+    m_clock_drift_ppb.store(driftPpb, std::memory_order_relaxed);
+    m_clock_locked.store(locked, std::memory_order_relaxed);
+}
+
+bool RtpStats::fillReportState(RtcpSourceState* out) const
+{
+    if (!m_have_seq) {
+        return false;
+    }
+
+    // Cumulative totals survive resyncs, so interval deltas stay meaningful
+    uint32_t unique = m_received.load(std::memory_order_relaxed) -
+                      m_duplicates.load(std::memory_order_relaxed);
+    out->extended_max_seq = m_cycles + m_max_seq;
+    out->received = unique;
+    out->expected = unique + m_lost.load(std::memory_order_relaxed);
+    return true;
+}
+
+void RtpStats::snapshot(Snapshot* out) const
+{
+    uint32_t proc_min = m_proc_min_ns.load(std::memory_order_relaxed);
+
+    out->received = m_received.load(std::memory_order_relaxed);
+    out->lost = m_lost.load(std::memory_order_relaxed);
+    out->reordered = m_reordered.load(std::memory_order_relaxed);
+    out->duplicates = m_duplicates.load(std::memory_order_relaxed);
+    out->late = m_late.load(std::memory_order_relaxed);
+    out->jitter_us = m_jitter_us.load(std::memory_order_relaxed);
+    out->proc_min_ns = proc_min == UINT32_MAX ? 0 : proc_min;
+    out->proc_avg_ns = m_proc_avg_ns.load(std::memory_order_relaxed);
+    out->proc_max_ns = m_proc_max_ns.load(std::memory_order_relaxed);
+    out->plc_frames = m_plc_frames.load(std::memory_order_relaxed);
+    out->plc_avg_ns = m_plc_avg_ns.load(std::memory_order_relaxed);
+    out->plc_max_ns = m_plc_max_ns.load(std::memory_order_relaxed);
+    out->jb_delay_avg_us = m_jb_delay_avg_us.load(std::memory_order_relaxed);
+    out->jb_delay_max_us = m_jb_delay_max_us.load(std::memory_order_relaxed);
+    out->jb_depth = m_jb_depth.load(std::memory_order_relaxed);
+    out->jb_target = m_jb_target.load(std::memory_order_relaxed);
+    out->jb_max_depth = m_jb_max_depth.load(std::memory_order_relaxed);
+    out->jb_underruns = m_jb_underruns.load(std::memory_order_relaxed);
+    out->jb_drops = m_jb_drops.load(std::memory_order_relaxed);
+    out->clock_drift_ppb = m_clock_drift_ppb.load(std::memory_order_relaxed);
+    out->clock_locked = m_clock_locked.load(std::memory_order_relaxed);
+    m_network_delay.snapshot(&out->network_delay);
+}
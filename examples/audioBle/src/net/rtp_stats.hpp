@@ -0,0 +1,213 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include "../audio/jitter_buffer.hpp"
+#include "rtcp.hpp"
+
+/**
+ * @brief Delay distribution in power-of-two millisecond buckets
+ *
+ * Same single-writer rule as RtpStats. Bucket 0 holds delays below 1 ms
+ * (and negative ones), bucket i the range [2^(i-1), 2^i) ms, the last
+ * bucket everything longer. Percentiles are interpolated within their
+ * bucket by the reader.
+ */
+class DelayHistogram {
+public:
+    static constexpr size_t kBuckets = 12;
+
+    struct Snapshot {
+        uint32_t count;
+        int32_t min_us;     // Negative when the clocks disagree by more than the delay
+        int32_t avg_us;
+        int32_t max_us;
+        int32_t p50_us;
+        int32_t p99_us;
+        uint32_t buckets[kBuckets];
+    };
+
+    /**
+     * @brief Lower bound of a bucket in milliseconds
+     */
+    static uint32_t bucketLowMs(size_t bucket) { return bucket == 0 ? 0 : 1u << (bucket - 1); }
+
+    void record(int32_t us);
+    void clear();
+    void snapshot(Snapshot* out) const;
+
+private:
+    static int32_t percentile(const Snapshot& s, uint32_t permille);
+
+    int64_t m_sum_us = 0;
+    std::atomic<uint32_t> m_count{0};
+    std::atomic<int32_t> m_min_us{INT32_MAX};
+    std::atomic<int32_t> m_avg_us{0};
+    std::atomic<int32_t> m_max_us{INT32_MIN};
+    std::atomic<uint32_t> m_buckets[kBuckets] = {};
+};
+
+/**
+ * @brief Per-stream RTP receive statistics
+ *
+ * Single writer (the RTP receive thread), any number of readers (shell).
+ * Every counter is a std::atomic updated with relaxed load/store, so the
+ * writer never takes a lock and readers see torn-free values. Readers ask
+ * for a reset with requestReset(); the writer performs it at its next
+ * update, which keeps the single-writer rule intact.
+ *
+ * Loss follows RFC 3550 A.3: expected packets from the extended highest
+ * sequence number minus the packets actually received (duplicates
+ * excluded). Jitter is the RFC 3550 interarrival estimate taken from the
+ * jitter buffer.
+ */
+class RtpStats {
+public:
+    struct Snapshot {
+        uint32_t received;      // Valid RTP packets accepted by the parser
+        uint32_t lost;          // Sequence numbers never received
+        uint32_t reordered;     // Arrived after a higher sequence number
+        uint32_t duplicates;    // Sequence number already buffered
+        uint32_t late;          // Arrived after its playout time
+        uint32_t jitter_us;     // RFC 3550 interarrival jitter
+        uint32_t proc_min_ns;   // Parse + enqueue time per packet
+        uint32_t proc_avg_ns;
+        uint32_t proc_max_ns;
+        uint32_t plc_frames;    // Frames synthesized by loss concealment
+        uint32_t plc_avg_ns;    // Concealment time per frame
+        uint32_t plc_max_ns;
+        uint32_t jb_delay_avg_us;  // Arrival to playout, per played frame
+        uint32_t jb_delay_max_us;
+        uint32_t jb_depth;      // Current jitter buffer depth (frames)
+        uint32_t jb_target;     // Current adaptive target (frames)
+        uint32_t jb_max_depth;  // Largest depth seen (frames)
+        uint32_t jb_underruns;
+        uint32_t jb_drops;
+        int32_t clock_drift_ppb;  // Recovered sender clock drift (positive = fast)
+        bool clock_locked;
+        DelayHistogram::Snapshot network_delay;  // Send time to recvfrom()
+    };
+
+    // --- Writer side (receive thread) ---
+
+    /**
+     * @brief Perform a pending reset; call before a batch of updates
+     */
+    void applyPendingReset();
+
+    /**
+     * @brief Account one parsed packet and what the jitter buffer did with it
+     */
+    void onPacket(uint16_t sequence, JitterBuffer::PushResult result);
+
+    /**
+     * @brief Account the parse + enqueue time of one packet
+     */
+    void onProcessTime(uint32_t ns);
+
+    /**
+     * @brief Account one concealed frame and the time it took
+     */
+    void onConcealment(uint32_t ns);
+
+    /**
+     * @brief Account how long a played frame waited in the jitter buffer
+     */
+    void onPlayoutDelay(uint32_t us);
+
+    /**
+     * @brief Account the one-way delay of a packet with a send timestamp
+     * @param us Arrival minus send time on the synchronised wall clock
+     */
+    void onNetworkDelay(int32_t us) { m_network_delay.record(us); }
+
+    /**
+     * @brief Copy the current jitter buffer state
+     */
+    void onJitterBuffer(const JitterBuffer& jb);
+
+    /**
+     * @brief Copy the clock recovery state
+     */
+    void onClock(int32_t driftPpb, bool locked);
+
+    /**
+     * @brief Fill the sequence/loss fields of an RTCP report block
+     *
+     * Writer side only (reads unsynchronised tracking state). Sets
+     * extended_max_seq, expected and received; the caller adds ssrc
+     * and jitter_ts.
+     * @return false if no packet has been received yet
+     */
+    bool fillReportState(RtcpSourceState* out) const;
+
+    // --- Reader side ---
+
+    /**
+     * @brief Ask the writer to clear all counters at its next update
+     */
+    void requestReset() { m_reset_requested.store(true, std::memory_order_release); }
+
+    /**
+     * @brief Take a consistent-enough copy of all counters
+     */
+    void snapshot(Snapshot* out) const;
+
+private:
+    static void inc(std::atomic<uint32_t>& counter)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    static void set(std::atomic<uint32_t>& value, uint32_t v)
+    {
+        value.store(v, std::memory_order_relaxed);
+    }
+
+    void clear();
+
+    std::atomic<bool> m_reset_requested{false};
+
+    // Sequence tracking (writer only, RFC 3550 A.1)
+    bool m_have_seq = false;
+    uint16_t m_max_seq = 0;
+    uint32_t m_cycles = 0;      // Sequence number wraps, shifted by 16
+    uint32_t m_base_seq = 0;    // Extended sequence number of the first packet
+    uint32_t m_lost_carry = 0;  // Loss accounted before a resync
+    uint32_t m_unique_base = 0; // Unique packets received before the base
+    uint64_t m_proc_sum_ns = 0;
+    uint64_t m_plc_sum_ns = 0;
+    uint64_t m_jb_delay_sum_us = 0;
+    uint32_t m_jb_delay_count = 0;
+
+    std::atomic<uint32_t> m_received{0};
+    std::atomic<uint32_t> m_lost{0};
+    std::atomic<uint32_t> m_reordered{0};
+    std::atomic<uint32_t> m_duplicates{0};
+    std::atomic<uint32_t> m_late{0};
+    std::atomic<uint32_t> m_jitter_us{0};
+    std::atomic<uint32_t> m_proc_count{0};
+    std::atomic<uint32_t> m_proc_min_ns{UINT32_MAX};
+    std::atomic<uint32_t> m_proc_avg_ns{0};
+    std::atomic<uint32_t> m_proc_max_ns{0};
+    std::atomic<uint32_t> m_plc_frames{0};
+    std::atomic<uint32_t> m_plc_avg_ns{0};
+    std::atomic<uint32_t> m_plc_max_ns{0};
+    std::atomic<uint32_t> m_jb_delay_avg_us{0};
+    std::atomic<uint32_t> m_jb_delay_max_us{0};
+    std::atomic<uint32_t> m_jb_depth{0};
+    std::atomic<uint32_t> m_jb_target{0};
+    std::atomic<uint32_t> m_jb_max_depth{0};
+    std::atomic<uint32_t> m_jb_underruns{0};
+    std::atomic<uint32_t> m_jb_drops{0};
+    std::atomic<int32_t> m_clock_drift_ppb{0};
+    std::atomic<bool> m_clock_locked{false};
+    DelayHistogram m_network_delay;
+
+    // Jitter buffer counters are cumulative; reset subtracts these
+    uint32_t m_jb_underruns_base = 0;
+    uint32_t m_jb_drops_base = 0;
+    uint32_t m_jb_underruns_raw = 0;
+    uint32_t m_jb_drops_raw = 0;
+};
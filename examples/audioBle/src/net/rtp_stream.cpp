@@ -0,0 +1,216 @@
+#include "rtp_stream.hpp"
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include "../trace/cycle_counter.hpp"
+#include "../util/log_throttle.hpp"
+
+LOG_MODULE_REGISTER(rtp_stream, CONFIG_RTP_RX_LOG_LEVEL);
+
+#define RTP_PLAYOUT_MAX_CATCHUP 10  // Frames the playout clock may fall behind
+#define RTCP_CNAME "audioBle"
+
+// Free-running microsecond clock for arrival and playout times (wraps after ~71 min)
+static inline uint32_t rtp_now_us()
+{
+    return static_cast<uint32_t>(k_ticks_to_us_floor64(k_uptime_ticks()));
+}
+
+RtpStream::RtpStream(PacketPool& pool, uint32_t cyclesPerSec, uint8_t index)
+    : m_index(index),
+      m_pool(pool),
+      m_jitter(CONFIG_RTP_CLOCK_RATE, pool),
+      m_clock(CONFIG_RTP_CLOCK_RATE, cyclesPerSec),
+      m_rtcp(RTCP_CNAME)
+{
+}
+
+void RtpStream::configure(uint16_t port, uint32_t ssrc)
+{
+    m_enabled = true;
+    m_port = port;
+    m_ssrc_filter = ssrc;
+}
+
+void RtpStream::start(uint8_t portIndex, uint32_t rtcpSsrc)
+{
+    m_port_index = portIndex;
+    m_bound = false;
+    m_bound_ssrc = 0;
+    m_rtcp.reset(rtcpSsrc);
+    m_rtcp.setSourceSsrc(0);
+    m_stats.requestReset();
+    restart();
+}
+
+void RtpStream::restart()
+{
+    m_jitter.reset();
+    m_clock.reset();
+    m_asrc.reset();
+    m_plc.reset();
+    m_output.clear();
+    m_playing = false;
+    m_mix_ready = false;
+    m_frame_samples = 0;
+}
+
+void RtpStream::bind(uint32_t ssrc)
+{
+    if (m_bound && ssrc != m_bound_ssrc) {
+        // A different source: nothing buffered or learned carries over
+        LOG_INF("Stream %u rebinding from SSRC 0x%08x to 0x%08x", m_index, m_bound_ssrc, ssrc);
+        restart();
+    }
+
+    m_bound = true;
+    m_bound_ssrc = ssrc;
+    m_last_packet_ms = k_uptime_get_32();
+    m_rtcp.setSourceSsrc(ssrc);
+}
+
+void RtpStream::onPacket(const RtpPacket& pkt, PacketBuf* buf, uint32_t startCyc)
+{
+    m_stats.applyPendingReset();
+    m_last_packet_ms = k_uptime_get_32();
+
+    if (!m_playing) {
+        // First packet starts the playout clock one frame later
+        m_playing = true;
+        m_next_playout_us = buf->arrival_us + m_jitter.frameDurationUs();
+        m_playout_frac_q16 = 0;
+    }
+
+    // The jitter buffer owns the block from here on
+    uint32_t arrival_cyc = buf->arrival_cyc;
+    JitterBuffer::PushResult res = m_jitter.push(
+        pkt.sequence, pkt.timestamp, buf, pkt.payload, pkt.payloadLen, buf->arrival_us);
+    m_stats.onProcessTime(cycle_counter_to_ns(cycle_counter_get() - startCyc));
+    m_stats.onPacket(pkt.sequence, res);
+    if (res == JitterBuffer::PushResult::Queued || res == JitterBuffer::PushResult::Resync) {
+        LAT_TRACE(JbEnqueue, m_index, pkt.sequence);
+    }
+    if (res == JitterBuffer::PushResult::Resync) {
+        LOG_WRN_THROTTLED("RTP sequence jump to %u, jitter buffer resynced", pkt.sequence);
+        m_clock.reset();
+    }
+    if (res != JitterBuffer::PushResult::Duplicate) {
+        m_clock.onPacket(pkt.timestamp, arrival_cyc);
+    }
+}
+
+void RtpStream::onRtcp(const uint8_t* packet, size_t length, uint32_t nowUs)
+{
+    if (m_rtcp.onPacket(packet, length, nowUs) < 0) {
+        LOG_DBG_THROTTLED("Malformed RTCP packet (%d bytes)", length);
+    }
+}
+
+void RtpStream::feedResampler(const uint8_t* payload, size_t samples)
+{
+    int16_t* in = m_asrc.inputSpan(samples);
+    if (!in) {
+        // Cannot happen with one frame in per tick; drop rather than overrun
+        LOG_WRN_THROTTLED("Resampler input full, dropping %u samples", samples);
+        return;
+    }
+
+    if (payload) {
+        dsp::l16beToHost(payload, in, samples);
+        m_plc.onGoodFrame(in, samples);
+    } else {
+        uint32_t start_cyc = cycle_counter_get();
+        m_plc.conceal(in, samples);
+        m_stats.onConcealment(cycle_counter_to_ns(cycle_counter_get() - start_cyc));
+    }
+
+    m_asrc.commitInput(samples);
+}
+
+void RtpStream::pullFrame()
+{
+    JitterBuffer::Frame frame;
+
+    switch (m_jitter.pop(&frame)) {
+    case JitterBuffer::PopResult::Frame:
+        LAT_TRACE(JbDequeue, m_index, frame.sequence);
+        m_frame_samples = frame.length / sizeof(int16_t);
+        m_stats.onPlayoutDelay(rtp_now_us() - frame.buf->arrival_us);
+        feedResampler(frame.payload, m_frame_samples);
+        m_pool.free(frame.buf);
+        LAT_TRACE(Decode, m_index, frame.sequence);
+#ifdef CONFIG_AUDIO_LATENCY_TRACE
+        m_trace_seq = frame.sequence;
+#endif
+        break;
+    case JitterBuffer::PopResult::Lost:
+        // Keep the consumer's timeline intact with a concealed frame
+        LOG_DBG_THROTTLED("Frame seq=%u lost at playout", frame.sequence);
+        feedResampler(nullptr, m_frame_samples);
+        break;
+    case JitterBuffer::PopResult::Empty:
+        break;
+    }
+}
+
+bool RtpStream::playoutDue(uint32_t nowUs)
+{
+    if (!m_playing) {
+        return false;
+    }
+
+    uint32_t frame_us = m_jitter.frameDurationUs();
+    if (static_cast<int32_t>(nowUs - m_next_playout_us) >=
+        static_cast<int32_t>(RTP_PLAYOUT_MAX_CATCHUP * frame_us)) {
+        // Thread was starved for several frames - restart the clock
+        // instead of bursting the backlog into the PCM ring
+        LOG_WRN_THROTTLED("Playout clock %u us late, resetting", nowUs - m_next_playout_us);
+        m_next_playout_us = nowUs;
+    }
+
+    return static_cast<int32_t>(nowUs - m_next_playout_us) >= 0;
+}
+
+void RtpStream::playoutTick()
+{
+    // One frame in per tick, and ticks follow the sender clock: one
+    // jitter buffer pop per frame period of the sender, so pops stay in
+    // phase with arrivals however the clocks drift. The resampler turns
+    // the frame into however many samples that is at our rate
+    m_asrc.setDriftPpb(m_clock.driftPpb());
+    pullFrame();
+
+    uint32_t frame_us = m_jitter.frameDurationUs();
+    uint64_t period_q16 = (static_cast<uint64_t>(frame_us) << 16) * 1000000000 /
+                          (1000000000 + m_asrc.driftPpb());
+    m_playout_frac_q16 += period_q16;
+    m_next_playout_us += static_cast<uint32_t>(m_playout_frac_q16 >> 16);
+    m_playout_frac_q16 &= 0xFFFF;
+
+    m_stats.onJitterBuffer(m_jitter);
+    m_stats.onClock(m_clock.driftPpb(), m_clock.isLocked());
+}
+
+bool RtpStream::mixReady(size_t n)
+{
+    // Our ticks and the lead's are not in phase: wait for two blocks
+    // before mixing, so the ring never runs dry between our ticks
+    size_t fill = m_output.fillLevel();
+    if (!m_mix_ready && fill >= 2 * n) {
+        m_mix_ready = true;
+    } else if (m_mix_ready && fill < n) {
+        m_mix_ready = false;
+    }
+    return m_mix_ready;
+}
+
+size_t RtpStream::buildReceiverReport(uint8_t* buf, size_t size, uint32_t nowUs)
+{
+    RtcpSourceState source;
+    if (!m_bound || !m_stats.fillReportState(&source)) {
+        return 0;
+    }
+    source.ssrc = m_bound_ssrc;
+    source.jitter_ts = m_jitter.jitterTs();
+
+    return m_rtcp.buildReceiverReport(buf, size, source, nowUs);
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include "packet_pool.hpp"
+#include "rtp_parser.hpp"
+#include "rtp_stats.hpp"
+#include "rtcp.hpp"
+#include "../audio/jitter_buffer.hpp"
+#include "../audio/pcm_ring.hpp"
+#include "../audio/clock_recovery.hpp"
+#include "../audio/asrc.hpp"
+#include "../audio/plc.hpp"
+#include "../audio/dsp.hpp"
+#include "../trace/latency_trace.hpp"
+
+// Defaults for builds without Kconfig (host tools); see audioBle/Kconfig
+#ifndef CONFIG_RTP_STREAM_RING_SAMPLES
+#define CONFIG_RTP_STREAM_RING_SAMPLES 1024
+#endif
+
+/**
+ * @brief Receive and playout state of one RTP source
+ *
+ * Everything that belongs to a single SSRC: jitter buffer, clock recovery,
+ * resampler, loss concealment, statistics, RTCP reporting and the playout
+ * clock. RtpReceiver owns a fixed table of these, demultiplexes packets
+ * into them (by port and SSRC) and routes their output; all streams share
+ * one packet pool and one receive thread.
+ *
+ * A stream is configured with a port (0 = the port given to
+ * RtpReceiver::start()) and an SSRC (0 = take the first unclaimed source
+ * on that port). Configuration changes only while the receiver is
+ * stopped; the gain may change at any time.
+ *
+ * Output is pulled by the receiver after every playout tick with
+ * drain(). Streams that are mixed under another one park their output in
+ * their own ring until the lead stream's tick collects it.
+ */
+class RtpStream {
+public:
+    using OutputRing = PcmRing<CONFIG_RTP_STREAM_RING_SAMPLES>;
+
+    /**
+     * @param pool Shared packet pool (jitter buffer returns blocks here)
+     * @param cyclesPerSec Rate of k_cycle_get_32(), for clock recovery
+     * @param index Position in the receiver's table (logs and traces)
+     */
+    RtpStream(PacketPool& pool, uint32_t cyclesPerSec, uint8_t index);
+
+    uint8_t index() const { return m_index; }
+
+    // --- Configuration ---
+
+    /**
+     * @brief Receive this source (while the receiver is stopped)
+     * @param port UDP port, 0 for the receiver's primary port
+     * @param ssrc Source to accept, 0 for the first unclaimed one
+     */
+    void configure(uint16_t port, uint32_t ssrc);
+
+    /**
+     * @brief Take the stream out of use (while the receiver is stopped)
+     */
+    void disable() { m_enabled = false; }
+
+    bool isEnabled() const { return m_enabled; }
+    uint16_t port() const { return m_port; }
+    uint32_t ssrcFilter() const { return m_ssrc_filter; }
+
+    /**
+     * @brief Output gain, Q16 (dsp::kGainUnityQ16 = 0 dB, 0 = muted)
+     *
+     * Non-lead streams with a non-zero gain are mixed into the lead.
+     */
+    void setGainQ16(int32_t gain) { m_gain_q16.store(gain, std::memory_order_relaxed); }
+    int32_t gainQ16() const { return m_gain_q16.load(std::memory_order_relaxed); }
+
+    // --- Receive thread ---
+
+    /**
+     * @brief Reset all state for a new session
+     * @param portIndex Index of the stream's socket in the receiver
+     * @param rtcpSsrc Our SSRC for receiver reports
+     */
+    void start(uint8_t portIndex, uint32_t rtcpSsrc);
+
+    /**
+     * @brief Drop buffered packets and audio, stop the playout clock
+     *        (the binding and statistics are kept)
+     */
+    void restart();
+
+    uint8_t portIndex() const { return m_port_index; }
+
+    /**
+     * @brief Claim a source; a stream that was bound to another one
+     *        restarts its jitter buffer, clock recovery and resampler
+     */
+    void bind(uint32_t ssrc);
+
+    bool isBound() const { return m_bound; }
+    uint32_t boundSsrc() const { return m_bound_ssrc; }
+
+    /**
+     * @brief Milliseconds since the last accepted packet
+     */
+    uint32_t idleMs(uint32_t nowMs) const { return nowMs - m_last_packet_ms; }
+
+    /**
+     * @brief Hand one parsed packet (and its block) to the stream
+     * @param startCyc cycle_counter_get() taken before the packet was
+     *                 parsed, so the process time covers parse + enqueue
+     */
+    void onPacket(const RtpPacket& pkt, PacketBuf* buf, uint32_t startCyc);
+
+    /**
+     * @brief Account the one-way delay of the packet just handed over
+     * @param us recvfrom() time minus its send-time extension, wall clock
+     */
+    void onNetworkDelay(int32_t us) { m_stats.onNetworkDelay(us); }
+
+    /**
+     * @brief Feed a received RTCP packet (sender reports of our source)
+     */
+    void onRtcp(const uint8_t* packet, size_t length, uint32_t nowUs);
+
+    /**
+     * @brief Call after a batch of packets to publish jitter buffer state
+     */
+    void onBatchDone() { m_stats.onJitterBuffer(m_jitter); }
+
+    /**
+     * @brief True once the first packet arrived and the playout clock runs
+     */
+    bool isPlaying() const { return m_playing; }
+
+    /**
+     * @brief Check whether a playout tick is due (restarts a starved clock)
+     */
+    bool playoutDue(uint32_t nowUs);
+
+    /**
+     * @brief Move one frame from the jitter buffer into the resampler and
+     *        advance the playout clock by one sender frame period
+     */
+    void playoutTick();
+
+    /**
+     * @brief Time of the next playout tick (free-running microseconds)
+     */
+    uint32_t nextPlayoutUs() const { return m_next_playout_us; }
+
+    /**
+     * @brief Take resampled output
+     * @param out Output buffer, or nullptr to discard
+     * @return Number of samples produced (at most n)
+     */
+    size_t drain(int16_t* out, size_t n) { return m_asrc.process(out, n); }
+
+    /**
+     * @brief Trace the sink handoff of the frame played by the last tick;
+     *        call once its output has been drained
+     */
+    void traceHandoff()
+    {
+#ifdef CONFIG_AUDIO_LATENCY_TRACE
+        if (m_trace_seq >= 0) {
+            LAT_TRACE(SinkHandoff, m_index, m_trace_seq);
+            m_trace_seq = -1;
+        }
+#endif
+    }
+
+    /**
+     * @brief Ring holding output until the lead stream mixes it in
+     */
+    OutputRing& outputRing() { return m_output; }
+
+    /**
+     * @brief True if the output ring holds enough to be mixed without
+     *        running dry (re-armed after every underrun)
+     */
+    bool mixReady(size_t n);
+
+    /**
+     * @brief Build a receiver report for the bound source
+     * @return Packet length, 0 if there is nothing to report
+     */
+    size_t buildReceiverReport(uint8_t* buf, size_t size, uint32_t nowUs);
+
+    // --- Status (any thread) ---
+
+    const RtpStats& getStats() const { return m_stats; }
+    void resetStats() { m_stats.requestReset(); }
+    const JitterBuffer& getJitterBuffer() const { return m_jitter; }
+    const RtcpReporter& getRtcp() const { return m_rtcp; }
+    const OutputRing& getOutputRing() const { return m_output; }
+
+private:
+    void pullFrame();
+    void feedResampler(const uint8_t* payload, size_t samples);
+
+    // Configuration
+    const uint8_t m_index;
+    bool m_enabled = false;
+    uint16_t m_port = 0;
+    uint32_t m_ssrc_filter = 0;
+    std::atomic<int32_t> m_gain_q16{dsp::kGainUnityQ16};
+
+    PacketPool& m_pool;
+    JitterBuffer m_jitter;
+    ClockRecovery m_clock;
+    Asrc m_asrc;
+    Plc m_plc;
+    RtpStats m_stats;
+    RtcpReporter m_rtcp;
+    OutputRing m_output;
+
+    // Receive thread state
+    uint8_t m_port_index = 0;
+    bool m_bound = false;
+    uint32_t m_bound_ssrc = 0;
+    uint32_t m_last_packet_ms = 0;
+    bool m_playing = false;
+    bool m_mix_ready = false;
+    size_t m_frame_samples = 0;       // Samples in the last played frame
+    uint32_t m_next_playout_us = 0;
+    uint64_t m_playout_frac_q16 = 0;  // Sub-microsecond part of the playout clock
+#ifdef CONFIG_AUDIO_LATENCY_TRACE
+    int32_t m_trace_seq = -1;         // Frame of the last tick, until traceHandoff()
+#endif
+};
@@ -4,16 +4,441 @@
 #include <zephyr/net/net_event.h>
 #include <zephyr/net/net_if.h>
 #include <zephyr/net/socket.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/util.h>
+#ifdef CONFIG_WIFI_CREDENTIALS
+#include <net/wifi_credentials.h>
+#endif
+#ifdef CONFIG_WIFI_SNTP
+#include <zephyr/net/sntp.h>
+#endif
 #include <errno.h>
 #include <string.h>
 
 LOG_MODULE_REGISTER(wifi_mgr, LOG_LEVEL_INF);
 
+#define WIFI_CONNECT_TIMEOUT_MS 30000
+#define WIFI_DHCP_TIMEOUT_MS 30000
+#define WIFI_RECONNECT_STACK_SIZE 4096
+#define WIFI_RECONNECT_PRIORITY 8  /* Below the RTP receive thread */
+#define WIFI_RECONNECT_BACKOFF_MIN_MS 250
+#define WIFI_CACHE_VERSION 2
+#define WIFI_SNTP_RETRY_S 10
+#define WIFI_SNTP_STACK_SIZE 3072  /* DNS lookup + one UDP socket */
+#define WIFI_SNTP_PRIORITY 10      /* Below the reconnect engine */
+
+/*
+ * Last network that reached IPv4, stored as the settings value
+ * "wifi_mgr/net". It holds no secret: the PSK comes from wifi_mgr_connect()
+ * (RAM only) or from the wifi_credentials store.
+ */
+struct wifi_cache {
+    uint8_t version;
+    uint8_t ssid_len;           /* 0: no network cached */
+    uint8_t channel;
+    uint8_t band;
+    uint8_t security;
+    uint8_t bssid[WIFI_MAC_ADDR_LEN];
+    char ssid[WIFI_SSID_MAX_LEN];
+};
+
 static K_SEM_DEFINE(wifi_connected, 0, 1);
 static K_SEM_DEFINE(ipv4_addr, 0, 1);
 static struct net_mgmt_event_callback wifi_cb;
 static struct net_mgmt_event_callback ipv4_cb;
 static bool is_connected = false;
+static int connect_status;
+
+/* Reconnect engine; the work items below run on its own queue, in order */
+static K_THREAD_STACK_DEFINE(reconnect_stack, WIFI_RECONNECT_STACK_SIZE);
+static struct k_work_q reconnect_q;
+static struct k_work_delayable reconnect_work;
+static struct k_work learn_work;
+static struct k_work ready_work;
+static K_MUTEX_DEFINE(cache_lock);
+static struct wifi_cache cache;
+static struct wifi_cache saved;         /* What the settings hold */
+static char cached_psk[WIFI_PSK_MAX_LEN + 1];
+static struct in_addr lease_addr;       /* RAM only: the DHCP client's lease, 0.0.0.0: none */
+static bool initialized;
+static bool auto_reconnect = IS_ENABLED(CONFIG_WIFI_AUTO_RECONNECT);
+static bool disconnect_requested;
+static bool recovering;
+static bool awaiting_ipv4;     /* A recovery attempt associated, DHCP pending */
+static unsigned int attempt;
+static uint32_t drop_time;
+static bool ip_notified;
+static struct in_addr notified_addr;
+static wifi_mgr_ip_cb_t ip_cb;
+static void *ip_cb_data;
+static uint32_t stat_drops;
+static uint32_t stat_fast_ok;
+static uint32_t stat_fast_fail;
+static uint32_t stat_full_ok;
+static uint32_t stat_last_recovery_ms;
+
+#ifdef CONFIG_WIFI_SNTP
+/*
+ * sntp_simple() blocks for up to CONFIG_WIFI_SNTP_TIMEOUT_MS, so it runs on
+ * its own queue: a drop during a query must not hold up reconnect_work
+ */
+static K_THREAD_STACK_DEFINE(sntp_stack, WIFI_SNTP_STACK_SIZE);
+static struct k_work_q sntp_q;
+
+/* Wall clock: Unix time = uptime + clock_offset_us, from the last SNTP sync */
+static struct k_work_delayable sntp_work;
+static struct k_spinlock clock_lock;
+static bool clock_synced;
+static int64_t clock_offset_us;
+static int64_t clock_sync_ms;
+static int32_t clock_step_us;
+static uint32_t clock_rtt_us;
+static uint32_t stat_sntp_ok;
+static uint32_t stat_sntp_fail;
+#endif
+
+static int settings_set(const char *name, size_t len, settings_read_cb read_cb, void *cb_arg)
+{
+    struct wifi_cache loaded;
+    ssize_t rc;
+
+    if (!settings_name_steq(name, "net", NULL)) {
+        return -ENOENT;
+    }
+    if (len != sizeof(loaded)) {
+        /* Other layout: forget it, the next connect writes a new one */
+        return 0;
+    }
+
+    rc = read_cb(cb_arg, &loaded, sizeof(loaded));
+    if (rc < 0) {
+        return rc;
+    }
+    if (loaded.version == WIFI_CACHE_VERSION && loaded.ssid_len <= WIFI_SSID_MAX_LEN) {
+        cache = loaded;
+        saved = loaded;
+    }
+    return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(wifi_mgr, "wifi_mgr", NULL, settings_set, NULL, NULL);
+
+/* Save the cache if it changed; call with cache_lock held */
+static void save_cache(void)
+{
+    int ret;
+
+    if (memcmp(&cache, &saved, sizeof(cache)) == 0) {
+        return;
+    }
+
+    ret = settings_save_one("wifi_mgr/net", &cache, sizeof(cache));
+    if (ret) {
+        LOG_WRN("Failed to save network cache: %d", ret);
+        return;
+    }
+    saved = cache;
+}
+
+static bool find_dhcp_addr(struct net_if *iface, struct in_addr *addr)
+{
+    for (int i = 0; i < NET_IF_MAX_IPV4_ADDR; i++) {
+        struct net_if_addr *if_addr = (struct net_if_addr*)&iface->config.ip.ipv4->unicast[i];
+
+        if (if_addr->addr_type == NET_ADDR_DHCP && if_addr->is_used) {
+            *addr = if_addr->address.in_addr;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Interface has an address: remember the lease, tell the user */
+static void network_ready(void)
+{
+    struct net_if *iface = net_if_get_default();
+    struct in_addr addr;
+    bool notify;
+
+    if (!iface || !is_connected || !find_dhcp_addr(iface, &addr)) {
+        return;
+    }
+
+    k_mutex_lock(&cache_lock, K_FOREVER);
+    lease_addr = addr;
+    save_cache();
+    k_mutex_unlock(&cache_lock);
+
+    if (recovering) {
+        recovering = false;
+        awaiting_ipv4 = false;
+        stat_last_recovery_ms = k_uptime_get_32() - drop_time;
+        LOG_INF("WiFi recovered in %u ms", stat_last_recovery_ms);
+    }
+
+    notify = !ip_notified || notified_addr.s_addr != addr.s_addr;
+    ip_notified = true;
+    notified_addr = addr;
+    if (notify && ip_cb) {
+        ip_cb(ip_cb_data);
+    }
+
+#ifdef CONFIG_WIFI_SNTP
+    /* Resync now; the offset from before a drop is still used meanwhile */
+    if (notify) {
+        k_work_reschedule_for_queue(&sntp_q, &sntp_work, K_NO_WAIT);
+    }
+#endif
+}
+
+#ifdef CONFIG_WIFI_SNTP
+static void sntp_work_handler(struct k_work *work)
+{
+    struct sntp_time ts;
+    int64_t t0_us, t1_us, server_us, offset_us;
+    k_spinlock_key_t key;
+    int ret;
+
+    ARG_UNUSED(work);
+
+    if (!is_connected) {
+        return;
+    }
+
+    t0_us = k_ticks_to_us_floor64(k_uptime_ticks());
+    ret = sntp_simple(CONFIG_WIFI_SNTP_SERVER, CONFIG_WIFI_SNTP_TIMEOUT_MS, &ts);
+    t1_us = k_ticks_to_us_floor64(k_uptime_ticks());
+    if (ret) {
+        stat_sntp_fail++;
+        LOG_WRN("SNTP with %s failed: %d", CONFIG_WIFI_SNTP_SERVER, ret);
+        k_work_reschedule_for_queue(&sntp_q, &sntp_work, K_SECONDS(WIFI_SNTP_RETRY_S));
+        return;
+    }
+
+    /* The server stamped its reply somewhere in the round trip; take the middle */
+    server_us = (int64_t)ts.seconds * USEC_PER_SEC +
+                (int64_t)(((uint64_t)ts.fraction * USEC_PER_SEC) >> 32);
+    offset_us = server_us - (t0_us + t1_us) / 2;
+
+    key = k_spin_lock(&clock_lock);
+    clock_step_us = clock_synced ? (int32_t)CLAMP(offset_us - clock_offset_us,
+                                                   INT32_MIN, INT32_MAX) : 0;
+    clock_offset_us = offset_us;
+    clock_sync_ms = k_uptime_get();
+    clock_rtt_us = (uint32_t)(t1_us - t0_us);
+    clock_synced = true;
+    k_spin_unlock(&clock_lock, key);
+
+    if (stat_sntp_ok++ == 0) {
+        LOG_INF("Wall clock synced with %s (round trip %u us)", CONFIG_WIFI_SNTP_SERVER,
+                clock_rtt_us);
+    }
+    k_work_reschedule_for_queue(&sntp_q, &sntp_work, K_SECONDS(CONFIG_WIFI_SNTP_RESYNC_S));
+}
+#endif
+
+static void ready_work_handler(struct k_work *work)
+{
+    ARG_UNUSED(work);
+    network_ready();
+}
+
+/* Associated: remember where, and resume at once if the lease survived */
+static void learn_work_handler(struct k_work *work)
+{
+    struct net_if *iface = net_if_get_default();
+    struct wifi_iface_status status = {0};
+    struct in_addr addr;
+    bool lease_kept;
+
+    ARG_UNUSED(work);
+
+    if (!iface || net_mgmt(NET_REQUEST_WIFI_IFACE_STATUS, iface, &status, sizeof(status))) {
+        return;
+    }
+
+    k_mutex_lock(&cache_lock, K_FOREVER);
+    if (status.ssid_len != cache.ssid_len || memcmp(status.ssid, cache.ssid, cache.ssid_len)) {
+        /* Another network: the lease and PSK of the old one do not apply */
+        memset(&cache, 0, sizeof(cache));
+        cached_psk[0] = '\0';
+        lease_addr.s_addr = 0;
+    }
+    cache.version = WIFI_CACHE_VERSION;
+    cache.ssid_len = MIN(status.ssid_len, WIFI_SSID_MAX_LEN);
+    memcpy(cache.ssid, status.ssid, cache.ssid_len);
+    memcpy(cache.bssid, status.bssid, WIFI_MAC_ADDR_LEN);
+    cache.channel = status.channel;
+    cache.band = status.band;
+    cache.security = status.security;
+    lease_kept = lease_addr.s_addr != 0 && find_dhcp_addr(iface, &addr) &&
+                 addr.s_addr == lease_addr.s_addr;
+    k_mutex_unlock(&cache_lock);
+
+    LOG_INF("Associated with %02x:%02x:%02x:%02x:%02x:%02x on channel %u",
+            status.bssid[0], status.bssid[1], status.bssid[2],
+            status.bssid[3], status.bssid[4], status.bssid[5], status.channel);
+
+    /*
+     * The DHCP client keeps a bound lease across a link drop and renews it
+     * when the link comes back; the address is usable now, so do not wait
+     * for the ACK. If the server hands out another address, ADDR_ADD runs
+     * network_ready() again.
+     */
+    if (lease_kept) {
+        network_ready();
+    }
+}
+
+/* PSK and security for the cached network; call with cache_lock held */
+static int lookup_credentials(char *psk, size_t psk_size, size_t *psk_len, uint8_t *security)
+{
+    *security = cache.security;
+    if (cache.security == WIFI_SECURITY_TYPE_NONE) {
+        *psk_len = 0;
+        return 0;
+    }
+
+    if (cached_psk[0]) {
+        *psk_len = strlen(cached_psk);
+        memcpy(psk, cached_psk, *psk_len);
+        return 0;
+    }
+
+#ifdef CONFIG_WIFI_CREDENTIALS
+    struct wifi_credentials_personal creds;
+
+    if (wifi_credentials_get_by_ssid_personal_struct(cache.ssid, cache.ssid_len, &creds) == 0 &&
+        creds.password_len <= psk_size) {
+        *psk_len = creds.password_len;
+        memcpy(psk, creds.password, creds.password_len);
+        return 0;
+    }
+#endif
+
+    return -ENOENT;
+}
+
+/* Send a connect request for the cached network */
+static int request_reconnect(struct net_if *iface, bool directed)
+{
+    struct wifi_connect_req_params params = {0};
+    char psk[WIFI_PSK_MAX_LEN];
+    size_t psk_len;
+    uint8_t security;
+    int ret;
+
+    k_mutex_lock(&cache_lock, K_FOREVER);
+    ret = lookup_credentials(psk, sizeof(psk), &psk_len, &security);
+    params.ssid = (uint8_t *)cache.ssid;
+    params.ssid_length = cache.ssid_len;
+    if (directed) {
+        /* Only the cached AP's channel is probed instead of every channel */
+        memcpy(params.bssid, cache.bssid, WIFI_MAC_ADDR_LEN);
+        params.channel = cache.channel;
+        params.band = cache.band;
+    } else {
+        params.channel = WIFI_CHANNEL_ANY;
+        params.band = WIFI_FREQ_BAND_UNKNOWN;
+    }
+    k_mutex_unlock(&cache_lock);
+
+    if (ret) {
+        LOG_WRN("No PSK for the cached network, leaving the reconnect to the supplicant "
+                "(connect with 'reconnect connect')");
+        return ret;
+    }
+
+    params.psk = (uint8_t *)psk;
+    params.psk_length = psk_len;
+    params.security = security;
+    params.mfp = WIFI_MFP_OPTIONAL;
+    params.timeout = SYS_FOREVER_MS;
+
+    k_sem_reset(&wifi_connected);
+    return net_mgmt(NET_REQUEST_WIFI_CONNECT, iface, &params, sizeof(params));
+}
+
+/*
+ * One recovery attempt. The first goes straight to the cached BSSID and
+ * channel with a short timeout; the rest scan every channel with backoff,
+ * in case the AP moved or another AP of the network is closer.
+ */
+static void reconnect_work_handler(struct k_work *work)
+{
+    struct net_if *iface = net_if_get_default();
+    bool directed;
+    int timeout_ms;
+    int delay_ms;
+    int ret;
+
+    ARG_UNUSED(work);
+
+    if (!auto_reconnect || !recovering || !iface) {
+        return;
+    }
+    if (is_connected) {
+        if (!awaiting_ipv4) {
+            return;
+        }
+        /* Associated, but DHCP never completed: try again from a scan */
+        LOG_WRN("No IPv4 address %u ms after associating, reconnecting", WIFI_DHCP_TIMEOUT_MS);
+        awaiting_ipv4 = false;
+        net_mgmt(NET_REQUEST_WIFI_DISCONNECT, iface, NULL, 0);
+        attempt = 1;
+        k_work_reschedule_for_queue(&reconnect_q, &reconnect_work,
+                                    K_MSEC(WIFI_RECONNECT_BACKOFF_MIN_MS << attempt));
+        return;
+    }
+
+    k_mutex_lock(&cache_lock, K_FOREVER);
+    directed = attempt == 0 && cache.channel != 0;
+    k_mutex_unlock(&cache_lock);
+    timeout_ms = directed ? CONFIG_WIFI_FAST_CONNECT_TIMEOUT_MS : WIFI_CONNECT_TIMEOUT_MS;
+
+    LOG_INF("Reconnect attempt %u (%s)", attempt + 1, directed ? "directed" : "scan");
+    ret = request_reconnect(iface, directed);
+    if (ret == -ENOENT) {
+        recovering = false;
+        return;
+    }
+    if (ret == 0 && k_sem_take(&wifi_connected, K_MSEC(timeout_ms)) == 0 &&
+        connect_status == 0) {
+        if (directed) {
+            stat_fast_ok++;
+        } else {
+            stat_full_ok++;
+        }
+        /* learn_work and ready_work take it from here, unless DHCP stalls */
+        attempt = 0;
+        awaiting_ipv4 = true;
+        k_work_reschedule_for_queue(&reconnect_q, &reconnect_work, K_MSEC(WIFI_DHCP_TIMEOUT_MS));
+        return;
+    }
+
+    if (directed) {
+        stat_fast_fail++;
+        LOG_WRN("Directed connect failed (%d), scanning", ret);
+    }
+
+    /* Abandon the pending attempt before the next one */
+    net_mgmt(NET_REQUEST_WIFI_DISCONNECT, iface, NULL, 0);
+
+    /* A failed directed attempt falls back to a scan at once */
+    attempt++;
+    delay_ms = directed ? 0 : MIN(WIFI_RECONNECT_BACKOFF_MIN_MS << MIN(attempt, 12U),
+                                  CONFIG_WIFI_RECONNECT_BACKOFF_MAX_MS);
+    k_work_reschedule_for_queue(&reconnect_q, &reconnect_work, K_MSEC(delay_ms));
+}
+
+static void start_recovery(void)
+{
+    recovering = true;
+    awaiting_ipv4 = false;
+    attempt = 0;
+    drop_time = k_uptime_get_32();
+    k_work_reschedule_for_queue(&reconnect_q, &reconnect_work, K_NO_WAIT);
+}
 
 static void handle_wifi_connect_result(struct net_mgmt_event_callback *cb,
                                        uint32_t mgmt_event, struct net_if *iface)
@@ -21,19 +446,40 @@ static void handle_wifi_connect_result(struct net_mgmt_event_callback *cb,
     const struct wifi_status *status = (const struct wifi_status *)cb->info;
 
     if (mgmt_event == NET_EVENT_WIFI_CONNECT_RESULT) {
+        connect_status = status->status;
         if (status->status == 0) {
             LOG_INF("WiFi Connected!");
             is_connected = true;
-            k_sem_give(&wifi_connected);
+            disconnect_requested = false;
+            k_work_submit_to_queue(&reconnect_q, &learn_work);
         } else {
             LOG_ERR("WiFi Connection failed: %d", status->status);
             is_connected = false;
         }
+        k_sem_give(&wifi_connected);
     } else if (mgmt_event == NET_EVENT_WIFI_DISCONNECT_RESULT) {
+        bool was_connected = is_connected;
+
         LOG_INF("WiFi Disconnected");
         is_connected = false;
+        ip_notified = false;
         k_sem_reset(&wifi_connected);
         k_sem_reset(&ipv4_addr);
+#ifdef CONFIG_WIFI_SNTP
+        k_work_cancel_delayable(&sntp_work);
+#endif
+
+        /*
+         * A failed attempt of a recovery in progress also lands here; a drop
+         * after an attempt associated, before DHCP completed, starts over
+         */
+        if (was_connected && !disconnect_requested && (!recovering || awaiting_ipv4)) {
+            stat_drops++;
+            if (auto_reconnect && cache.ssid_len) {
+                LOG_WRN("WiFi dropped, reconnecting");
+                start_recovery();
+            }
+        }
     }
 }
 
@@ -42,25 +488,68 @@ static void handle_ipv4_result(struct net_mgmt_event_callback *cb,
 {
     if (mgmt_event == NET_EVENT_IPV4_ADDR_ADD) {
         char buf[NET_IPV4_ADDR_LEN];
-        
-        for (int i = 0; i < NET_IF_MAX_IPV4_ADDR; i++) {
-            struct net_if_addr *if_addr = (struct net_if_addr*)&iface->config.ip.ipv4->unicast[i];
-            
-            if (if_addr->addr_type == NET_ADDR_DHCP && if_addr->is_used) {
-                net_addr_ntop(AF_INET, &if_addr->address.in_addr, buf, sizeof(buf));
-                LOG_INF("IPv4 address: %s", buf);
-                k_sem_give(&ipv4_addr);
-                break;
-            }
+        struct in_addr addr;
+
+        if (find_dhcp_addr(iface, &addr)) {
+            net_addr_ntop(AF_INET, &addr, buf, sizeof(buf));
+            LOG_INF("IPv4 address: %s", buf);
+            k_sem_give(&ipv4_addr);
+            k_work_submit_to_queue(&reconnect_q, &ready_work);
         }
     }
 }
 
+int wifi_mgr_init(void)
+{
+    int ret;
+
+    if (initialized) {
+        return 0;
+    }
+
+    ret = settings_subsys_init();
+    if (ret) {
+        LOG_WRN("Settings unavailable (%d), the network cache is not persistent", ret);
+    } else {
+        settings_load_subtree("wifi_mgr");
+    }
+
+    k_work_queue_init(&reconnect_q);
+    k_work_queue_start(&reconnect_q, reconnect_stack, K_THREAD_STACK_SIZEOF(reconnect_stack),
+                       WIFI_RECONNECT_PRIORITY, NULL);
+    k_thread_name_set(&reconnect_q.thread, "wifi_reconnect");
+    k_work_init_delayable(&reconnect_work, reconnect_work_handler);
+    k_work_init(&learn_work, learn_work_handler);
+    k_work_init(&ready_work, ready_work_handler);
+#ifdef CONFIG_WIFI_SNTP
+    k_work_queue_init(&sntp_q);
+    k_work_queue_start(&sntp_q, sntp_stack, K_THREAD_STACK_SIZEOF(sntp_stack),
+                       WIFI_SNTP_PRIORITY, NULL);
+    k_thread_name_set(&sntp_q.thread, "wifi_sntp");
+    k_work_init_delayable(&sntp_work, sntp_work_handler);
+#endif
+
+    net_mgmt_init_event_callback(&wifi_cb, handle_wifi_connect_result,
+                                 NET_EVENT_WIFI_CONNECT_RESULT |
+                                 NET_EVENT_WIFI_DISCONNECT_RESULT);
+    net_mgmt_add_event_callback(&wifi_cb);
+
+    net_mgmt_init_event_callback(&ipv4_cb, handle_ipv4_result,
+                                 NET_EVENT_IPV4_ADDR_ADD);
+    net_mgmt_add_event_callback(&ipv4_cb);
+    initialized = true;
+    LOG_INF("WiFi callbacks initialized");
+
+    if (cache.ssid_len) {
+        LOG_INF("Cached network: %.*s, channel %u", cache.ssid_len, cache.ssid, cache.channel);
+    }
+    return 0;
+}
+
 int wifi_mgr_connect(const char *ssid, const char *password)
 {
     struct net_if *iface;
     struct wifi_connect_req_params params = {0};
-    static bool callbacks_init = false;
     int ret;
 
     LOG_INF("Connecting to WiFi SSID: %s", ssid);
@@ -73,18 +562,19 @@ int wifi_mgr_connect(const char *ssid, const char *password)
     }
 
     /* Setup callbacks (once) */
-    if (!callbacks_init) {
-        net_mgmt_init_event_callback(&wifi_cb, handle_wifi_connect_result,
-                                     NET_EVENT_WIFI_CONNECT_RESULT |
-                                     NET_EVENT_WIFI_DISCONNECT_RESULT);
-        net_mgmt_add_event_callback(&wifi_cb);
+    ret = wifi_mgr_init();
+    if (ret) {
+        return ret;
+    }
 
-        net_mgmt_init_event_callback(&ipv4_cb, handle_ipv4_result,
-                                     NET_EVENT_IPV4_ADDR_ADD);
-        net_mgmt_add_event_callback(&ipv4_cb);
-        callbacks_init = true;
-        LOG_INF("WiFi callbacks initialized");
+    /* Kept for reconnecting, in RAM only */
+    k_mutex_lock(&cache_lock, K_FOREVER);
+    strncpy(cached_psk, password, sizeof(cached_psk) - 1);
+    if (strlen(ssid) != cache.ssid_len || memcmp(ssid, cache.ssid, cache.ssid_len)) {
+        memset(&cache, 0, sizeof(cache));
+        lease_addr.s_addr = 0;
     }
+    k_mutex_unlock(&cache_lock);
 
     /* Setup connection parameters */
     params.ssid = (uint8_t *)ssid;
@@ -99,6 +589,7 @@ int wifi_mgr_connect(const char *ssid, const char *password)
 
     /* Request connection */
     LOG_INF("Sending connection request...");
+    k_sem_reset(&wifi_connected);
     ret = net_mgmt(NET_REQUEST_WIFI_CONNECT, iface, &params, sizeof(params));
     if (ret) {
         LOG_ERR("Connection request failed: %d", ret);
@@ -108,15 +599,18 @@ int wifi_mgr_connect(const char *ssid, const char *password)
     LOG_INF("Connection request sent, waiting for result...");
 
     /* Wait for connection */
-    if (k_sem_take(&wifi_connected, K_SECONDS(30)) != 0) {
+    if (k_sem_take(&wifi_connected, K_MSEC(WIFI_CONNECT_TIMEOUT_MS)) != 0) {
         LOG_ERR("Connection timeout");
         return -ETIMEDOUT;
     }
+    if (connect_status != 0) {
+        return -ECONNREFUSED;
+    }
 
     LOG_INF("Connected, waiting for IP...");
 
     /* Wait for IP address */
-    if (k_sem_take(&ipv4_addr, K_SECONDS(30)) != 0) {
+    if (k_sem_take(&ipv4_addr, K_MSEC(WIFI_DHCP_TIMEOUT_MS)) != 0) {
         LOG_ERR("DHCP timeout");
         return -ETIMEDOUT;
     }
@@ -128,7 +622,13 @@ int wifi_mgr_connect(const char *ssid, const char *password)
 void wifi_mgr_disconnect(void)
 {
     struct net_if *iface = net_if_get_default();
-    
+
+    disconnect_requested = true;
+    recovering = false;
+    if (initialized) {
+        k_work_cancel_delayable(&reconnect_work);
+    }
+
     if (iface) {
         net_mgmt(NET_REQUEST_WIFI_DISCONNECT, iface, NULL, 0);
     }
@@ -143,18 +643,113 @@ bool wifi_mgr_is_connected(void)
 int wifi_mgr_get_ip(char *buf, size_t buflen)
 {
     struct net_if *iface = net_if_get_default();
-    
+    struct in_addr addr;
+
     if (!iface || !is_connected) {
         return -ENOTCONN;
     }
 
-    for (int i = 0; i < NET_IF_MAX_IPV4_ADDR; i++) {
-        struct net_if_addr *if_addr = (struct net_if_addr*)&iface->config.ip.ipv4->unicast[i];
-        
-        if (if_addr->addr_type == NET_ADDR_DHCP && if_addr->is_used) {
-            return net_addr_ntop(AF_INET, &if_addr->address.in_addr, buf, buflen) ? 0 : -EINVAL;
-        }
+    if (find_dhcp_addr(iface, &addr)) {
+        return net_addr_ntop(AF_INET, &addr, buf, buflen) ? 0 : -EINVAL;
     }
-    
+
     return -ENOENT;
 }
+
+void wifi_mgr_set_ip_callback(wifi_mgr_ip_cb_t cb, void *user_data)
+{
+    ip_cb_data = user_data;
+    ip_cb = cb;
+}
+
+void wifi_mgr_set_auto_reconnect(bool enable)
+{
+    auto_reconnect = enable;
+    if (!enable && initialized) {
+        recovering = false;
+        k_work_cancel_delayable(&reconnect_work);
+    }
+}
+
+int wifi_mgr_reconnect(void)
+{
+    if (!initialized || !cache.ssid_len) {
+        return -ENOENT;
+    }
+    if (is_connected) {
+        return -EALREADY;
+    }
+
+    disconnect_requested = false;
+    start_recovery();
+    return 0;
+}
+
+void wifi_mgr_forget(void)
+{
+    k_mutex_lock(&cache_lock, K_FOREVER);
+    memset(&cache, 0, sizeof(cache));
+    memset(&saved, 0, sizeof(saved));
+    cached_psk[0] = '\0';
+    lease_addr.s_addr = 0;
+    settings_delete("wifi_mgr/net");
+    k_mutex_unlock(&cache_lock);
+}
+
+void wifi_mgr_get_reconnect_info(struct wifi_mgr_reconnect_info *info)
+{
+    memset(info, 0, sizeof(*info));
+
+    k_mutex_lock(&cache_lock, K_FOREVER);
+    info->have_network = cache.ssid_len != 0;
+    memcpy(info->ssid, cache.ssid, MIN(cache.ssid_len, sizeof(info->ssid) - 1));
+    memcpy(info->bssid, cache.bssid, sizeof(info->bssid));
+    info->channel = cache.channel;
+    k_mutex_unlock(&cache_lock);
+
+    info->auto_reconnect = auto_reconnect;
+    info->recovering = recovering;
+    info->drops = stat_drops;
+    info->fast_ok = stat_fast_ok;
+    info->fast_fail = stat_fast_fail;
+    info->full_ok = stat_full_ok;
+    info->last_recovery_ms = stat_last_recovery_ms;
+}
+
+struct k_work_q *wifi_mgr_get_work_queue(void)
+{
+    return initialized ? &reconnect_q : NULL;
+}
+
+int wifi_mgr_get_clock_offset(int64_t *offset_us)
+{
+#ifdef CONFIG_WIFI_SNTP
+    k_spinlock_key_t key = k_spin_lock(&clock_lock);
+    int ret = clock_synced ? 0 : -EAGAIN;
+
+    *offset_us = clock_offset_us;
+    k_spin_unlock(&clock_lock, key);
+    return ret;
+#else
+    ARG_UNUSED(offset_us);
+    return -ENOTSUP;
+#endif
+}
+
+void wifi_mgr_get_clock_info(struct wifi_mgr_clock_info *info)
+{
+    memset(info, 0, sizeof(*info));
+
+#ifdef CONFIG_WIFI_SNTP
+    k_spinlock_key_t key = k_spin_lock(&clock_lock);
+
+    info->synced = clock_synced;
+    info->rtt_us = clock_rtt_us;
+    info->last_step_us = clock_step_us;
+    info->age_s = clock_synced ? (uint32_t)((k_uptime_get() - clock_sync_ms) / 1000) : 0;
+    k_spin_unlock(&clock_lock, key);
+
+    info->syncs = stat_sntp_ok;
+    info->failures = stat_sntp_fail;
+#endif
+}
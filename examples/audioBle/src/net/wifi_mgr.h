@@ -6,6 +6,50 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Reconnect engine state, for status reporting
+ */
+struct wifi_mgr_reconnect_info {
+    bool auto_reconnect;        /* Reconnect after a drop (wifi_mgr_set_auto_reconnect) */
+    bool recovering;            /* A drop is being recovered right now */
+    bool have_network;          /* A network is cached */
+    char ssid[33];
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint32_t drops;             /* Unrequested disconnects */
+    uint32_t fast_ok;           /* Recovered by the directed connect */
+    uint32_t fast_fail;         /* Directed connect failed, fell back to a scan */
+    uint32_t full_ok;           /* Recovered by a full scan connect */
+    uint32_t last_recovery_ms;  /* Drop to IPv4 ready, 0 until the first recovery */
+};
+
+/**
+ * @brief SNTP wall clock state, for status reporting
+ */
+struct wifi_mgr_clock_info {
+    bool synced;                /* At least one SNTP exchange succeeded */
+    uint32_t syncs;
+    uint32_t failures;
+    uint32_t rtt_us;            /* Round trip of the last exchange, bounds its error */
+    int32_t last_step_us;       /* Offset change at the last resync (local clock drift) */
+    uint32_t age_s;             /* Since the last sync */
+};
+
+/**
+ * @brief Called from the reconnect work queue when the interface has an
+ *        IPv4 address: after every association, and again if the address changes
+ */
+typedef void (*wifi_mgr_ip_cb_t)(void *user_data);
+
+/**
+ * @brief Register the network event handlers and load the cached network
+ *
+ * Called by wifi_mgr_connect() if needed; call it at boot so drops of
+ * connections made with the 'wifi connect' shell command are recovered too.
+ * @return 0 on success, negative error code on failure
+ */
+int wifi_mgr_init(void);
+
 /**
  * @brief Connect to WiFi network
  * @param ssid Network SSID (null-terminated string)
@@ -15,7 +59,7 @@ extern "C" {
 int wifi_mgr_connect(const char *ssid, const char *password);
 
 /**
- * @brief Disconnect from WiFi
+ * @brief Disconnect from WiFi (not treated as a drop, no reconnect)
  */
 void wifi_mgr_disconnect(void);
 
@@ -33,6 +77,61 @@ bool wifi_mgr_is_connected(void);
  */
 int wifi_mgr_get_ip(char *buf, size_t buflen);
 
+/**
+ * @brief Set the callback run when the interface gets an IPv4 address
+ * @param cb Callback, NULL to remove it
+ * @param user_data Passed to cb
+ */
+void wifi_mgr_set_ip_callback(wifi_mgr_ip_cb_t cb, void *user_data);
+
+/**
+ * @brief Enable or disable reconnecting after a drop
+ *
+ * Disabling also abandons a recovery in progress.
+ */
+void wifi_mgr_set_auto_reconnect(bool enable);
+
+/**
+ * @brief Start recovering now, as if the link had dropped
+ * @return 0 on success, -ENOENT if no network is cached, -EALREADY if connected
+ */
+int wifi_mgr_reconnect(void);
+
+/**
+ * @brief Drop the cached network (RAM and settings)
+ */
+void wifi_mgr_forget(void);
+
+/**
+ * @brief Get the reconnect engine state
+ */
+void wifi_mgr_get_reconnect_info(struct wifi_mgr_reconnect_info *info);
+
+/**
+ * @brief WiFi management work queue, shared with the power-save policy
+ *
+ * Work queued here waits behind a reconnect attempt (up to 30 s), which
+ * only happens while the link is down anyway.
+ * @return Queue, NULL before wifi_mgr_init()
+ */
+struct k_work_q *wifi_mgr_get_work_queue(void);
+
+/**
+ * @brief Offset from uptime to Unix time (CONFIG_WIFI_SNTP)
+ *
+ * Unix time in microseconds = k_ticks_to_us_floor64(k_uptime_ticks()) +
+ * offset. Synced after every IPv4 address and then periodically; kept
+ * across a WiFi drop. Safe from any thread.
+ * @param offset_us Output offset
+ * @return 0 on success, -EAGAIN before the first sync, -ENOTSUP without SNTP
+ */
+int wifi_mgr_get_clock_offset(int64_t *offset_us);
+
+/**
+ * @brief Get the SNTP wall clock state
+ */
+void wifi_mgr_get_clock_info(struct wifi_mgr_clock_info *info);
+
 #ifdef __cplusplus
 }
 #endif
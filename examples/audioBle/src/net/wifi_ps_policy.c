@@ -0,0 +1,344 @@
+#include "wifi_ps_policy.h"
+#include "wifi_mgr.h"
+#include <zephyr/logging/log.h>
+#include <zephyr/net/wifi_mgmt.h>
+#include <zephyr/net/net_event.h>
+#include <zephyr/net/net_if.h>
+#include <errno.h>
+
+LOG_MODULE_REGISTER(wifi_ps_policy, LOG_LEVEL_INF);
+
+#define TWT_FLOW_ID 1
+#define TWT_DEFAULT_INTERVAL_US 20000      /* Until the packet period is known */
+#define TWT_PERIOD_TOLERANCE_PCT 10        /* Renegotiate beyond this period change */
+
+static struct k_work_q *policy_q;
+static struct k_work apply_work;
+static struct net_mgmt_event_callback policy_cb;
+
+/* Inputs: written by the receive, shell and net_mgmt threads */
+static bool running;
+static bool streaming;
+static uint32_t last_packet_ms;
+static uint32_t period_us;
+static uint32_t packets_per_sec;
+static bool forced;
+static enum wifi_ps_policy_mode forced_mode;
+
+/* Applied state: only apply_work (and the TWT event) touch it */
+static bool applied_valid;
+static enum wifi_ps_policy_mode applied = WIFI_PS_POLICY_SAVE;
+static bool twt_active;
+static bool twt_pending;
+static bool twt_rejected;
+static uint32_t twt_interval_us;
+static uint8_t twt_dialog_token;
+static uint32_t switches;
+static uint32_t errors;
+
+static enum wifi_ps_policy_mode desired_mode(void)
+{
+    if (forced) {
+        /* A refused flow is not asked for again until the next association */
+        return forced_mode == WIFI_PS_POLICY_TWT && twt_rejected ? WIFI_PS_POLICY_LOW_LATENCY
+                                                                 : forced_mode;
+    }
+    if (!streaming) {
+        return WIFI_PS_POLICY_SAVE;
+    }
+    if (IS_ENABLED(CONFIG_WIFI_PS_ACTIVE_TWT) && !twt_rejected && period_us) {
+        return WIFI_PS_POLICY_TWT;
+    }
+    return WIFI_PS_POLICY_LOW_LATENCY;
+}
+
+static uint32_t twt_interval_for(uint32_t period)
+{
+    return period ? period : TWT_DEFAULT_INTERVAL_US;
+}
+
+static bool period_differs(uint32_t a, uint32_t b)
+{
+    uint32_t diff = a > b ? a - b : b - a;
+
+    return diff * 100 > b * TWT_PERIOD_TOLERANCE_PCT;
+}
+
+static int set_ps_param(struct net_if *iface, enum wifi_ps_param_type type,
+                        struct wifi_ps_params *params)
+{
+    params->type = type;
+    if (net_mgmt(NET_REQUEST_WIFI_PS, iface, params, sizeof(*params))) {
+        LOG_WRN("PS parameter %d not applied (reason %d)", type, params->fail_reason);
+        errors++;
+        return -EIO;
+    }
+    return 0;
+}
+
+/* PS on; wake every DTIM or on the listen interval, sleep after timeout_ms idle */
+static int apply_ps(struct net_if *iface, bool dtim, int timeout_ms)
+{
+    struct wifi_ps_params params = {0};
+    int ret = 0;
+
+    params.enabled = WIFI_PS_ENABLED;
+    ret |= set_ps_param(iface, WIFI_PS_PARAM_STATE, &params);
+    params.wakeup_mode = dtim ? WIFI_PS_WAKEUP_MODE_DTIM : WIFI_PS_WAKEUP_MODE_LISTEN_INTERVAL;
+    ret |= set_ps_param(iface, WIFI_PS_PARAM_WAKEUP_MODE, &params);
+    params.timeout_ms = timeout_ms;
+    ret |= set_ps_param(iface, WIFI_PS_PARAM_TIMEOUT, &params);
+    return ret ? -EIO : 0;
+}
+
+static int twt_request(struct net_if *iface, enum wifi_twt_operation operation, uint32_t interval_us)
+{
+    struct wifi_twt_params params = {0};
+
+    params.operation = operation;
+    params.negotiation_type = WIFI_TWT_INDIVIDUAL;
+    params.setup_cmd = WIFI_TWT_SETUP_CMD_REQUEST;
+    if (++twt_dialog_token == 0) {
+        twt_dialog_token = 1;
+    }
+    params.dialog_token = twt_dialog_token;
+    params.flow_id = TWT_FLOW_ID;
+    if (operation == WIFI_TWT_SETUP) {
+        /*
+         * Unannounced, implicit: the STA wakes every interval whether or not
+         * the AP has data, which is what a constant-rate stream wants. The
+         * service period is capped at half the interval.
+         */
+        params.setup.implicit = true;
+        params.setup.twt_wake_interval = MIN(CONFIG_WIFI_PS_TWT_WAKE_US, interval_us / 2);
+        params.setup.twt_interval = interval_us;
+    }
+
+    if (net_mgmt(NET_REQUEST_WIFI_TWT, iface, &params, sizeof(params))) {
+        LOG_WRN("TWT %s failed (reason %d)", operation == WIFI_TWT_SETUP ? "setup" : "teardown",
+                params.fail_reason);
+        errors++;
+        return -EIO;
+    }
+    return 0;
+}
+
+static void apply_work_handler(struct k_work *work)
+{
+    struct net_if *iface = net_if_get_default();
+    enum wifi_ps_policy_mode mode = desired_mode();
+    uint32_t interval_us = twt_interval_for(period_us);
+    bool twt_stale;
+    int ret = 0;
+
+    ARG_UNUSED(work);
+
+    if (!iface) {
+        return;
+    }
+
+    twt_stale = (twt_active || twt_pending) &&
+                (mode != WIFI_PS_POLICY_TWT || period_differs(interval_us, twt_interval_us));
+    if (applied_valid && mode == applied && !twt_stale &&
+        (mode != WIFI_PS_POLICY_TWT || twt_active || twt_pending)) {
+        return;
+    }
+
+    /* Leave the old flow first, it would keep waking on the old schedule */
+    if (twt_stale) {
+        twt_request(iface, WIFI_TWT_TEARDOWN, 0);
+        twt_active = false;
+        twt_pending = false;
+    }
+
+    switch (mode) {
+    case WIFI_PS_POLICY_SAVE:
+        ret = apply_ps(iface, false, CONFIG_WIFI_PS_SAVE_TIMEOUT_MS);
+        break;
+    case WIFI_PS_POLICY_LOW_LATENCY:
+        ret = apply_ps(iface, true, CONFIG_WIFI_PS_LOW_LATENCY_TIMEOUT_MS);
+        break;
+    case WIFI_PS_POLICY_TWT:
+        /* PS stays on between service periods; DTIM wakeup if the flow goes */
+        ret = apply_ps(iface, true, CONFIG_WIFI_PS_LOW_LATENCY_TIMEOUT_MS);
+        if (!wifi_mgr_is_connected()) {
+            /* Negotiated after the next association (connect event) */
+            ret = -ENOTCONN;
+            break;
+        }
+        if (twt_request(iface, WIFI_TWT_SETUP, interval_us) == 0) {
+            twt_pending = true;
+            twt_interval_us = interval_us;
+        } else {
+            /* Typically an AP without 802.11ax: stay on low-latency PS */
+            twt_rejected = true;
+            k_work_submit_to_queue(policy_q, &apply_work);
+        }
+        break;
+    }
+
+    if (!applied_valid || mode != applied) {
+        LOG_INF("Power save: %s -> %s", applied_valid ? wifi_ps_policy_mode_name(applied) : "-",
+                wifi_ps_policy_mode_name(mode));
+        switches++;
+    }
+    applied = mode;
+    applied_valid = ret == 0;
+}
+
+static void schedule_apply(void)
+{
+    if (policy_q) {
+        k_work_submit_to_queue(policy_q, &apply_work);
+    }
+}
+
+static void handle_wifi_event(struct net_mgmt_event_callback *cb,
+                              uint32_t mgmt_event, struct net_if *iface)
+{
+    ARG_UNUSED(iface);
+
+    if (mgmt_event == NET_EVENT_WIFI_CONNECT_RESULT) {
+        const struct wifi_status *status = (const struct wifi_status *)cb->info;
+
+        if (status->status == 0) {
+            /* New association: no flow yet, and the AP may support TWT */
+            twt_active = false;
+            twt_pending = false;
+            twt_rejected = false;
+            applied_valid = false;
+            schedule_apply();
+        }
+    } else if (mgmt_event == NET_EVENT_WIFI_DISCONNECT_RESULT) {
+        twt_active = false;
+        twt_pending = false;
+    } else if (mgmt_event == NET_EVENT_WIFI_TWT) {
+        const struct wifi_twt_params *resp = (const struct wifi_twt_params *)cb->info;
+
+        if (resp->operation == WIFI_TWT_TEARDOWN) {
+            if (twt_active) {
+                /* Do not renegotiate with an AP that just ended the flow */
+                LOG_INF("TWT flow torn down by the AP, using low-latency PS");
+                twt_rejected = true;
+            }
+            twt_active = false;
+        } else if (resp->resp_status == WIFI_TWT_RESP_RECEIVED &&
+                   resp->setup_cmd == WIFI_TWT_SETUP_CMD_ACCEPT) {
+            twt_active = true;
+            twt_interval_us = (uint32_t)resp->setup.twt_interval;
+            LOG_INF("TWT flow accepted: wake %u us every %u us",
+                    resp->setup.twt_wake_interval, twt_interval_us);
+        } else {
+            LOG_WRN("TWT refused by the AP (command %d), using low-latency PS",
+                    resp->setup_cmd);
+            twt_active = false;
+            twt_rejected = true;
+        }
+        twt_pending = false;
+        schedule_apply();
+    }
+}
+
+int wifi_ps_policy_init(void)
+{
+    struct net_if *iface = net_if_get_default();
+    struct wifi_ps_params params = {0};
+    int ret;
+
+    ret = wifi_mgr_init();
+    if (ret) {
+        return ret;
+    }
+    if (!iface) {
+        return -ENODEV;
+    }
+
+    policy_q = wifi_mgr_get_work_queue();
+    k_work_init(&apply_work, apply_work_handler);
+
+    net_mgmt_init_event_callback(&policy_cb, handle_wifi_event,
+                                 NET_EVENT_WIFI_CONNECT_RESULT |
+                                 NET_EVENT_WIFI_DISCONNECT_RESULT |
+                                 NET_EVENT_WIFI_TWT);
+    net_mgmt_add_event_callback(&policy_cb);
+
+    /* Only accepted while disconnected; the AP learns it at association */
+    params.listen_interval = CONFIG_WIFI_PS_LISTEN_INTERVAL;
+    if (set_ps_param(iface, WIFI_PS_PARAM_LISTEN_INTERVAL, &params) == 0) {
+        LOG_INF("Listen interval %u beacons", CONFIG_WIFI_PS_LISTEN_INTERVAL);
+    }
+
+    schedule_apply();
+    return 0;
+}
+
+void wifi_ps_policy_stream_state(bool is_running)
+{
+    running = is_running;
+    streaming = is_running;
+    if (is_running) {
+        /* Low latency from the first packet, not after the first report */
+        last_packet_ms = k_uptime_get_32();
+    } else {
+        packets_per_sec = 0;
+    }
+    schedule_apply();
+}
+
+void wifi_ps_policy_traffic(uint32_t packets, uint32_t interval_ms, uint32_t packet_period_us)
+{
+    uint32_t now = k_uptime_get_32();
+    bool was_streaming = streaming;
+    uint32_t old_period = period_us;
+
+    if (packets) {
+        last_packet_ms = now;
+    }
+    streaming = running && now - last_packet_ms < CONFIG_WIFI_PS_IDLE_MS;
+    packets_per_sec = interval_ms ? packets * 1000 / interval_ms : 0;
+    if (packet_period_us) {
+        period_us = packet_period_us;
+    }
+
+    if (streaming != was_streaming || (period_us && !old_period) ||
+        (old_period && period_differs(period_us, old_period))) {
+        schedule_apply();
+    }
+}
+
+void wifi_ps_policy_force(enum wifi_ps_policy_mode mode)
+{
+    forced_mode = mode;
+    forced = true;
+    schedule_apply();
+}
+
+void wifi_ps_policy_auto(void)
+{
+    forced = false;
+    schedule_apply();
+}
+
+void wifi_ps_policy_get_info(struct wifi_ps_policy_info *info)
+{
+    info->forced = forced;
+    info->streaming = streaming;
+    info->mode = applied;
+    info->twt_active = twt_active;
+    info->twt_rejected = twt_rejected;
+    info->twt_interval_us = twt_active ? twt_interval_us : 0;
+    info->packet_period_us = period_us;
+    info->packets_per_sec = packets_per_sec;
+    info->switches = switches;
+    info->errors = errors;
+}
+
+const char *wifi_ps_policy_mode_name(enum wifi_ps_policy_mode mode)
+{
+    switch (mode) {
+    case WIFI_PS_POLICY_SAVE:        return "save";
+    case WIFI_PS_POLICY_LOW_LATENCY: return "low_latency";
+    case WIFI_PS_POLICY_TWT:         return "twt";
+    default:                         return "?";
+    }
+}
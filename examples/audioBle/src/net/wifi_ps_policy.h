@@ -0,0 +1,79 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief WiFi power-save modes the policy switches between
+ */
+enum wifi_ps_policy_mode {
+    WIFI_PS_POLICY_SAVE,         /* Idle: PS on, wake on the listen interval */
+    WIFI_PS_POLICY_LOW_LATENCY,  /* Streaming: PS on, wake every DTIM, long inactivity timeout */
+    WIFI_PS_POLICY_TWT,          /* Streaming: TWT flow, one wake per packet period */
+};
+
+/**
+ * @brief Policy state, for status reporting
+ */
+struct wifi_ps_policy_info {
+    bool forced;                        /* Mode set by wifi_ps_policy_force() */
+    bool streaming;                     /* Receiver running and packets arriving */
+    enum wifi_ps_policy_mode mode;      /* Applied mode */
+    bool twt_active;                    /* AP accepted the TWT flow */
+    bool twt_rejected;                  /* AP refused TWT, low-latency PS until reconnect */
+    uint32_t twt_interval_us;           /* Negotiated wake interval */
+    uint32_t packet_period_us;          /* Lead stream's packet period, 0 until known */
+    uint32_t packets_per_sec;           /* Over the last traffic report */
+    uint32_t switches;                  /* Mode changes applied */
+    uint32_t errors;                    /* Driver requests that failed */
+};
+
+/**
+ * @brief Set the listen interval and apply the idle mode
+ *
+ * Call once at boot, after wifi_mgr_init() and before connecting: the
+ * listen interval is sent at association and cannot change while
+ * connected. The policy runs on the wifi_mgr work queue.
+ * @return 0 on success, negative error code on failure
+ */
+int wifi_ps_policy_init(void);
+
+/**
+ * @brief The RTP receiver started or stopped (any thread)
+ */
+void wifi_ps_policy_stream_state(bool running);
+
+/**
+ * @brief Traffic since the last report, from the receive thread
+ * @param packets RTP packets received
+ * @param interval_ms Time covered
+ * @param packet_period_us Lead stream's packet period, 0 if not known yet
+ */
+void wifi_ps_policy_traffic(uint32_t packets, uint32_t interval_ms, uint32_t packet_period_us);
+
+/**
+ * @brief Pin a mode regardless of the stream state
+ */
+void wifi_ps_policy_force(enum wifi_ps_policy_mode mode);
+
+/**
+ * @brief Let the stream state choose the mode again
+ */
+void wifi_ps_policy_auto(void);
+
+/**
+ * @brief Get the policy state
+ */
+void wifi_ps_policy_get_info(struct wifi_ps_policy_info *info);
+
+/**
+ * @brief Short name of a mode, for status output
+ */
+const char *wifi_ps_policy_mode_name(enum wifi_ps_policy_mode mode);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,37 @@
+#include "boot_metrics.hpp"
+#include <zephyr/kernel.h>
+#include <atomic>
+
+namespace boot_metrics {
+
+namespace {
+
+std::atomic<uint32_t> s_times[kStageCount];
+
+const char* const kNames[kStageCount] = {
+    "main", "shell_ready", "iface_up", "network_ready", "rtp_started", "first_packet",
+};
+
+}  // namespace
+
+bool mark(Stage stage)
+{
+    // 0 means "not reached", so the earliest possible stamp is 1 us
+    uint32_t now = static_cast<uint32_t>(k_ticks_to_us_floor64(k_uptime_ticks()));
+    uint32_t expected = 0;
+
+    return s_times[static_cast<size_t>(stage)].compare_exchange_strong(
+        expected, now ? now : 1, std::memory_order_relaxed);
+}
+
+uint32_t get(Stage stage)
+{
+    return s_times[static_cast<size_t>(stage)].load(std::memory_order_relaxed);
+}
+
+const char* name(Stage stage)
+{
+    return kNames[static_cast<size_t>(stage)];
+}
+
+}  // namespace boot_metrics
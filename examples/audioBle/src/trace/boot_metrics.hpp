@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Boot milestones, in microseconds of uptime
+ *
+ *   Main          main() entered (kernel and drivers initialized)
+ *   ShellReady    RtpReceiver constructed and the shell commands registered
+ *   IfaceUp       WiFi interface administratively up
+ *   NetworkReady  IPv4 address on the interface (first association)
+ *   RtpStarted    RtpReceiver::start() succeeded
+ *   FirstPacket   First RTP datagram received
+ *
+ * Each milestone keeps its first time only, so a reconnect or a second
+ * 'rtp start' does not move it. mark() is one atomic compare-and-swap,
+ * safe from any thread.
+ */
+namespace boot_metrics {
+
+enum class Stage : uint8_t {
+    Main,
+    ShellReady,
+    IfaceUp,
+    NetworkReady,
+    RtpStarted,
+    FirstPacket,
+    Count
+};
+
+static constexpr size_t kStageCount = static_cast<size_t>(Stage::Count);
+
+/**
+ * @brief Record that a milestone was reached
+ * @return true the first time, false if it was already recorded
+ */
+bool mark(Stage stage);
+
+/**
+ * @brief Time a milestone was first reached
+ * @return Microseconds of uptime, 0 if not reached yet
+ */
+uint32_t get(Stage stage);
+
+/**
+ * @brief Short name of a milestone, for status output
+ */
+const char* name(Stage stage);
+
+}  // namespace boot_metrics
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <cstdint>
+#ifdef CONFIG_CPU_CORTEX_M_HAS_DWT
+#include <cmsis_core.h>
+#endif
+
+/**
+ * @brief CPU cycle counter: the DWT CYCCNT when the core has one, else the
+ *        (much coarser) kernel cycle counter
+ *
+ * CYCCNT is per core and wraps after 2^32 cycles (33 s at 128 MHz), so
+ * only differences of nearby stamps from the same core are meaningful.
+ */
+
+/**
+ * @brief Start the counter (idempotent, safe to call from any thread)
+ */
+static inline void cycle_counter_init()
+{
+#ifdef CONFIG_CPU_CORTEX_M_HAS_DWT
+    DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+static inline uint32_t cycle_counter_get()
+{
+#ifdef CONFIG_CPU_CORTEX_M_HAS_DWT
+    return DWT->CYCCNT;
+#else
+    return k_cycle_get_32();
+#endif
+}
+
+/**
+ * @brief Counter rate in Hz
+ */
+static inline uint32_t cycle_counter_hz()
+{
+#ifdef CONFIG_CPU_CORTEX_M_HAS_DWT
+    return SystemCoreClock;
+#else
+    return sys_clock_hw_cycles_per_sec();
+#endif
+}
+
+/**
+ * @brief Convert a difference of two cycle_counter_get() stamps to ns
+ */
+static inline uint32_t cycle_counter_to_ns(uint32_t cycles)
+{
+    return static_cast<uint32_t>(static_cast<uint64_t>(cycles) * 1000000000 / cycle_counter_hz());
+}
+
+/**
+ * @brief True if cycle_counter_get() counts CPU cycles
+ */
+static constexpr bool cycle_counter_is_dwt()
+{
+#ifdef CONFIG_CPU_CORTEX_M_HAS_DWT
+    return true;
+#else
+    return false;
+#endif
+}
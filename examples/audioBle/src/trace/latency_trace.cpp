@@ -0,0 +1,305 @@
+#include "latency_trace.hpp"
+#include "cycle_counter.hpp"
+#include <zephyr/kernel.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+// Defaults for builds without Kconfig (host tools); see audioBle/Kconfig
+#ifndef CONFIG_AUDIO_LATENCY_TRACE_RECORDS
+#define CONFIG_AUDIO_LATENCY_TRACE_RECORDS 1024
+#endif
+#ifndef CONFIG_MP_MAX_NUM_CPUS
+#define CONFIG_MP_MAX_NUM_CPUS 1
+#endif
+
+namespace latency_trace {
+
+namespace {
+
+constexpr size_t kRecords = CONFIG_AUDIO_LATENCY_TRACE_RECORDS;
+static_assert(kRecords >= 64 && (kRecords & (kRecords - 1)) == 0,
+              "Trace ring size must be a power of two");
+
+struct Ring {
+    std::atomic<uint32_t> head{0};  // Records written, free-running
+    Record records[kRecords];
+};
+
+Ring s_rings[CONFIG_MP_MAX_NUM_CPUS];
+std::atomic<bool> s_enabled{false};
+
+// analyze() scratch: packets not yet seen at the sink, and stage samples
+constexpr size_t kOpenSlots = 64;
+constexpr size_t kMaxSamples = kRecords * CONFIG_MP_MAX_NUM_CPUS / kPointCount + 1;
+constexpr uint8_t kAllPoints = (1u << kPointCount) - 1;
+
+struct OpenPacket {
+    uint32_t cycles[kPointCount];
+    uint16_t sequence;
+    uint8_t stream;
+    uint8_t seen;  // Bit per point
+    bool used;
+};
+
+OpenPacket s_open[kOpenSlots];
+size_t s_open_next;
+uint32_t s_samples[kStageCount][kMaxSamples];
+uint32_t s_sample_count[kStageCount];
+
+inline Ring& currentRing()
+{
+#if CONFIG_MP_MAX_NUM_CPUS > 1
+    return s_rings[arch_curr_cpu()->id];
+#else
+    return s_rings[0];
+#endif
+}
+
+// Pause tracing for a reader, restore the previous state afterwards
+class Pause {
+public:
+    Pause() : m_was_enabled(s_enabled.exchange(false, std::memory_order_acq_rel)) {}
+    ~Pause() { s_enabled.store(m_was_enabled, std::memory_order_release); }
+
+private:
+    bool m_was_enabled;
+};
+
+template <typename Fn>
+void walk(Fn fn)
+{
+    for (unsigned cpu = 0; cpu < CONFIG_MP_MAX_NUM_CPUS; cpu++) {
+        const Ring& ring = s_rings[cpu];
+        uint32_t head = ring.head.load(std::memory_order_acquire);
+        uint32_t first = head > kRecords ? head - kRecords : 0;
+        for (uint32_t i = first; i != head; i++) {
+            fn(cpu, ring.records[i & (kRecords - 1)]);
+        }
+    }
+}
+
+uint32_t cyclesToNs(uint32_t cycles)
+{
+    return static_cast<uint32_t>(static_cast<uint64_t>(cycles) * 1000000000 / cycle_counter_hz());
+}
+
+size_t bucketOf(uint32_t ns)
+{
+    uint32_t us = ns / 1000;
+    size_t bucket = 0;
+    while (us != 0 && bucket < kBuckets - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void addSample(Stage stage, uint32_t cycles)
+{
+    size_t s = static_cast<size_t>(stage);
+    if (s_sample_count[s] < kMaxSamples) {
+        s_samples[s][s_sample_count[s]++] = cyclesToNs(cycles);
+    }
+}
+
+void completePacket(const OpenPacket& pkt)
+{
+    const uint32_t* t = pkt.cycles;
+    for (size_t stage = 0; stage < static_cast<size_t>(Stage::Total); stage++) {
+        // Stage n runs from point n to point n + 1
+        addSample(static_cast<Stage>(stage), t[stage + 1] - t[stage]);
+    }
+    addSample(Stage::Total, t[static_cast<size_t>(Point::SinkHandoff)] -
+                            t[static_cast<size_t>(Point::RxDone)]);
+}
+
+OpenPacket* findOpen(uint8_t stream, uint16_t sequence)
+{
+    for (OpenPacket& pkt : s_open) {
+        if (pkt.used && pkt.stream == stream && pkt.sequence == sequence) {
+            return &pkt;
+        }
+    }
+    return nullptr;
+}
+
+void matchRecord(const Record& rec, Report* out)
+{
+    Point point = static_cast<Point>(rec.point);
+    if (point >= Point::Count) {
+        return;
+    }
+
+    OpenPacket* pkt = findOpen(rec.stream, rec.sequence);
+    bool stored = pkt && (pkt->seen & (1u << static_cast<size_t>(Point::JbEnqueue)));
+
+    if (point == Point::RxDone || point == Point::ParseDone) {
+        if (stored) {
+            // Duplicate of a buffered packet: keep the original's stamps
+            return;
+        }
+        if (!pkt && point == Point::RxDone) {
+            // Oldest slot goes to the new packet; it never reached the sink
+            pkt = &s_open[s_open_next];
+            s_open_next = (s_open_next + 1) % kOpenSlots;
+            if (pkt->used) {
+                out->partial++;
+            }
+            pkt->used = true;
+            pkt->stream = rec.stream;
+            pkt->sequence = rec.sequence;
+            pkt->seen = 0;
+        }
+    }
+    if (!pkt) {
+        // Its earlier points were overwritten in the ring
+        return;
+    }
+
+    pkt->cycles[rec.point] = rec.cycles;
+    pkt->seen |= 1u << rec.point;
+
+    if (point == Point::SinkHandoff) {
+        if (pkt->seen == kAllPoints) {
+            completePacket(*pkt);
+            out->packets++;
+        } else {
+            out->partial++;
+        }
+        pkt->used = false;
+    }
+}
+
+void summarize(Stage stage, StageStats* out)
+{
+    size_t s = static_cast<size_t>(stage);
+    uint32_t* samples = s_samples[s];
+    size_t n = s_sample_count[s];
+
+    memset(out, 0, sizeof(*out));
+    out->count = n;
+    if (n == 0) {
+        return;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        out->buckets[bucketOf(samples[i])]++;
+    }
+
+    std::sort(samples, samples + n);
+    out->p50_ns = samples[(n - 1) * 50 / 100];
+    out->p99_ns = samples[(n - 1) * 99 / 100];
+    out->max_ns = samples[n - 1];
+}
+
+}  // namespace
+
+void init()
+{
+    cycle_counter_init();
+    clear();
+    setEnabled(true);
+}
+
+void setEnabled(bool enabled)
+{
+    s_enabled.store(enabled, std::memory_order_release);
+}
+
+bool isEnabled()
+{
+    return s_enabled.load(std::memory_order_relaxed);
+}
+
+void clear()
+{
+    Pause pause;
+    for (Ring& ring : s_rings) {
+        ring.head.store(0, std::memory_order_release);
+    }
+}
+
+uint32_t now()
+{
+    return cycle_counter_get();
+}
+
+uint32_t cyclesPerSec()
+{
+    return cycle_counter_hz();
+}
+
+void record(Point point, uint8_t stream, uint16_t sequence)
+{
+    recordAt(point, stream, sequence, cycle_counter_get());
+}
+
+void recordAt(Point point, uint8_t stream, uint16_t sequence, uint32_t cycles)
+{
+    if (!s_enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    // One atomic increment claims the slot; preempting writers get their own
+    Ring& ring = currentRing();
+    uint32_t slot = ring.head.fetch_add(1, std::memory_order_relaxed);
+    Record& rec = ring.records[slot & (kRecords - 1)];
+    rec.cycles = cycles;
+    rec.sequence = sequence;
+    rec.stream = stream;
+    rec.point = static_cast<uint8_t>(point);
+}
+
+void analyze(Report* out)
+{
+    Pause pause;
+
+    memset(out, 0, sizeof(*out));
+    memset(s_open, 0, sizeof(s_open));
+    memset(s_sample_count, 0, sizeof(s_sample_count));
+    s_open_next = 0;
+
+    walk([out](unsigned, const Record& rec) {
+        out->records++;
+        matchRecord(rec, out);
+    });
+
+    for (size_t stage = 0; stage < kStageCount; stage++) {
+        summarize(static_cast<Stage>(stage), &out->stages[stage]);
+    }
+}
+
+void forEach(void (*fn)(unsigned cpu, const Record& rec, void* ctx), void* ctx)
+{
+    Pause pause;
+    walk([fn, ctx](unsigned cpu, const Record& rec) { fn(cpu, rec, ctx); });
+}
+
+const char* pointName(Point point)
+{
+    switch (point) {
+    case Point::RxDone:      return "rx";
+    case Point::ParseDone:   return "parse";
+    case Point::JbEnqueue:   return "jb_in";
+    case Point::JbDequeue:   return "jb_out";
+    case Point::Decode:      return "decode";
+    case Point::SinkHandoff: return "sink";
+    default:                 return "?";
+    }
+}
+
+const char* stageName(Stage stage)
+{
+    switch (stage) {
+    case Stage::Parse:   return "parse";
+    case Stage::Enqueue: return "enqueue";
+    case Stage::Jitter:  return "jitter buf";
+    case Stage::Decode:  return "decode";
+    case Stage::Sink:    return "sink";
+    case Stage::Total:   return "total";
+    default:             return "?";
+    }
+}
+
+}  // namespace latency_trace
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Cycle-accurate packet latency tracing through the receive pipeline
+ *
+ * Tracepoints stamp a packet (stream index + RTP sequence number) with the
+ * cycle counter at each stage:
+ *
+ *   RxDone      recvfrom() returned the datagram
+ *   ParseDone   RTP header parsed and the stream found
+ *   JbEnqueue   frame stored in the jitter buffer
+ *   JbDequeue   frame taken out at its playout tick
+ *   Decode      L16 converted and handed to PLC and the resampler
+ *   SinkHandoff resampled audio written to the PCM ring (or mix ring)
+ *
+ * Records go to a fixed ring per CPU; the oldest are overwritten. Writers
+ * never block or lock: a slot is claimed with one atomic increment. The
+ * readers (analyze(), forEach()) pause tracing while they walk the rings.
+ *
+ * With CONFIG_AUDIO_LATENCY_TRACE off the LAT_TRACE* macros expand to
+ * nothing (their arguments are not evaluated) and this module is not built.
+ */
+namespace latency_trace {
+
+enum class Point : uint8_t {
+    RxDone,
+    ParseDone,
+    JbEnqueue,
+    JbDequeue,
+    Decode,
+    SinkHandoff,
+    Count
+};
+
+/**
+ * @brief Stage between two consecutive points, plus end to end
+ */
+enum class Stage : uint8_t {
+    Parse,    // RxDone -> ParseDone
+    Enqueue,  // ParseDone -> JbEnqueue
+    Jitter,   // JbEnqueue -> JbDequeue
+    Decode,   // JbDequeue -> Decode
+    Sink,     // Decode -> SinkHandoff
+    Total,    // RxDone -> SinkHandoff
+    Count
+};
+
+static constexpr size_t kPointCount = static_cast<size_t>(Point::Count);
+static constexpr size_t kStageCount = static_cast<size_t>(Stage::Count);
+static constexpr size_t kBuckets = 20;  // log2 microsecond buckets, last is open-ended
+
+struct Record {
+    uint32_t cycles;
+    uint16_t sequence;
+    uint8_t stream;
+    uint8_t point;
+};
+
+struct StageStats {
+    uint32_t count;
+    uint32_t p50_ns;
+    uint32_t p99_ns;
+    uint32_t max_ns;
+    uint32_t buckets[kBuckets];  // [0]: < 1 us, [k]: [2^(k-1), 2^k) us
+};
+
+struct Report {
+    uint32_t records;   // Records examined
+    uint32_t packets;   // Packets seen at every point
+    uint32_t partial;   // Packets missing a point (lost, dropped, overwritten)
+    StageStats stages[kStageCount];
+};
+
+/**
+ * @brief Start the cycle counter and enable tracing
+ */
+void init();
+
+void setEnabled(bool enabled);
+bool isEnabled();
+
+/**
+ * @brief Drop all records (tracing keeps its enabled state)
+ */
+void clear();
+
+/**
+ * @brief Current cycle count, for stamps taken before the sequence is known
+ */
+uint32_t now();
+
+/**
+ * @brief Counter rate, for converting cycles to time
+ */
+uint32_t cyclesPerSec();
+
+/**
+ * @brief Record a point now
+ */
+void record(Point point, uint8_t stream, uint16_t sequence);
+
+/**
+ * @brief Record a point with an earlier stamp from now()
+ */
+void recordAt(Point point, uint8_t stream, uint16_t sequence, uint32_t cycles);
+
+/**
+ * @brief Match records into packets and compute per-stage percentiles
+ *
+ * Pauses tracing while it runs. Not reentrant (static scratch buffers).
+ */
+void analyze(Report* out);
+
+/**
+ * @brief Visit every record, oldest first per CPU (pauses tracing)
+ */
+void forEach(void (*fn)(unsigned cpu, const Record& rec, void* ctx), void* ctx);
+
+/**
+ * @brief Short name of a point or stage, for dumps
+ */
+const char* pointName(Point point);
+const char* stageName(Stage stage);
+
+}  // namespace latency_trace
+
+#ifdef CONFIG_AUDIO_LATENCY_TRACE
+#define LAT_TRACE(point, stream, seq) \
+    latency_trace::record(latency_trace::Point::point, (stream), (seq))
+#define LAT_TRACE_AT(point, stream, seq, cycles) \
+    latency_trace::recordAt(latency_trace::Point::point, (stream), (seq), (cycles))
+#define LAT_TRACE_STAMP(var) ((var) = latency_trace::now())
+#else
+#define LAT_TRACE(point, stream, seq) ((void)0)
+#define LAT_TRACE_AT(point, stream, seq, cycles) ((void)0)
+#define LAT_TRACE_STAMP(var) ((void)0)
+#endif
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <cstdint>
+
+// Defaults for builds without Kconfig (host tools); see audioBle/Kconfig
+#ifndef CONFIG_AUDIO_LOG_THROTTLE_MS
+#define CONFIG_AUDIO_LOG_THROTTLE_MS 1000
+#endif
+
+/**
+ * @brief Per-call-site state of a throttled log message
+ */
+struct LogThrottle {
+    uint32_t last_ms;
+    uint32_t suppressed;
+    bool started;
+};
+
+/**
+ * @brief Decide whether a throttled message may be logged now
+ * @param state Call site state
+ * @param suppressed Output: messages dropped since the last one logged
+ * @return true at most once per CONFIG_AUDIO_LOG_THROTTLE_MS
+ */
+static inline bool log_throttle_pass(LogThrottle* state, uint32_t* suppressed)
+{
+    uint32_t now = k_uptime_get_32();
+    if (state->started && now - state->last_ms < CONFIG_AUDIO_LOG_THROTTLE_MS) {
+        state->suppressed++;
+        return false;
+    }
+
+    *suppressed = state->suppressed;
+    state->suppressed = 0;
+    state->last_ms = now;
+    state->started = true;
+    return true;
+}
+
+/*
+ * LOG_*_THROTTLED(fmt, ...) for messages the packet path can emit per packet
+ * or per frame (errors that repeat while a condition lasts). Each call site
+ * logs at most once per CONFIG_AUDIO_LOG_THROTTLE_MS; the next message that
+ * gets through carries the number suppressed in between. The format stays a
+ * string literal, so it works with dictionary logging.
+ */
+#define LOG_THROTTLED_IMPL(log_macro, fmt, ...)                                     \
+    do {                                                                            \
+        static LogThrottle _log_throttle;                                           \
+        uint32_t _log_suppressed;                                                   \
+        if (log_throttle_pass(&_log_throttle, &_log_suppressed)) {                  \
+            if (_log_suppressed) {                                                  \
+                log_macro(fmt " (+%u suppressed)", ##__VA_ARGS__, _log_suppressed); \
+            } else {                                                                \
+                log_macro(fmt, ##__VA_ARGS__);                                      \
+            }                                                                       \
+        }                                                                           \
+    } while (0)
+
+#define LOG_ERR_THROTTLED(fmt, ...) LOG_THROTTLED_IMPL(LOG_ERR, fmt, ##__VA_ARGS__)
+#define LOG_WRN_THROTTLED(fmt, ...) LOG_THROTTLED_IMPL(LOG_WRN, fmt, ##__VA_ARGS__)
+#define LOG_INF_THROTTLED(fmt, ...) LOG_THROTTLED_IMPL(LOG_INF, fmt, ##__VA_ARGS__)
+#define LOG_DBG_THROTTLED(fmt, ...) LOG_THROTTLED_IMPL(LOG_DBG, fmt, ##__VA_ARGS__)
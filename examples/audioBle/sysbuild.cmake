@@ -0,0 +1,20 @@
+if(SB_CONFIG_NET_CORE_IMAGE_HCI_IPC)
+	# LE Audio broadcast: build the repo's hci_ipc with the BIS controller
+	# (LL_SW_SPLIT, ISO broadcaster) for the network core
+
+	set(NET_APP hci_ipc)
+	set(NET_APP_SRC_DIR ${APP_DIR}/../${NET_APP})
+
+	ExternalZephyrProject_Add(
+		APPLICATION ${NET_APP}
+		SOURCE_DIR  ${NET_APP_SRC_DIR}
+		BOARD       ${SB_CONFIG_NET_CORE_BOARD}
+	)
+
+	set(${NET_APP}_CONF_FILE
+	 ${NET_APP_SRC_DIR}/nrf5340_cpunet_bis-bt_ll_sw_split.conf
+	 CACHE INTERNAL ""
+	)
+
+	set(${NET_APP}_SNIPPET bt-ll-sw-split CACHE INTERNAL "")
+endif()
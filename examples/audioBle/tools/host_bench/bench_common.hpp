@@ -0,0 +1,31 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+// Keeps results alive so the compiler cannot drop the measured work
+extern volatile uint32_t g_bench_sink;
+
+/**
+ * @brief Run fn(i) for iterations and print the average time per call
+ * @return Nanoseconds per call
+ */
+template <typename Fn>
+double bench_run(const char* name, uint32_t iterations, Fn fn)
+{
+    // Warm caches and branch predictors first
+    for (uint32_t i = 0; i < iterations / 10; i++) {
+        fn(i);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++) {
+        fn(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+    printf("%-32s %8.2f ns/op\n", name, ns);
+    return ns;
+}
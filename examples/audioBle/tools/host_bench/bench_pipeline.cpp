@@ -0,0 +1,696 @@
+// Replays RTP traffic through the receive pipeline: RtpParser, RtpStream
+// (jitter buffer, clock recovery, PLC, resampler) and the PCM ring, with
+// a consumer pulling 10 ms blocks like the LE Audio encoder. Input is a
+// pcap capture or generated traffic with loss, jitter, reordering,
+// bursts and clock drift.
+//
+// The pipeline runs in virtual time (zephyr_shim/zephyr/kernel.h), so its
+// audio results are the same on every run; only the per-stage wall times
+// depend on the host. Reports packets/s, per-stage latency percentiles,
+// heap use during the run and the stack high-water mark, as text and
+// optionally as JSON. Exits non-zero if the run allocated from the heap,
+// leaked pool blocks or exceeded --budget-ns.
+
+#include "bench_common.hpp"
+#include "packet_source.hpp"
+#include "audio/pcm_ring.hpp"
+#include "net/packet_pool.hpp"
+#include "net/rtp_parser.hpp"
+#include "net/rtp_stream.hpp"
+#include "trace/cycle_counter.hpp"
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <pthread.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+volatile uint32_t g_bench_sink;
+
+#define BENCH_STREAMS 4        // CONFIG_RTP_MAX_STREAMS upper limit
+// RTP_PACKET_POOL_SIZE rule: every jitter buffer full plus one batch of 4
+#define BENCH_POOL_BLOCKS (BENCH_STREAMS * CONFIG_RTP_JITTER_BUFFER_MAX_DEPTH + 4 + 1)
+#define BENCH_STACK_SIZE (256 * 1024)
+#define BENCH_STACK_PAINT 0xAA
+#define BENCH_CONSUMER_SAMPLES (CONFIG_RTP_CLOCK_RATE / 100)  // 10 ms blocks
+#define BENCH_TAIL_US 2000000  // Upper limit for draining the jitter buffers at the end
+
+// --- Heap accounting: every operator new while the pipeline runs ---
+
+static std::atomic<bool> g_heap_tracking;
+static std::atomic<uint32_t> g_heap_allocs;
+static std::atomic<uint64_t> g_heap_bytes;
+
+void* operator new(size_t size)
+{
+    if (g_heap_tracking.load(std::memory_order_relaxed)) {
+        g_heap_allocs.fetch_add(1, std::memory_order_relaxed);
+        g_heap_bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+    void* p = malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    try {
+        return operator new(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    free(p);
+}
+
+// --- Pipeline ---
+
+// Datagrams are copied into these blocks like recvfrom() does on target
+alignas(8) static uint8_t g_pool_storage[BENCH_POOL_BLOCKS * sizeof(PacketBuf)];
+static struct k_mem_slab g_pool_slab;
+
+// Constructed in place, like the receiver's streams in static storage
+alignas(RtpStream) static uint8_t g_stream_storage[BENCH_STREAMS][sizeof(RtpStream)];
+
+// The pipeline thread runs on this stack, painted to find its high-water mark
+alignas(64) static uint8_t g_stack[BENCH_STACK_SIZE];
+static uintptr_t g_stack_top;
+
+static AudioPcmRing g_pcm;
+
+static inline uint64_t wall_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Wall time of every call of one pipeline stage
+ */
+struct Stage {
+    const char* name;
+    std::vector<uint32_t> ns;  // Reserved before the run, extra calls only counted
+    uint64_t total_ns = 0;
+    uint32_t count = 0;
+
+    void add(uint64_t t)
+    {
+        total_ns += t;
+        count++;
+        if (ns.size() < ns.capacity()) {
+            ns.push_back(static_cast<uint32_t>(t));
+        }
+    }
+};
+
+enum { kStageParse, kStageEnqueue, kStagePlayout, kStageSink, kStageCount };
+
+struct Counters {
+    uint32_t input = 0;
+    uint32_t parsed = 0;
+    uint32_t parse_errors = 0;
+    uint32_t filtered = 0;
+    uint32_t rtcp = 0;
+    uint32_t pool_exhausted = 0;
+    uint32_t consumer_blocks = 0;
+};
+
+struct Bench {
+    const PacketSource& source;
+    PacketPool pool{&g_pool_slab};
+    RtpParser parser;
+    RtpStream* streams[BENCH_STREAMS];
+    Stage stages[kStageCount] = {{"parse", {}}, {"enqueue", {}}, {"playout", {}}, {"sink", {}}};
+    Counters counters;
+    uint64_t media_us = 0;
+    uint64_t wall_total_ns = 0;
+
+    explicit Bench(const PacketSource& src) : source(src)
+    {
+        for (size_t i = 0; i < BENCH_STREAMS; i++) {
+            streams[i] = new (g_stream_storage[i])
+                RtpStream(pool, HOST_CYCLES_PER_SEC, static_cast<uint8_t>(i));
+            streams[i]->configure(0, 0);
+            streams[i]->start(0, 0x0BE1CAFE);
+        }
+
+        size_t packets = source.packets().size();
+        stages[kStageParse].ns.reserve(packets);
+        stages[kStageEnqueue].ns.reserve(packets);
+        stages[kStagePlayout].ns.reserve(packets * 2 + 1024);
+        stages[kStageSink].ns.reserve(packets * 2 + 1024);
+    }
+
+    RtpStream* findStream(uint32_t ssrc)
+    {
+        for (RtpStream* s : streams) {
+            if (s->isBound() && s->boundSsrc() == ssrc) {
+                return s;
+            }
+        }
+        for (RtpStream* s : streams) {
+            if (!s->isBound()) {
+                s->bind(ssrc);
+                return s;
+            }
+        }
+        return nullptr;
+    }
+
+    // Same as RtpReceiver::drainInto()
+    static void drainInto(RtpStream& stream, AudioPcmRing& ring)
+    {
+        int16_t* span;
+        while (true) {
+            size_t n = ring.writeSpan(&span);
+            if (n == 0) {
+                ring.noteOverrun(stream.drain(nullptr, SIZE_MAX));
+                return;
+            }
+            size_t produced = stream.drain(span, n);
+            ring.commitWrite(produced);
+            if (produced < n) {
+                return;
+            }
+        }
+    }
+
+    void receive(const SourcePacket& src, uint32_t now_us)
+    {
+        counters.input++;
+        const uint8_t* data = source.data(src);
+        if (src.length >= 2 && data[1] >= 200 && data[1] <= 204) {
+            // RTCP multiplexed on the RTP port (RFC 5761)
+            counters.rtcp++;
+            return;
+        }
+
+        PacketBuf* buf = pool.alloc();
+        if (!buf) {
+            counters.pool_exhausted++;
+            return;
+        }
+        buf->length = std::min<size_t>(src.length, sizeof(buf->data));
+        memcpy(buf->data, data, buf->length);
+        buf->arrival_us = now_us;
+        buf->arrival_cyc = k_cycle_get_32();
+
+        RtpPacket pkt;
+        uint32_t start_cyc = cycle_counter_get();
+        uint64_t t0 = wall_ns();
+        int ret = parser.parse(buf->data, buf->length, &pkt);
+        uint64_t t1 = wall_ns();
+        stages[kStageParse].add(t1 - t0);
+        if (ret != 0) {
+            if (ret == -ENOMSG) {
+                counters.filtered++;
+            } else {
+                counters.parse_errors++;
+            }
+            pool.free(buf);
+            return;
+        }
+
+        RtpStream* stream = findStream(pkt.ssrc);
+        if (!stream) {
+            counters.filtered++;
+            pool.free(buf);
+            return;
+        }
+        counters.parsed++;
+
+        t0 = wall_ns();
+        stream->onPacket(pkt, buf, start_cyc);
+        stages[kStageEnqueue].add(wall_ns() - t0);
+    }
+
+    void playout(uint32_t now_us)
+    {
+        for (size_t i = 0; i < BENCH_STREAMS; i++) {
+            RtpStream& stream = *streams[i];
+            while (stream.playoutDue(now_us)) {
+                uint64_t t0 = wall_ns();
+                stream.playoutTick();
+                uint64_t t1 = wall_ns();
+                // Stream 0 is heard, the others are resampled and discarded
+                if (i == 0) {
+                    drainInto(stream, g_pcm);
+                } else {
+                    stream.drain(nullptr, SIZE_MAX);
+                }
+                uint64_t t2 = wall_ns();
+                stages[kStagePlayout].add(t1 - t0);
+                stages[kStageSink].add(t2 - t1);
+            }
+        }
+    }
+
+    // True once every received frame has been played out
+    bool drained() const
+    {
+        for (RtpStream* s : streams) {
+            if (s->isPlaying() && s->getJitterBuffer().depth() != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Next playout deadline of any stream, or UINT64_MAX
+    uint64_t nextPlayout(uint64_t now) const
+    {
+        uint64_t next = UINT64_MAX;
+        for (RtpStream* s : streams) {
+            if (s->isPlaying()) {
+                int32_t delta = static_cast<int32_t>(s->nextPlayoutUs() - static_cast<uint32_t>(now));
+                next = std::min(next, now + std::max(delta, 0));
+            }
+        }
+        return next;
+    }
+
+    void run()
+    {
+        static int16_t block[BENCH_CONSUMER_SAMPLES];
+        const uint64_t block_us = BENCH_CONSUMER_SAMPLES * 1000000ull / CONFIG_RTP_CLOCK_RATE;
+        const std::vector<SourcePacket>& packets = source.packets();
+        const uint64_t end_us = packets.back().arrival_us + BENCH_TAIL_US;
+        uint64_t consumer_us = UINT64_MAX;  // Starts once two blocks are buffered
+        size_t next = 0;
+        uint64_t now = 0;
+
+        uint64_t start = wall_ns();
+        g_heap_tracking.store(true);
+
+        while (now < end_us) {
+            uint64_t t = std::min({next < packets.size() ? packets[next].arrival_us : UINT64_MAX,
+                                   consumer_us, nextPlayout(now), end_us});
+            now = std::max(now, t);
+            host_set_time_us(now);
+            uint32_t now_us = static_cast<uint32_t>(now);
+
+            // Everything that arrived together is one batch, like one poll() wakeup
+            bool batch = false;
+            while (next < packets.size() && packets[next].arrival_us <= now) {
+                receive(packets[next++], now_us);
+                batch = true;
+            }
+            if (batch) {
+                for (RtpStream* s : streams) {
+                    s->onBatchDone();
+                }
+            }
+
+            playout(now_us);
+            if (next == packets.size() && drained()) {
+                break;
+            }
+
+            if (consumer_us == UINT64_MAX && g_pcm.fillLevel() >= 2 * BENCH_CONSUMER_SAMPLES) {
+                consumer_us = now;
+            }
+            while (consumer_us <= now) {
+                g_pcm.read(block, BENCH_CONSUMER_SAMPLES);
+                g_bench_sink = g_bench_sink + static_cast<uint16_t>(block[0]);
+                counters.consumer_blocks++;
+                consumer_us += block_us;
+            }
+        }
+
+        g_heap_tracking.store(false);
+        wall_total_ns = wall_ns() - start;
+        media_us = now;
+    }
+};
+
+static void* pipeline_thread(void* arg)
+{
+    g_stack_top = reinterpret_cast<uintptr_t>(__builtin_frame_address(0));
+    static_cast<Bench*>(arg)->run();
+    return nullptr;
+}
+
+// Bytes between the pipeline entry frame and the deepest overwritten paint
+static size_t stack_used()
+{
+    size_t untouched = 0;
+    while (untouched < sizeof(g_stack) && g_stack[untouched] == BENCH_STACK_PAINT) {
+        untouched++;
+    }
+    return g_stack_top - reinterpret_cast<uintptr_t>(g_stack + untouched);
+}
+
+static int run_on_painted_stack(Bench* bench)
+{
+    pthread_attr_t attr;
+    pthread_t thread;
+
+    memset(g_stack, BENCH_STACK_PAINT, sizeof(g_stack));
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, g_stack, sizeof(g_stack));
+    int ret = pthread_create(&thread, &attr, pipeline_thread, bench);
+    pthread_attr_destroy(&attr);
+    if (ret != 0) {
+        fprintf(stderr, "pthread_create: %s\n", strerror(ret));
+        return -ret;
+    }
+    pthread_join(thread, nullptr);
+    return 0;
+}
+
+// --- Reporting ---
+
+struct Percentiles {
+    uint32_t count;
+    double mean;
+    uint32_t p50, p90, p99, p999, max;
+};
+
+static Percentiles percentiles(const Stage& stage)
+{
+    Percentiles p = {};
+    std::vector<uint32_t> v = stage.ns;
+    if (v.empty()) {
+        return p;
+    }
+    std::sort(v.begin(), v.end());
+    auto at = [&v](double q) { return v[std::min(v.size() - 1, static_cast<size_t>(v.size() * q))]; };
+    p.count = stage.count;
+    p.mean = static_cast<double>(stage.total_ns) / stage.count;
+    p.p50 = at(0.5);
+    p.p90 = at(0.9);
+    p.p99 = at(0.99);
+    p.p999 = at(0.999);
+    p.max = v.back();
+    return p;
+}
+
+struct Results {
+    uint64_t pipeline_ns;
+    double ns_per_packet;
+    double packets_per_s;
+    double realtime_factor;
+    Percentiles stages[kStageCount];
+    uint32_t pool_leaked;
+    size_t stack_used;
+    size_t static_bytes;
+};
+
+static void print_text(const Bench& b, const Results& r)
+{
+    printf("Pipeline: %u packets in, %u parsed, %.1f s of media\n", b.counters.input,
+           b.counters.parsed, b.media_us / 1e6);
+    printf("%-32s %8.2f ns/packet, %.0f packets/s, %.0fx real time\n", "hot path",
+           r.ns_per_packet, r.packets_per_s, r.realtime_factor);
+    printf("%-10s %8s %8s %8s %8s %8s %8s %8s\n", "stage [ns]", "calls", "mean", "p50", "p90",
+           "p99", "p99.9", "max");
+    for (size_t i = 0; i < kStageCount; i++) {
+        const Percentiles& p = r.stages[i];
+        printf("%-10s %8u %8.1f %8u %8u %8u %8u %8u\n", b.stages[i].name, p.count, p.mean, p.p50,
+               p.p90, p.p99, p.p999, p.max);
+    }
+
+    for (size_t i = 0; i < BENCH_STREAMS; i++) {
+        const RtpStream& s = *b.streams[i];
+        if (!s.isBound()) {
+            continue;
+        }
+        RtpStats::Snapshot st;
+        s.getStats().snapshot(&st);
+        printf("Stream %zu (SSRC 0x%08x): received %u, lost %u, reordered %u, duplicates %u, late %u\n",
+               i, s.boundSsrc(), st.received, st.lost, st.reordered, st.duplicates, st.late);
+        printf("  jitter %u us, PLC %u frames, JB delay avg %u / max %u us, depth max %u, "
+               "target %u, underruns %u, drops %u, drift %d ppb%s\n",
+               st.jitter_us, st.plc_frames, st.jb_delay_avg_us, st.jb_delay_max_us,
+               st.jb_max_depth, st.jb_target, st.jb_underruns, st.jb_drops, st.clock_drift_ppb,
+               st.clock_locked ? " (locked)" : "");
+    }
+    printf("PCM ring: high %u, low %u, overruns %u, underruns %u (%u samples)\n",
+           g_pcm.highWater(), g_pcm.lowWater(), g_pcm.overruns(), g_pcm.underruns(),
+           g_pcm.missingSamples());
+    printf("Memory: pool high-water %u/%u, leaked %u, pool exhausted %u, heap %u allocs "
+           "(%llu bytes), stack %zu bytes, static %zu bytes\n",
+           b.pool.highWater(), b.pool.capacity(), r.pool_leaked, b.counters.pool_exhausted,
+           g_heap_allocs.load(), static_cast<unsigned long long>(g_heap_bytes.load()),
+           r.stack_used, r.static_bytes);
+}
+
+static void write_json(FILE* f, const char* source, const Bench& b, const Results& r)
+{
+    const Counters& c = b.counters;
+
+    fprintf(f, "{\n  \"source\": \"");
+    for (const char* p = source; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            fputc('\\', f);
+        }
+        fputc(*p, f);
+    }
+    fprintf(f, "\",\n");
+    fprintf(f, "  \"media_s\": %.3f,\n  \"wall_s\": %.6f,\n", b.media_us / 1e6, b.wall_total_ns / 1e9);
+    fprintf(f, "  \"packets\": {\"input\": %u, \"parsed\": %u, \"parse_errors\": %u, "
+               "\"filtered\": %u, \"rtcp\": %u, \"pool_exhausted\": %u},\n",
+            c.input, c.parsed, c.parse_errors, c.filtered, c.rtcp, c.pool_exhausted);
+    fprintf(f, "  \"throughput\": {\"ns_per_packet\": %.2f, \"packets_per_s\": %.0f, "
+               "\"realtime_factor\": %.1f},\n",
+            r.ns_per_packet, r.packets_per_s, r.realtime_factor);
+
+    fprintf(f, "  \"stages_ns\": {\n");
+    for (size_t i = 0; i < kStageCount; i++) {
+        const Percentiles& p = r.stages[i];
+        fprintf(f, "    \"%s\": {\"count\": %u, \"mean\": %.1f, \"p50\": %u, \"p90\": %u, "
+                   "\"p99\": %u, \"p999\": %u, \"max\": %u}%s\n",
+                b.stages[i].name, p.count, p.mean, p.p50, p.p90, p.p99, p.p999, p.max,
+                i + 1 < kStageCount ? "," : "");
+    }
+    fprintf(f, "  },\n");
+
+    fprintf(f, "  \"streams\": [");
+    bool first = true;
+    for (size_t i = 0; i < BENCH_STREAMS; i++) {
+        const RtpStream& s = *b.streams[i];
+        if (!s.isBound()) {
+            continue;
+        }
+        RtpStats::Snapshot st;
+        s.getStats().snapshot(&st);
+        fprintf(f, "%s\n    {\"index\": %zu, \"ssrc\": \"0x%08x\", \"received\": %u, \"lost\": %u, "
+                   "\"reordered\": %u, \"duplicates\": %u, \"late\": %u, \"jitter_us\": %u, "
+                   "\"plc_frames\": %u, \"jb_delay_avg_us\": %u, \"jb_delay_max_us\": %u, "
+                   "\"jb_max_depth\": %u, \"jb_target\": %u, \"jb_underruns\": %u, "
+                   "\"jb_drops\": %u, \"clock_drift_ppb\": %d, \"clock_locked\": %s}",
+                first ? "" : ",", i, s.boundSsrc(), st.received, st.lost, st.reordered,
+                st.duplicates, st.late, st.jitter_us, st.plc_frames, st.jb_delay_avg_us,
+                st.jb_delay_max_us, st.jb_max_depth, st.jb_target, st.jb_underruns, st.jb_drops,
+                st.clock_drift_ppb, st.clock_locked ? "true" : "false");
+        first = false;
+    }
+    fprintf(f, "\n  ],\n");
+
+    fprintf(f, "  \"pcm_ring\": {\"capacity\": %zu, \"high_water\": %u, \"low_water\": %u, "
+               "\"overruns\": %u, \"underruns\": %u, \"missing_samples\": %u, "
+               "\"consumer_blocks\": %u},\n",
+            AudioPcmRing::capacity(), g_pcm.highWater(), g_pcm.lowWater(), g_pcm.overruns(),
+            g_pcm.underruns(), g_pcm.missingSamples(), c.consumer_blocks);
+    fprintf(f, "  \"memory\": {\"pool_blocks\": %u, \"pool_high_water\": %u, \"pool_leaked\": %u, "
+               "\"heap_allocs\": %u, \"heap_bytes\": %llu, \"stack_used_bytes\": %zu, "
+               "\"stack_size_bytes\": %zu, \"static_bytes\": %zu},\n",
+            b.pool.capacity(), b.pool.highWater(), r.pool_leaked, g_heap_allocs.load(),
+            static_cast<unsigned long long>(g_heap_bytes.load()), r.stack_used, sizeof(g_stack),
+            r.static_bytes);
+    fprintf(f, "  \"logs\": {\"err\": %u, \"wrn\": %u, \"inf\": %u, \"dbg\": %u}\n}\n",
+            g_host_log_count[LOG_LEVEL_ERR], g_host_log_count[LOG_LEVEL_WRN],
+            g_host_log_count[LOG_LEVEL_INF], g_host_log_count[LOG_LEVEL_DBG]);
+}
+
+// --- Command line ---
+
+static void usage(const char* prog)
+{
+    printf("Usage: %s [options] [capture.pcap]\n"
+           "Without a capture, generated L16 traffic is replayed.\n"
+           "  --port N           UDP port to take from the capture (default 5004, 0 = any)\n"
+           "  --duration S       Generated: seconds of audio (default 600)\n"
+           "  --packet-ms MS     Generated: audio per packet (default 20)\n"
+           "  --loss PCT         Generated: packets not sent\n"
+           "  --reorder PCT      Generated: packets delivered after their successor\n"
+           "  --duplicate PCT    Generated: packets delivered twice\n"
+           "  --jitter-ms MS     Generated: extra delay, uniform in [0, MS)\n"
+           "  --burst-every S    Generated: seconds between bursts (default 0, none)\n"
+           "  --burst-ms MS      Generated: traffic held back per burst (default 100)\n"
+           "  --drift-ppm PPM    Generated: sender clock error, positive = fast\n"
+           "  --seed N           Generated: impairment random seed (default 1)\n"
+           "  --json FILE        Write the results as JSON (- for stdout)\n"
+           "  --budget-ns N      Fail if the hot path takes more than N ns per packet\n"
+           "  --verbose          Print the pipeline's log messages\n"
+           "pcapng captures: convert with 'editcap -F pcap in.pcapng out.pcap'\n",
+           prog);
+}
+
+int main(int argc, char** argv)
+{
+    PacketSource::Traffic traffic;
+    const char* pcap = nullptr;
+    const char* json = nullptr;
+    uint16_t port = 5004;
+    double budget_ns = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* val = i + 1 < argc ? argv[i + 1] : nullptr;
+        auto take = [&](double* out) {
+            if (!val) {
+                fprintf(stderr, "%s needs a value\n", arg);
+                exit(2);
+            }
+            *out = atof(val);
+            i++;
+        };
+        double v;
+
+        if (!strcmp(arg, "--help") || !strcmp(arg, "-h")) {
+            usage(argv[0]);
+            return 0;
+        } else if (!strcmp(arg, "--port")) {
+            take(&v);
+            port = static_cast<uint16_t>(v);
+        } else if (!strcmp(arg, "--duration")) {
+            take(&traffic.duration_s);
+        } else if (!strcmp(arg, "--packet-ms")) {
+            take(&traffic.packet_ms);
+        } else if (!strcmp(arg, "--loss")) {
+            take(&traffic.loss_pct);
+        } else if (!strcmp(arg, "--reorder")) {
+            take(&traffic.reorder_pct);
+        } else if (!strcmp(arg, "--duplicate")) {
+            take(&traffic.duplicate_pct);
+        } else if (!strcmp(arg, "--jitter-ms")) {
+            take(&traffic.jitter_ms);
+        } else if (!strcmp(arg, "--burst-every")) {
+            take(&traffic.burst_every_s);
+        } else if (!strcmp(arg, "--burst-ms")) {
+            take(&traffic.burst_ms);
+        } else if (!strcmp(arg, "--drift-ppm")) {
+            take(&traffic.drift_ppm);
+        } else if (!strcmp(arg, "--seed")) {
+            take(&v);
+            traffic.seed = static_cast<uint32_t>(v);
+        } else if (!strcmp(arg, "--budget-ns")) {
+            take(&budget_ns);
+        } else if (!strcmp(arg, "--json") && val) {
+            json = val;
+            i++;
+        } else if (!strcmp(arg, "--verbose")) {
+            g_host_log_level = LOG_LEVEL_DBG;
+        } else if (arg[0] != '-' && !pcap) {
+            pcap = arg;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    PacketSource source;
+    if (pcap) {
+        if (source.loadPcap(pcap, port) != 0) {
+            return 2;
+        }
+    } else {
+        size_t max_ms = (sizeof(PacketBuf::data) - RtpParser::kHeaderSize) / 2 * 1000 / CONFIG_RTP_CLOCK_RATE;
+        if (traffic.packet_ms <= 0 || traffic.packet_ms > max_ms || traffic.duration_s <= 0) {
+            fprintf(stderr, "--packet-ms must be in (0, %zu], --duration positive\n", max_ms);
+            return 2;
+        }
+        traffic.clock_rate = CONFIG_RTP_CLOCK_RATE;
+        source.generate(traffic);
+        if (source.packets().empty()) {
+            fprintf(stderr, "No packets generated\n");
+            return 2;
+        }
+    }
+
+    k_mem_slab_init(&g_pool_slab, g_pool_storage, sizeof(PacketBuf), BENCH_POOL_BLOCKS);
+    static Bench bench(source);
+
+    if (run_on_painted_stack(&bench) != 0) {
+        return 2;
+    }
+
+    Results r = {};
+    for (size_t i = 0; i < kStageCount; i++) {
+        r.stages[i] = percentiles(bench.stages[i]);
+        r.pipeline_ns += bench.stages[i].total_ns;
+    }
+    r.ns_per_packet = bench.counters.input ? static_cast<double>(r.pipeline_ns) / bench.counters.input : 0;
+    r.packets_per_s = r.pipeline_ns ? bench.counters.input * 1e9 / r.pipeline_ns : 0;
+    r.realtime_factor = r.pipeline_ns ? bench.media_us * 1e3 / r.pipeline_ns : 0;
+    r.stack_used = stack_used();
+    r.static_bytes = sizeof(g_pool_storage) + sizeof(g_stream_storage) + sizeof(g_pcm);
+
+    // Everything still buffered goes back to the pool; what does not is a leak
+    for (RtpStream* s : bench.streams) {
+        s->restart();
+    }
+    r.pool_leaked = bench.pool.capacity() - bench.pool.freeCount();
+
+    bool json_stdout = json && !strcmp(json, "-");
+    if (!json_stdout) {
+        print_text(bench, r);
+    }
+    if (json) {
+        FILE* f = json_stdout ? stdout : fopen(json, "w");
+        if (!f) {
+            fprintf(stderr, "%s: %s\n", json, strerror(errno));
+            return 2;
+        }
+        write_json(f, pcap ? pcap : "synthetic", bench, r);
+        if (f != stdout) {
+            fclose(f);
+        }
+    }
+
+    // Failures go to stderr when stdout carries the JSON
+    FILE* out = json_stdout ? stderr : stdout;
+    int failures = 0;
+    if (g_heap_allocs.load() != 0) {
+        fprintf(out, "FAIL: %u heap allocations on the packet path\n", g_heap_allocs.load());
+        failures++;
+    }
+    if (r.pool_leaked != 0) {
+        fprintf(out, "FAIL: %u pool blocks leaked\n", r.pool_leaked);
+        failures++;
+    }
+    if (budget_ns > 0 && r.ns_per_packet > budget_ns) {
+        fprintf(out, "FAIL: %.2f ns/packet over the %.0f ns budget\n", r.ns_per_packet, budget_ns);
+        failures++;
+    }
+    return failures ? 1 : 0;
+}
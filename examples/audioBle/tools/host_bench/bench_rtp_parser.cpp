@@ -0,0 +1,78 @@
+// Microbenchmark for RtpParser: reports ns/packet for the fast path,
+// the slow path (CSRC + extension + padding) and filtered packets.
+
+#include "bench_common.hpp"
+#include "net/rtp_parser.hpp"
+#include <cstring>
+
+volatile uint32_t g_bench_sink;
+
+#define BENCH_PACKETS 64
+#define BENCH_PAYLOAD 640  // 20 ms of 16 kHz mono L16
+#define BENCH_ITERATIONS 20000000
+
+// One extra byte so packets can start at an odd address
+static uint8_t g_packets[BENCH_PACKETS][BENCH_PAYLOAD + 64 + 1];
+static size_t g_lengths[BENCH_PACKETS];
+
+static size_t build_packet(uint8_t* p, uint16_t seq, bool rare)
+{
+    size_t n = 0;
+    p[n++] = rare ? (0x80 | 0x20 | 0x10 | 2) : 0x80;  // V=2 [P X CC=2]
+    p[n++] = 11;                                      // PT=11 (L16)
+    p[n++] = seq >> 8;
+    p[n++] = seq & 0xFF;
+    for (int i = 0; i < 4; i++) {
+        p[n++] = static_cast<uint8_t>((seq * 320u) >> (24 - 8 * i));
+    }
+    p[n++] = 0x12; p[n++] = 0x34; p[n++] = 0x56; p[n++] = 0x78;
+    if (rare) {
+        memset(p + n, 0xCC, 8);   // 2 CSRCs
+        n += 8;
+        p[n++] = 0xBE; p[n++] = 0xDE; p[n++] = 0x00; p[n++] = 0x01;
+        memset(p + n, 0, 4);      // 1-word extension
+        n += 4;
+    }
+    memset(p + n, 0x55, BENCH_PAYLOAD);
+    n += BENCH_PAYLOAD;
+    if (rare) {
+        p[n++] = 0;
+        p[n++] = 0;
+        p[n++] = 3;               // 3 bytes of padding
+    }
+    return n;
+}
+
+static void bench_case(const char* name, const RtpParser& parser, bool rare, size_t offset)
+{
+    for (uint16_t i = 0; i < BENCH_PACKETS; i++) {
+        g_lengths[i] = build_packet(g_packets[i] + offset, i, rare);
+    }
+
+    RtpPacket pkt;
+    bench_run(name, BENCH_ITERATIONS, [&](uint32_t i) {
+        uint32_t idx = i & (BENCH_PACKETS - 1);
+        int ret = parser.parse(g_packets[idx] + offset, g_lengths[idx], &pkt);
+        g_bench_sink = g_bench_sink + static_cast<uint32_t>(ret) + pkt.sequence +
+                       static_cast<uint32_t>(pkt.payloadLen);
+    });
+}
+
+int main()
+{
+    RtpParser any;
+    RtpParser match;
+    match.setPayloadTypeFilter(11);
+    match.setSsrcFilter(0x12345678);
+    RtpParser reject;
+    reject.setSsrcFilter(0xCAFEBABE);
+
+    printf("RtpParser (%d packets, %d byte payload)\n", BENCH_PACKETS, BENCH_PAYLOAD);
+    bench_case("fast path", any, false, 0);
+    bench_case("fast path, unaligned", any, false, 1);
+    bench_case("fast path, PT+SSRC filter", match, false, 0);
+    bench_case("fast path, filtered out", reject, false, 0);
+    bench_case("slow path (P+X+CC=2)", any, true, 0);
+    bench_case("slow path, unaligned", any, true, 1);
+    return 0;
+}
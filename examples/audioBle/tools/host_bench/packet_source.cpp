@@ -0,0 +1,303 @@
+#include "packet_source.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+namespace {
+
+// pcap link types (https://www.tcpdump.org/linktypes.html)
+constexpr uint32_t kLinkNull = 0;
+constexpr uint32_t kLinkEthernet = 1;
+constexpr uint32_t kLinkRaw = 101;
+constexpr uint32_t kLinkLinuxSll = 113;
+constexpr uint32_t kLinkIpv4 = 228;
+constexpr uint32_t kLinkIpv6 = 229;
+constexpr uint32_t kLinkLinuxSll2 = 276;
+
+constexpr uint16_t kEtherIpv4 = 0x0800;
+constexpr uint16_t kEtherIpv6 = 0x86DD;
+constexpr uint16_t kEtherVlan = 0x8100;
+constexpr uint16_t kEtherQinQ = 0x88A8;
+constexpr uint8_t kIpProtoUdp = 17;
+
+uint16_t be16(const uint8_t* p)
+{
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+uint32_t rd32(const uint8_t* p, bool swap)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return swap ? __builtin_bswap32(v) : v;
+}
+
+// Network-layer start and its ethertype for one captured frame
+bool linkPayload(uint32_t link, const uint8_t* frame, size_t len, bool swap,
+                 const uint8_t** ip, size_t* ipLen)
+{
+    size_t off;
+    uint16_t type;
+
+    switch (link) {
+    case kLinkEthernet:
+        if (len < 14) {
+            return false;
+        }
+        off = 14;
+        type = be16(frame + 12);
+        while ((type == kEtherVlan || type == kEtherQinQ) && len >= off + 4) {
+            type = be16(frame + off + 2);
+            off += 4;
+        }
+        break;
+    case kLinkLinuxSll:
+        if (len < 16) {
+            return false;
+        }
+        off = 16;
+        type = be16(frame + 14);
+        break;
+    case kLinkLinuxSll2:
+        if (len < 20) {
+            return false;
+        }
+        off = 20;
+        type = be16(frame);
+        break;
+    case kLinkNull: {
+        if (len < 4) {
+            return false;
+        }
+        // Address family in the byte order of the capturing host
+        uint32_t family = rd32(frame, swap);
+        off = 4;
+        type = family == 2 ? kEtherIpv4 : (family == 24 || family == 28 || family == 30) ? kEtherIpv6 : 0;
+        break;
+    }
+    case kLinkRaw:
+    case kLinkIpv4:
+    case kLinkIpv6:
+        if (len < 1) {
+            return false;
+        }
+        off = 0;
+        type = (frame[0] >> 4) == 4 ? kEtherIpv4 : (frame[0] >> 4) == 6 ? kEtherIpv6 : 0;
+        break;
+    default:
+        return false;
+    }
+
+    if (type != kEtherIpv4 && type != kEtherIpv6) {
+        return false;
+    }
+    *ip = frame + off;
+    *ipLen = len - off;
+    return true;
+}
+
+// UDP payload of an IPv4/IPv6 packet, if it goes to port (0 = any)
+bool udpPayload(const uint8_t* ip, size_t len, uint16_t port, const uint8_t** payload,
+                size_t* payloadLen)
+{
+    size_t hdr;
+    size_t total;
+
+    if (len >= 20 && (ip[0] >> 4) == 4) {
+        hdr = (ip[0] & 0x0F) * 4u;
+        total = be16(ip + 2);
+        if (hdr < 20 || ip[9] != kIpProtoUdp || (be16(ip + 6) & 0x1FFF) != 0) {
+            return false;
+        }
+    } else if (len >= 40 && (ip[0] >> 4) == 6) {
+        hdr = 40;
+        total = 40 + be16(ip + 4);
+        if (ip[6] != kIpProtoUdp) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+
+    total = std::min(total, len);
+    if (total < hdr + 8) {
+        return false;
+    }
+
+    const uint8_t* udp = ip + hdr;
+    size_t udpLen = std::min<size_t>(be16(udp + 4), total - hdr);
+    if (udpLen < 8 || (port != 0 && be16(udp + 2) != port)) {
+        return false;
+    }
+    *payload = udp + 8;
+    *payloadLen = udpLen - 8;
+    return true;
+}
+
+}  // namespace
+
+void PacketSource::add(uint64_t arrivalUs, const uint8_t* payload, size_t length)
+{
+    SourcePacket pkt;
+    pkt.arrival_us = arrivalUs;
+    pkt.offset = static_cast<uint32_t>(m_data.size());
+    pkt.length = static_cast<uint32_t>(length);
+    m_data.insert(m_data.end(), payload, payload + length);
+    m_packets.push_back(pkt);
+}
+
+int PacketSource::loadPcap(const char* path, uint16_t port)
+{
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -errno;
+    }
+
+    std::vector<uint8_t> file;
+    uint8_t chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        file.insert(file.end(), chunk, chunk + n);
+    }
+    fclose(f);
+
+    if (file.size() < 24) {
+        fprintf(stderr, "%s: not a pcap file\n", path);
+        return -EINVAL;
+    }
+
+    uint32_t magic;
+    memcpy(&magic, file.data(), sizeof(magic));
+    bool swap;
+    bool nanosec;
+    switch (magic) {
+    case 0xA1B2C3D4: swap = false; nanosec = false; break;
+    case 0xD4C3B2A1: swap = true;  nanosec = false; break;
+    case 0xA1B23C4D: swap = false; nanosec = true;  break;
+    case 0x4D3CB2A1: swap = true;  nanosec = true;  break;
+    default:
+        fprintf(stderr, "%s: not a classic pcap file (pcapng? see --help)\n", path);
+        return -EINVAL;
+    }
+    uint32_t link = rd32(file.data() + 20, swap) & 0x0FFFFFFF;
+
+    size_t off = 24;
+    bool first = true;
+    uint64_t start_us = 0;
+    while (off + 16 <= file.size()) {
+        const uint8_t* rec = file.data() + off;
+        uint64_t sec = rd32(rec, swap);
+        uint64_t frac = rd32(rec + 4, swap);
+        size_t caplen = rd32(rec + 8, swap);
+        off += 16;
+        if (caplen > file.size() - off) {
+            fprintf(stderr, "%s: truncated at record %zu\n", path, m_packets.size());
+            break;
+        }
+
+        const uint8_t* ip;
+        size_t ipLen;
+        const uint8_t* payload;
+        size_t payloadLen;
+        if (linkPayload(link, file.data() + off, caplen, swap, &ip, &ipLen) &&
+            udpPayload(ip, ipLen, port, &payload, &payloadLen)) {
+            uint64_t us = sec * 1000000 + (nanosec ? frac / 1000 : frac);
+            if (first) {
+                start_us = us;
+                first = false;
+            }
+            // Clock steps backwards in the capture are clamped to keep the order
+            uint64_t rel = us > start_us ? us - start_us : 0;
+            if (!m_packets.empty() && rel < m_packets.back().arrival_us) {
+                rel = m_packets.back().arrival_us;
+            }
+            add(rel, payload, payloadLen);
+        }
+        off += caplen;
+    }
+
+    if (m_packets.empty()) {
+        fprintf(stderr, "%s: no UDP packets to port %u (link type %u)\n", path, port, link);
+        return -ENOENT;
+    }
+    return 0;
+}
+
+void PacketSource::generate(const Traffic& traffic)
+{
+    std::mt19937 rng(traffic.seed);
+    auto uniform = [&rng]() { return (rng() >> 8) * (1.0 / 16777216.0); };
+
+    size_t samples = static_cast<size_t>(std::lround(traffic.packet_ms * traffic.clock_rate / 1000.0));
+    size_t count = static_cast<size_t>(traffic.duration_s * 1000.0 / traffic.packet_ms);
+    // A fast sender puts its packets closer together in our time
+    double period_us = traffic.packet_ms * 1000.0 / (1.0 + traffic.drift_ppm * 1e-6);
+    uint16_t seq0 = static_cast<uint16_t>(rng());
+    uint32_t ts0 = rng();
+
+    struct Entry {
+        uint64_t arrival_us;
+        uint32_t index;
+    };
+    std::vector<Entry> entries;
+    entries.reserve(count + count / 10);
+
+    for (uint32_t i = 0; i < count; i++) {
+        double send_us = i * period_us;
+        if (uniform() * 100.0 < traffic.loss_pct) {
+            continue;
+        }
+
+        double arrival_us = send_us + uniform() * traffic.jitter_ms * 1000.0;
+        if (traffic.burst_every_s > 0 && traffic.burst_ms > 0) {
+            // Held back from the start of each burst window until its end
+            double every_us = traffic.burst_every_s * 1e6;
+            double window = std::floor(send_us / every_us);
+            double release_us = window * every_us + traffic.burst_ms * 1000.0;
+            if (window >= 1 && send_us < release_us) {
+                arrival_us = std::max(arrival_us, release_us);
+            }
+        }
+        if (uniform() * 100.0 < traffic.reorder_pct) {
+            arrival_us = std::max(arrival_us, send_us + period_us + 1);
+        }
+
+        entries.push_back({static_cast<uint64_t>(arrival_us), i});
+        if (uniform() * 100.0 < traffic.duplicate_pct) {
+            entries.push_back({static_cast<uint64_t>(arrival_us) + 100, i});
+        }
+    }
+
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const Entry& a, const Entry& b) { return a.arrival_us < b.arrival_us; });
+
+    m_packets.reserve(entries.size());
+    m_data.reserve(entries.size() * (12 + samples * 2));
+
+    std::vector<uint8_t> pkt(12 + samples * 2);
+    for (const Entry& e : entries) {
+        uint16_t seq = static_cast<uint16_t>(seq0 + e.index);
+        uint32_t ts = ts0 + static_cast<uint32_t>(e.index * samples);
+        pkt[0] = 0x80;
+        pkt[1] = 11;  // L16 mono
+        pkt[2] = seq >> 8;
+        pkt[3] = seq & 0xFF;
+        for (int b = 0; b < 4; b++) {
+            pkt[4 + b] = static_cast<uint8_t>(ts >> (24 - 8 * b));
+            pkt[8 + b] = static_cast<uint8_t>(traffic.ssrc >> (24 - 8 * b));
+        }
+
+        // 440 Hz tone, continuous across packets, big-endian like on the wire
+        for (size_t s = 0; s < samples; s++) {
+            double t = static_cast<double>(e.index * samples + s) / traffic.clock_rate;
+            int16_t v = static_cast<int16_t>(std::lround(8000.0 * std::sin(2 * M_PI * 440.0 * t)));
+            pkt[12 + 2 * s] = static_cast<uint8_t>(static_cast<uint16_t>(v) >> 8);
+            pkt[13 + 2 * s] = static_cast<uint8_t>(v & 0xFF);
+        }
+        add(e.arrival_us, pkt.data(), pkt.size());
+    }
+}
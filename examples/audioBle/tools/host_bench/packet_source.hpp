@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief One UDP payload with its arrival time, as recvfrom() would see it
+ */
+struct SourcePacket {
+    uint64_t arrival_us;  // Relative to the first packet of the source
+    uint32_t offset;      // Into PacketSource::data()
+    uint32_t length;
+};
+
+/**
+ * @brief Datagrams for bench_pipeline, read or generated up front
+ *
+ * Everything is prepared before the measured run, so replaying the
+ * source costs nothing and allocates nothing. Packets are kept in
+ * arrival order.
+ */
+class PacketSource {
+public:
+    const std::vector<SourcePacket>& packets() const { return m_packets; }
+    const uint8_t* data(const SourcePacket& pkt) const { return m_data.data() + pkt.offset; }
+
+    /**
+     * @brief UDP payloads to the given port from a classic pcap capture
+     *
+     * Link types: Ethernet (with 802.1Q tags), Linux cooked (SLL, SLL2),
+     * BSD loopback and raw IP. IPv4 and IPv6 without extension headers;
+     * IP fragments other than the first are skipped. pcapng is not read,
+     * convert with "editcap -F pcap in.pcapng out.pcap".
+     *
+     * @param port UDP destination port, 0 for any
+     * @return 0 on success, negative error code (reason printed)
+     */
+    int loadPcap(const char* path, uint16_t port);
+
+    /**
+     * @brief Impairments for generate(), same meaning as in stream_audio.py --bench
+     */
+    struct Traffic {
+        double duration_s = 600;
+        double packet_ms = 20;      // Audio per packet
+        uint32_t clock_rate = 16000;
+        uint32_t ssrc = 0x12345678;
+        double loss_pct = 0;        // Packets never sent
+        double reorder_pct = 0;     // Packets delivered after their successor
+        double duplicate_pct = 0;   // Packets delivered twice
+        double jitter_ms = 0;       // Extra delay, uniform in [0, jitter_ms)
+        double burst_every_s = 0;   // WiFi power-save style bursts, 0 for none
+        double burst_ms = 100;      // Traffic held back per burst
+        double drift_ppm = 0;       // Sender clock error, positive = fast
+        uint32_t seed = 1;
+    };
+
+    /**
+     * @brief Synthesize an L16 mono tone stream with impairments
+     */
+    void generate(const Traffic& traffic);
+
+private:
+    void add(uint64_t arrivalUs, const uint8_t* payload, size_t length);
+
+    std::vector<SourcePacket> m_packets;
+    std::vector<uint8_t> m_data;
+};
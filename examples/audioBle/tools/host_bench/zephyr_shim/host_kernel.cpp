@@ -0,0 +1,29 @@
+// State behind the host kernel and logging stand-ins (zephyr/kernel.h,
+// zephyr/logging/log.h in this directory)
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <cstdarg>
+#include <cstdio>
+
+uint64_t g_host_time_us;
+
+int g_host_log_level = LOG_LEVEL_NONE;
+uint32_t g_host_log_count[LOG_LEVEL_DBG + 1];
+
+void host_log(int level, const char* fmt, ...)
+{
+    static const char* const kTags[] = {"", "err", "wrn", "inf", "dbg"};
+
+    g_host_log_count[level]++;
+    if (level > g_host_log_level) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "[%10.3f] <%s> ", g_host_time_us / 1000.0, kTags[level]);
+    vfprintf(stderr, fmt, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+// Host stand-in for the few kernel services the audio pipeline uses, so
+// net/rtp_stream.cpp and net/packet_pool.cpp build unchanged off target.
+// Time is virtual: the benchmark sets it with host_set_time_us() before
+// each event, which makes a run repeatable and independent of host load.
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+
+// Rate of k_cycle_get_32() (the DWT cycle counter at 128 MHz on target)
+#define HOST_CYCLES_PER_SEC 128000000u
+
+extern uint64_t g_host_time_us;
+
+static inline void host_set_time_us(uint64_t us)
+{
+    g_host_time_us = us;
+}
+
+// One tick per microsecond
+static inline int64_t k_uptime_ticks(void)
+{
+    return static_cast<int64_t>(g_host_time_us);
+}
+
+static inline uint64_t k_ticks_to_us_floor64(uint64_t ticks)
+{
+    return ticks;
+}
+
+static inline uint32_t k_uptime_get_32(void)
+{
+    return static_cast<uint32_t>(g_host_time_us / 1000);
+}
+
+static inline uint32_t k_cycle_get_32(void)
+{
+    return static_cast<uint32_t>(g_host_time_us * (HOST_CYCLES_PER_SEC / 1000000u));
+}
+
+static inline uint32_t sys_clock_hw_cycles_per_sec(void)
+{
+    return HOST_CYCLES_PER_SEC;
+}
+
+static inline uint32_t k_cyc_to_ns_floor32(uint32_t cycles)
+{
+    return static_cast<uint32_t>(static_cast<uint64_t>(cycles) * 1000000000u / HOST_CYCLES_PER_SEC);
+}
+
+typedef struct {
+    int64_t ticks;
+} k_timeout_t;
+
+#define K_NO_WAIT (k_timeout_t{0})
+
+// Same layout idea as the kernel's: a free list threaded through the blocks
+struct k_mem_slab_info {
+    uint32_t num_blocks;
+    size_t block_size;
+    uint32_t num_used;
+};
+
+struct k_mem_slab {
+    struct k_mem_slab_info info;
+    char* buffer;
+    char* free_list;
+};
+
+/**
+ * @brief Initialize a slab over caller-provided storage
+ */
+static inline int k_mem_slab_init(struct k_mem_slab* slab, void* buffer, size_t block_size,
+                                  uint32_t num_blocks)
+{
+    slab->info.num_blocks = num_blocks;
+    slab->info.block_size = block_size;
+    slab->info.num_used = 0;
+    slab->buffer = static_cast<char*>(buffer);
+    slab->free_list = nullptr;
+    for (uint32_t i = num_blocks; i-- > 0;) {
+        char* block = slab->buffer + i * block_size;
+        *reinterpret_cast<char**>(block) = slab->free_list;
+        slab->free_list = block;
+    }
+    return 0;
+}
+
+static inline int k_mem_slab_alloc(struct k_mem_slab* slab, void** mem, k_timeout_t)
+{
+    if (!slab->free_list) {
+        *mem = nullptr;
+        return -ENOMEM;
+    }
+    *mem = slab->free_list;
+    slab->free_list = *reinterpret_cast<char**>(slab->free_list);
+    slab->info.num_used++;
+    return 0;
+}
+
+static inline void k_mem_slab_free(struct k_mem_slab* slab, void* mem)
+{
+    *static_cast<char**>(mem) = slab->free_list;
+    slab->free_list = static_cast<char*>(mem);
+    slab->info.num_used--;
+}
+
+static inline uint32_t k_mem_slab_num_used_get(struct k_mem_slab* slab)
+{
+    return slab->info.num_used;
+}
+
+static inline uint32_t k_mem_slab_num_free_get(struct k_mem_slab* slab)
+{
+    return slab->info.num_blocks - slab->info.num_used;
+}
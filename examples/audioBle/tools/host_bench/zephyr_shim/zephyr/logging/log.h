@@ -0,0 +1,27 @@
+#pragma once
+
+// Host stand-in for Zephyr logging: messages are counted per level and
+// only printed when host_log_level allows it (bench_pipeline --verbose).
+// Formats are printed as given; like on target, %u with a size_t argument
+// relies on the value fitting in 32 bits.
+
+#include <cstdint>
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERR 1
+#define LOG_LEVEL_WRN 2
+#define LOG_LEVEL_INF 3
+#define LOG_LEVEL_DBG 4
+
+extern int g_host_log_level;
+extern uint32_t g_host_log_count[LOG_LEVEL_DBG + 1];
+
+void host_log(int level, const char* fmt, ...);
+
+#define LOG_MODULE_REGISTER(name, ...) static_assert(true, #name)
+#define LOG_MODULE_DECLARE(name, ...) static_assert(true, #name)
+
+#define LOG_ERR(...) host_log(LOG_LEVEL_ERR, __VA_ARGS__)
+#define LOG_WRN(...) host_log(LOG_LEVEL_WRN, __VA_ARGS__)
+#define LOG_INF(...) host_log(LOG_LEVEL_INF, __VA_ARGS__)
+#define LOG_DBG(...) host_log(LOG_LEVEL_DBG, __VA_ARGS__)
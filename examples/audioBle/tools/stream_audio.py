@@ -8,27 +8,95 @@ Requirements:
 
 Usage:
     python3 stream_audio.py <audio_file> [port]
-    
+    python3 stream_audio.py --bench [options] [port]
+
 Example:
     python3 stream_audio.py song.mp3 5004
-    
+    python3 stream_audio.py --bench --duration 60 --loss 1 --streams 2
+
 Then on nRF7002-DK:
     uart:~$ wifi connect -s <ssid> -p <password> -k 1
     uart:~$ rtp start <this_computer_ip> 5004
+
+RTCP runs on port + 1: the server sends sender reports and the device answers
+with receiver reports (loss, jitter, LSR/DLSR). When the reports show the link
+degrading, the server switches to longer packets (fewer packets per second on
+the air) and returns to the original packet size once the link has recovered.
+
+--bench sends a generated tone instead of a file (pydub is not needed), for
+throughput and latency runs: packets are paced against monotonic-clock
+deadlines, size and rate are free, loss, reordering and bursts are injected
+from a seeded random generator, several SSRCs can be sent at once, and every
+packet carries its send time in an RFC 8285 header extension. See
+BenchmarkStreamer for the options and the summary it prints.
 """
 
+import argparse
+import json
+import math
+import random
 import sys
 import socket
 import time
 import struct
 from pathlib import Path
 
+# Seconds between 1900-01-01 (NTP epoch) and 1970-01-01 (Unix epoch)
+NTP_EPOCH_OFFSET = 2208988800
+
+# RFC 8285 one-byte header extension carrying the send time: element ID 1,
+# 8 bytes, 64-bit NTP timestamp (wall clock) taken just before sendto()
+RTP_EXT_PROFILE_ONE_BYTE = 0xBEDE
+SEND_TIME_EXT_ID = 1
+
+# Largest UDP payload without IP fragmentation on a 1500-byte MTU
+MAX_UDP_PAYLOAD = 1472
+
 try:
     from pydub import AudioSegment
 except ImportError:
-    print("Error: pydub is not installed")
-    print("Install it with: pip3 install pydub")
-    sys.exit(1)
+    AudioSegment = None  # Only needed to stream a file
+
+
+class RateController:
+    """Picks the packet duration from RTCP receiver reports
+
+    Backs off one step (longer packets) as soon as a report shows loss or
+    jitter approaching the packet duration, i.e. before the device's jitter
+    buffer runs dry. Steps back up only after a run of clean reports.
+    """
+
+    LOSS_BACKOFF = 5          # Fraction lost (x/256, ~2%) that triggers a back-off
+    CLEAN_REPORTS_TO_RECOVER = 10
+
+    def __init__(self, durations_ms):
+        self.durations_ms = durations_ms   # Ascending, first entry is preferred
+        self.level = 0
+        self.clean_reports = 0
+
+    @property
+    def duration_ms(self):
+        return self.durations_ms[self.level]
+
+    def on_report(self, fraction_lost, jitter_ms):
+        """Feed one receiver report, returns True if the duration changed"""
+        if fraction_lost >= self.LOSS_BACKOFF or jitter_ms > self.duration_ms:
+            self.clean_reports = 0
+            if self.level + 1 < len(self.durations_ms):
+                self.level += 1
+                return True
+            return False
+
+        if fraction_lost == 0 and jitter_ms < self.duration_ms / 2:
+            self.clean_reports += 1
+        else:
+            self.clean_reports = 0
+
+        if self.clean_reports >= self.CLEAN_REPORTS_TO_RECOVER and self.level > 0:
+            self.level -= 1
+            self.clean_reports = 0
+            return True
+        return False
 
 
 class RtpServer:
@@ -37,6 +105,11 @@ class RtpServer:
     # RTP payload type for raw PCM audio
     PAYLOAD_TYPE_PCMU = 0  # G.711 μ-law
     PAYLOAD_TYPE_L16 = 11  # Linear PCM 16-bit, 44.1kHz
+
+    # RTCP packet types (RFC 3550)
+    RTCP_SR = 200
+    RTCP_RR = 201
+    RTCP_INTERVAL_S = 1.0
     
     def __init__(self, port=5004, sample_rate=48000):
         self.port = port
@@ -50,9 +123,20 @@ class RtpServer:
         # Create UDP socket and bind to port
         self.socket = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
         self.socket.bind(('0.0.0.0', port))
+
+        # RTCP on port + 1 (non-blocking, polled from the send loop)
+        self.rtcp_socket = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.rtcp_socket.bind(('0.0.0.0', port + 1))
+        self.rtcp_socket.setblocking(False)
+
+        # Sender statistics for SR packets
+        self.packets_sent = 0
+        self.octets_sent = 0
+        self.last_sr_time = 0.0
         
         # Client address (will be set when client connects)
         self.client_addr = None
+        self.client_rtcp_addr = None
         
         print(f"RTP Server started on port {port}")
         print(f"Waiting for client connection...")
@@ -90,6 +174,7 @@ class RtpServer:
             # Wait for any packet from client
             data, addr = self.socket.recvfrom(1024)
             self.client_addr = addr  # Use the address client is bound to (should be port 5004)
+            self.client_rtcp_addr = (addr[0], addr[1] + 1)
             print(f"✓ Client connected from {addr[0]}:{addr[1]}")
             print(f"  Received: {len(data)} bytes - {data[:30]}")
             
@@ -153,6 +238,78 @@ class RtpServer:
         
         # Update sequence number (wraps at 65535)
         self.sequence_number = (self.sequence_number + 1) & 0xFFFF
+        self.packets_sent += 1
+        self.octets_sent += len(audio_data)
+
+    def send_sender_report(self, ssrc=None, rtp_timestamp=None, packets=None, octets=None):
+        """Send an RTCP SR so the client can report LSR/DLSR (RTT)
+
+        Defaults to this server's own stream; the benchmark passes the
+        counters of each of its SSRCs.
+        """
+        now = time.time() + NTP_EPOCH_OFFSET
+        ntp_msw = int(now) & 0xFFFFFFFF
+        ntp_lsw = int((now % 1.0) * (1 << 32)) & 0xFFFFFFFF
+
+        packet = struct.pack('!BBHIIIIII',
+            0x80, self.RTCP_SR, 6,     # V=2, RC=0, length in words - 1
+            self.ssrc if ssrc is None else ssrc,
+            ntp_msw, ntp_lsw,
+            (self.timestamp if rtp_timestamp is None else rtp_timestamp) & 0xFFFFFFFF,
+            (self.packets_sent if packets is None else packets) & 0xFFFFFFFF,
+            (self.octets_sent if octets is None else octets) & 0xFFFFFFFF
+        )
+
+        try:
+            self.rtcp_socket.sendto(packet, self.client_rtcp_addr)
+        except OSError as e:
+            print(f"ERROR sending RTCP SR: {e}")
+        self.last_sr_time = time.time()
+
+    def poll_receiver_reports(self):
+        """Drain the RTCP socket, return a list of report block dicts"""
+        reports = []
+        while True:
+            try:
+                data, _ = self.rtcp_socket.recvfrom(1500)
+            except (BlockingIOError, socket.timeout):
+                break
+            except OSError:
+                break
+
+            # Walk the compound packet, keep the first report block of each RR
+            offset = 0
+            while offset + 4 <= len(data):
+                vprc, pt, length = struct.unpack_from('!BBH', data, offset)
+                part_len = (length + 1) * 4
+                if (vprc >> 6) != 2 or offset + part_len > len(data):
+                    break
+                if pt == self.RTCP_RR and (vprc & 0x1F) >= 1 and part_len >= 32:
+                    (ssrc, src_ssrc, lost_word, ext_max, jitter,
+                     lsr, dlsr) = struct.unpack_from('!IIIIIII', data, offset + 4)
+                    cumulative = lost_word & 0xFFFFFF
+                    if cumulative & 0x800000:
+                        cumulative -= 1 << 24
+                    reports.append({
+                        'source_ssrc': src_ssrc,
+                        'fraction_lost': lost_word >> 24,
+                        'cumulative_lost': cumulative,
+                        'ext_max_seq': ext_max,
+                        'jitter': jitter,
+                        'rtt_ms': self._rtt_ms(lsr, dlsr),
+                    })
+                offset += part_len
+        return reports
+
+    @staticmethod
+    def _rtt_ms(lsr, dlsr):
+        """RFC 3550 6.4.1: RTT = now - LSR - DLSR (middle 32 bits of NTP time)"""
+        if lsr == 0:
+            return None
+        now = time.time() + NTP_EPOCH_OFFSET
+        now_mid = int(now * 65536) & 0xFFFFFFFF
+        rtt = (now_mid - lsr - dlsr) & 0xFFFFFFFF
+        return rtt * 1000.0 / 65536
         
     def stream_audio(self, audio_file, chunk_duration_ms=20):
         """
@@ -198,20 +355,28 @@ class RtpServer:
         if chunk_size > max_chunk_size:
             chunk_size = max_chunk_size
             samples_per_chunk = chunk_size // bytes_per_sample
-        
-        # Timestamp increment per packet
-        timestamp_increment = samples_per_chunk
+
+        # Back-off ladder: longer packets mean fewer packets on the air for
+        # the same bitrate. The sample rate stays fixed because the device
+        # plays out at CONFIG_RTP_CLOCK_RATE.
+        bytes_per_ms = audio.frame_rate * bytes_per_sample // 1000
+        durations = [chunk_duration_ms] + [d for d in (30, 40, 60)
+                                           if d > chunk_duration_ms
+                                           and d * bytes_per_ms <= max_chunk_size]
+        rate = RateController(durations)
         
         print(f"Packet size: {chunk_size} bytes ({chunk_duration_ms}ms)")
-        print(f"Timestamp increment: {timestamp_increment}")
+        print(f"Timestamp increment: {samples_per_chunk}")
+        print(f"RTCP back-off ladder: {durations} ms")
         print("-" * 50)
         
         # Stream audio in chunks
         packet_count = 0
         start_time = time.time()
+        i = 0
         
         try:
-            for i in range(0, len(raw_data), chunk_size):
+            while i < len(raw_data):
                 chunk = raw_data[i:i + chunk_size]
                 
                 # Pad last chunk if necessary
@@ -223,7 +388,27 @@ class RtpServer:
                 self.send_rtp_packet(chunk, marker)
                 
                 packet_count += 1
-                self.timestamp += timestamp_increment
+                self.timestamp += samples_per_chunk
+                i += chunk_size
+
+                # RTCP: periodic SR out, RRs in
+                if time.time() - self.last_sr_time >= self.RTCP_INTERVAL_S:
+                    self.send_sender_report()
+
+                for rr in self.poll_receiver_reports():
+                    jitter_ms = rr['jitter'] * 1000.0 / audio.frame_rate
+                    rtt = rr['rtt_ms']
+                    rtt_str = f"{rtt:.1f}ms" if rtt is not None else "n/a"
+                    print(f"RR: lost {rr['fraction_lost'] * 100 / 256:.1f}% "
+                          f"(total {rr['cumulative_lost']}) | "
+                          f"jitter {jitter_ms:.1f}ms | RTT {rtt_str}")
+
+                    if rate.on_report(rr['fraction_lost'], jitter_ms):
+                        chunk_duration_ms = rate.duration_ms
+                        samples_per_chunk = audio.frame_rate * chunk_duration_ms // 1000
+                        chunk_size = samples_per_chunk * bytes_per_sample
+                        print(f"Packet duration now {chunk_duration_ms}ms "
+                              f"({chunk_size} bytes)")
                 
                 # Log progress
                 if packet_count % 50 == 0:
@@ -244,28 +429,330 @@ class RtpServer:
         print(f"\nStreaming complete:")
         print(f"  Total packets sent: {packet_count}")
         print(f"  Total time: {elapsed:.2f} seconds")
-        print(f"  Data rate: {(packet_count * chunk_size / elapsed / 1024):.2f} KB/s")
+        print(f"  Data rate: {(self.octets_sent / elapsed / 1024):.2f} KB/s")
+
+
+def send_time_extension(ext_id, wall_time):
+    """RFC 8285 one-byte header extension with one 8-byte NTP timestamp"""
+    ntp = int((wall_time + NTP_EPOCH_OFFSET) * (1 << 32)) & 0xFFFFFFFFFFFFFFFF
+    element = struct.pack('!BQ', (ext_id << 4) | (8 - 1), ntp)  # L = length - 1
+    element += b'\x00' * (-len(element) % 4)
+    return struct.pack('!HH', RTP_EXT_PROFILE_ONE_BYTE, len(element) // 4) + element
+
+
+class BenchStream:
+    """Sequence number, timestamp and counters of one benchmark SSRC"""
+
+    def __init__(self, ssrc):
+        self.ssrc = ssrc
+        self.sequence_number = 0
+        self.timestamp = 0
+        self.packets_sent = 0
+        self.octets_sent = 0
+        self.dropped = 0
+        self.reordered = 0
+        self.held = None            # Packet waiting to be sent after the next one
+        self.last_report = None
+
+
+class BenchmarkStreamer:
+    """Load generator: paced, impaired, multi-SSRC RTP with send timestamps
+
+    Packet n goes out at start + n * period on time.monotonic(), so a late
+    wakeup is caught up instead of delaying every later packet (sleeping for
+    the period drifts by the wakeup latency each time). The last SPIN_S
+    before a deadline is busy-waited. With several streams, each deadline
+    sends one packet per SSRC back-to-back.
+
+    Impairments come from a seeded generator, so a run can be repeated:
+      loss    - the packet is not sent, its sequence number is used up
+      reorder - the packet is held and sent after the next one of its stream
+      burst   - every burst_every_s, packets are held for burst_ms and then
+                sent back-to-back, like a power-save doze at the AP
+
+    The send-time extension is stamped right before sendto(), after any
+    holding, so it measures the network and the device and not the injected
+    delay. The payload is a 440 Hz tone in L16 (big-endian) at CLOCK_RATE;
+    timestamps advance by the samples in each packet, so a --rate that does
+    not match the payload duration makes the media clock run fast or slow.
+    """
+
+    CLOCK_RATE = 16000
+    TONE_HZ = 440
+    SPIN_S = 0.002
+    PROGRESS_INTERVAL_S = 5.0
+    SSRC_BASE = 0x12345678
+
+    def __init__(self, server, payload_bytes, rate_pps, streams=1, loss=0.0,
+                 reorder=0.0, burst_every_s=0.0, burst_ms=0, seed=1, send_time=True):
+        self.server = server
+        self.payload_bytes = payload_bytes & ~1  # Whole 16-bit samples
+        self.period_s = 1.0 / rate_pps
+        self.loss = loss / 100.0
+        self.reorder = reorder / 100.0
+        self.burst_every_s = burst_every_s
+        self.burst_s = burst_ms / 1000.0
+        self.send_time = send_time
+        self.rng = random.Random(seed)
+        self.streams = [BenchStream(self.SSRC_BASE + i) for i in range(streams)]
+
+        # One second of tone holds a whole number of cycles; doubled so any
+        # payload-sized slice can be taken without wrapping
+        tone = [int(12000 * math.sin(2 * math.pi * self.TONE_HZ * n / self.CLOCK_RATE))
+                for n in range(self.CLOCK_RATE)]
+        self.tone = struct.pack(f'>{len(tone)}h', *tone) * 2
+
+        self.lateness_ms = []       # Send time - deadline, packets not held
+        self.burst_count = 0
+        self.burst_queue = []
+
+    def max_payload(self):
+        ext = len(send_time_extension(SEND_TIME_EXT_ID, 0)) if self.send_time else 0
+        return MAX_UDP_PAYLOAD - 12 - ext
+
+    def _payload(self, stream):
+        offset = (stream.timestamp % self.CLOCK_RATE) * 2
+        return self.tone[offset:offset + self.payload_bytes]
+
+    def _send(self, stream, sequence, timestamp, payload, marker):
+        mpt = (0x80 if marker else 0x00) | RtpServer.PAYLOAD_TYPE_L16
+        header = struct.pack('!BBHII', 0x90 if self.send_time else 0x80, mpt,
+                             sequence, timestamp & 0xFFFFFFFF, stream.ssrc)
+        if self.send_time:
+            header += send_time_extension(SEND_TIME_EXT_ID, time.time())
+        try:
+            self.server.socket.sendto(header + payload, self.server.client_addr)
+        except OSError as e:
+            print(f"ERROR sending packet: {e}")
+            return
+        stream.packets_sent += 1
+        stream.octets_sent += len(payload)
+
+    def _wait_until(self, deadline):
+        while True:
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                return
+            if remaining > self.SPIN_S:
+                time.sleep(remaining - self.SPIN_S)
+
+    def _in_burst(self, elapsed):
+        if self.burst_every_s <= 0 or self.burst_s <= 0:
+            return False
+        phase = elapsed % self.burst_every_s
+        return elapsed >= self.burst_every_s and phase < self.burst_s
+
+    def _flush_burst(self):
+        if self.burst_queue:
+            self.burst_count += 1
+        for item in self.burst_queue:
+            self._send(*item)
+        self.burst_queue = []
+
+    def _poll_reports(self):
+        by_ssrc = {s.ssrc: s for s in self.streams}
+        for rr in self.server.poll_receiver_reports():
+            stream = by_ssrc.get(rr['source_ssrc'])
+            if stream is None:
+                continue
+            stream.last_report = rr
+            jitter_ms = rr['jitter'] * 1000.0 / self.CLOCK_RATE
+            rtt = rr['rtt_ms']
+            rtt_str = f"{rtt:.1f}ms" if rtt is not None else "n/a"
+            print(f"RR 0x{stream.ssrc:08x}: lost {rr['fraction_lost'] * 100 / 256:.1f}% "
+                  f"(total {rr['cumulative_lost']}) | "
+                  f"jitter {jitter_ms:.1f}ms | RTT {rtt_str}")
+
+    def run(self, duration_s):
+        """Stream for duration_s seconds (0 until Ctrl+C), return the summary"""
+        if not self.server.wait_for_client():
+            return None
+
+        samples = self.payload_bytes // 2
+        print(f"\nBenchmark to {self.server.client_addr[0]}:{self.server.client_addr[1]}")
+        print(f"  {len(self.streams)} stream(s), {self.payload_bytes} byte payload, "
+              f"{1 / self.period_s:.1f} packets/s per stream "
+              f"({samples * 1000 / self.CLOCK_RATE:.1f} ms of audio each)")
+        for i, stream in enumerate(self.streams[1:], start=1):
+            print(f"  Stream {i}: uart:~$ rtp stream set {i} 0 0x{stream.ssrc:08x}")
+        print("Press Ctrl+C to stop\n")
+
+        start = time.monotonic()
+        last_sr = 0.0
+        last_progress = start
+        n = 0
+        try:
+            while duration_s <= 0 or n * self.period_s < duration_s:
+                deadline = start + n * self.period_s
+                self._wait_until(deadline)
+                elapsed = deadline - start
+                bursting = self._in_burst(elapsed)
+                if not bursting:
+                    self._flush_burst()
+
+                for stream in self.streams:
+                    item = (stream, stream.sequence_number, stream.timestamp,
+                            self._payload(stream), n == 0)
+                    stream.sequence_number = (stream.sequence_number + 1) & 0xFFFF
+                    stream.timestamp += samples
+
+                    ready = []
+                    if n > 0 and self.rng.random() < self.loss:
+                        stream.dropped += 1
+                    elif stream.held is None and n > 0 and self.rng.random() < self.reorder:
+                        stream.held = item
+                        stream.reordered += 1
+                    else:
+                        ready.append(item)
+                        if stream.held is not None:
+                            ready.append(stream.held)
+                            stream.held = None
+
+                    if bursting:
+                        self.burst_queue.extend(ready)
+                    else:
+                        for packet in ready:
+                            self._send(*packet)
+                        if ready:
+                            self.lateness_ms.append((time.monotonic() - deadline) * 1000)
+                n += 1
+
+                now = time.monotonic()
+                if now - last_sr >= RtpServer.RTCP_INTERVAL_S:
+                    for stream in self.streams:
+                        self.server.send_sender_report(stream.ssrc, stream.timestamp,
+                                                       stream.packets_sent, stream.octets_sent)
+                    last_sr = now
+                self._poll_reports()
+
+                if now - last_progress >= self.PROGRESS_INTERVAL_S:
+                    sent = sum(s.packets_sent for s in self.streams)
+                    octets = sum(s.octets_sent for s in self.streams)
+                    print(f"{now - start:.0f}s: {sent} packets, "
+                          f"{octets * 8 / (now - start) / 1000:.0f} kbit/s payload")
+                    last_progress = now
+        except KeyboardInterrupt:
+            print("\n\nBenchmark stopped by user")
+
+        self._flush_burst()
+        elapsed = time.monotonic() - start
+        # Late reports for the last packets
+        time.sleep(RtpServer.RTCP_INTERVAL_S)
+        self._poll_reports()
+        return self.summary(elapsed)
+
+    def summary(self, elapsed_s):
+        late = sorted(self.lateness_ms)
+
+        def pct(p):
+            return round(late[min(len(late) - 1, int(len(late) * p))], 3) if late else None
+
+        streams = []
+        for stream in self.streams:
+            rr = stream.last_report
+            streams.append({
+                'ssrc': f"0x{stream.ssrc:08x}",
+                'sent': stream.packets_sent,
+                'dropped': stream.dropped,
+                'reordered': stream.reordered,
+                'payload_octets': stream.octets_sent,
+                'receiver_cumulative_lost': rr['cumulative_lost'] if rr else None,
+                'receiver_jitter_ms': (round(rr['jitter'] * 1000.0 / self.CLOCK_RATE, 2)
+                                       if rr else None),
+                'rtt_ms': round(rr['rtt_ms'], 2) if rr and rr['rtt_ms'] is not None else None,
+            })
+        octets = sum(s.octets_sent for s in self.streams)
+        return {
+            'elapsed_s': round(elapsed_s, 3),
+            'payload_bytes': self.payload_bytes,
+            'rate_pps': round(1 / self.period_s, 3),
+            'payload_kbit_s': round(octets * 8 / elapsed_s / 1000, 1) if elapsed_s else 0,
+            'bursts': self.burst_count,
+            'pacing_late_ms': {'p50': pct(0.5), 'p99': pct(0.99), 'max': pct(1.0)},
+            'streams': streams,
+        }
+
+
+def print_summary(summary):
+    late = summary['pacing_late_ms']
+    print("\nBenchmark complete:")
+    print(f"  Time: {summary['elapsed_s']:.2f} s, {summary['payload_kbit_s']} kbit/s payload, "
+          f"{summary['bursts']} bursts")
+    print(f"  Pacing (send - deadline): p50 {late['p50']} ms, p99 {late['p99']} ms, "
+          f"max {late['max']} ms")
+    for s in summary['streams']:
+        print(f"  {s['ssrc']}: sent {s['sent']}, dropped {s['dropped']}, "
+              f"reordered {s['reordered']} | device: lost {s['receiver_cumulative_lost']}, "
+              f"jitter {s['receiver_jitter_ms']} ms, RTT {s['rtt_ms']} ms")
 
 
 def main():
-    if len(sys.argv) < 2:
-        print("Usage: python3 stream_audio.py <audio_file> [port]")
-        print("\nExample:")
-        print("  python3 stream_audio.py music.mp3 5004")
-        print("\nThen on nRF7002-DK:")
-        print("  uart:~$ wifi connect -s <ssid> -p <password> -k 1")
-        print("  uart:~$ rtp start <this_computer_ip> 5004")
+    parser = argparse.ArgumentParser(
+        description="Stream an audio file, or generated benchmark traffic, over RTP",
+        epilog="Then on the nRF7002-DK: wifi connect -s <ssid> -p <password> -k 1; "
+               "rtp start <this_computer_ip> <port>")
+    parser.add_argument('audio_file', nargs='?', help="File to stream (not with --bench)")
+    parser.add_argument('port', nargs='?', type=int, default=5004)
+    parser.add_argument('--bench', action='store_true',
+                        help="Send a generated tone with pacing, impairments and send timestamps")
+    bench = parser.add_argument_group('benchmark')
+    bench.add_argument('--duration', type=float, default=60, help="Seconds, 0 until Ctrl+C")
+    bench.add_argument('--packet-ms', type=float, default=20,
+                       help="Audio per packet; sets the payload and the rate (default 20)")
+    bench.add_argument('--payload', type=int, help="Payload bytes, overrides --packet-ms")
+    bench.add_argument('--rate', type=float, help="Packets per second per stream, overrides --packet-ms")
+    bench.add_argument('--streams', type=int, default=1, help="SSRCs sent in parallel")
+    bench.add_argument('--loss', type=float, default=0, help="Percent of packets not sent")
+    bench.add_argument('--reorder', type=float, default=0,
+                       help="Percent of packets sent after their successor")
+    bench.add_argument('--burst-every', type=float, default=0,
+                       help="Seconds between bursts, 0 for none")
+    bench.add_argument('--burst-ms', type=int, default=100,
+                       help="Traffic held back per burst (default 100)")
+    bench.add_argument('--seed', type=int, default=1, help="Impairment random seed")
+    bench.add_argument('--no-send-time', action='store_true',
+                       help="Leave out the send-time header extension")
+    bench.add_argument('--json', help="Write the summary to this file")
+    args = parser.parse_args()
+
+    if args.bench:
+        # "--bench 5006" puts the port in the first positional
+        port = int(args.audio_file) if args.audio_file and args.audio_file.isdigit() else args.port
+        samples = int(BenchmarkStreamer.CLOCK_RATE * args.packet_ms / 1000)
+        payload = args.payload if args.payload is not None else samples * 2
+        rate = args.rate if args.rate is not None else 1000.0 / args.packet_ms
+        if payload < 2 or rate <= 0 or args.streams < 1:
+            parser.error("payload, rate and streams must be positive")
+
+        server = RtpServer(port, BenchmarkStreamer.CLOCK_RATE)
+        streamer = BenchmarkStreamer(server, payload, rate, args.streams, args.loss,
+                                     args.reorder, args.burst_every, args.burst_ms,
+                                     args.seed, not args.no_send_time)
+        if streamer.payload_bytes > streamer.max_payload():
+            parser.error(f"payload above {streamer.max_payload()} bytes would fragment")
+        summary = streamer.run(args.duration)
+        if summary is None:
+            sys.exit(1)
+        print_summary(summary)
+        if args.json:
+            summary['args'] = vars(args)
+            Path(args.json).write_text(json.dumps(summary, indent=2) + "\n")
+            print(f"  Summary written to {args.json}")
+        return
+
+    if not args.audio_file:
+        parser.print_help()
         sys.exit(1)
-    
-    audio_file = sys.argv[1]
-    port = int(sys.argv[2]) if len(sys.argv) > 2 else 5004
-    
-    if not Path(audio_file).exists():
-        print(f"Error: Audio file not found: {audio_file}")
+    if AudioSegment is None:
+        print("Error: pydub is not installed")
+        print("Install it with: pip3 install pydub")
         sys.exit(1)
-    
-    server = RtpServer(port)
-    server.stream_audio(audio_file)
+    if not Path(args.audio_file).exists():
+        print(f"Error: Audio file not found: {args.audio_file}")
+        sys.exit(1)
+
+    server = RtpServer(args.port)
+    server.stream_audio(args.audio_file)
 
 
 if __name__ == "__main__":
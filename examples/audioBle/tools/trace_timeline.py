@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+"""
+Turn a 'trace dump' from the device into a per-packet latency timeline
+
+The firmware must be built with CONFIG_AUDIO_LATENCY_TRACE=y. Capture the
+dump from the serial console (the shell prompt and log lines around it are
+ignored):
+
+    uart:~$ trace dump
+
+Usage:
+    python3 trace_timeline.py dump.txt                 # text timeline + summary
+    python3 trace_timeline.py dump.txt --chrome t.json # Chrome/Perfetto trace
+
+The Chrome trace format opens in chrome://tracing or https://ui.perfetto.dev:
+one track per stream, one slice per pipeline stage of every packet.
+"""
+
+import argparse
+import json
+import re
+import sys
+
+POINTS = ["rx", "parse", "jb_in", "jb_out", "decode", "sink"]
+STAGES = ["parse", "enqueue", "jitter buf", "decode", "sink"]
+
+RECORD_RE = re.compile(r"T (\d+) (\d+) (\w+) (\d+) (\d+)")
+HEADER_RE = re.compile(r"cycles_per_sec=(\d+)")
+ANSI_RE = re.compile(r"\x1b\[[0-9;]*[A-Za-z]")
+
+
+def parse_dump(lines):
+    """Return (cycles_per_sec, [(cpu, stream, point, seq, cycles)...])"""
+    hz = None
+    records = []
+    for line in lines:
+        line = ANSI_RE.sub("", line)
+        m = HEADER_RE.search(line)
+        if m:
+            hz = int(m.group(1))
+            continue
+        m = RECORD_RE.search(line)
+        if m and m.group(3) in POINTS:
+            cpu, stream, point, seq, cycles = m.groups()
+            records.append((int(cpu), int(stream), point, int(seq), int(cycles)))
+    return hz, records
+
+
+def build_packets(records, hz):
+    """Group records into packets, times in microseconds from the first record
+
+    The cycle counter is 32 bits and wraps; records are in order per CPU,
+    so each CPU's stamps are unwrapped against the previous one.
+    """
+    last = {}
+    wraps = {}
+    base = None
+    packets = {}
+    order = []
+
+    for cpu, stream, point, seq, cycles in records:
+        if cpu in last and cycles < last[cpu] and last[cpu] - cycles > (1 << 31):
+            wraps[cpu] = wraps.get(cpu, 0) + 1
+        last[cpu] = cycles
+        abs_cycles = cycles + (wraps.get(cpu, 0) << 32)
+        if base is None:
+            base = abs_cycles
+        t_us = (abs_cycles - base) * 1e6 / hz
+
+        key = (stream, seq)
+        pkt = packets.get(key)
+        if point == "rx" and (pkt is None or "jb_in" not in pkt):
+            # New packet (or a retransmitted duplicate before it was stored)
+            pkt = {}
+            packets[key] = pkt
+            order.append((key, pkt))
+        if pkt is None:
+            continue
+        if point in ("rx", "parse") and "jb_in" in pkt:
+            continue  # Duplicate of a buffered packet
+        pkt[point] = t_us
+        if point == "sink":
+            del packets[key]
+
+    return [(key, pkt) for key, pkt in order if pkt]
+
+
+def percentile(values, p):
+    values = sorted(values)
+    return values[(len(values) - 1) * p // 100]
+
+
+def print_timeline(packets, limit):
+    print("%-6s %-6s %12s %s" % ("stream", "seq", "rx (ms)",
+                                  "  ".join("%9s" % p for p in POINTS[1:])))
+    for (stream, seq), pkt in packets[:limit]:
+        if "rx" not in pkt:
+            continue
+        rx = pkt["rx"]
+        cols = []
+        for point in POINTS[1:]:
+            cols.append("%9.1f" % (pkt[point] - rx) if point in pkt else "%9s" % "-")
+        print("%-6u %-6u %12.3f %s" % (stream, seq, rx / 1000, "  ".join(cols)))
+    if len(packets) > limit:
+        print("... %u more packets (use --limit)" % (len(packets) - limit))
+    print("(columns: microseconds after rx)")
+
+
+def print_summary(packets):
+    complete = [pkt for _, pkt in packets if all(p in pkt for p in POINTS)]
+    print()
+    print("%u packets, %u complete" % (len(packets), len(complete)))
+    if not complete:
+        return
+    print("%-11s %10s %10s %10s" % ("stage", "p50 us", "p99 us", "max us"))
+    for i, stage in enumerate(STAGES + ["total"]):
+        if stage == "total":
+            values = [pkt["sink"] - pkt["rx"] for pkt in complete]
+        else:
+            values = [pkt[POINTS[i + 1]] - pkt[POINTS[i]] for pkt in complete]
+        print("%-11s %10.1f %10.1f %10.1f" % (stage, percentile(values, 50),
+                                             percentile(values, 99), max(values)))
+
+
+def write_chrome(packets, path):
+    events = []
+    for (stream, seq), pkt in packets:
+        for i, stage in enumerate(STAGES):
+            start, end = POINTS[i], POINTS[i + 1]
+            if start in pkt and end in pkt:
+                events.append({
+                    "name": stage,
+                    "cat": "audio",
+                    "ph": "X",
+                    "ts": pkt[start],
+                    "dur": pkt[end] - pkt[start],
+                    "pid": 1,
+                    "tid": stream,
+                    "args": {"seq": seq},
+                })
+    meta = [{"name": "thread_name", "ph": "M", "pid": 1, "tid": s,
+             "args": {"name": "stream %u" % s}}
+            for s in sorted({stream for (stream, _), _ in packets})]
+    with open(path, "w") as f:
+        json.dump({"traceEvents": meta + events, "displayTimeUnit": "ms"}, f)
+    print("Wrote %u slices to %s" % (len(events), path))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("dump", help="captured 'trace dump' output, - for stdin")
+    parser.add_argument("--chrome", metavar="JSON", help="write a Chrome trace event file")
+    parser.add_argument("--limit", type=int, default=50, help="packets in the text timeline")
+    parser.add_argument("--hz", type=int, help="cycle counter rate, if the header is missing")
+    args = parser.parse_args()
+
+    if args.dump == "-":
+        lines = sys.stdin.readlines()
+    else:
+        with open(args.dump, errors="replace") as f:
+            lines = f.readlines()
+
+    hz, records = parse_dump(lines)
+    hz = args.hz or hz
+    if not records:
+        print("Error: no trace records found")
+        sys.exit(1)
+    if not hz:
+        print("Error: no cycles_per_sec header, pass --hz")
+        sys.exit(1)
+
+    packets = build_packets(records, hz)
+    print_timeline(packets, args.limit)
+    print_summary(packets)
+    if args.chrome:
+        write_chrome(packets, args.chrome)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,405 @@
+/* ble_periph.c - Event-driven connectable peripheral
+ *
+ * One thread owns advertising, the connection state, the status LED and
+ * the notification schedule. Everything that can change them posts a bit
+ * to periph_events; the thread sleeps in k_event_wait() until one arrives
+ * or the next periodic notification is due, so an idle peripheral does
+ * not wake at all.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/sys/util.h>
+
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/hci.h>
+#include <zephyr/bluetooth/conn.h>
+
+#include "ble_periph.h"
+
+#define EVT_CONNECTED  BIT(0)
+#define EVT_RELEASED   BIT(1) /* Connection object free: advertise again */
+#define EVT_ADV_UPDATE BIT(2)
+#define EVT_NOTIFY     BIT(3) /* Notifier kicked, enabled, or link changed */
+#define EVT_ALL        (EVT_CONNECTED | EVT_RELEASED | EVT_ADV_UPDATE | EVT_NOTIFY)
+
+/* ble_notifier.flags */
+#define NOTIFIER_ENABLED   0
+#define NOTIFIER_KICKED    1
+#define NOTIFIER_SCHEDULED 2
+
+static K_EVENT_DEFINE(periph_events);
+static K_THREAD_STACK_DEFINE(periph_stack, CONFIG_BLE_PERIPH_STACK_SIZE);
+static struct k_thread periph_thread_data;
+
+static const struct ble_periph_config *config;
+static sys_slist_t notifiers = SYS_SLIST_STATIC_INIT(&notifiers);
+static atomic_t conn_count;
+
+/* Peripheral thread only, once ble_periph_start() has returned */
+static bool advertising;
+#if defined(CONFIG_BT_EXT_ADV)
+static struct bt_le_ext_adv *adv;
+#endif
+
+/* ---------- Status LED: blinks while advertising, on while connected ---------- */
+
+#if defined(CONFIG_BLE_PERIPH_LED) && DT_NODE_HAS_STATUS_OKAY(DT_ALIAS(led0))
+#include <zephyr/drivers/gpio.h>
+static const struct gpio_dt_spec led = GPIO_DT_SPEC_GET(DT_ALIAS(led0), gpios);
+#define BLINK_ONOFF K_MSEC(500)
+
+static struct k_work_delayable blink_work;
+static bool                  led_ready;
+static bool                  led_is_on;
+
+static void blink_timeout(struct k_work *work)
+{
+	led_is_on = !led_is_on;
+	gpio_pin_set_dt(&led, (int)led_is_on);
+
+	k_work_schedule(&blink_work, BLINK_ONOFF);
+}
+
+static void led_setup(void)
+{
+	if (!gpio_is_ready_dt(&led) || gpio_pin_configure_dt(&led, GPIO_OUTPUT_INACTIVE)) {
+		printk("LED not available\n");
+		return;
+	}
+
+	k_work_init_delayable(&blink_work, blink_timeout);
+	led_ready = true;
+}
+
+static void led_blink(bool blink)
+{
+	struct k_work_sync work_sync;
+
+	if (!led_ready) {
+		return;
+	}
+
+	if (blink) {
+		k_work_schedule(&blink_work, K_NO_WAIT);
+	} else {
+		k_work_cancel_delayable_sync(&blink_work, &work_sync);
+		led_is_on = true;
+		gpio_pin_set_dt(&led, (int)led_is_on);
+	}
+}
+#else
+static void led_setup(void) {}
+static void led_blink(bool blink) { ARG_UNUSED(blink); }
+#endif /* CONFIG_BLE_PERIPH_LED */
+
+/* ---------- Advertising ---------- */
+
+static int adv_create(void)
+{
+#if defined(CONFIG_BT_EXT_ADV)
+	struct bt_le_adv_param adv_param = {
+		.id = BT_ID_DEFAULT,
+		.sid = 0U,
+		.secondary_max_skip = 0U,
+		.options = (BT_LE_ADV_OPT_EXT_ADV |
+			    BT_LE_ADV_OPT_CONNECTABLE |
+			    BT_LE_ADV_OPT_CODED),
+		.interval_min = BT_GAP_ADV_FAST_INT_MIN_2,
+		.interval_max = BT_GAP_ADV_FAST_INT_MAX_2,
+		.peer = NULL,
+	};
+	int err;
+
+	printk("Creating a Coded PHY connectable non-scannable advertising set\n");
+	err = bt_le_ext_adv_create(&adv_param, NULL, &adv);
+	if (err) {
+		printk("Failed to create Coded PHY extended advertising set (err %d)\n", err);
+
+		printk("Creating a non-Coded PHY connectable non-scannable advertising set\n");
+		adv_param.options &= ~BT_LE_ADV_OPT_CODED;
+		err = bt_le_ext_adv_create(&adv_param, NULL, &adv);
+		if (err) {
+			printk("Failed to create extended advertising set (err %d)\n", err);
+			return err;
+		}
+	}
+
+	err = bt_le_ext_adv_set_data(adv, config->ad, config->ad_len, NULL, 0);
+	if (err) {
+		printk("Failed to set extended advertising data (err %d)\n", err);
+		return err;
+	}
+#endif /* CONFIG_BT_EXT_ADV */
+
+	return 0;
+}
+
+static int adv_start(void)
+{
+	int err;
+
+#if !defined(CONFIG_BT_EXT_ADV)
+	printk("Starting Legacy Advertising (connectable and scannable)\n");
+	err = bt_le_adv_start(BT_LE_ADV_CONN_ONE_TIME, config->ad, config->ad_len,
+			      config->sd, config->sd_len);
+#else
+	printk("Starting Extended Advertising (connectable and non-scannable)\n");
+	err = bt_le_ext_adv_start(adv, BT_LE_EXT_ADV_START_DEFAULT);
+#endif /* CONFIG_BT_EXT_ADV */
+	if (err && err != -EALREADY) {
+		/* No free connection object yet: the next release retries */
+		printk("Advertising failed to start (err %d)\n", err);
+		return err;
+	}
+
+	advertising = true;
+	led_blink(true);
+
+	return 0;
+}
+
+static void adv_set_data(void)
+{
+	int err;
+
+#if !defined(CONFIG_BT_EXT_ADV)
+	/* A stopped legacy advertiser takes the data at the next start */
+	if (!advertising) {
+		return;
+	}
+	err = bt_le_adv_update_data(config->ad, config->ad_len, config->sd, config->sd_len);
+#else
+	/* A stopped set keeps it for the next start */
+	err = bt_le_ext_adv_set_data(adv, config->ad, config->ad_len, NULL, 0);
+#endif /* CONFIG_BT_EXT_ADV */
+	if (err) {
+		printk("Advertising data update failed (err %d)\n", err);
+	}
+}
+
+/* ---------- Notifiers ---------- */
+
+static bool notifier_active(struct ble_notifier *n)
+{
+	return atomic_test_bit(&n->flags, NOTIFIER_ENABLED) && atomic_get(&conn_count) > 0;
+}
+
+/* Send what is due and return how long to sleep until the next period */
+static k_timeout_t notifiers_run(void)
+{
+	struct ble_notifier *n;
+	int64_t now = k_uptime_get();
+	int64_t next = INT64_MAX;
+	bool send;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&notifiers, n, node) {
+		send = atomic_test_and_clear_bit(&n->flags, NOTIFIER_KICKED);
+
+		if (!notifier_active(n)) {
+			atomic_clear_bit(&n->flags, NOTIFIER_SCHEDULED);
+			continue;
+		}
+
+		if (n->period_ms) {
+			if (!atomic_test_and_set_bit(&n->flags, NOTIFIER_SCHEDULED)) {
+				/* Just enabled: first value one period from now */
+				n->due_ms = now + n->period_ms;
+			} else if (now >= n->due_ms) {
+				send = true;
+				n->due_ms += n->period_ms;
+				if (n->due_ms <= now) {
+					/* Fell behind: skip, do not burst */
+					n->due_ms = now + n->period_ms;
+				}
+			}
+			next = MIN(next, n->due_ms);
+		}
+
+		if (send) {
+			n->send(n);
+		}
+	}
+
+	return next == INT64_MAX ? K_FOREVER : K_TIMEOUT_ABS_MS(next);
+}
+
+void ble_notifier_register(struct ble_notifier *n)
+{
+	sys_slist_append(&notifiers, &n->node);
+}
+
+void ble_notifier_enable(struct ble_notifier *n, bool enable)
+{
+	if (enable) {
+		atomic_set_bit(&n->flags, NOTIFIER_ENABLED);
+	} else {
+		atomic_clear_bit(&n->flags, NOTIFIER_ENABLED);
+	}
+	k_event_post(&periph_events, EVT_NOTIFY);
+}
+
+void ble_notifier_kick(struct ble_notifier *n)
+{
+	atomic_set_bit(&n->flags, NOTIFIER_KICKED);
+	k_event_post(&periph_events, EVT_NOTIFY);
+}
+
+void ble_periph_adv_update(void)
+{
+	k_event_post(&periph_events, EVT_ADV_UPDATE);
+}
+
+/* ---------- Connection callbacks ---------- */
+
+/* Connection parameters come from the host, which requests the
+ * BT_PERIPHERAL_PREF_* set a few seconds after connecting. For the PHY,
+ * a link made on Coded PHY stays there for range, any other moves to 2M;
+ * with BT_AUTO_PHY_UPDATE the host already asks for 2M itself.
+ */
+static void link_setup(struct bt_conn *conn)
+{
+#if defined(CONFIG_BT_USER_PHY_UPDATE) && !defined(CONFIG_BT_AUTO_PHY_UPDATE)
+	struct bt_conn_info info;
+	int err;
+
+	err = bt_conn_get_info(conn, &info);
+	if (err || info.le.phy->rx_phy == BT_GAP_LE_PHY_CODED) {
+		return;
+	}
+
+	err = bt_conn_le_phy_update(conn, BT_CONN_LE_PHY_PARAM_2M);
+	if (err) {
+		printk("PHY update failed (err %d)\n", err);
+	}
+#else
+	ARG_UNUSED(conn);
+#endif
+}
+
+static void connected(struct bt_conn *conn, uint8_t err)
+{
+	if (err) {
+		printk("Connection failed, err 0x%02x %s\n", err, bt_hci_err_to_str(err));
+		/* Advertising has stopped: start it again */
+		k_event_post(&periph_events, EVT_CONNECTED | EVT_RELEASED);
+		return;
+	}
+
+	printk("Connected\n");
+
+	atomic_inc(&conn_count);
+	link_setup(conn);
+	if (config && config->connected) {
+		config->connected(conn);
+	}
+
+	k_event_post(&periph_events, EVT_CONNECTED | EVT_NOTIFY);
+}
+
+static void disconnected(struct bt_conn *conn, uint8_t reason)
+{
+	printk("Disconnected, reason 0x%02x %s\n", reason, bt_hci_err_to_str(reason));
+
+	atomic_dec(&conn_count);
+	if (config && config->disconnected) {
+		config->disconnected(conn, reason);
+	}
+
+	k_event_post(&periph_events, EVT_NOTIFY);
+}
+
+/* Advertising cannot restart before the connection object is released */
+static void recycled(void)
+{
+	k_event_post(&periph_events, EVT_RELEASED);
+}
+
+static void le_param_updated(struct bt_conn *conn, uint16_t interval, uint16_t latency,
+			     uint16_t timeout)
+{
+	printk("Connection parameters: interval %u us, latency %u, timeout %u ms\n",
+	       BT_CONN_INTERVAL_TO_US(interval), latency, timeout * 10U);
+}
+
+#if defined(CONFIG_BT_USER_PHY_UPDATE)
+static void le_phy_updated(struct bt_conn *conn, struct bt_conn_le_phy_info *param)
+{
+	printk("PHY updated: tx %u, rx %u\n", param->tx_phy, param->rx_phy);
+}
+#endif /* CONFIG_BT_USER_PHY_UPDATE */
+
+BT_CONN_CB_DEFINE(ble_periph_conn_callbacks) = {
+	.connected = connected,
+	.disconnected = disconnected,
+	.recycled = recycled,
+	.le_param_updated = le_param_updated,
+#if defined(CONFIG_BT_USER_PHY_UPDATE)
+	.le_phy_updated = le_phy_updated,
+#endif /* CONFIG_BT_USER_PHY_UPDATE */
+};
+
+/* ---------- Peripheral thread ---------- */
+
+static void periph_thread(void *p1, void *p2, void *p3)
+{
+	k_timeout_t timeout = K_FOREVER;
+	uint32_t events;
+
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	for (;;) {
+		events = k_event_wait(&periph_events, EVT_ALL, false, timeout);
+		k_event_clear(&periph_events, events);
+
+		if (events & EVT_CONNECTED) {
+			/* Connectable advertising stops on connection */
+			advertising = false;
+			led_blink(false);
+		}
+
+		if ((events & EVT_RELEASED) && !advertising) {
+			(void)adv_start();
+		}
+
+		if (events & EVT_ADV_UPDATE) {
+			adv_set_data();
+		}
+
+		timeout = notifiers_run();
+	}
+}
+
+int ble_periph_start(const struct ble_periph_config *cfg)
+{
+	int err;
+
+	config = cfg;
+
+	led_setup();
+
+	err = adv_create();
+	if (err) {
+		return err;
+	}
+
+	err = adv_start();
+	if (err) {
+		return err;
+	}
+
+	printk("Advertising successfully started\n");
+
+	k_thread_create(&periph_thread_data, periph_stack, K_THREAD_STACK_SIZEOF(periph_stack),
+			periph_thread, NULL, NULL, NULL,
+			K_PRIO_PREEMPT(CONFIG_BLE_PERIPH_THREAD_PRIO), 0, K_NO_WAIT);
+	k_thread_name_set(&periph_thread_data, "ble_periph");
+
+	return 0;
+}
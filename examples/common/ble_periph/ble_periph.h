@@ -0,0 +1,86 @@
+/* ble_periph.h - Event-driven connectable peripheral
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef BLE_PERIPH_H_
+#define BLE_PERIPH_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/slist.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+
+/* What the application advertises, and optional connection hooks. The
+ * hooks run in the Bluetooth thread, like the bt_conn_cb callbacks.
+ */
+struct ble_periph_config {
+	const struct bt_data *ad;
+	size_t ad_len;
+	/* Scan response, legacy advertising only */
+	const struct bt_data *sd;
+	size_t sd_len;
+	void (*connected)(struct bt_conn *conn);
+	void (*disconnected)(struct bt_conn *conn, uint8_t reason);
+};
+
+/* Start advertising and the peripheral thread. Call after bt_enable()
+ * and after registering the notifiers; the caller may then return from
+ * main(). The thread sleeps until something happens:
+ *
+ * - connection and disconnection: advertising restarts as soon as the
+ *   connection object is released, the LED follows the state;
+ * - ble_periph_adv_update(): the advertising data is set again;
+ * - notifiers: each one is sent when kicked or when its period is due,
+ *   while it is enabled and a central is connected.
+ *
+ * cfg must stay valid; the data it points to may change, see
+ * ble_periph_adv_update().
+ */
+int ble_periph_start(const struct ble_periph_config *cfg);
+
+/* The application changed the data behind cfg->ad (or cfg->sd): set it
+ * again. Any thread; the update itself runs in the peripheral thread.
+ */
+void ble_periph_adv_update(void);
+
+struct ble_notifier;
+
+/* Send the characteristic: bt_gatt_notify() or a service's own notify
+ * helper. Runs in the peripheral thread.
+ */
+typedef void (*ble_notifier_send_t)(struct ble_notifier *n);
+
+/* Notification schedule of one characteristic */
+struct ble_notifier {
+	ble_notifier_send_t send;
+	/* Send every period_ms while active; 0 sends only when kicked */
+	uint32_t period_ms;
+	/* Private */
+	sys_snode_t node;
+	atomic_t flags;
+	int64_t due_ms;
+};
+
+#define BLE_NOTIFIER_INIT(_send, _period_ms) \
+	{ .send = (_send), .period_ms = (_period_ms) }
+
+/* Add a notifier; call before ble_periph_start() */
+void ble_notifier_register(struct ble_notifier *n);
+
+/* Typically from the CCC changed callback. A disabled notifier is never
+ * sent and costs no wakeups. Any thread.
+ */
+void ble_notifier_enable(struct ble_notifier *n, bool enable);
+
+/* The value changed: send it as soon as possible. Kicks while the
+ * notifier is inactive are dropped. Any thread.
+ */
+void ble_notifier_kick(struct ble_notifier *n);
+
+#endif /* BLE_PERIPH_H_ */
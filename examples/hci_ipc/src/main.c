@@ -24,6 +24,10 @@
 #include <zephyr/bluetooth/hci_raw.h>
 #include <zephyr/bluetooth/hci_vs.h>
 
+#if defined(CONFIG_HCI_IPC_TIMING)
+#include <zephyr/timing/timing.h>
+#endif /* CONFIG_HCI_IPC_TIMING */
+
 #include <zephyr/logging/log_ctrl.h>
 #include <zephyr/logging/log.h>
 
@@ -35,6 +39,8 @@ static K_THREAD_STACK_DEFINE(tx_thread_stack, CONFIG_BT_HCI_TX_STACK_SIZE);
 static struct k_thread tx_thread_data;
 static K_FIFO_DEFINE(tx_queue);
 static K_SEM_DEFINE(ipc_bound_sem, 0, 1);
+/* incoming events and data from the controller */
+static K_FIFO_DEFINE(rx_queue);
 #if defined(CONFIG_BT_CTLR_ASSERT_HANDLER) || defined(CONFIG_BT_HCI_VS_FATAL_ERROR)
 /* A flag used to store information if the IPC endpoint has already been bound. The end point can't
  * be used before that happens.
@@ -47,155 +53,310 @@ static bool ipc_ept_ready;
 #define HCI_IPC_SCO 0x03
 #define HCI_IPC_EVT 0x04
 #define HCI_IPC_ISO 0x05
+#define HCI_IPC_BATCH 0xf0 /* Coalesced H:4 packets, see CONFIG_HCI_IPC_COALESCE */
 
 #define HCI_FATAL_ERR_MSG true
 #define HCI_REGULAR_MSG false
 
-static struct net_buf *hci_ipc_cmd_recv(uint8_t *data, size_t remaining)
+/* Vendor commands answered by this sample rather than the controller, no
+ * parameters; they return the structs below.
+ */
+#define HCI_IPC_OP_VS_READ_QUEUE_STATS BT_OP(BT_OGF_VS, 0x03f0)
+#define HCI_IPC_OP_VS_READ_PKT_STATS   BT_OP(BT_OGF_VS, 0x03f1)
+
+struct hci_ipc_rp_vs_read_queue_stats {
+	uint8_t  status;
+	uint16_t evt_depth;
+	uint16_t iso_depth;
+	uint16_t acl_depth;
+	uint16_t evt_max;
+	uint16_t iso_max;
+	uint16_t acl_max;
+	uint32_t iso_expired;
+	uint32_t iso_overflow;
+	uint32_t stalls;
+} __packed;
+
+struct hci_ipc_rp_vs_read_pkt_stats {
+	uint8_t  status;
+	uint32_t rx_msgs;
+	uint32_t rx_cmd;
+	uint32_t rx_acl;
+	uint32_t rx_iso;
+	uint32_t rx_held;
+	uint32_t rx_short;
+	uint32_t rx_bad_len;
+	uint32_t rx_no_buf;
+	uint32_t rx_unknown;
+	uint32_t tx_msgs;
+	uint32_t tx_pkts;
+	uint32_t cmd_ns;
+	uint32_t acl_ns;
+	uint32_t iso_ns;
+} __packed;
+
+/* Per-packet counters, in place of per-packet logging */
+static struct {
+	uint32_t rx_msgs;
+	uint32_t rx_pkts[HCI_IPC_ISO + 1];
+	uint32_t rx_held;
+	uint32_t rx_short;
+	uint32_t rx_bad_len;
+	uint32_t rx_no_buf;
+	uint32_t rx_unknown;
+	uint32_t tx_msgs;
+	uint32_t tx_pkts;
+#if defined(CONFIG_HCI_IPC_TIMING)
+	uint64_t rx_cycles[HCI_IPC_ISO + 1];
+#endif /* CONFIG_HCI_IPC_TIMING */
+} pkt_stats;
+
+/* Count a dropped packet; the message costs nothing when logging is off */
+#define HCI_IPC_DROP(_counter, ...)							\
+	do {										\
+		pkt_stats._counter++;							\
+		LOG_ERR(__VA_ARGS__);							\
+	} while (0)
+
+static bool hci_ipc_vs_cmd(const uint8_t *data, size_t len);
+
+#if defined(CONFIG_HCI_IPC_NOCOPY)
+/* Set when the backend cannot hold or lend its buffers; copy from then on */
+static bool nocopy_rx_off;
+static bool nocopy_tx_off;
+
+/* Start of the held IPC message behind each buffer of held_pool */
+static void *held_msg[CONFIG_HCI_IPC_NOCOPY_RX_COUNT];
+
+static void hci_ipc_held_destroy(struct net_buf *buf)
 {
-	struct bt_hci_cmd_hdr *hdr = (void *)data;
-	struct net_buf *buf;
+	void **msg = &held_msg[net_buf_id(buf)];
 
-	if (remaining < sizeof(*hdr)) {
-		LOG_ERR("Not enough data for command header");
-		return NULL;
+	if (*msg) {
+		ipc_service_release_rx_buffer(&hci_ept, *msg);
+		*msg = NULL;
 	}
+	net_buf_destroy(buf);
+}
 
-	buf = bt_buf_get_tx(BT_BUF_CMD, K_NO_WAIT, hdr, sizeof(*hdr));
-	if (buf) {
-		data += sizeof(*hdr);
-		remaining -= sizeof(*hdr);
-	} else {
-		LOG_ERR("No available command buffers!");
+/* Buffers without data of their own, pointing into held IPC messages */
+NET_BUF_POOL_FIXED_DEFINE(held_pool, CONFIG_HCI_IPC_NOCOPY_RX_COUNT, 0, BT_BUF_USER_DATA_MIN,
+			  hci_ipc_held_destroy);
+#endif /* CONFIG_HCI_IPC_NOCOPY */
+
+/* Wrap the received message that data (just past the indicator) belongs to
+ * in a net_buf instead of copying it. The message stays in shared memory
+ * until the controller is done with the buffer. Returns NULL to copy.
+ */
+static struct net_buf *hci_ipc_hold(uint8_t *data, size_t remaining, enum bt_buf_type type)
+{
+#if defined(CONFIG_HCI_IPC_NOCOPY)
+	uint8_t *msg = data - 1;
+	struct net_buf *buf;
+	int err;
+
+	if (nocopy_rx_off) {
 		return NULL;
 	}
 
-	if (remaining != hdr->param_len) {
-		LOG_ERR("Command payload length is not correct");
-		net_buf_unref(buf);
+	buf = net_buf_alloc_with_data(&held_pool, msg, remaining + 1, K_NO_WAIT);
+	if (!buf) {
 		return NULL;
 	}
 
-	if (remaining > net_buf_tailroom(buf)) {
-		LOG_ERR("Not enough space in buffer");
+	err = ipc_service_hold_rx_buffer(&hci_ept, msg);
+	if (err) {
+		LOG_WRN("IPC backend cannot hold buffers (%d), copying", err);
+		nocopy_rx_off = true;
 		net_buf_unref(buf);
 		return NULL;
 	}
 
-	LOG_DBG("len %u", hdr->param_len);
-	net_buf_add_mem(buf, data, remaining);
+	held_msg[net_buf_id(buf)] = msg;
+	net_buf_pull(buf, 1);
+	bt_buf_set_type(buf, type);
 
 	return buf;
+#else
+	return NULL;
+#endif /* CONFIG_HCI_IPC_NOCOPY */
 }
 
-static struct net_buf *hci_ipc_acl_recv(uint8_t *data, size_t remaining)
-{
-	struct bt_hci_acl_hdr *hdr = (void *)data;
-	struct net_buf *buf;
-
-	if (remaining < sizeof(*hdr)) {
-		LOG_ERR("Not enough data for ACL header");
-		return NULL;
+/* Define the receive handler hci_ipc_<name>_recv() and payload length reader
+ * hci_ipc_<name>_len() of one H:4 packet type. Header type, length expression
+ * and buffer type are compile-time constants, so each handler is specialised
+ * for its type instead of branching on it per packet. hdr in _payload_len is
+ * the packet header. Every failure is counted and logged only if logging is
+ * enabled.
+ */
+#define HCI_IPC_HANDLER_DEFINE(_name, _hdr_type, _payload_len, _buf_type, _holdable)	\
+	static size_t hci_ipc_##_name##_len(const uint8_t *data)				\
+	{											\
+		const _hdr_type *hdr = (const void *)data;					\
+												\
+		return _payload_len;								\
+	}											\
+												\
+	static struct net_buf *hci_ipc_##_name##_recv(uint8_t *data, size_t remaining,	\
+						      bool hold)				\
+	{											\
+		struct net_buf *buf;								\
+												\
+		if (remaining < sizeof(_hdr_type)) {						\
+			HCI_IPC_DROP(rx_short, "Not enough data for " #_name " header");	\
+			return NULL;								\
+		}										\
+		remaining -= sizeof(_hdr_type);							\
+												\
+		if (remaining != hci_ipc_##_name##_len(data)) {					\
+			HCI_IPC_DROP(rx_bad_len, #_name " payload length is not correct");	\
+			return NULL;								\
+		}										\
+												\
+		/* The controller checks the length against its own limits as it	\
+		 * copies the payload out of a held message.				\
+		 */									\
+		if ((_holdable) && hold) {							\
+			buf = hci_ipc_hold(data, sizeof(_hdr_type) + remaining, _buf_type);	\
+			if (buf) {								\
+				pkt_stats.rx_held++;						\
+				return buf;							\
+			}									\
+		}										\
+												\
+		buf = bt_buf_get_tx(_buf_type, K_NO_WAIT, data, sizeof(_hdr_type));		\
+		if (!buf) {									\
+			HCI_IPC_DROP(rx_no_buf, "No available " #_name " buffers!");		\
+			return NULL;								\
+		}										\
+												\
+		if (remaining > net_buf_tailroom(buf)) {					\
+			HCI_IPC_DROP(rx_bad_len, "Not enough space in buffer");			\
+			net_buf_unref(buf);							\
+			return NULL;								\
+		}										\
+												\
+		net_buf_add_mem(buf, data + sizeof(_hdr_type), remaining);			\
+												\
+		return buf;									\
 	}
 
-	buf = bt_buf_get_tx(BT_BUF_ACL_OUT, K_NO_WAIT, hdr, sizeof(*hdr));
-	if (buf) {
-		data += sizeof(*hdr);
-		remaining -= sizeof(*hdr);
-	} else {
-		LOG_ERR("No available ACL buffers!");
-		return NULL;
-	}
+HCI_IPC_HANDLER_DEFINE(cmd, struct bt_hci_cmd_hdr, hdr->param_len, BT_BUF_CMD, false)
+HCI_IPC_HANDLER_DEFINE(acl, struct bt_hci_acl_hdr, sys_le16_to_cpu(hdr->len), BT_BUF_ACL_OUT, true)
+HCI_IPC_HANDLER_DEFINE(iso, struct bt_hci_iso_hdr, bt_iso_hdr_len(sys_le16_to_cpu(hdr->len)),
+		       BT_BUF_ISO_OUT, true)
 
-	if (remaining != sys_le16_to_cpu(hdr->len)) {
-		LOG_ERR("ACL payload length is not correct");
-		net_buf_unref(buf);
-		return NULL;
-	}
+struct hci_ipc_handler {
+	struct net_buf *(*recv)(uint8_t *data, size_t remaining, bool hold);
+	size_t (*len)(const uint8_t *data);
+	uint8_t hdr_len;
+};
 
-	if (remaining > net_buf_tailroom(buf)) {
-		LOG_ERR("Not enough space in buffer");
-		net_buf_unref(buf);
+/* Indexed by H:4 indicator; host-to-controller types only */
+static const struct hci_ipc_handler hci_ipc_handlers[] = {
+	[HCI_IPC_CMD] = { hci_ipc_cmd_recv, hci_ipc_cmd_len, sizeof(struct bt_hci_cmd_hdr) },
+	[HCI_IPC_ACL] = { hci_ipc_acl_recv, hci_ipc_acl_len, sizeof(struct bt_hci_acl_hdr) },
+	[HCI_IPC_ISO] = { hci_ipc_iso_recv, hci_ipc_iso_len, sizeof(struct bt_hci_iso_hdr) },
+};
+
+static const struct hci_ipc_handler *hci_ipc_handler_get(uint8_t pkt_indicator)
+{
+	if (pkt_indicator >= ARRAY_SIZE(hci_ipc_handlers) ||
+	    !hci_ipc_handlers[pkt_indicator].recv) {
 		return NULL;
 	}
 
-	LOG_DBG("len %u", remaining);
-	net_buf_add_mem(buf, data, remaining);
-
-	return buf;
+	return &hci_ipc_handlers[pkt_indicator];
 }
 
-static struct net_buf *hci_ipc_iso_recv(uint8_t *data, size_t remaining)
+/* hold: data is a whole IPC message, which may be kept instead of copied */
+static void hci_ipc_rx_packet(uint8_t *data, size_t len, bool hold)
 {
-	struct bt_hci_iso_hdr *hdr = (void *)data;
+	const struct hci_ipc_handler *handler;
+	uint8_t pkt_indicator;
 	struct net_buf *buf;
+#if defined(CONFIG_HCI_IPC_TIMING)
+	timing_t start = timing_counter_get();
+	timing_t end;
+#endif /* CONFIG_HCI_IPC_TIMING */
 
-	if (remaining < sizeof(*hdr)) {
-		LOG_ERR("Not enough data for ISO header");
-		return NULL;
-	}
+	pkt_indicator = *data++;
+	len -= sizeof(pkt_indicator);
 
-	buf = bt_buf_get_tx(BT_BUF_ISO_OUT, K_NO_WAIT, hdr, sizeof(*hdr));
-	if (buf) {
-		data += sizeof(*hdr);
-		remaining -= sizeof(*hdr);
-	} else {
-		LOG_ERR("No available ISO buffers!");
-		return NULL;
+	handler = hci_ipc_handler_get(pkt_indicator);
+	if (!handler) {
+		HCI_IPC_DROP(rx_unknown, "Unknown HCI type %u", pkt_indicator);
+		return;
 	}
+	pkt_stats.rx_pkts[pkt_indicator]++;
 
-	if (remaining != bt_iso_hdr_len(sys_le16_to_cpu(hdr->len))) {
-		LOG_ERR("ISO payload length is not correct");
-		net_buf_unref(buf);
-		return NULL;
+	if (pkt_indicator == HCI_IPC_CMD && hci_ipc_vs_cmd(data, len)) {
+		return;
 	}
 
-	if (remaining > net_buf_tailroom(buf)) {
-		LOG_ERR("Not enough space in buffer");
-		net_buf_unref(buf);
-		return NULL;
-	}
+	buf = handler->recv(data, len, hold);
+	if (buf) {
+		k_fifo_put(&tx_queue, buf);
 
-	LOG_DBG("len %zu", remaining);
-	net_buf_add_mem(buf, data, remaining);
+		LOG_HEXDUMP_DBG(buf->data, buf->len, "Final net buffer:");
+	}
 
-	return buf;
+#if defined(CONFIG_HCI_IPC_TIMING)
+	end = timing_counter_get();
+	pkt_stats.rx_cycles[pkt_indicator] += timing_cycles_get(&start, &end);
+#endif /* CONFIG_HCI_IPC_TIMING */
 }
 
-static void hci_ipc_rx(uint8_t *data, size_t len)
+#if defined(CONFIG_HCI_IPC_COALESCE)
+/* Length of the H:4 packet at data, indicator included; 0 if it is cut short */
+static size_t hci_ipc_pkt_len(const uint8_t *data, size_t remaining)
 {
-	uint8_t pkt_indicator;
-	struct net_buf *buf = NULL;
-	size_t remaining = len;
+	const struct hci_ipc_handler *handler = hci_ipc_handler_get(data[0]);
 
-	LOG_HEXDUMP_DBG(data, len, "IPC data:");
+	if (!handler || remaining < 1U + handler->hdr_len) {
+		return 0;
+	}
 
-	pkt_indicator = *data++;
-	remaining -= sizeof(pkt_indicator);
+	return 1 + handler->hdr_len + handler->len(data + 1);
+}
 
-	switch (pkt_indicator) {
-	case HCI_IPC_CMD:
-		buf = hci_ipc_cmd_recv(data, remaining);
-		break;
+static void hci_ipc_rx_batch(uint8_t *data, size_t len)
+{
+	while (len > 0) {
+		size_t pkt_len = hci_ipc_pkt_len(data, len);
 
-	case HCI_IPC_ACL:
-		buf = hci_ipc_acl_recv(data, remaining);
-		break;
+		if (pkt_len == 0 || pkt_len > len) {
+			HCI_IPC_DROP(rx_bad_len, "Malformed coalesced message, %zu bytes dropped",
+				     len);
+			return;
+		}
 
-	case HCI_IPC_ISO:
-		buf = hci_ipc_iso_recv(data, remaining);
-		break;
+		hci_ipc_rx_packet(data, pkt_len, false);
+		data += pkt_len;
+		len -= pkt_len;
+	}
+}
+#endif /* CONFIG_HCI_IPC_COALESCE */
 
-	default:
-		LOG_ERR("Unknown HCI type %u", pkt_indicator);
+static void hci_ipc_rx(uint8_t *data, size_t len)
+{
+	LOG_HEXDUMP_DBG(data, len, "IPC data:");
+
+	pkt_stats.rx_msgs++;
+
+	if (len == 0) {
+		HCI_IPC_DROP(rx_short, "Empty IPC message");
 		return;
 	}
 
-	if (buf) {
-		k_fifo_put(&tx_queue, buf);
-
-		LOG_HEXDUMP_DBG(buf->data, buf->len, "Final net buffer:");
+#if defined(CONFIG_HCI_IPC_COALESCE)
+	if (data[0] == HCI_IPC_BATCH) {
+		hci_ipc_rx_batch(data + 1, len - 1);
+		return;
 	}
+#endif /* CONFIG_HCI_IPC_COALESCE */
+
+	hci_ipc_rx_packet(data, len, true);
 }
 
 static void tx_thread(void *p1, void *p2, void *p3)
@@ -214,12 +375,35 @@ static void tx_thread(void *p1, void *p2, void *p3)
 		}
 
 		/* Give other threads a chance to run if tx_queue keeps getting
-		 * new data all the time.
+		 * new data all the time. When it is empty the next k_fifo_get()
+		 * blocks anyway.
 		 */
-		k_yield();
+		if (!k_fifo_is_empty(&tx_queue)) {
+			k_yield();
+		}
 	}
 }
 
+/* H:4 indicator of a controller buffer, or 0 for an unknown type */
+static uint8_t hci_ipc_indicator(struct net_buf *buf)
+{
+	switch (bt_buf_get_type(buf)) {
+	case BT_BUF_ACL_IN:
+		return HCI_IPC_ACL;
+	case BT_BUF_EVT:
+		return HCI_IPC_EVT;
+	case BT_BUF_ISO_IN:
+		return HCI_IPC_ISO;
+	default:
+		LOG_ERR("Unknown type %u", bt_buf_get_type(buf));
+		return 0;
+	}
+}
+
+#if defined(CONFIG_BT_CTLR_ASSERT_HANDLER) || defined(CONFIG_BT_HCI_VS_FATAL_ERROR)
+/* Blocking send, for the fatal error handlers only: they bypass the send
+ * queue and stop the system right after.
+ */
 static void hci_ipc_send(struct net_buf *buf, bool is_fatal_err)
 {
 	uint8_t pkt_indicator;
@@ -230,18 +414,8 @@ static void hci_ipc_send(struct net_buf *buf, bool is_fatal_err)
 
 	LOG_HEXDUMP_DBG(buf->data, buf->len, "Controller buffer:");
 
-	switch (bt_buf_get_type(buf)) {
-	case BT_BUF_ACL_IN:
-		pkt_indicator = HCI_IPC_ACL;
-		break;
-	case BT_BUF_EVT:
-		pkt_indicator = HCI_IPC_EVT;
-		break;
-	case BT_BUF_ISO_IN:
-		pkt_indicator = HCI_IPC_ISO;
-		break;
-	default:
-		LOG_ERR("Unknown type %u", bt_buf_get_type(buf));
+	pkt_indicator = hci_ipc_indicator(buf);
+	if (!pkt_indicator) {
 		net_buf_unref(buf);
 		return;
 	}
@@ -259,14 +433,13 @@ static void hci_ipc_send(struct net_buf *buf, bool is_fatal_err)
 				retries = 0;
 			}
 
-			/* The function can be called by the application main thread,
-			 * bt_ctlr_assert_handle and k_sys_fatal_error_handler. In case of a call by
-			 * Bluetooth Controller assert handler or system fatal error handler the
-			 * call can be from ISR context, hence there is no thread to yield. Besides
-			 * that both handlers implement a policy to provide error information and
-			 * stop the system in an infinite loop. The goal is to prevent any other
-			 * damage to the system if one of such exeptional situations occur, hence
-			 * call to k_yield is against it.
+			/* The function can be called by bt_ctlr_assert_handle and
+			 * k_sys_fatal_error_handler, possibly from ISR context, hence there
+			 * is no thread to yield. Besides that both handlers implement a
+			 * policy to provide error information and stop the system in an
+			 * infinite loop. The goal is to prevent any other damage to the
+			 * system if one of such exeptional situations occur, hence call to
+			 * k_yield is against it.
 			 */
 			if (is_fatal_err) {
 				LOG_ERR("IPC service send error: %d", ret);
@@ -276,11 +449,503 @@ static void hci_ipc_send(struct net_buf *buf, bool is_fatal_err)
 		}
 	} while (ret < 0);
 
-	LOG_INF("Sent message of %d bytes.", ret);
+	LOG_DBG("Sent message of %d bytes.", ret);
+
+	net_buf_unref(buf);
+}
+#endif /* CONFIG_BT_CTLR_ASSERT_HANDLER || CONFIG_BT_HCI_VS_FATAL_ERROR */
+
+/* Send queue
+ *
+ * Controller-to-host packets wait in one lane per type and go out events
+ * first, then ISO data, then ACL data, as far as the IPC backend takes them
+ * without blocking. When it is full the main loop keeps sorting new packets
+ * into the lanes and retries, so one stuck data packet does not hold back
+ * the events behind it. ISO SDUs older than CONFIG_HCI_IPC_ISO_MAX_AGE_MS
+ * are dropped rather than delivered late. Events and ACL data are never
+ * dropped; the controller's buffer pools bound their lanes.
+ */
+#define HCI_IPC_RETRY K_MSEC(1)
+#define HCI_IPC_STALL_WARN_MS 1500
+
+static K_FIFO_DEFINE(evt_lane);
+static K_FIFO_DEFINE(acl_lane);
+
+static struct {
+	struct net_buf *buf[CONFIG_HCI_IPC_ISO_LANE_DEPTH];
+	k_timepoint_t deadline[CONFIG_HCI_IPC_ISO_LANE_DEPTH];
+	size_t head;
+	size_t count;
+} iso_lane;
+
+/* Written by the main thread, read by the vendor command handler */
+static struct {
+	uint16_t evt_depth;
+	uint16_t iso_depth;
+	uint16_t acl_depth;
+	uint16_t evt_max;
+	uint16_t iso_max;
+	uint16_t acl_max;
+	uint32_t iso_expired;
+	uint32_t iso_overflow;
+	uint32_t stalls;
+} queue_stats;
+
+static void hci_ipc_iso_drop_head(void)
+{
+	net_buf_unref(iso_lane.buf[iso_lane.head]);
+	iso_lane.head = (iso_lane.head + 1) % ARRAY_SIZE(iso_lane.buf);
+	iso_lane.count--;
+	queue_stats.iso_depth--;
+}
+
+static void hci_ipc_queue_put(struct net_buf *buf)
+{
+	size_t tail;
+
+	switch (hci_ipc_indicator(buf)) {
+	case HCI_IPC_EVT:
+		k_fifo_put(&evt_lane, buf);
+		queue_stats.evt_depth++;
+		queue_stats.evt_max = MAX(queue_stats.evt_max, queue_stats.evt_depth);
+		break;
+
+	case HCI_IPC_ACL:
+		k_fifo_put(&acl_lane, buf);
+		queue_stats.acl_depth++;
+		queue_stats.acl_max = MAX(queue_stats.acl_max, queue_stats.acl_depth);
+		break;
+
+	case HCI_IPC_ISO:
+		if (iso_lane.count == ARRAY_SIZE(iso_lane.buf)) {
+			/* The oldest SDU is the first to go stale */
+			hci_ipc_iso_drop_head();
+			queue_stats.iso_overflow++;
+		}
+		tail = (iso_lane.head + iso_lane.count) % ARRAY_SIZE(iso_lane.buf);
+		iso_lane.buf[tail] = buf;
+		iso_lane.deadline[tail] = sys_timepoint_calc(K_MSEC(CONFIG_HCI_IPC_ISO_MAX_AGE_MS));
+		iso_lane.count++;
+		queue_stats.iso_depth++;
+		queue_stats.iso_max = MAX(queue_stats.iso_max, queue_stats.iso_depth);
+		break;
+
+	default:
+		net_buf_unref(buf);
+		break;
+	}
+}
+
+/* Next packet to send, left in its lane until hci_ipc_queue_pop() */
+static struct net_buf *hci_ipc_queue_head(void)
+{
+	struct net_buf *buf;
+
+	buf = k_fifo_peek_head(&evt_lane);
+	if (buf) {
+		return buf;
+	}
+
+	while (iso_lane.count && sys_timepoint_expired(iso_lane.deadline[iso_lane.head])) {
+		LOG_DBG("ISO SDU expired");
+		hci_ipc_iso_drop_head();
+		queue_stats.iso_expired++;
+	}
+	if (iso_lane.count) {
+		return iso_lane.buf[iso_lane.head];
+	}
+
+	return k_fifo_peek_head(&acl_lane);
+}
+
+/* Remove the packet hci_ipc_queue_head() returned, once it is sent */
+static void hci_ipc_queue_pop(struct net_buf *buf)
+{
+	pkt_stats.tx_pkts++;
+
+	switch (bt_buf_get_type(buf)) {
+	case BT_BUF_EVT:
+		(void)k_fifo_get(&evt_lane, K_NO_WAIT);
+		queue_stats.evt_depth--;
+		break;
+	case BT_BUF_ISO_IN:
+		iso_lane.head = (iso_lane.head + 1) % ARRAY_SIZE(iso_lane.buf);
+		iso_lane.count--;
+		queue_stats.iso_depth--;
+		break;
+	default:
+		(void)k_fifo_get(&acl_lane, K_NO_WAIT);
+		queue_stats.acl_depth--;
+		break;
+	}
 
 	net_buf_unref(buf);
 }
 
+#if defined(CONFIG_HCI_IPC_NOCOPY)
+/* Borrow a TX buffer without waiting: -EAGAIN when the backend has none
+ * free, -ENOTSUP when it does not lend buffers at all.
+ */
+static int hci_ipc_lend(void **data, uint32_t *size)
+{
+	int err;
+
+	if (nocopy_tx_off) {
+		return -ENOTSUP;
+	}
+
+	err = ipc_service_get_tx_buffer(&hci_ept, data, size, K_NO_WAIT);
+	if (err == -ENOBUFS || err == -ENOMEM || err == -EAGAIN) {
+		return -EAGAIN;
+	} else if (err) {
+		LOG_WRN("IPC backend cannot lend buffers (%d), copying", err);
+		nocopy_tx_off = true;
+		return -ENOTSUP;
+	}
+
+	return 0;
+}
+#endif /* CONFIG_HCI_IPC_NOCOPY */
+
+/* Send one message without blocking: -EAGAIN when the backend is full */
+static int hci_ipc_try_send(const uint8_t *data, size_t len)
+{
+	int ret;
+
+#if defined(CONFIG_HCI_IPC_NOCOPY)
+	void *tx;
+	uint32_t size = len;
+
+	ret = hci_ipc_lend(&tx, &size);
+	if (ret == 0) {
+		memcpy(tx, data, len);
+		ret = ipc_service_send_nocopy(&hci_ept, tx, len);
+		if (ret < 0) {
+			(void)ipc_service_drop_tx_buffer(&hci_ept, tx);
+			return -EAGAIN;
+		}
+		pkt_stats.tx_msgs++;
+		return 0;
+	} else if (ret == -EAGAIN) {
+		return ret;
+	}
+#endif /* CONFIG_HCI_IPC_NOCOPY */
+
+	/* Backends without lent buffers fail fast when they are full */
+	ret = ipc_service_send(&hci_ept, data, len);
+	if (ret < 0) {
+		return -EAGAIN;
+	}
+	pkt_stats.tx_msgs++;
+
+	return 0;
+}
+
+/* Send a lane packet as a plain H:4 message */
+static int hci_ipc_try_send_buf(struct net_buf *buf)
+{
+	int err;
+
+	net_buf_push_u8(buf, hci_ipc_indicator(buf));
+
+	LOG_HEXDUMP_DBG(buf->data, buf->len, "Final HCI buffer:");
+
+	err = hci_ipc_try_send(buf->data, buf->len);
+	if (err) {
+		/* Stays queued; the indicator is pushed again on retry */
+		net_buf_pull(buf, 1);
+	}
+
+	return err;
+}
+
+#if defined(CONFIG_HCI_IPC_COALESCE)
+/* Message being coalesced: HCI_IPC_BATCH, then H:4 packets back-to-back.
+ * It is built in a TX buffer lent by the backend where possible, in
+ * batch_buf otherwise.
+ */
+static uint8_t batch_buf[CONFIG_HCI_IPC_COALESCE_MAX_LEN];
+static uint8_t *batch_data = batch_buf;
+static bool batch_nocopy;
+static size_t batch_len;
+static size_t batch_count;
+static size_t batch_limit = sizeof(batch_buf);
+static k_timepoint_t batch_deadline;
+
+/* Open a new message; false when the backend has no buffer to lend */
+static bool hci_ipc_batch_start(void)
+{
+	batch_data = batch_buf;
+	batch_nocopy = false;
+
+#if defined(CONFIG_HCI_IPC_NOCOPY)
+	void *data;
+	uint32_t size = batch_limit;
+	int err;
+
+	err = hci_ipc_lend(&data, &size);
+	if (err == 0) {
+		batch_data = data;
+		batch_nocopy = true;
+	} else if (err == -EAGAIN) {
+		return false;
+	}
+#endif /* CONFIG_HCI_IPC_NOCOPY */
+
+	batch_data[0] = HCI_IPC_BATCH;
+	batch_len = 1;
+	batch_deadline = sys_timepoint_calc(K_USEC(CONFIG_HCI_IPC_COALESCE_LATENCY_US));
+
+	return true;
+}
+
+static void hci_ipc_batch_add(struct net_buf *buf)
+{
+	batch_data[batch_len++] = hci_ipc_indicator(buf);
+	memcpy(&batch_data[batch_len], buf->data, buf->len);
+	batch_len += buf->len;
+	batch_count++;
+}
+
+/* Send the open message; -EAGAIN keeps it open for a retry */
+static int hci_ipc_batch_flush(void)
+{
+	int ret;
+
+	if (batch_count == 1 && !batch_nocopy) {
+		/* A lone packet goes out as a plain H:4 message. A lent buffer
+		 * can only be sent from its start, so it stays a batch of one.
+		 */
+		ret = ipc_service_send(&hci_ept, batch_data + 1, batch_len - 1);
+	} else if (batch_nocopy) {
+		ret = ipc_service_send_nocopy(&hci_ept, batch_data, batch_len);
+	} else {
+		ret = ipc_service_send(&hci_ept, batch_data, batch_len);
+	}
+	if (ret < 0) {
+		return -EAGAIN;
+	}
+
+	LOG_DBG("Coalesced %zu packets", batch_count);
+	pkt_stats.tx_msgs++;
+
+	batch_len = 0;
+	batch_count = 0;
+
+	return 0;
+}
+
+/* Pack and send what the backend takes; false when it is full */
+static bool hci_ipc_queue_send(void)
+{
+	struct net_buf *buf;
+
+	while (true) {
+		while ((buf = hci_ipc_queue_head()) != NULL) {
+			if (batch_count == 0 && buf->len + 2U > batch_limit) {
+				/* Does not fit even in an empty message */
+				if (hci_ipc_try_send_buf(buf)) {
+					return false;
+				}
+				hci_ipc_queue_pop(buf);
+				continue;
+			}
+
+			if (batch_count == 0 && !hci_ipc_batch_start()) {
+				return false;
+			}
+
+			if (batch_len + 1 + buf->len > batch_limit) {
+				break;
+			}
+
+			hci_ipc_batch_add(buf);
+			hci_ipc_queue_pop(buf);
+		}
+
+		if (batch_count == 0) {
+			return true;
+		}
+
+		/* Lanes drained: wait for more until the deadline */
+		if (!buf && !sys_timepoint_expired(batch_deadline)) {
+			return true;
+		}
+
+		if (hci_ipc_batch_flush()) {
+			return false;
+		}
+	}
+}
+#else
+/* Send what the backend takes; false when it is full */
+static bool hci_ipc_queue_send(void)
+{
+	struct net_buf *buf;
+
+	while ((buf = hci_ipc_queue_head()) != NULL) {
+		if (hci_ipc_try_send_buf(buf)) {
+			return false;
+		}
+		hci_ipc_queue_pop(buf);
+	}
+
+	return true;
+}
+#endif /* CONFIG_HCI_IPC_COALESCE */
+
+/* Command Complete event for a vendor command, with rp_len bytes of return
+ * parameters left for the caller to add
+ */
+static struct net_buf *hci_ipc_vs_cmd_complete(uint16_t opcode, uint8_t rp_len)
+{
+	struct bt_hci_evt_cmd_complete *cc;
+	struct bt_hci_evt_hdr *hdr;
+	struct net_buf *buf;
+
+	buf = bt_buf_get_rx(BT_BUF_EVT, K_NO_WAIT);
+	if (!buf) {
+		LOG_ERR("No event buffer for vendor command 0x%04x", opcode);
+		return NULL;
+	}
+
+	hdr = net_buf_add(buf, sizeof(*hdr));
+	hdr->evt = BT_HCI_EVT_CMD_COMPLETE;
+	hdr->len = sizeof(*cc) + rp_len;
+
+	cc = net_buf_add(buf, sizeof(*cc));
+	cc->ncmd = 1;
+	cc->opcode = sys_cpu_to_le16(opcode);
+
+	return buf;
+}
+
+static void hci_ipc_vs_read_queue_stats(void)
+{
+	struct hci_ipc_rp_vs_read_queue_stats *rp;
+	struct net_buf *buf;
+
+	buf = hci_ipc_vs_cmd_complete(HCI_IPC_OP_VS_READ_QUEUE_STATS, sizeof(*rp));
+	if (!buf) {
+		return;
+	}
+
+	rp = net_buf_add(buf, sizeof(*rp));
+	rp->status = BT_HCI_ERR_SUCCESS;
+	rp->evt_depth = sys_cpu_to_le16(queue_stats.evt_depth);
+	rp->iso_depth = sys_cpu_to_le16(queue_stats.iso_depth);
+	rp->acl_depth = sys_cpu_to_le16(queue_stats.acl_depth);
+	rp->evt_max = sys_cpu_to_le16(queue_stats.evt_max);
+	rp->iso_max = sys_cpu_to_le16(queue_stats.iso_max);
+	rp->acl_max = sys_cpu_to_le16(queue_stats.acl_max);
+	rp->iso_expired = sys_cpu_to_le32(queue_stats.iso_expired);
+	rp->iso_overflow = sys_cpu_to_le32(queue_stats.iso_overflow);
+	rp->stalls = sys_cpu_to_le32(queue_stats.stalls);
+
+	k_fifo_put(&rx_queue, buf);
+}
+
+/* Average receive time of one packet type, 0 without CONFIG_HCI_IPC_TIMING */
+static uint32_t hci_ipc_rx_ns(uint8_t pkt_indicator)
+{
+#if defined(CONFIG_HCI_IPC_TIMING)
+	uint32_t count = pkt_stats.rx_pkts[pkt_indicator];
+
+	if (count) {
+		return timing_cycles_to_ns(pkt_stats.rx_cycles[pkt_indicator]) / count;
+	}
+#endif /* CONFIG_HCI_IPC_TIMING */
+
+	return 0;
+}
+
+static void hci_ipc_vs_read_pkt_stats(void)
+{
+	struct hci_ipc_rp_vs_read_pkt_stats *rp;
+	struct net_buf *buf;
+
+	buf = hci_ipc_vs_cmd_complete(HCI_IPC_OP_VS_READ_PKT_STATS, sizeof(*rp));
+	if (!buf) {
+		return;
+	}
+
+	rp = net_buf_add(buf, sizeof(*rp));
+	rp->status = BT_HCI_ERR_SUCCESS;
+	rp->rx_msgs = sys_cpu_to_le32(pkt_stats.rx_msgs);
+	rp->rx_cmd = sys_cpu_to_le32(pkt_stats.rx_pkts[HCI_IPC_CMD]);
+	rp->rx_acl = sys_cpu_to_le32(pkt_stats.rx_pkts[HCI_IPC_ACL]);
+	rp->rx_iso = sys_cpu_to_le32(pkt_stats.rx_pkts[HCI_IPC_ISO]);
+	rp->rx_held = sys_cpu_to_le32(pkt_stats.rx_held);
+	rp->rx_short = sys_cpu_to_le32(pkt_stats.rx_short);
+	rp->rx_bad_len = sys_cpu_to_le32(pkt_stats.rx_bad_len);
+	rp->rx_no_buf = sys_cpu_to_le32(pkt_stats.rx_no_buf);
+	rp->rx_unknown = sys_cpu_to_le32(pkt_stats.rx_unknown);
+	rp->tx_msgs = sys_cpu_to_le32(pkt_stats.tx_msgs);
+	rp->tx_pkts = sys_cpu_to_le32(pkt_stats.tx_pkts);
+	rp->cmd_ns = sys_cpu_to_le32(hci_ipc_rx_ns(HCI_IPC_CMD));
+	rp->acl_ns = sys_cpu_to_le32(hci_ipc_rx_ns(HCI_IPC_ACL));
+	rp->iso_ns = sys_cpu_to_le32(hci_ipc_rx_ns(HCI_IPC_ISO));
+
+	k_fifo_put(&rx_queue, buf);
+}
+
+/* Answer the sample's own vendor commands; false for anything else */
+static bool hci_ipc_vs_cmd(const uint8_t *data, size_t len)
+{
+	const struct bt_hci_cmd_hdr *hdr = (const void *)data;
+
+	if (len < sizeof(*hdr)) {
+		return false;
+	}
+
+	switch (sys_le16_to_cpu(hdr->opcode)) {
+	case HCI_IPC_OP_VS_READ_QUEUE_STATS:
+		hci_ipc_vs_read_queue_stats();
+		return true;
+	case HCI_IPC_OP_VS_READ_PKT_STATS:
+		hci_ipc_vs_read_pkt_stats();
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* How long the main loop may wait for the controller */
+static k_timeout_t hci_ipc_queue_timeout(bool stalled)
+{
+	if (stalled) {
+		return HCI_IPC_RETRY;
+	}
+
+#if defined(CONFIG_HCI_IPC_COALESCE)
+	if (batch_count) {
+		return sys_timepoint_timeout(batch_deadline);
+	}
+#endif /* CONFIG_HCI_IPC_COALESCE */
+
+	return K_FOREVER;
+}
+
+static void hci_ipc_queue_stalled(bool stalled)
+{
+	static int64_t stall_start;
+	static bool warned;
+
+	if (!stalled) {
+		stall_start = 0;
+		return;
+	}
+
+	if (stall_start == 0) {
+		stall_start = k_uptime_get();
+		warned = false;
+		queue_stats.stalls++;
+	} else if (!warned && k_uptime_get() - stall_start > HCI_IPC_STALL_WARN_MS) {
+		LOG_WRN("IPC send has been blocked for 1.5 seconds.");
+		warned = true;
+	}
+}
+
 #if defined(CONFIG_BT_CTLR_ASSERT_HANDLER)
 void bt_ctlr_assert_handle(char *file, uint32_t line)
 {
@@ -354,6 +1019,14 @@ void k_sys_fatal_error_handler(unsigned int reason, const struct arch_esf *esf)
 
 static void hci_ept_bound(void *priv)
 {
+#if defined(CONFIG_HCI_IPC_COALESCE)
+	int tx_size = ipc_service_get_tx_buffer_size(&hci_ept);
+
+	if (tx_size > 0 && (size_t)tx_size < batch_limit) {
+		batch_limit = tx_size;
+	}
+#endif /* CONFIG_HCI_IPC_COALESCE */
+
 	k_sem_give(&ipc_bound_sem);
 #if defined(CONFIG_BT_CTLR_ASSERT_HANDLER) || defined(CONFIG_BT_HCI_VS_FATAL_ERROR)
 	ipc_ept_ready = true;
@@ -362,7 +1035,6 @@ static void hci_ept_bound(void *priv)
 
 static void hci_ept_recv(const void *data, size_t len, void *priv)
 {
-	LOG_INF("Received message of %u bytes.", len);
 	hci_ipc_rx((uint8_t *) data, len);
 }
 
@@ -377,14 +1049,17 @@ static struct ipc_ept_cfg hci_ept_cfg = {
 int main(void)
 {
 	int err;
+	bool stalled = false;
 	const struct device *hci_ipc_instance =
 		DEVICE_DT_GET(DT_CHOSEN(zephyr_bt_hci_ipc));
 
-	/* incoming events and data from the controller */
-	static K_FIFO_DEFINE(rx_queue);
-
 	LOG_DBG("Start");
 
+#if defined(CONFIG_HCI_IPC_TIMING)
+	timing_init();
+	timing_start();
+#endif /* CONFIG_HCI_IPC_TIMING */
+
 	/* Enable the raw interface, this will in turn open the HCI driver */
 	bt_enable_raw(&rx_queue);
 
@@ -412,8 +1087,17 @@ int main(void)
 	while (1) {
 		struct net_buf *buf;
 
-		buf = k_fifo_get(&rx_queue, K_FOREVER);
-		hci_ipc_send(buf, HCI_REGULAR_MSG);
+		/* Sort everything the controller has produced into the lanes,
+		 * then send as much as the backend takes.
+		 */
+		buf = k_fifo_get(&rx_queue, hci_ipc_queue_timeout(stalled));
+		while (buf) {
+			hci_ipc_queue_put(buf);
+			buf = k_fifo_get(&rx_queue, K_NO_WAIT);
+		}
+
+		stalled = !hci_ipc_queue_send();
+		hci_ipc_queue_stalled(stalled);
 	}
 	return 0;
 }
@@ -18,7 +18,7 @@
 #include <zephyr/bluetooth/services/bas.h>
 #include <zephyr/bluetooth/services/hrs.h>
 
-static bool hrf_ntf_enabled;
+#include "ble_periph.h"
 
 static const struct bt_data ad[] = {
 	BT_DATA_BYTES(BT_DATA_FLAGS, (BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR)),
@@ -37,38 +37,16 @@ static const struct bt_data sd[] = {
 };
 #endif /* !CONFIG_BT_EXT_ADV */
 
-/* Use atomic variable, 2 bits for connection and disconnection state */
-static ATOMIC_DEFINE(state, 2U);
+static void hrs_send(struct ble_notifier *n);
+static void bas_send(struct ble_notifier *n);
 
-#define STATE_CONNECTED    1U
-#define STATE_DISCONNECTED 2U
-
-static void connected(struct bt_conn *conn, uint8_t err)
-{
-	if (err) {
-		printk("Connection failed, err 0x%02x %s\n", err, bt_hci_err_to_str(err));
-	} else {
-		printk("Connected\n");
-
-		(void)atomic_set_bit(state, STATE_CONNECTED);
-	}
-}
-
-static void disconnected(struct bt_conn *conn, uint8_t reason)
-{
-	printk("Disconnected, reason 0x%02x %s\n", reason, bt_hci_err_to_str(reason));
-
-	(void)atomic_set_bit(state, STATE_DISCONNECTED);
-}
-
-BT_CONN_CB_DEFINE(conn_callbacks) = {
-	.connected = connected,
-	.disconnected = disconnected,
-};
+/* Heart rate while a client subscribed, battery level while connected */
+static struct ble_notifier hrs_notifier = BLE_NOTIFIER_INIT(hrs_send, 1000U);
+static struct ble_notifier bas_notifier = BLE_NOTIFIER_INIT(bas_send, 1000U);
 
 static void hrs_ntf_changed(bool enabled)
 {
-	hrf_ntf_enabled = enabled;
+	ble_notifier_enable(&hrs_notifier, enabled);
 
 	printk("HRS notification status changed: %s\n",
 	       enabled ? "enabled" : "disabled");
@@ -91,7 +69,7 @@ static struct bt_conn_auth_cb auth_cb_display = {
 	.cancel = auth_cancel,
 };
 
-static void bas_notify(void)
+static void bas_send(struct ble_notifier *n)
 {
 	uint8_t battery_level = bt_bas_get_battery_level();
 
@@ -101,10 +79,11 @@ static void bas_notify(void)
 		battery_level = 100U;
 	}
 
+	/* Notifies subscribed clients itself */
 	bt_bas_set_battery_level(battery_level);
 }
 
-static void hrs_notify(void)
+static void hrs_send(struct ble_notifier *n)
 {
 	static uint8_t heartrate = 90U;
 
@@ -114,77 +93,17 @@ static void hrs_notify(void)
 		heartrate = 90U;
 	}
 
-	if (hrf_ntf_enabled) {
-		bt_hrs_notify(heartrate);
-	}
-}
-
-#if defined(CONFIG_GPIO)
-/* The devicetree node identifier for the "led0" alias. */
-#define LED0_NODE DT_ALIAS(led0)
-
-#if DT_NODE_HAS_STATUS_OKAY(LED0_NODE)
-#include <zephyr/drivers/gpio.h>
-#define HAS_LED     1
-static const struct gpio_dt_spec led = GPIO_DT_SPEC_GET(LED0_NODE, gpios);
-#define BLINK_ONOFF K_MSEC(500)
-
-static struct k_work_delayable blink_work;
-static bool                  led_is_on;
-
-static void blink_timeout(struct k_work *work)
-{
-	led_is_on = !led_is_on;
-	gpio_pin_set(led.port, led.pin, (int)led_is_on);
-
-	k_work_schedule(&blink_work, BLINK_ONOFF);
-}
-
-static int blink_setup(void)
-{
-	int err;
-
-	printk("Checking LED device...");
-	if (!gpio_is_ready_dt(&led)) {
-		printk("failed.\n");
-		return -EIO;
-	}
-	printk("done.\n");
-
-	printk("Configuring GPIO pin...");
-	err = gpio_pin_configure_dt(&led, GPIO_OUTPUT_ACTIVE);
-	if (err) {
-		printk("failed.\n");
-		return -EIO;
-	}
-	printk("done.\n");
-
-	k_work_init_delayable(&blink_work, blink_timeout);
-
-	return 0;
+	bt_hrs_notify(heartrate);
 }
 
-static void blink_start(void)
-{
-	printk("Start blinking LED...\n");
-	led_is_on = false;
-	gpio_pin_set(led.port, led.pin, (int)led_is_on);
-	k_work_schedule(&blink_work, BLINK_ONOFF);
-}
-
-static void blink_stop(void)
-{
-	struct k_work_sync work_sync;
-
-	printk("Stop blinking LED.\n");
-	k_work_cancel_delayable_sync(&blink_work, &work_sync);
-
-	/* Keep LED on */
-	led_is_on = true;
-	gpio_pin_set(led.port, led.pin, (int)led_is_on);
-}
-#endif /* LED0_NODE */
-#endif /* CONFIG_GPIO */
+static const struct ble_periph_config periph_config = {
+	.ad = ad,
+	.ad_len = ARRAY_SIZE(ad),
+#if !defined(CONFIG_BT_EXT_ADV)
+	.sd = sd,
+	.sd_len = ARRAY_SIZE(sd),
+#endif /* !CONFIG_BT_EXT_ADV */
+};
 
 int main(void)
 {
@@ -202,108 +121,18 @@ int main(void)
 
 	bt_hrs_cb_register(&hrs_cb);
 
-#if !defined(CONFIG_BT_EXT_ADV)
-	printk("Starting Legacy Advertising (connectable and scannable)\n");
-	err = bt_le_adv_start(BT_LE_ADV_CONN_ONE_TIME, ad, ARRAY_SIZE(ad), sd, ARRAY_SIZE(sd));
-	if (err) {
-		printk("Advertising failed to start (err %d)\n", err);
-		return 0;
-	}
-
-#else /* CONFIG_BT_EXT_ADV */
-	struct bt_le_adv_param adv_param = {
-		.id = BT_ID_DEFAULT,
-		.sid = 0U,
-		.secondary_max_skip = 0U,
-		.options = (BT_LE_ADV_OPT_EXT_ADV |
-			    BT_LE_ADV_OPT_CONNECTABLE |
-			    BT_LE_ADV_OPT_CODED),
-		.interval_min = BT_GAP_ADV_FAST_INT_MIN_2,
-		.interval_max = BT_GAP_ADV_FAST_INT_MAX_2,
-		.peer = NULL,
-	};
-	struct bt_le_ext_adv *adv;
-
-	printk("Creating a Coded PHY connectable non-scannable advertising set\n");
-	err = bt_le_ext_adv_create(&adv_param, NULL, &adv);
-	if (err) {
-		printk("Failed to create Coded PHY extended advertising set (err %d)\n", err);
-
-		printk("Creating a non-Coded PHY connectable non-scannable advertising set\n");
-		adv_param.options &= ~BT_LE_ADV_OPT_CODED;
-		err = bt_le_ext_adv_create(&adv_param, NULL, &adv);
-		if (err) {
-			printk("Failed to create extended advertising set (err %d)\n", err);
-			return 0;
-		}
-	}
-
-	printk("Setting extended advertising data\n");
-	err = bt_le_ext_adv_set_data(adv, ad, ARRAY_SIZE(ad), NULL, 0);
-	if (err) {
-		printk("Failed to set extended advertising data (err %d)\n", err);
-		return 0;
-	}
-
-	printk("Starting Extended Advertising (connectable non-scannable)\n");
-	err = bt_le_ext_adv_start(adv, BT_LE_EXT_ADV_START_DEFAULT);
-	if (err) {
-		printk("Failed to start extended advertising set (err %d)\n", err);
-		return 0;
-	}
-#endif /* CONFIG_BT_EXT_ADV */
-
-	printk("Advertising successfully started\n");
+	ble_notifier_register(&hrs_notifier);
+	ble_notifier_register(&bas_notifier);
+	ble_notifier_enable(&bas_notifier, true);
 
-#if defined(HAS_LED)
-	err = blink_setup();
+	err = ble_periph_start(&periph_config);
 	if (err) {
+		printk("Peripheral failed to start (err %d)\n", err);
 		return 0;
 	}
 
-	blink_start();
-#endif /* HAS_LED */
-
-	/* Implement notification. */
-	while (1) {
-		k_sleep(K_SECONDS(1));
-
-		/* Heartrate measurements simulation */
-		hrs_notify();
-
-		/* Battery level simulation */
-		bas_notify();
-
-		if (atomic_test_and_clear_bit(state, STATE_CONNECTED)) {
-			/* Connected callback executed */
-
-#if defined(HAS_LED)
-			blink_stop();
-#endif /* HAS_LED */
-		} else if (atomic_test_and_clear_bit(state, STATE_DISCONNECTED)) {
-#if !defined(CONFIG_BT_EXT_ADV)
-			printk("Starting Legacy Advertising (connectable and scannable)\n");
-			err = bt_le_adv_start(BT_LE_ADV_CONN_ONE_TIME, ad, ARRAY_SIZE(ad), sd,
-					      ARRAY_SIZE(sd));
-			if (err) {
-				printk("Advertising failed to start (err %d)\n", err);
-				return 0;
-			}
-
-#else /* CONFIG_BT_EXT_ADV */
-			printk("Starting Extended Advertising (connectable and non-scannable)\n");
-			err = bt_le_ext_adv_start(adv, BT_LE_EXT_ADV_START_DEFAULT);
-			if (err) {
-				printk("Failed to start extended advertising set (err %d)\n", err);
-				return 0;
-			}
-#endif /* CONFIG_BT_EXT_ADV */
-
-#if defined(HAS_LED)
-			blink_start();
-#endif /* HAS_LED */
-		}
-	}
-
+	/* Advertising, reconnection and notifications run in the peripheral
+	 * thread from here on; main has nothing left to do.
+	 */
 	return 0;
 }
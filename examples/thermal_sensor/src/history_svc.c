@@ -0,0 +1,330 @@
+/* history_svc.c - GATT access to the temperature history
+ *
+ * Temperature History service (vendor UUIDs):
+ *
+ * - Control (read, write). Read returns struct history_info. Writing
+ *   HISTORY_OP_SEND followed by a little-endian u32 record index streams
+ *   the records from that index on (0 for all that are kept) as
+ *   notifications of Data; HISTORY_OP_STOP ends a transfer.
+ * - Data (notify). Each notification is a little-endian u32 index of its
+ *   first record followed by as many struct temp_history_rec as fit in the
+ *   ATT MTU: 40 per notification at the 247-byte MTU requested on connect,
+ *   so hours of readings go over in a few connection events.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/bluetooth/uuid.h>
+
+#include "history_svc.h"
+#include "temp_history.h"
+
+#define HISTORY_OP_STOP 0x00
+#define HISTORY_OP_SEND 0x01
+
+/* Largest notification: ATT header plus what fits in the largest MTU */
+#define HISTORY_MAX_RECS \
+    ((CONFIG_BT_L2CAP_TX_MTU - 3 - sizeof(uint32_t)) / sizeof(struct temp_history_rec))
+
+/* Connection interval while a transfer runs: 15-30 ms, no latency */
+#define HISTORY_FAST_INT_MIN 12
+#define HISTORY_FAST_INT_MAX 24
+#define HISTORY_FAST_TIMEOUT 400
+
+/* 7e1f0000-5a3b-4c8e-9d2f-6b1a0c3e4d50 and following */
+#define HISTORY_UUID_VAL(n) \
+    BT_UUID_128_ENCODE(0x7e1f0000 + (n), 0x5a3b, 0x4c8e, 0x9d2f, 0x6b1a0c3e4d50)
+
+static const struct bt_uuid_128 history_uuid = BT_UUID_INIT_128(HISTORY_UUID_VAL(0));
+static const struct bt_uuid_128 control_uuid = BT_UUID_INIT_128(HISTORY_UUID_VAL(1));
+static const struct bt_uuid_128 data_uuid = BT_UUID_INIT_128(HISTORY_UUID_VAL(2));
+
+struct history_info {
+    uint32_t first;         /* Oldest record kept */
+    uint32_t end;           /* Index the next record will get */
+    uint32_t now_s;         /* Device time, as in the records */
+    uint16_t interval_s;    /* Time between records */
+} __packed;
+
+/* Transfer state, owned by send_work on the system work queue */
+static struct bt_conn *stream_conn;
+static uint32_t stream_index;
+static atomic_t in_flight;
+static struct k_work_delayable send_work;
+
+/* Requests from the Bluetooth threads, taken over by send_work */
+static struct k_spinlock req_lock;
+static struct bt_conn *req_conn;    /* SEND pending, reference held */
+static uint32_t req_index;
+static bool req_stop;
+
+static ssize_t control_read(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                            void *buf, uint16_t len, uint16_t offset);
+static ssize_t control_write(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                             const void *buf, uint16_t len, uint16_t offset, uint8_t flags);
+
+/* attrs: [0]=primary, [1]=control decl, [2]=control, [3]=data decl, [4]=data, [5]=CCC */
+BT_GATT_SERVICE_DEFINE(history_svc,
+    BT_GATT_PRIMARY_SERVICE(&history_uuid),
+    BT_GATT_CHARACTERISTIC(&control_uuid.uuid,
+        BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE,
+        BT_GATT_PERM_READ | BT_GATT_PERM_WRITE,
+        control_read, control_write, NULL),
+    BT_GATT_CHARACTERISTIC(&data_uuid.uuid,
+        BT_GATT_CHRC_NOTIFY,
+        BT_GATT_PERM_NONE,
+        NULL, NULL, NULL),
+    BT_GATT_CCC(NULL, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE)
+);
+
+static ssize_t control_read(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                            void *buf, uint16_t len, uint16_t offset)
+{
+    struct history_info info;
+    uint32_t first, end;
+
+    temp_history_range(&first, &end);
+    info.first = sys_cpu_to_le32(first);
+    info.end = sys_cpu_to_le32(end);
+    info.now_s = sys_cpu_to_le32(temp_history_now());
+    info.interval_s = sys_cpu_to_le16(CONFIG_TEMP_HISTORY_INTERVAL_S);
+
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, &info, sizeof(info));
+}
+
+static void stream_stop(void)
+{
+    if (stream_conn) {
+        bt_conn_unref(stream_conn);
+        stream_conn = NULL;
+    }
+    /* Completions of a dropped connection may never come */
+    atomic_set(&in_flight, 0);
+}
+
+static bool conn_is_connected(struct bt_conn *conn)
+{
+    struct bt_conn_info info;
+
+    return bt_conn_get_info(conn, &info) == 0 && info.state == BT_CONN_STATE_CONNECTED;
+}
+
+/* Short interval for the transfer, back to the preferred low-power
+ * parameters when it ends
+ */
+static void stream_link(bool fast)
+{
+#if defined(CONFIG_TEMP_HISTORY_FAST_CONN)
+    const struct bt_le_conn_param *param = fast ?
+        BT_LE_CONN_PARAM(HISTORY_FAST_INT_MIN, HISTORY_FAST_INT_MAX, 0,
+                         HISTORY_FAST_TIMEOUT) :
+        BT_LE_CONN_PARAM(CONFIG_BT_PERIPHERAL_PREF_MIN_INT, CONFIG_BT_PERIPHERAL_PREF_MAX_INT,
+                         CONFIG_BT_PERIPHERAL_PREF_LATENCY, CONFIG_BT_PERIPHERAL_PREF_TIMEOUT);
+    int err;
+
+    if (!stream_conn || !conn_is_connected(stream_conn)) {
+        return;
+    }
+    err = bt_conn_le_param_update(stream_conn, param);
+    if (err && err != -EALREADY) {
+        printk("Conn param update failed (%d)\n", err);
+    }
+#else
+    ARG_UNUSED(fast);
+#endif
+}
+
+/* The transfer finished or was stopped by the central */
+static void stream_end(void)
+{
+    stream_link(false);
+    stream_stop();
+}
+
+static ssize_t control_write(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                             const void *buf, uint16_t len, uint16_t offset, uint8_t flags)
+{
+    const uint8_t *op = buf;
+    k_spinlock_key_t key;
+
+    if (offset != 0) {
+        return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
+    }
+    if (len < 1) {
+        return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+    }
+
+    switch (op[0]) {
+    case HISTORY_OP_STOP:
+        key = k_spin_lock(&req_lock);
+        if (req_conn) {
+            bt_conn_unref(req_conn);
+            req_conn = NULL;
+        }
+        req_stop = true;
+        k_spin_unlock(&req_lock, key);
+        k_work_reschedule(&send_work, K_NO_WAIT);
+        break;
+
+    case HISTORY_OP_SEND:
+        if (len != 1 + sizeof(uint32_t)) {
+            return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+        }
+        if (!bt_gatt_is_subscribed(conn, &history_svc.attrs[4], BT_GATT_CCC_NOTIFY)) {
+            return BT_GATT_ERR(BT_ATT_ERR_CCC_IMPROPER_CONF);
+        }
+        key = k_spin_lock(&req_lock);
+        if (req_conn) {
+            bt_conn_unref(req_conn);
+        }
+        req_conn = bt_conn_ref(conn);
+        req_index = sys_get_le32(&op[1]);
+        k_spin_unlock(&req_lock, key);
+        k_work_reschedule(&send_work, K_NO_WAIT);
+        break;
+
+    default:
+        return BT_GATT_ERR(BT_ATT_ERR_NOT_SUPPORTED);
+    }
+
+    return len;
+}
+
+static void sent(struct bt_conn *conn, void *user_data)
+{
+    /* A buffer is free again: continue the transfer */
+    atomic_dec(&in_flight);
+    k_work_reschedule(&send_work, K_NO_WAIT);
+}
+
+/* Take over a new request, or drop a transfer that was stopped or whose
+ * connection is gone
+ */
+static void take_request(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&req_lock);
+    struct bt_conn *conn = req_conn;
+    uint32_t index = req_index;
+    bool stop = req_stop;
+
+    req_conn = NULL;
+    req_stop = false;
+
+    k_spin_unlock(&req_lock, key);
+
+    if (conn) {
+        stream_stop();
+        stream_conn = conn;
+        stream_index = index;
+        stream_link(true);
+    } else if (stop) {
+        stream_end();
+    }
+
+    if (stream_conn && !conn_is_connected(stream_conn)) {
+        stream_stop();
+    }
+}
+
+/* Send until the history is exhausted or the stack runs out of buffers;
+ * the completion of a sent notification resumes the transfer.
+ */
+static void send_next(struct k_work *work)
+{
+    static uint8_t pdu[sizeof(uint32_t) + HISTORY_MAX_RECS * sizeof(struct temp_history_rec)];
+    struct temp_history_rec *recs = (void *)&pdu[sizeof(uint32_t)];
+    struct bt_gatt_notify_params params = {
+        .attr = &history_svc.attrs[4],
+        .data = pdu,
+        .func = sent,
+    };
+    uint32_t first, end, max, count;
+    int err;
+
+    take_request();
+
+    while (stream_conn) {
+        max = (bt_gatt_get_mtu(stream_conn) - 3 - sizeof(uint32_t)) / sizeof(*recs);
+        max = MIN(max, HISTORY_MAX_RECS);
+
+        temp_history_range(&first, &end);
+        stream_index = MAX(stream_index, first);
+        count = temp_history_read(stream_index, recs, max);
+        if (count == 0) {
+            /* Caught up */
+            stream_end();
+            return;
+        }
+
+        sys_put_le32(stream_index, pdu);
+        params.len = sizeof(uint32_t) + count * sizeof(*recs);
+
+        err = bt_gatt_notify_cb(stream_conn, &params);
+        if (err == -ENOMEM) {
+            /* Wait for sent(), or poll if nothing of ours is in flight */
+            if (atomic_get(&in_flight) <= 0) {
+                k_work_reschedule(&send_work, K_MSEC(10));
+            }
+            return;
+        } else if (err) {
+            printk("History notify failed (%d)\n", err);
+            stream_end();
+            return;
+        }
+        atomic_inc(&in_flight);
+        stream_index += count;
+    }
+}
+
+static void mtu_exchanged(struct bt_conn *conn, uint8_t err,
+                          struct bt_gatt_exchange_params *params)
+{
+    if (err) {
+        printk("MTU exchange failed (ATT 0x%02x)\n", err);
+    } else {
+        printk("ATT MTU %u\n", bt_gatt_get_mtu(conn));
+    }
+}
+
+void history_svc_conn_setup(struct bt_conn *conn)
+{
+    static struct bt_gatt_exchange_params mtu_params = {
+        .func = mtu_exchanged,
+    };
+    int err;
+
+    err = bt_gatt_exchange_mtu(conn, &mtu_params);
+    if (err && err != -EALREADY) {
+        printk("MTU exchange failed (%d)\n", err);
+    }
+
+    err = bt_conn_le_data_len_update(conn, BT_LE_DATA_LEN_PARAM_MAX);
+    if (err) {
+        printk("Data length update failed (%d)\n", err);
+    }
+}
+
+static void disconnected(struct bt_conn *conn, uint8_t reason)
+{
+    /* Lets send_work release its reference to the connection */
+    k_work_reschedule(&send_work, K_NO_WAIT);
+}
+
+BT_CONN_CB_DEFINE(history_conn_cbs) = {
+    .disconnected = disconnected,
+};
+
+static int history_svc_init(void)
+{
+    k_work_init_delayable(&send_work, send_next);
+    return 0;
+}
+
+SYS_INIT(history_svc_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
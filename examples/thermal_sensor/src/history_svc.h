@@ -0,0 +1,16 @@
+/* history_svc.h - GATT access to the temperature history
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef HISTORY_SVC_H_
+#define HISTORY_SVC_H_
+
+#include <zephyr/bluetooth/conn.h>
+
+/* Ask for the largest ATT MTU and data length, so each notification
+ * carries as many records as possible. Call from the connected callback.
+ */
+void history_svc_conn_setup(struct bt_conn *conn);
+
+#endif /* HISTORY_SVC_H_ */
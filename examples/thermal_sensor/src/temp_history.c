@@ -0,0 +1,211 @@
+/* temp_history.c - Temperature history kept for reconnecting centrals
+ *
+ * A RAM ring of CONFIG_TEMP_HISTORY_SIZE records, one per
+ * CONFIG_TEMP_HISTORY_INTERVAL_S. With CONFIG_TEMP_HISTORY_NVS every full
+ * block of CONFIG_TEMP_HISTORY_NVS_BLOCK records is also written to NVS, so
+ * a reboot loses at most the block being filled.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+
+#if defined(CONFIG_TEMP_HISTORY_NVS)
+#include <zephyr/drivers/flash.h>
+#include <zephyr/fs/nvs.h>
+#include <zephyr/storage/flash_map.h>
+#endif
+
+#include "temp_history.h"
+
+static struct temp_history_rec ring[CONFIG_TEMP_HISTORY_SIZE];
+static uint32_t oldest;
+static uint32_t next;
+static uint32_t time_base_s;    /* Added to uptime: persisted device time */
+static int64_t  next_record_ms;
+static struct k_spinlock lock;
+
+uint32_t temp_history_now(void)
+{
+    return time_base_s + (uint32_t)(k_uptime_get() / MSEC_PER_SEC);
+}
+
+#if defined(CONFIG_TEMP_HISTORY_NVS)
+#define NVS_BLOCKS (CONFIG_TEMP_HISTORY_SIZE / CONFIG_TEMP_HISTORY_NVS_BLOCK)
+
+BUILD_ASSERT(CONFIG_TEMP_HISTORY_SIZE % CONFIG_TEMP_HISTORY_NVS_BLOCK == 0,
+             "History size must be a whole number of NVS blocks");
+
+/* One NVS entry: records [first, first + CONFIG_TEMP_HISTORY_NVS_BLOCK) */
+struct nvs_block {
+    uint32_t first;
+    struct temp_history_rec recs[CONFIG_TEMP_HISTORY_NVS_BLOCK];
+} __packed;
+
+static struct nvs_fs fs;
+static bool fs_ready;
+
+/* Block n lives at NVS id 1 + n % NVS_BLOCKS */
+static uint16_t block_id(uint32_t first)
+{
+    return 1 + (first / CONFIG_TEMP_HISTORY_NVS_BLOCK) % NVS_BLOCKS;
+}
+
+static void nvs_store_block(uint32_t first)
+{
+    static struct nvs_block blk;
+    k_spinlock_key_t key;
+    ssize_t len;
+
+    if (!fs_ready) {
+        return;
+    }
+
+    key = k_spin_lock(&lock);
+    blk.first = first;
+    for (uint32_t i = 0; i < CONFIG_TEMP_HISTORY_NVS_BLOCK; i++) {
+        blk.recs[i] = ring[(first + i) % ARRAY_SIZE(ring)];
+    }
+    k_spin_unlock(&lock, key);
+
+    len = nvs_write(&fs, block_id(first), &blk, sizeof(blk));
+    if (len < 0) {
+        printk("History block %u not stored (%d)\n", first, (int)len);
+    }
+}
+
+static void nvs_restore(void)
+{
+    static struct nvs_block blk;
+    uint32_t first_min = UINT32_MAX;
+    uint32_t end_max = 0;
+    bool found = false;
+
+    for (uint16_t id = 1; id <= NVS_BLOCKS; id++) {
+        if (nvs_read(&fs, id, &blk, sizeof(blk)) != sizeof(blk) ||
+            block_id(blk.first) != id) {
+            continue;
+        }
+        for (uint32_t i = 0; i < CONFIG_TEMP_HISTORY_NVS_BLOCK; i++) {
+            ring[(blk.first + i) % ARRAY_SIZE(ring)] = blk.recs[i];
+        }
+        first_min = MIN(first_min, blk.first);
+        end_max = MAX(end_max, blk.first + CONFIG_TEMP_HISTORY_NVS_BLOCK);
+        found = true;
+    }
+
+    if (!found) {
+        return;
+    }
+
+    /* Blocks older than one ring length were overwritten in flash too */
+    next = end_max;
+    oldest = MAX(first_min, next > ARRAY_SIZE(ring) ? next - ARRAY_SIZE(ring) : 0);
+    time_base_s = ring[(next - 1) % ARRAY_SIZE(ring)].time_s + CONFIG_TEMP_HISTORY_INTERVAL_S;
+
+    printk("History restored: %u records\n", next - oldest);
+}
+
+static int nvs_setup(void)
+{
+    struct flash_pages_info info;
+    int err;
+
+    fs.flash_device = FIXED_PARTITION_DEVICE(storage_partition);
+    if (!device_is_ready(fs.flash_device)) {
+        return -ENODEV;
+    }
+    fs.offset = FIXED_PARTITION_OFFSET(storage_partition);
+
+    err = flash_get_page_info_by_offs(fs.flash_device, fs.offset, &info);
+    if (err) {
+        return err;
+    }
+    fs.sector_size = info.size;
+    fs.sector_count = FIXED_PARTITION_SIZE(storage_partition) / info.size;
+
+    err = nvs_mount(&fs);
+    if (err) {
+        return err;
+    }
+    fs_ready = true;
+
+    nvs_restore();
+    return 0;
+}
+#endif /* CONFIG_TEMP_HISTORY_NVS */
+
+int temp_history_init(void)
+{
+    int err = 0;
+
+#if defined(CONFIG_TEMP_HISTORY_NVS)
+    err = nvs_setup();
+    if (err) {
+        printk("History storage unavailable (%d), RAM only\n", err);
+    }
+#endif
+
+    next_record_ms = k_uptime_get();
+    return err;
+}
+
+void temp_history_add(const struct temp_sample *sample)
+{
+    k_spinlock_key_t key;
+    uint32_t index;
+
+    if (sample->uptime_ms < next_record_ms) {
+        return;
+    }
+    /* Fixed rate, skipping intervals that had no reading */
+    do {
+        next_record_ms += CONFIG_TEMP_HISTORY_INTERVAL_S * MSEC_PER_SEC;
+    } while (next_record_ms <= sample->uptime_ms);
+
+    key = k_spin_lock(&lock);
+    index = next++;
+    ring[index % ARRAY_SIZE(ring)] = (struct temp_history_rec){
+        .time_s = time_base_s + (uint32_t)(sample->uptime_ms / MSEC_PER_SEC),
+        .centi  = sample->centi,
+    };
+    if (next - oldest > ARRAY_SIZE(ring)) {
+        oldest = next - ARRAY_SIZE(ring);
+    }
+    k_spin_unlock(&lock, key);
+
+#if defined(CONFIG_TEMP_HISTORY_NVS)
+    if (next % CONFIG_TEMP_HISTORY_NVS_BLOCK == 0) {
+        nvs_store_block(next - CONFIG_TEMP_HISTORY_NVS_BLOCK);
+    }
+#endif
+}
+
+void temp_history_range(uint32_t *first, uint32_t *end)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    *first = oldest;
+    *end = next;
+
+    k_spin_unlock(&lock, key);
+}
+
+uint32_t temp_history_read(uint32_t index, struct temp_history_rec *recs, uint32_t max)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    uint32_t count = 0;
+
+    if (index < oldest) {
+        index = oldest;
+    }
+    while (count < max && index < next) {
+        recs[count++] = ring[index++ % ARRAY_SIZE(ring)];
+    }
+
+    k_spin_unlock(&lock, key);
+    return count;
+}
@@ -0,0 +1,41 @@
+/* temp_history.h - Temperature history kept for reconnecting centrals
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef TEMP_HISTORY_H_
+#define TEMP_HISTORY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <zephyr/toolchain.h>
+
+#include "temp_sampler.h"
+
+/* One stored reading, as it goes over the air */
+struct temp_history_rec {
+    uint32_t time_s;    /* Device time, see temp_history_now() */
+    int16_t  centi;     /* signed 0.01 °C units */
+} __packed;
+
+/* Restore persisted records (CONFIG_TEMP_HISTORY_NVS) and start recording */
+int temp_history_init(void);
+
+/* Offer a reading; one is recorded per CONFIG_TEMP_HISTORY_INTERVAL_S */
+void temp_history_add(const struct temp_sample *sample);
+
+/* Records are numbered from 0 in the order they were taken. The history
+ * holds [first, end); older ones have been overwritten.
+ */
+void temp_history_range(uint32_t *first, uint32_t *end);
+
+/* Copy up to max records starting at index; returns how many were copied */
+uint32_t temp_history_read(uint32_t index, struct temp_history_rec *recs, uint32_t max);
+
+/* Device time in seconds: uptime, continued across reboots when the
+ * history is persisted. A central maps it to wall time by reading it.
+ */
+uint32_t temp_history_now(void);
+
+#endif /* TEMP_HISTORY_H_ */
@@ -0,0 +1,187 @@
+/* temp_sampler.c - Asynchronous DS18B20 sampling
+ *
+ * sensor_sample_fetch() on the DS18B20 sleeps through the whole conversion
+ * (750 ms at 12 bits). Instead, start the conversion with the 1-Wire API,
+ * let the bus convert while the CPU sleeps, and read the scratchpad from a
+ * delayable work item once the conversion time has passed. Readings go to a
+ * small ring that the publisher drains.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/w1.h>
+#include <zephyr/sys/byteorder.h>
+
+#include "temp_sampler.h"
+
+#define DS18B20_NODE DT_NODELABEL(ds18b20_0)
+
+#define DS18B20_CMD_CONVERT_T        0x44
+#define DS18B20_CMD_READ_SCRATCHPAD  0xBE
+#define DS18B20_SCRATCHPAD_LEN       9
+
+/* Conversion time halves with each bit of resolution below 12 (750 ms) */
+#define DS18B20_RESOLUTION  DT_PROP_OR(DS18B20_NODE, resolution, 12)
+#define DS18B20_CONV_MS     ((750 >> (12 - DS18B20_RESOLUTION)) + 10)
+
+BUILD_ASSERT(CONFIG_TEMP_SAMPLE_INTERVAL_MS > DS18B20_CONV_MS,
+             "Sample interval shorter than the DS18B20 conversion time");
+
+static const struct device *const ds18b20 = DEVICE_DT_GET(DS18B20_NODE);
+static const struct device *const w1_bus = DEVICE_DT_GET(DT_BUS(DS18B20_NODE));
+
+static struct w1_slave_config slave_cfg;
+
+static temp_sampler_cb_t sample_cb;
+static struct k_work_delayable convert_work;
+static struct k_work_delayable read_work;
+static int64_t next_convert_ms;
+
+/* Ring of samples, written by the work items, read by the publisher */
+static struct temp_sample ring[CONFIG_TEMP_SAMPLE_RING_SIZE];
+static size_t ring_head;
+static size_t ring_count;
+static struct k_spinlock ring_lock;
+
+static uint32_t dropped;
+static uint32_t errors;
+
+static void ring_put(const struct temp_sample *sample)
+{
+    k_spinlock_key_t key = k_spin_lock(&ring_lock);
+
+    if (ring_count == ARRAY_SIZE(ring)) {
+        /* Keep the newest readings */
+        ring_head = (ring_head + 1) % ARRAY_SIZE(ring);
+        ring_count--;
+        dropped++;
+    }
+    ring[(ring_head + ring_count) % ARRAY_SIZE(ring)] = *sample;
+    ring_count++;
+
+    k_spin_unlock(&ring_lock, key);
+}
+
+bool temp_sampler_get(struct temp_sample *sample)
+{
+    k_spinlock_key_t key = k_spin_lock(&ring_lock);
+    bool found = ring_count > 0;
+
+    if (found) {
+        *sample = ring[ring_head];
+        ring_head = (ring_head + 1) % ARRAY_SIZE(ring);
+        ring_count--;
+    }
+
+    k_spin_unlock(&ring_lock, key);
+    return found;
+}
+
+uint32_t temp_sampler_dropped(void)
+{
+    return dropped;
+}
+
+uint32_t temp_sampler_errors(void)
+{
+    return errors;
+}
+
+/* Address the sensor and send one function command */
+static int ds18b20_command(uint8_t cmd)
+{
+    int err = w1_match_rom(w1_bus, &slave_cfg);
+
+    if (err == 0) {
+        err = w1_write_byte(w1_bus, cmd);
+    }
+    return err;
+}
+
+static void schedule_next_convert(void)
+{
+    /* Fixed rate: the period does not stretch by the conversion time */
+    next_convert_ms += CONFIG_TEMP_SAMPLE_INTERVAL_MS;
+    k_work_schedule(&convert_work, K_TIMEOUT_ABS_MS(next_convert_ms));
+}
+
+static void convert_start(struct k_work *work)
+{
+    int err;
+
+    (void)w1_lock_bus(w1_bus);
+    err = ds18b20_command(DS18B20_CMD_CONVERT_T);
+    (void)w1_unlock_bus(w1_bus);
+
+    if (err) {
+        errors++;
+        printk("DS18B20 convert failed (%d)\n", err);
+        schedule_next_convert();
+        return;
+    }
+
+    k_work_schedule(&read_work, K_MSEC(DS18B20_CONV_MS));
+}
+
+static void convert_read(struct k_work *work)
+{
+    uint8_t pad[DS18B20_SCRATCHPAD_LEN];
+    struct temp_sample sample;
+    int16_t raw;
+    int err;
+
+    (void)w1_lock_bus(w1_bus);
+    err = ds18b20_command(DS18B20_CMD_READ_SCRATCHPAD);
+    if (err == 0) {
+        err = w1_read_block(w1_bus, pad, sizeof(pad));
+    }
+    (void)w1_unlock_bus(w1_bus);
+
+    if (err == 0 && w1_crc8(pad, sizeof(pad) - 1) != pad[sizeof(pad) - 1]) {
+        err = -EIO;
+    }
+
+    schedule_next_convert();
+
+    if (err) {
+        errors++;
+        printk("DS18B20 read failed (%d)\n", err);
+        return;
+    }
+
+    /* 1/16 °C units; the bits below the resolution are undefined */
+    raw = (int16_t)sys_get_le16(pad);
+    raw &= ~((1 << (12 - DS18B20_RESOLUTION)) - 1);
+
+    sample.uptime_ms = k_uptime_get();
+    sample.centi = (int16_t)((raw * 100 + (raw >= 0 ? 8 : -8)) / 16);
+    ring_put(&sample);
+
+    if (sample_cb) {
+        sample_cb();
+    }
+}
+
+int temp_sampler_start(temp_sampler_cb_t cb)
+{
+    if (!device_is_ready(ds18b20) || !device_is_ready(w1_bus)) {
+        return -ENODEV;
+    }
+
+    /* The sensor driver set the resolution at init; only its ROM is needed */
+    w1_uint64_to_rom(DT_REG_ADDR_U64(DS18B20_NODE), &slave_cfg.rom);
+
+    sample_cb = cb;
+    k_work_init_delayable(&convert_work, convert_start);
+    k_work_init_delayable(&read_work, convert_read);
+
+    next_convert_ms = k_uptime_get();
+    k_work_schedule(&convert_work, K_NO_WAIT);
+
+    return 0;
+}
@@ -0,0 +1,33 @@
+/* temp_sampler.h - Asynchronous DS18B20 sampling
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef TEMP_SAMPLER_H_
+#define TEMP_SAMPLER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct temp_sample {
+    int64_t uptime_ms;  /* When the conversion finished */
+    int16_t centi;      /* signed 0.01 °C units */
+};
+
+/* Called from the system work queue after a sample entered the ring */
+typedef void (*temp_sampler_cb_t)(void);
+
+/* Check the sensor and start sampling every CONFIG_TEMP_SAMPLE_INTERVAL_MS.
+ * The conversion runs on the bus while the CPU is free: one work item
+ * starts it, a second one reads the result when it is due.
+ */
+int temp_sampler_start(temp_sampler_cb_t cb);
+
+/* Take the oldest sample out of the ring; false when it is empty */
+bool temp_sampler_get(struct temp_sample *sample);
+
+/* Samples lost because the ring was full, and failed reads */
+uint32_t temp_sampler_dropped(void);
+uint32_t temp_sampler_errors(void);
+
+#endif /* TEMP_SAMPLER_H_ */